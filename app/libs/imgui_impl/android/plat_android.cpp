@@ -158,13 +158,20 @@ void clean(int mode) {
         shutdown();
         ImGui::DestroyContext();
         SDL_GL_DeleteContext(ctx);
-        SDL_Quit();
     }
     if (mode == BEFORE_EMULATION || mode == EXITING) {
         SDL_DestroyWindow(window);
     }
+    if (mode == EXITING) {
+        jzintv_warm_release();
+    }
     if (mode == AFTER_EMULATION || mode == EXITING) {
-        SDL_Quit();
+        // A warm jzIntv keeps SDL up between games: only give back what setup_window took
+        if (jzintv_is_warm()) {
+            SDL_QuitSubSystem(SDL_INIT_VIDEO | SDL_INIT_TIMER);
+        } else {
+            SDL_Quit();
+        }
     }
 }
 
@@ -265,6 +272,10 @@ char *get_external_sd_path() {
     return strdup(res);
 }
 
+bool wait_for_event(int timeout_millis) {
+    return SDL_WaitEventTimeout(NULL, timeout_millis) == 1;
+}
+
 bool is_ok_permission() {
     return is_ok_perm;
 }
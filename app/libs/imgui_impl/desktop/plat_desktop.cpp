@@ -136,8 +136,16 @@ void clean(int mode) {
     if (mode == BEFORE_EMULATION || mode == EXITING) {
         SDL_DestroyWindow(window);
     }
+    if (mode == EXITING) {
+        jzintv_warm_release();
+    }
     if (mode == AFTER_EMULATION || mode == EXITING) {
-        SDL_Quit();
+        // A warm jzIntv keeps SDL up between games: only give back what setup_window took
+        if (jzintv_is_warm()) {
+            SDL_QuitSubSystem(SDL_INIT_VIDEO | SDL_INIT_TIMER);
+        } else {
+            SDL_Quit();
+        }
     }
 }
 
@@ -169,6 +177,10 @@ void check_for_special_event(bool *exit, app_config_struct_t *config) {
     }
 }
 
+bool wait_for_event(int timeout_millis) {
+    return SDL_WaitEventTimeout(NULL, timeout_millis) == 1;
+}
+
 char *get_root_folder_for_configuration() {
     return get_curr_folder();
 }
@@ -177,12 +177,20 @@ void clean(int mode) {
         glfwTerminate();
         socketExit();
     }
+    if (mode == EXITING) {
+        jzintv_warm_release();
+    }
 }
 
 void check_for_special_event(bool *exit, app_config_struct_t* config) {
     *exit = glfwWindowShouldClose(window);
 }
 
+// Joypads are polled here, not evented, so waiting would only delay them
+bool wait_for_event(int timeout_millis) {
+    return true;
+}
+
 char *get_root_folder_for_configuration() {
     return get_curr_folder();
 }
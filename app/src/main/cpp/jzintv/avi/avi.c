@@ -13,6 +13,8 @@
 //   -- Border color and border region
 //   -- Selectable compression
 //   -- Slight code and data restructuring
+//   -- Encoding moved to a worker thread fed by a bounded frame queue
+//   -- Motion search at the native 160-pixel width, with SIMD kernels
 
 //  ZMBV specs from http://wiki.multimedia.cx/?title=DosBox_Capture_Codec
 
@@ -21,10 +23,22 @@
 #include <stdint.h>
 #include "config.h"
 #include "plat/plat_lib.h"
+#include "plat/plat.h"
 #include "zlib/zlib.h"
 #include "gfx/palette.h"
 #include "avi/avi.h"
 
+#if defined(NO_SIMD)
+/* Plain C kernels only */
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define AVI_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define AVI_SIMD_NEON
+#endif
+
 #define APP_TITLE       "jzIntv"
 
 #define AVI_AUDIO_BUF   (65536)
@@ -48,6 +62,19 @@
 #define BLOCK_WIDTH     (16)
 #define BLOCK_HEIGHT    (16)
 
+// The Intellivision's pixels are always doubled horizontally, so we keep
+// frames and do motion search at the native width, and only double pixels
+// when emitting key frames and block deltas.
+#define NAT_DIM_X       (AVI_DIM_X / 2)
+#define NAT_BORD_X_SZ   (AVI_BORD_X_SZ / 2)
+#define NAT_INPUT_X     (INPUT_DIM_X / 2)
+#define NAT_BLOCK_WIDTH (BLOCK_WIDTH / 2)
+
+// Frames and audio handed to the encoder thread.  Roughly 4 seconds of
+// video at the default audio buffer size.
+#define AVI_QUEUE_SLOTS (256)
+#define AVI_QUEUE_AUDIO (4096)
+
 #define NUM_X_BLOCK     (AVI_DIM_X / BLOCK_WIDTH)
 #define NUM_Y_BLOCK     (AVI_DIM_Y / BLOCK_HEIGHT)
 
@@ -61,9 +88,9 @@
 
 #define STRUCT_ALIGN (64)
 
-static double avi_time_scale         = 1.0;
-static double audio_time_scale       = 1.0;
-static double audio_time_scale_ratio = 1.0;
+static THREAD_LOCAL double avi_time_scale         = 1.0;
+static THREAD_LOCAL double audio_time_scale       = 1.0;
+static THREAD_LOCAL double audio_time_scale_ratio = 1.0;
 
 
 /* Locations to be patched */
@@ -97,13 +124,20 @@ typedef struct avi_audio_t
 
 typedef struct
 {
-    uint8_t f[AVI_DIM_Y][AVI_DIM_X];
+    uint8_t f[AVI_DIM_Y][NAT_DIM_X];
 } avi_frame_t ALIGN(STRUCT_ALIGN);
 
+typedef struct
+{
+    uint8_t f[AVI_DIM_Y][AVI_DIM_X];
+} avi_wide_frame_t ALIGN(STRUCT_ALIGN);
+
 /* Video buffering */
 typedef struct avi_video_t
 {
     avi_frame_t frame[2];
+    avi_wide_frame_t wide;      /* Pixel-doubled key frame */
+    uint8_t     codec[AVI_FRAME_BYTES + 4096];  /* Vectors + block deltas */
     uint8_t     toggle;
     uint8_t     palette[256][3];
     uint8_t     encode_buf[AVI_VIDEO_BUF_BYTES];
@@ -114,6 +148,32 @@ typedef struct avi_video_t
     double      time_remainder;
 } avi_video_t ALIGN(STRUCT_ALIGN);
 
+/* Work queued up for the encoder thread */
+enum { AVI_Q_VIDEO, AVI_Q_AUDIO };
+
+typedef struct avi_qslot_t
+{
+    int         type;           /* AVI_Q_VIDEO or AVI_Q_AUDIO */
+    int         num_samples;    /* Audio only */
+    uint8_t     border;         /* Video only */
+    union
+    {
+        uint8_t image[NAT_INPUT_X * INPUT_DIM_Y];
+        int16_t audio[AVI_QUEUE_AUDIO];
+    } u;
+} avi_qslot_t;
+
+typedef struct avi_queue_t
+{
+    avi_qslot_t    *slot;
+    uint32_t        wr, rd;     /* Free-running; mod AVI_QUEUE_SLOTS */
+    int             quit;
+    plat_mutex_t   *lock;
+    plat_cond_t    *not_empty;
+    plat_cond_t    *not_full;
+    plat_thread_t  *worker;     /* NULL == encode inline */
+} avi_queue_t;
+
 typedef struct avi_pvt_t
 {
     avi_container_t container;  /* Locations to be patched */
@@ -122,8 +182,14 @@ typedef struct avi_pvt_t
     avi_audio_t     audio;      /* Audio buffering */
     avi_video_t     video;      /* Video buffering */
     z_stream        zstream;    /* ZLib state */
+    avi_queue_t     queue;      /* Hand-off to encoder thread */
 } avi_pvt_t ALIGN(STRUCT_ALIGN);
 
+LOCAL void avi_queue_start(avi_writer_t *const avi);
+LOCAL void avi_submit_audio(const avi_writer_t *const avi,
+                            const int16_t *const audio_data,
+                            const int num_samples);
+
 
 /*
  ** Write a 32 bits code
@@ -318,6 +384,9 @@ int avi_start_video
     info->max_size_audio            = 0;
     info->total_audio               = 0;
     info->compress                  = compress;
+    info->queue_stalls              = 0;
+    info->queue_high_water          = 0;
+    info->audio_padded              = 0;
 
     audio->buffer_read              = audio->buffer;
     audio->buffer_write             = audio->buffer;
@@ -458,6 +527,8 @@ int avi_start_video
             info->compress = 0;
         }
     }
+
+    avi_queue_start(avi);
     return 0;
 }
 
@@ -665,7 +736,7 @@ void avi_record_audio
     const int                 silent
 )
 {
-    if (!avi->pvt || !avi->pvt->riff.file)
+    if (!avi->pvt || !avi->pvt->info.active)
         return;
 
     if (num_samples >= AVI_AUDIO_BUF)
@@ -673,7 +744,7 @@ void avi_record_audio
 
     if (audio_time_scale_ratio == 1.0)
     {
-        avi_record_audio_internal(avi, audio_data, num_samples);
+        avi_submit_audio(avi, audio_data, num_samples);
         return;
     }
 
@@ -695,31 +766,102 @@ void avi_record_audio
     while (audio->time_remainder < 0.0)
     {
         audio->time_remainder += audio_time_scale_ratio * num_samples;
-        avi_record_audio_internal(avi, audio_data, num_samples);
+        avi_submit_audio(avi, audio_data, num_samples);
         if (audio_time_scale_ratio > 1.0)
             break;
     }
 }
 
 
+// All of the block comparisons below work on native-width frames.  Since
+// every native pixel stands for two output pixels, and motion vectors are
+// always even, the results are exactly what a comparison on the doubled
+// frame would produce.
+
+#if defined(AVI_SIMD_SSE2)
+// Load two 8-pixel native block rows into one vector.
+LOCAL INLINE __m128i avi_load_rows(const uint8_t *const row0,
+                                   const uint8_t *const row1)
+{
+    return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)row0),
+                              _mm_loadl_epi64((const __m128i *)row1));
+}
+
+// Horizontal sum of the byte lanes.
+LOCAL INLINE int avi_sum_bytes(const __m128i v)
+{
+    const __m128i sad = _mm_sad_epu8(v, _mm_setzero_si128());
+    return _mm_cvtsi128_si32(sad) + _mm_cvtsi128_si32(_mm_srli_si128(sad, 8));
+}
+#elif defined(AVI_SIMD_NEON)
+LOCAL INLINE uint8x16_t avi_load_rows(const uint8_t *const row0,
+                                      const uint8_t *const row1)
+{
+    return vcombine_u8(vld1_u8(row0), vld1_u8(row1));
+}
+
+LOCAL INLINE int avi_sum_bytes(const uint8x16_t v)
+{
+    const uint64x2_t sum = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(v)));
+    return (int)(vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+}
+#endif
+
 // Compute block difference, decimated by 4x in each direction.
 LOCAL INLINE int block_diff_decim4(const avi_frame_t *const RESTRICT prev,
                                    const avi_frame_t *const RESTRICT curr,
                                    const int px, const int py,
                                    const int cx, const int cy)
 {
-    int x, y, dif = 0;
-
-    assert(px >= 0);    assert(px <= AVI_DIM_X - BLOCK_WIDTH);
+    assert(px >= 0);    assert(px <= NAT_DIM_X - NAT_BLOCK_WIDTH);
     assert(py >= 0);    assert(py <= AVI_DIM_Y - BLOCK_HEIGHT);
-    assert(cx >= 0);    assert(cx <= AVI_DIM_X - BLOCK_WIDTH);
+    assert(cx >= 0);    assert(cx <= NAT_DIM_X - NAT_BLOCK_WIDTH);
     assert(cy >= 0);    assert(cy <= AVI_DIM_Y - BLOCK_HEIGHT);
 
+#if defined(AVI_SIMD_SSE2)
+    // Rows 0, 4, 8, 12; every other native pixel.
+    const __m128i even = _mm_set1_epi16(0x00FF);
+    const __m128i p0 = avi_load_rows(&prev->f[py + 0][px],
+                                     &prev->f[py + 4][px]);
+    const __m128i c0 = avi_load_rows(&curr->f[cy + 0][cx],
+                                     &curr->f[cy + 4][cx]);
+    const __m128i p1 = avi_load_rows(&prev->f[py + 8][px],
+                                     &prev->f[py + 12][px]);
+    const __m128i c1 = avi_load_rows(&curr->f[cy + 8][cx],
+                                     &curr->f[cy + 12][cx]);
+    __m128i same = _mm_setzero_si128();
+
+    same = _mm_sub_epi8(same, _mm_and_si128(_mm_cmpeq_epi8(p0, c0), even));
+    same = _mm_sub_epi8(same, _mm_and_si128(_mm_cmpeq_epi8(p1, c1), even));
+
+    return (16 - avi_sum_bytes(same)) << 4;
+#elif defined(AVI_SIMD_NEON)
+    static const uint8_t even_lanes[16] =
+        { 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0 };
+    const uint8x16_t even = vld1q_u8(even_lanes);
+    const uint8x16_t p0 = avi_load_rows(&prev->f[py + 0][px],
+                                        &prev->f[py + 4][px]);
+    const uint8x16_t c0 = avi_load_rows(&curr->f[cy + 0][cx],
+                                        &curr->f[cy + 4][cx]);
+    const uint8x16_t p1 = avi_load_rows(&prev->f[py + 8][px],
+                                        &prev->f[py + 12][px]);
+    const uint8x16_t c1 = avi_load_rows(&curr->f[cy + 8][cx],
+                                        &curr->f[cy + 12][cx]);
+    uint8x16_t same;
+
+    same = vandq_u8(vceqq_u8(p0, c0), even);
+    same = vaddq_u8(same, vandq_u8(vceqq_u8(p1, c1), even));
+
+    return (16 - avi_sum_bytes(same)) << 4;
+#else
+    int x, y, dif = 0;
+
     for (y = 0; y < BLOCK_HEIGHT; y += 4)
-        for (x = 0; x < BLOCK_WIDTH; x += 4)
+        for (x = 0; x < NAT_BLOCK_WIDTH; x += 2)
             dif += prev->f[py + y][px + x] != curr->f[cy + y][cx + x];
 
     return dif << 4;
+#endif
 }
 
 // Compute block difference across all pixels.
@@ -728,21 +870,53 @@ LOCAL INLINE int block_diff(const avi_frame_t *const RESTRICT prev,
                             const int px, const int py,
                             const int cx, const int cy)
 {
-    int x, y, dif = 0;
+    int y;
 
-    assert(px >= 0);    assert(px <= AVI_DIM_X - BLOCK_WIDTH);
+    assert(px >= 0);    assert(px <= NAT_DIM_X - NAT_BLOCK_WIDTH);
     assert(py >= 0);    assert(py <= AVI_DIM_Y - BLOCK_HEIGHT);
-    assert(cx >= 0);    assert(cx <= AVI_DIM_X - BLOCK_WIDTH);
+    assert(cx >= 0);    assert(cx <= NAT_DIM_X - NAT_BLOCK_WIDTH);
     assert(cy >= 0);    assert(cy <= AVI_DIM_Y - BLOCK_HEIGHT);
 
+#if defined(AVI_SIMD_SSE2)
+    __m128i same = _mm_setzero_si128();
+
+    for (y = 0; y < BLOCK_HEIGHT; y += 2)
+    {
+        const __m128i p = avi_load_rows(&prev->f[py + y][px],
+                                        &prev->f[py + y + 1][px]);
+        const __m128i c = avi_load_rows(&curr->f[cy + y][cx],
+                                        &curr->f[cy + y + 1][cx]);
+        same = _mm_sub_epi8(same, _mm_cmpeq_epi8(p, c));
+    }
+
+    return (NAT_BLOCK_WIDTH * BLOCK_HEIGHT - avi_sum_bytes(same)) * 2;
+#elif defined(AVI_SIMD_NEON)
+    uint8x16_t same = vdupq_n_u8(0);
+
+    for (y = 0; y < BLOCK_HEIGHT; y += 2)
+    {
+        const uint8x16_t p = avi_load_rows(&prev->f[py + y][px],
+                                           &prev->f[py + y + 1][px]);
+        const uint8x16_t c = avi_load_rows(&curr->f[cy + y][cx],
+                                           &curr->f[cy + y + 1][cx]);
+        same = vsubq_u8(same, vceqq_u8(p, c));
+    }
+
+    return (NAT_BLOCK_WIDTH * BLOCK_HEIGHT - avi_sum_bytes(same)) * 2;
+#else
+    int x, dif = 0;
+
     for (y = 0; y < BLOCK_HEIGHT; y++)
-        for (x = 0; x < BLOCK_WIDTH; x++)
+        for (x = 0; x < NAT_BLOCK_WIDTH; x++)
             dif += prev->f[py + y][px + x] != curr->f[cy + y][cx + x];
 
-    return dif;
+    return dif * 2;
+#endif
 }
 
 // Search for the best match for the current block in the previous image.
+// The block's X coordinate is native; the movement table and the vector
+// we return are in output (doubled) pixels.
 LOCAL INLINE int motion_search(const avi_frame_t *const RESTRICT prev,
                                const avi_frame_t *const RESTRICT curr,
                                const int x, const int y,
@@ -755,12 +929,12 @@ LOCAL INLINE int motion_search(const avi_frame_t *const RESTRICT prev,
 
     for (explore = 0; explore < NUM_MOVEMENT; explore++)
     {
-        ex = x + movement[explore][0];
+        ex = x + movement[explore][0] / 2;
         ey = y + movement[explore][1];
 
         /* First see if we're out of bounds */
-        if (ex < 0 || ex > (AVI_DIM_X - BLOCK_WIDTH )) continue;
-        if (ey < 0 || ey > (AVI_DIM_Y - BLOCK_HEIGHT)) continue;
+        if (ex < 0 || ex > (NAT_DIM_X - NAT_BLOCK_WIDTH)) continue;
+        if (ey < 0 || ey > (AVI_DIM_Y - BLOCK_HEIGHT   )) continue;
 
         /* Next see if this is even worth it. */
         dif = block_diff_decim4(prev, curr, ex, ey, x, y);
@@ -785,6 +959,7 @@ LOCAL INLINE int motion_search(const avi_frame_t *const RESTRICT prev,
     return best_dif;
 }
 
+// Emit a block's XOR delta, doubling pixels back out to full width.
 LOCAL INLINE uint8_t *send_block_delta(const avi_frame_t *const RESTRICT prev,
                                        const avi_frame_t *const RESTRICT curr,
                                        const int px, const int py,
@@ -794,8 +969,13 @@ LOCAL INLINE uint8_t *send_block_delta(const avi_frame_t *const RESTRICT prev,
     int x, y, cnt = 0;
 
     for (y = 0; y < BLOCK_HEIGHT; y++)
-        for (x = 0; x < BLOCK_WIDTH; x++)
-            out[cnt++] = prev->f[py + y][px + x] ^ curr->f[cy + y][cx + x];
+        for (x = 0; x < NAT_BLOCK_WIDTH; x++)
+        {
+            const uint8_t d = prev->f[py + y][px + x] ^
+                              curr->f[cy + y][cx + x];
+            out[cnt++] = d;
+            out[cnt++] = d;
+        }
 
     return out + cnt;
 }
@@ -866,6 +1046,21 @@ void avi_set_palette
     }
 }
 
+// Returns non-zero if encoding another frame would overwrite encoded video
+// that the interleaver hasn't written out yet.
+LOCAL INLINE int avi_video_backlogged(const avi_video_t *const video)
+{
+    const uint32_t pending = video->encode_len_wr - video->encode_len_rd;
+    const uint32_t wr = video->encode_buf_wr < AVI_VIDEO_WRAP_THRESH
+                      ? video->encode_buf_wr : 0;
+
+    if (pending >= AVI_VIDEO_BUF_FRAMES)
+        return 1;
+
+    return pending && wr <= video->encode_buf_rd &&
+           wr + AVI_VIDEO_ENCODE_BYTES > video->encode_buf_rd;
+}
+
 // Only encode video frame into video frame circular buffer
 LOCAL void avi_record_video_internal
 (
@@ -876,6 +1071,7 @@ LOCAL void avi_record_video_internal
 {
     avi_pvt_t       *const pvt       = avi->pvt;
     avi_info_t      *const info      = &(pvt->info);
+    avi_riff_t      *const riff      = &(pvt->riff);
     avi_video_t     *const video     = &(pvt->video);
     z_stream        *const zstream   = &(pvt->zstream);
 
@@ -883,7 +1079,6 @@ LOCAL void avi_record_video_internal
     unsigned char *output;
     unsigned char *motion_vecs;
     unsigned char *block_deltas;
-    static unsigned char buffer_codec[AVI_FRAME_BYTES + 4096];
     int x, y;
     int block;
     const int rel_frame = info->total_frames - info->advance_audio_frames;
@@ -899,6 +1094,26 @@ LOCAL void avi_record_video_internal
     while (avi_write_interleaved_stream(avi, 0))
         ;
 
+    // If the audio has fallen so far behind that we'd overrun the encoded
+    // video buffer, pad the audio with silence so the interleaver can
+    // drain some video, rather than abandoning the recording.
+    while (riff->file && avi_video_backlogged(video))
+    {
+        static const int16_t silence[1024] = { 0 };
+        int pad = next_audio_frame_size(info);
+
+        info->audio_padded++;
+        while (pad > 0)
+        {
+            const int chunk = pad < 1024 ? pad : 1024;
+            avi_record_audio_internal(avi, silence, chunk);
+            pad -= chunk;
+        }
+
+        while (avi_write_interleaved_stream(avi, 0))
+            ;
+    }
+
     // Enough room for a full encoded frame?
     if (video->encode_buf_wr < AVI_VIDEO_WRAP_THRESH)
     {
@@ -909,14 +1124,6 @@ LOCAL void avi_record_video_internal
         output = base_output = video->encode_buf;
     }
 
-    // Did we overrun circular buffer?
-    if (video->encode_buf_wr < video->encode_buf_rd &&
-        video->encode_buf_wr + AVI_VIDEO_ENCODE_BYTES > video->encode_buf_rd)
-    {
-        jzp_printf("Video overrun! Closing AVI.");
-        avi_end_video_internal(avi,1);
-    }
-
     video->toggle = !video->toggle;
 
 #if AVI_BORD_X_SZ > 0 || AVI_BORD_Y_SZ > 0
@@ -924,22 +1131,10 @@ LOCAL void avi_record_video_internal
         memset((void*)&(curr->f), border, sizeof(avi_frame_t));
 #endif
 
-    // NOTE: This pixel-doubles horizontally for the Intellivision.
-    // If we want to be more efficient, we would teach the whole encoder
-    // to work in 160x192 and then just double pixels when sending blocks.
+    // Copy the frame in at native width.
     for (y = 0; y < INPUT_DIM_Y; y++)
-    {
-        const uint8_t *RESTRICT vid_row_i = image + y * (INPUT_DIM_X/2);
-        uint8_t *RESTRICT vid_row_o =
-            &(curr->f[y + AVI_BORD_Y_SZ][AVI_BORD_X_SZ]);
-
-        for (x = 0; x < INPUT_DIM_X/2; x++)
-        {
-            uint8_t p = *vid_row_i++;
-            *vid_row_o++ = p;
-            *vid_row_o++ = p;
-        }
-    }
+        memcpy(&(curr->f[y + AVI_BORD_Y_SZ][NAT_BORD_X_SZ]),
+               image + y * NAT_INPUT_X, NAT_INPUT_X);
 
     if (key_frame)
     {
@@ -952,19 +1147,33 @@ LOCAL void avi_record_video_internal
         *output++ = BLOCK_WIDTH;    /* Block width */
         *output++ = BLOCK_HEIGHT;   /* Block height */
 
+        // Key frames go out whole, so pixel-double them here.
+        for (y = 0; y < AVI_DIM_Y; y++)
+        {
+            const uint8_t *RESTRICT vid_row_i = curr->f[y];
+            uint8_t       *RESTRICT vid_row_o = video->wide.f[y];
+
+            for (x = 0; x < NAT_DIM_X; x++)
+            {
+                uint8_t p = *vid_row_i++;
+                *vid_row_o++ = p;
+                *vid_row_o++ = p;
+            }
+        }
+
         const uint32_t remain = AVI_VIDEO_ENCODE_BYTES - (output - base_output);
         output = send_frame(AVI_BPP == 8 ? &video->palette[0][0] : NULL,
-                            (void *)curr->f, AVI_FRAME_BYTES, output, remain,
-                            info->compress, zstream);
+                            (void *)video->wide.f, AVI_FRAME_BYTES, output,
+                            remain, info->compress, zstream);
     } else
     {
         *output++ = 0x00;   /* Non-key frame (+2 = Delta palette) */
-        motion_vecs  = buffer_codec;
+        motion_vecs  = video->codec;
         block_deltas = motion_vecs + NUM_X_BLOCK * NUM_Y_BLOCK * 2;
         block = 0;
         for (y = 0; y < AVI_DIM_Y; y += BLOCK_HEIGHT)
         {
-            for (x = 0; x < AVI_DIM_X; x += BLOCK_WIDTH)
+            for (x = 0; x < NAT_DIM_X; x += NAT_BLOCK_WIDTH)
             {
                 int move_x = 0, move_y = 0;
                 int best_dif = motion_search(prev, curr, x, y,
@@ -978,7 +1187,7 @@ LOCAL void avi_record_video_internal
                     motion_vecs[block++] = move_x * 2 + 1;
                     motion_vecs[block++] = move_y * 2;
                     block_deltas = send_block_delta(prev, curr,
-                                                    x + move_x, y + move_y,
+                                                    x + move_x / 2, y + move_y,
                                                     x, y, block_deltas);
                 }
             }
@@ -987,8 +1196,8 @@ LOCAL void avi_record_video_internal
         assert(block % 4 == 0);
 
         const uint32_t remain = AVI_VIDEO_ENCODE_BYTES - (output - base_output);
-        output = send_frame(NULL, (void *)buffer_codec,
-                            block_deltas - buffer_codec,
+        output = send_frame(NULL, (void *)video->codec,
+                            block_deltas - video->codec,
                             output, remain, info->compress, zstream);
     }
 
@@ -998,6 +1207,186 @@ LOCAL void avi_record_video_internal
     video->encode_buf_wr += length;
 }
 
+/*
+ ** Encoder thread:  Drain the queue in order until told to quit.
+ */
+LOCAL int avi_encode_thread(void *opaque)
+{
+    const avi_writer_t *const avi = (const avi_writer_t *)opaque;
+    avi_queue_t *const queue = &(avi->pvt->queue);
+
+    for (;;)
+    {
+        plat_mutex_lock(queue->lock);
+        while (queue->rd == queue->wr && !queue->quit)
+            plat_cond_wait(queue->not_empty, queue->lock);
+
+        if (queue->rd == queue->wr)     /* quit, and nothing left to do */
+        {
+            plat_mutex_unlock(queue->lock);
+            break;
+        }
+        plat_mutex_unlock(queue->lock);
+
+        const avi_qslot_t *const slot =
+            &(queue->slot[queue->rd % AVI_QUEUE_SLOTS]);
+
+        if (slot->type == AVI_Q_VIDEO)
+            avi_record_video_internal(avi, slot->u.image, slot->border);
+        else
+            avi_record_audio_internal(avi, slot->u.audio, slot->num_samples);
+
+        plat_mutex_lock(queue->lock);
+        queue->rd++;
+        plat_cond_signal(queue->not_full);
+        plat_mutex_unlock(queue->lock);
+    }
+
+    return 0;
+}
+
+/*
+ ** Tear down the encoder queue.  If the thread's running, it finishes
+ ** everything already queued before exiting.
+ */
+LOCAL void avi_queue_stop(const avi_writer_t *const avi)
+{
+    avi_queue_t *const queue = &(avi->pvt->queue);
+
+    if (queue->worker)
+    {
+        plat_mutex_lock(queue->lock);
+        queue->quit = 1;
+        plat_cond_signal(queue->not_empty);
+        plat_mutex_unlock(queue->lock);
+        plat_thread_join(queue->worker);
+        queue->worker = NULL;
+    }
+
+    plat_cond_destroy(queue->not_full);
+    plat_cond_destroy(queue->not_empty);
+    plat_mutex_destroy(queue->lock);
+    CONDFREE(queue->slot);
+
+    queue->not_full  = NULL;
+    queue->not_empty = NULL;
+    queue->lock      = NULL;
+}
+
+/*
+ ** Start the encoder thread.  If we can't, we just encode inline.
+ */
+LOCAL void avi_queue_start(avi_writer_t *const avi)
+{
+    avi_queue_t *const queue = &(avi->pvt->queue);
+
+    queue->wr = queue->rd = 0;
+    queue->quit      = 0;
+    queue->slot      = CALLOC(avi_qslot_t, AVI_QUEUE_SLOTS);
+    queue->lock      = plat_mutex_create();
+    queue->not_empty = plat_cond_create();
+    queue->not_full  = plat_cond_create();
+
+    if (queue->slot && queue->lock && queue->not_empty && queue->not_full)
+        queue->worker = plat_thread_create(avi_encode_thread, "jzintv AVI",
+                                           (void *)avi);
+
+    if (!queue->worker)
+        avi_queue_stop(avi);
+}
+
+/*
+ ** Grab the next free queue slot, waiting for the encoder if we must.
+ ** Returns NULL if there's no encoder thread.
+ */
+LOCAL avi_qslot_t *avi_queue_get_slot(const avi_writer_t *const avi)
+{
+    avi_info_t  *const info  = &(avi->pvt->info);
+    avi_queue_t *const queue = &(avi->pvt->queue);
+
+    if (!queue->worker)
+        return NULL;
+
+    plat_mutex_lock(queue->lock);
+    if (queue->wr - queue->rd >= AVI_QUEUE_SLOTS)
+    {
+        info->queue_stalls++;
+        while (queue->wr - queue->rd >= AVI_QUEUE_SLOTS)
+            plat_cond_wait(queue->not_full, queue->lock);
+    }
+    if (info->queue_high_water < queue->wr - queue->rd + 1)
+        info->queue_high_water = queue->wr - queue->rd + 1;
+    plat_mutex_unlock(queue->lock);
+
+    return &(queue->slot[queue->wr % AVI_QUEUE_SLOTS]);
+}
+
+LOCAL void avi_queue_put_slot(const avi_writer_t *const avi)
+{
+    avi_queue_t *const queue = &(avi->pvt->queue);
+
+    plat_mutex_lock(queue->lock);
+    queue->wr++;
+    plat_cond_signal(queue->not_empty);
+    plat_mutex_unlock(queue->lock);
+}
+
+/*
+ ** Hand a frame of video to the encoder.
+ */
+LOCAL void avi_submit_video
+(
+    const avi_writer_t *const avi,
+    const uint8_t      *const image,
+    const uint8_t             border
+)
+{
+    avi_qslot_t *const slot = avi_queue_get_slot(avi);
+
+    if (!slot)
+    {
+        avi_record_video_internal(avi, image, border);
+        return;
+    }
+
+    slot->type   = AVI_Q_VIDEO;
+    slot->border = border;
+    memcpy(slot->u.image, image, sizeof(slot->u.image));
+    avi_queue_put_slot(avi);
+}
+
+/*
+ ** Hand audio to the encoder, in chunks that fit a queue slot.
+ */
+LOCAL void avi_submit_audio
+(
+    const avi_writer_t *const avi,
+    const int16_t      *const audio_data,
+    const int                 num_samples
+)
+{
+    int done = 0;
+
+    while (done < num_samples)
+    {
+        const int remain = num_samples - done;
+        const int chunk  = remain < AVI_QUEUE_AUDIO ? remain : AVI_QUEUE_AUDIO;
+        avi_qslot_t *const slot = avi_queue_get_slot(avi);
+
+        if (!slot)
+        {
+            avi_record_audio_internal(avi, audio_data + done, chunk);
+        } else
+        {
+            slot->type        = AVI_Q_AUDIO;
+            slot->num_samples = chunk;
+            memcpy(slot->u.audio, audio_data + done, chunk * sizeof(int16_t));
+            avi_queue_put_slot(avi);
+        }
+        done += chunk;
+    }
+}
+
 void avi_record_video
 (
     const avi_writer_t *const avi,
@@ -1010,7 +1399,7 @@ void avi_record_video
 
     if (avi_time_scale == 1.0)
     {
-        avi_record_video_internal(avi, image, border);
+        avi_submit_video(avi, image, border);
         return;
     }
 
@@ -1021,7 +1410,7 @@ void avi_record_video
     while (video->time_remainder < 0.0)
     {
         video->time_remainder += avi_time_scale;
-        avi_record_video_internal(avi, image, border);
+        avi_submit_video(avi, image, border);
     }
 }
 
@@ -1096,7 +1485,10 @@ LOCAL void avi_end_video_internal
 void avi_end_video( const avi_writer_t *const avi )
 {
     if (avi->pvt && avi->pvt->info.active)
+    {
+        avi_queue_stop( avi );
         avi_end_video_internal( avi, 0 );
+    }
 }
 
 int avi_is_active( const avi_writer_t *const avi )
@@ -1120,6 +1512,6 @@ void avi_set_time_scale( const double avi_time_scale_,
     avi_time_scale         = avi_time_scale_ > 0.01 ? avi_time_scale_ : 1.0;
     audio_time_scale       = incoming_audio_time_scale;
     audio_time_scale_ratio = avi_time_scale / incoming_audio_time_scale;
-    printf("AVI: %5.3f %5.3f %5.3f\n", avi_time_scale, audio_time_scale,
+    jzp_printf("AVI: %5.3f %5.3f %5.3f\n", avi_time_scale, audio_time_scale,
            audio_time_scale_ratio);
 }
@@ -21,6 +21,9 @@ typedef struct avi_info_t
     int     total_frames;
     int     key_frames;
     int     compress;
+    uint32_t queue_stalls;      /* Times emulation waited on the encoder */
+    uint32_t queue_high_water;  /* Most slots ever queued for encoding   */
+    uint32_t audio_padded;      /* Frames of silence inserted to catch up */
 } avi_info_t;
 
 typedef struct avi_writer_t
@@ -321,7 +321,7 @@ void ay8910_write
 #if 0
         if (1 & ((data >> 4) ^ (data >> 5)))
         {
-            extern int debug_fault_detected;
+            extern THREAD_LOCAL int debug_fault_detected;
             int per, chan = (addr & 0xF) - 11;
             per = ay8910->reg[chan] | (ay8910->reg[chan+4]<<8);
             fprintf(stderr, "Warning: %.4X written to AY8910[%.1X], per=%.4X %c%c\n",
@@ -0,0 +1,607 @@
+/*
+ * ============================================================================
+ *  Title:    Batch Runner
+ * ============================================================================
+ *  jzintv-batch runs a list of games headless, unthrottled, for a fixed
+ *  number of frames each, on a pool of worker threads.  It checks each
+ *  run against the frame and audio hashes it's expected to produce, and
+ *  writes a JSON or CSV report with what each job did and how fast.
+ *
+ *  The manifest has one job per line.  '#' starts a comment.  A job is a
+ *  list of words separated by spaces:
+ *
+ *      rom=path        Game to run.  A .cfg next to a .bin goes with it.
+ *      frames=#        Frames to run it for.
+ *      video=XXXXXXXX  Expected CRC32 of those frames, in hex.  Optional.
+ *      audio=XXXXXXXX  Expected CRC32 of the audio, in hex.  Optional.
+ *      input=path      Input log to replay (--replay-input).  Optional.
+ *      -x, --xxx=yyy   Any other jzIntv flag, for this job only.
+ *
+ *  Flags after the manifest on the command line go to every job.  Each
+ *  worker runs one jzIntv instance at a time (see jzintv_run), so a job
+ *  costs a machine setup, not a process.
+ *
+ *  A job passes if it ran all its frames without a fault, exited cleanly
+ *  and its hashes match.  A job without expected hashes passes on the
+ *  first two alone; its report entry gives the hashes to expect.
+ * ============================================================================
+ */
+
+#include "config.h"
+#include "launch.h"
+#include "plat/plat.h"
+#include "debug/debug_if.h"
+
+#if defined(PLAT_LINUX) || defined(PLAT_MACOS)
+# include <unistd.h>
+# include <sys/resource.h>
+#endif
+
+#define BATCH_MAX_WORKERS   (256)
+
+typedef struct batch_job_t
+{
+    /* From the manifest */
+    int             line;           /* Manifest line, for messages.         */
+    char           *rom;            /* Game image.                          */
+    char           *input;          /* Input log to replay, or NULL.        */
+    uint32_t        frames;         /* Frames to run.                       */
+    uint32_t        exp_vid;        /* Expected frame hash, if chk_vid.     */
+    uint32_t        exp_snd;        /* Expected audio hash, if chk_snd.     */
+    bool            chk_vid, chk_snd;
+    int             argc;           /* Extra jzIntv flags for this job.     */
+    char          **argv;
+
+    /* Results */
+    const char     *status;         /* pass, fault, mismatch, short, error  */
+    int             rc;             /* jzIntv's return code.                */
+    jzintv_stats_t  stats;
+    double          wall_ms;        /* Whole job, setup included.           */
+    long            peak_rss_kb;    /* Process high-water mark at the end.  */
+} batch_job_t;
+
+typedef struct batch_t
+{
+    batch_job_t    *job;
+    int             num_jobs;
+    int             next;           /* Next job to hand out.                */
+    int             done;           /* Jobs finished, for progress.         */
+    int             failed;
+    int             argc;           /* Flags for every job.                 */
+    char          **argv;
+    plat_mutex_t   *lock;           /* Guards next/done/failed.             */
+} batch_t;
+
+/* ======================================================================== */
+/*  USAGE            -- Just give usage info and exit.                      */
+/* ======================================================================== */
+LOCAL void usage(void)
+{
+    fprintf(stderr,
+"Usage: jzintv-batch [-j #] [-o report] [-f json|csv] manifest [flags...]"  "\n"
+                                                                            "\n"
+"    -j #         Run # jobs at once.  Default is one per CPU."             "\n"
+"    -o report    Write the report here instead of to stdout."              "\n"
+"    -f fmt       Report format, 'json' or 'csv'.  Default is 'csv' if the" "\n"
+"                 report's name ends in .csv, and 'json' otherwise."        "\n"
+"    flags        jzIntv flags for every job, such as -e, -g and -p."       "\n"
+                                                                            "\n"
+"Each line of the manifest is a job:"                                       "\n"
+                                                                            "\n"
+"    rom=path frames=# [video=hash] [audio=hash] [input=path] [flags...]"   "\n"
+                                                                            "\n"
+"Exits with 0 if every job passed, 1 if any didn't, and 2 if it couldn't"   "\n"
+"read the manifest."                                                        "\n"
+    );
+    exit(2);
+}
+
+/* ======================================================================== */
+/*  BATCH_CPU_COUNT  -- How many jobs to run at once by default.            */
+/*  BATCH_PEAK_RSS   -- The process's peak resident set, in kB, or -1.      */
+/* ======================================================================== */
+LOCAL int batch_cpu_count(void)
+{
+#if defined(PLAT_LINUX) || defined(PLAT_MACOS)
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+#else
+    return 1;
+#endif
+}
+
+LOCAL long batch_peak_rss(void)
+{
+#if defined(PLAT_LINUX) || defined(PLAT_MACOS)
+    struct rusage ru;
+
+    if (getrusage(RUSAGE_SELF, &ru))
+        return -1;
+# ifdef PLAT_MACOS
+    return ru.ru_maxrss / 1024;     /* macOS reports bytes.                 */
+# else
+    return ru.ru_maxrss;
+# endif
+#else
+    return -1;
+#endif
+}
+
+/* ======================================================================== */
+/*  BATCH_PARSE_HASH -- Parse an 8-digit hex hash.  Returns 0 on success.   */
+/* ======================================================================== */
+LOCAL int batch_parse_hash(const char *const s, uint32_t *const hash)
+{
+    char *end;
+    const unsigned long v = strtoul(s, &end, 16);
+
+    if (!*s || *end || v > 0xFFFFFFFFul)
+        return -1;
+
+    *hash = v;
+    return 0;
+}
+
+/* ======================================================================== */
+/*  BATCH_ADD_WORD   -- Add one word of a manifest line to its job.         */
+/*                      Returns 0 on success.                               */
+/* ======================================================================== */
+LOCAL int batch_add_word(batch_job_t *const job, char *const word)
+{
+    char *const val = strchr(word, '=');
+
+    if (word[0] == '-')
+    {
+        char **const argv = (char **)realloc(job->argv,
+                                             (job->argc + 1) * sizeof(char*));
+        if (!argv)
+            return -1;
+        job->argv = argv;
+        job->argv[job->argc++] = strdup(word);
+        return 0;
+    }
+
+    if (!val)
+        return -1;
+
+    *val = 0;
+    if (!strcmp(word, "rom"))    { job->rom   = strdup(val + 1); return 0; }
+    if (!strcmp(word, "input"))  { job->input = strdup(val + 1); return 0; }
+    if (!strcmp(word, "frames"))
+    {
+        const int frames = atoi(val + 1);
+        job->frames = frames > 0 ? frames : 0;
+        return frames > 0 ? 0 : -1;
+    }
+    if (!strcmp(word, "video"))
+        return (job->chk_vid = !batch_parse_hash(val + 1, &job->exp_vid))
+               ? 0 : -1;
+    if (!strcmp(word, "audio"))
+        return (job->chk_snd = !batch_parse_hash(val + 1, &job->exp_snd))
+               ? 0 : -1;
+
+    *val = '=';
+    return -1;
+}
+
+/* ======================================================================== */
+/*  BATCH_READ_MANIFEST -- Read all the jobs.  Returns 0 on success.        */
+/* ======================================================================== */
+LOCAL int batch_read_manifest(batch_t *const batch, const char *const fname)
+{
+    FILE *const f = fopen(fname, "r");
+    char buf[4096];
+    int line = 0;
+
+    if (!f)
+    {
+        perror("fopen()");
+        fprintf(stderr, "jzintv-batch: Unable to open manifest %s\n", fname);
+        return -1;
+    }
+
+    while (fgets(buf, sizeof(buf), f))
+    {
+        batch_job_t *job;
+        char *s, *word;
+
+        line++;
+        if ((s = strchr(buf, '#')) != NULL)
+            *s = 0;
+        if (!(word = strtok(buf, " \t\r\n")))
+            continue;
+
+        job = (batch_job_t *)realloc(batch->job,
+                                     (batch->num_jobs + 1) * sizeof(*job));
+        if (!job)
+            goto oom;
+        batch->job = job;
+        job = &batch->job[batch->num_jobs++];
+        memset(job, 0, sizeof(*job));
+        job->line = line;
+
+        for (; word; word = strtok(NULL, " \t\r\n"))
+        {
+            if (batch_add_word(job, word))
+            {
+                fprintf(stderr, "jzintv-batch: %s:%d: Can't make sense of "
+                        "'%s'\n", fname, line, word);
+                fclose(f);
+                return -1;
+            }
+        }
+
+        if (!job->rom || !job->frames)
+        {
+            fprintf(stderr, "jzintv-batch: %s:%d: A job needs rom= and "
+                    "frames=\n", fname, line);
+            fclose(f);
+            return -1;
+        }
+    }
+
+    fclose(f);
+    return 0;
+
+oom:
+    fprintf(stderr, "jzintv-batch: Out of memory\n");
+    fclose(f);
+    return -1;
+}
+
+/* ======================================================================== */
+/*  BATCH_READABLE   -- jzIntv exits the whole process on some missing      */
+/*                      files, so check the ones we know about first.       */
+/* ======================================================================== */
+LOCAL bool batch_readable(const char *const fname)
+{
+    FILE *const f = fopen(fname, "rb");
+
+    if (f)
+        fclose(f);
+    return f != NULL;
+}
+
+/* ======================================================================== */
+/*  BATCH_RUN_JOB    -- Run one job on this thread and judge it.            */
+/* ======================================================================== */
+LOCAL void batch_run_job(const batch_t *const batch, batch_job_t *const job)
+{
+    char max_frames[32];
+    char **argv;
+    char *replay = NULL;
+    int argc = 0, i;
+    double start;
+
+    if (!batch_readable(job->rom) ||
+        (job->input && !batch_readable(job->input)))
+    {
+        job->status = "error";
+        job->rc     = -1;
+        return;
+    }
+
+    argv = CALLOC(char *, 5 + batch->argc + job->argc + 1);
+    if (job->input)
+        replay = CALLOC(char, strlen(job->input) + 16);
+    if (!argv || (job->input && !replay))
+    {
+        CONDFREE(argv);
+        CONDFREE(replay);
+        job->status = "error";
+        job->rc     = -1;
+        return;
+    }
+
+    snprintf(max_frames, sizeof(max_frames), "--max-frames=%u", job->frames);
+
+    argv[argc++] = (char *)"jzintv";
+    argv[argc++] = (char *)"-q";
+    argv[argc++] = max_frames;
+    if (replay)
+    {
+        sprintf(replay, "--replay-input=%s", job->input);
+        argv[argc++] = replay;
+    }
+    for (i = 0; i < batch->argc; i++)
+        argv[argc++] = batch->argv[i];
+    for (i = 0; i < job->argc; i++)
+        argv[argc++] = job->argv[i];
+    argv[argc++] = job->rom;
+    argv[argc]   = NULL;
+
+    start = get_time();
+    job->rc = jzintv_entry_point(argc, argv);
+    job->wall_ms = (get_time() - start) * 1000.;
+    job->peak_rss_kb = batch_peak_rss();
+    jzintv_last_stats(&job->stats);
+
+    free(argv);
+    CONDFREE(replay);
+
+    if (job->stats.fault)
+        job->status = "fault";
+    else if (job->stats.frames == 0 || job->rc != 0)
+        job->status = "error";
+    else if (job->stats.frames < job->frames)
+        job->status = "short";
+    else if ((job->chk_vid && job->stats.vid_hash != job->exp_vid) ||
+             (job->chk_snd && job->stats.snd_hash != job->exp_snd))
+        job->status = "mismatch";
+    else
+        job->status = "pass";
+}
+
+/* ======================================================================== */
+/*  BATCH_FAULT_NAME -- Name a DEBUG_xxx fault code for the report.         */
+/*  BATCH_MIPS       -- Emulated instructions per second, in millions.      */
+/* ======================================================================== */
+LOCAL const char *batch_fault_name(const int fault)
+{
+    switch (fault)
+    {
+        case DEBUG_NO_FAULT:    return "none";
+        case DEBUG_CRASHING:    return "crash";
+        case DEBUG_HLT_INSTR:   return "halt";
+        case DEBUG_ASYNC_HALT:  return "async_halt";
+        default:                return "unknown";
+    }
+}
+
+LOCAL double batch_mips(const batch_job_t *const job)
+{
+    return job->stats.run_ms > 0
+         ? job->stats.instrs / job->stats.run_ms / 1000. : 0.;
+}
+
+/* ======================================================================== */
+/*  BATCH_WORKER     -- Take jobs until there are none left.                */
+/* ======================================================================== */
+LOCAL int batch_worker(void *const opaque)
+{
+    batch_t *const batch = (batch_t *)opaque;
+
+    for (;;)
+    {
+        batch_job_t *job;
+
+        plat_mutex_lock(batch->lock);
+        job = batch->next < batch->num_jobs ? &batch->job[batch->next++]
+                                            : NULL;
+        plat_mutex_unlock(batch->lock);
+
+        if (!job)
+            return 0;
+
+        batch_run_job(batch, job);
+
+        plat_mutex_lock(batch->lock);
+        batch->done++;
+        if (strcmp(job->status, "pass"))
+            batch->failed++;
+        fprintf(stderr, "[%d/%d] %-8s %s  %.2f MIPS\n",
+                batch->done, batch->num_jobs, job->status, job->rom,
+                batch_mips(job));
+        plat_mutex_unlock(batch->lock);
+    }
+}
+
+/* ======================================================================== */
+/*  BATCH_PUT_STR    -- Write a string as a JSON or CSV string.             */
+/* ======================================================================== */
+LOCAL void batch_put_str(FILE *const f, const char *s, const bool json)
+{
+    putc('"', f);
+    for (; *s; s++)
+    {
+        if (json && (*s == '"' || *s == '\\'))
+            fprintf(f, "\\%c", *s);
+        else if (json && (unsigned char)*s < 0x20)
+            fprintf(f, "\\u%.4X", *s);
+        else if (!json && *s == '"')
+            fputs("\"\"", f);
+        else
+            putc(*s, f);
+    }
+    putc('"', f);
+}
+
+/* ======================================================================== */
+/*  BATCH_REPORT_JSON / BATCH_REPORT_CSV -- Write the report.               */
+/* ======================================================================== */
+LOCAL void batch_report_json(FILE *const f, const batch_t *const batch,
+                             const int workers, const double wall_ms)
+{
+    int i;
+
+    fprintf(f, "{\n  \"jobs\": [\n");
+    for (i = 0; i < batch->num_jobs; i++)
+    {
+        const batch_job_t *const job = &batch->job[i];
+
+        fprintf(f, "    {\"rom\": ");
+        batch_put_str(f, job->rom, true);
+        fprintf(f, ", \"line\": %d, \"status\": \"%s\", \"exit_code\": %d, "
+                   "\"fault\": \"%s\",\n", job->line, job->status, job->rc,
+                   batch_fault_name(job->stats.fault));
+        fprintf(f, "     \"frames\": %u, \"cycles\": %" U64_FMT ", "
+                   "\"instructions\": %" U64_FMT ",\n",
+                   job->stats.frames, job->stats.cycles, job->stats.instrs);
+        fprintf(f, "     \"wall_ms\": %.1f, \"run_ms\": %.1f, "
+                   "\"mips\": %.3f, \"peak_rss_kb\": %ld,\n",
+                   job->wall_ms, job->stats.run_ms, batch_mips(job),
+                   job->peak_rss_kb);
+        fprintf(f, "     \"video_hash\": \"%.8X\", \"audio_hash\": \"%.8X\"",
+                   job->stats.vid_hash, job->stats.snd_hash);
+        if (job->chk_vid)
+            fprintf(f, ", \"video_expected\": \"%.8X\"", job->exp_vid);
+        if (job->chk_snd)
+            fprintf(f, ", \"audio_expected\": \"%.8X\"", job->exp_snd);
+        fprintf(f, "}%s\n", i + 1 < batch->num_jobs ? "," : "");
+    }
+    fprintf(f, "  ],\n  \"summary\": {\"jobs\": %d, \"passed\": %d, "
+               "\"failed\": %d, \"workers\": %d, \"wall_ms\": %.1f}\n}\n",
+               batch->num_jobs, batch->num_jobs - batch->failed,
+               batch->failed, workers, wall_ms);
+}
+
+LOCAL void batch_report_csv(FILE *const f, const batch_t *const batch)
+{
+    int i;
+
+    fprintf(f, "rom,line,status,exit_code,fault,frames,cycles,instructions,"
+               "wall_ms,run_ms,mips,peak_rss_kb,video_hash,audio_hash,"
+               "video_expected,audio_expected\n");
+    for (i = 0; i < batch->num_jobs; i++)
+    {
+        const batch_job_t *const job = &batch->job[i];
+
+        batch_put_str(f, job->rom, false);
+        fprintf(f, ",%d,%s,%d,%s,%u,%" U64_FMT ",%" U64_FMT ","
+                   "%.1f,%.1f,%.3f,%ld,%.8X,%.8X,",
+                job->line, job->status, job->rc,
+                batch_fault_name(job->stats.fault), job->stats.frames,
+                job->stats.cycles, job->stats.instrs, job->wall_ms,
+                job->stats.run_ms, batch_mips(job), job->peak_rss_kb,
+                job->stats.vid_hash, job->stats.snd_hash);
+        if (job->chk_vid) fprintf(f, "%.8X", job->exp_vid);
+        putc(',', f);
+        if (job->chk_snd) fprintf(f, "%.8X", job->exp_snd);
+        putc('\n', f);
+    }
+}
+
+/* ======================================================================== */
+/*  MAIN             -- Read the manifest, run the jobs, report.            */
+/* ======================================================================== */
+int main(int argc, char *argv[])
+{
+    plat_thread_t *thread[BATCH_MAX_WORKERS];
+    batch_t batch;
+    const char *manifest = NULL, *report = NULL, *fmt = NULL;
+    int workers = 0, started = 0, i;
+    bool csv;
+    double start;
+    FILE *f;
+
+    memset(&batch, 0, sizeof(batch));
+
+    for (i = 1; i < argc && !manifest; i++)
+    {
+        const char *val = NULL;
+        char opt = 0;
+
+        /* ---------------------------------------------------------------- */
+        /*  Options take their value either attached (-j4) or next (-j 4).  */
+        /* ---------------------------------------------------------------- */
+        if (argv[i][0] == '-' && strchr("jof", argv[i][1]) && argv[i][1])
+        {
+            opt = argv[i][1];
+            if      (argv[i][2]) val = argv[i] + 2;
+            else if (i + 1 < argc) val = argv[++i];
+            else usage();
+        }
+
+        if      (opt == 'j')         workers  = atoi(val);
+        else if (opt == 'o')         report   = val;
+        else if (opt == 'f')         fmt      = val;
+        else if (argv[i][0] != '-')  manifest = argv[i];
+        else                         usage();
+    }
+
+    if (!manifest)
+        usage();
+
+    batch.argc = argc - i;
+    batch.argv = argv + i;
+
+    csv = fmt ? !strcmp(fmt, "csv")
+              : report && strlen(report) > 4 &&
+                !stricmp(report + strlen(report) - 4, ".csv");
+    if (fmt && !csv && strcmp(fmt, "json"))
+        usage();
+
+    if (batch_read_manifest(&batch, manifest))
+        exit(2);
+
+    if (workers <= 0)
+        workers = batch_cpu_count();
+    if (workers > batch.num_jobs)
+        workers = batch.num_jobs;
+    if (workers > BATCH_MAX_WORKERS)
+        workers = BATCH_MAX_WORKERS;
+
+    /* -------------------------------------------------------------------- */
+    /*  Run the jobs.  Without threads, this thread does them all.          */
+    /* -------------------------------------------------------------------- */
+    start = get_time();
+    batch.lock = plat_mutex_create();
+
+    for (i = 0; i < workers; i++)
+        if ((thread[started] = plat_thread_create(batch_worker, "batch",
+                                                  &batch)) != NULL)
+            started++;
+
+    if (!started)
+        batch_worker(&batch);
+
+    for (i = 0; i < started; i++)
+        plat_thread_join(thread[i]);
+
+    plat_mutex_destroy(batch.lock);
+
+    /* -------------------------------------------------------------------- */
+    /*  Write the report.                                                   */
+    /* -------------------------------------------------------------------- */
+    if (!report)
+        f = stdout;
+    else if (!(f = fopen(report, "w")))
+    {
+        perror("fopen()");
+        fprintf(stderr, "jzintv-batch: Unable to open %s for writing\n",
+                report);
+        exit(2);
+    }
+
+    if (csv)
+        batch_report_csv(f, &batch);
+    else
+        batch_report_json(f, &batch, started ? started : 1,
+                          (get_time() - start) * 1000.);
+
+    if (f != stdout)
+        fclose(f);
+
+    for (i = 0; i < batch.num_jobs; i++)
+    {
+        batch_job_t *const job = &batch.job[i];
+
+        while (job->argc > 0)
+            free(job->argv[--job->argc]);
+        CONDFREE(job->argv);
+        CONDFREE(job->rom);
+        CONDFREE(job->input);
+    }
+    CONDFREE(batch.job);
+
+    fprintf(stderr, "jzintv-batch: %d of %d jobs passed in %.1f s\n",
+            batch.num_jobs - batch.failed, batch.num_jobs,
+            get_time() - start);
+
+    return batch.failed ? 1 : 0;
+}
+
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
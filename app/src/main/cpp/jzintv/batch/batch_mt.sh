@@ -0,0 +1,53 @@
+#!/bin/sh
+# Check that jzIntv instances on separate threads don't disturb each other.
+# Runs a jzintv-batch manifest one job at a time, then every job at once,
+# for a few rounds.  Passes if every job passes every round -- each ran to
+# its expected frame and audio hashes -- and the reports agree on them.
+#
+#   batch_mt.sh jzintv-batch [manifest [rounds]] [-- flags...]
+#
+# The default manifest is batch/smoke.txt, run from the jzintv source
+# directory with the EXEC, GROM and ECS images in emscripten/.  The tree
+# only has one game, so point it at a manifest of your own ROMs, with
+# their expected hashes, to cover more of them.
+
+BATCH=${1:?usage: $0 jzintv-batch [manifest [rounds]] [-- flags...]}
+shift
+MANIFEST=batch/smoke.txt
+ROUNDS=3
+[ $# -gt 0 ] && [ "$1" != "--" ] && { MANIFEST=$1 ; shift ; }
+[ $# -gt 0 ] && [ "$1" != "--" ] && { ROUNDS=$1 ; shift ; }
+[ $# -gt 0 ] && [ "$1" = "--" ] && shift
+[ $# -eq 0 ] && set -- -e emscripten/miniexec.bin -g emscripten/minigrom.bin \
+                       -E emscripten/fake_ecs.bin
+
+JOBS=$(grep -c '^[[:space:]]*rom=' "$MANIFEST")
+OUT=${TMPDIR:-/tmp}/batch_mt.$$
+
+SDL_VIDEODRIVER=dummy
+SDL_AUDIODRIVER=dummy
+export SDL_VIDEODRIVER SDL_AUDIODRIVER
+
+# Keep the job, its status and its hashes; drop the timings.
+hashes() {
+    cut -d, -f1-3,13-14 "$1"
+}
+
+STATUS=0
+"$BATCH" -j 1 -f csv -o "$OUT.ref" "$MANIFEST" -q "$@" > "$OUT.log" 2>&1 \
+    || STATUS=1
+hashes "$OUT.ref" > "$OUT.ref.h"
+
+R=1
+while [ $R -le "$ROUNDS" ] ; do
+    "$BATCH" -j "$JOBS" -f csv -o "$OUT.$R" "$MANIFEST" -q "$@" \
+        >> "$OUT.log" 2>&1 || STATUS=1
+    hashes "$OUT.$R" | cmp -s - "$OUT.ref.h" || STATUS=1
+    R=$((R + 1))
+done
+
+echo "$JOBS jobs, 1 at a time, then $JOBS at once x $ROUNDS:"
+cat "$OUT.ref.h"
+if [ $STATUS -eq 0 ] ; then echo "PASS" ; else echo "FAIL (see $OUT.*)" ; fi
+[ $STATUS -eq 0 ] && rm -f "$OUT".*
+exit $STATUS
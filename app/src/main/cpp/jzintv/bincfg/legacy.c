@@ -21,7 +21,7 @@
 #include "bincfg.h"
 #include "legacy.h"
 
-extern int jlp_accel_on;
+extern THREAD_LOCAL int jlp_accel_on;
 
 /* ======================================================================== */
 /*  LEGACY_READ -- read from a legacy BIN+CFG.                              */
@@ -36,7 +36,8 @@ uint32_t legacy_read (periph_t *per, periph_t *ign,
     UNUSED(data);
 
     // Disallow reads to flat memory if JLP RAM / accelerators are on.
-    if (jlp_accel_on && addr >= 0x8000 && addr <= 0x9FFF)
+    // (Range first:  the flag is thread-local, and not free to look at.)
+    if (addr >= 0x8000 && addr <= 0x9FFF && jlp_accel_on)
         return ~0U;
 
     // Disallow reads if range isn't marked readable.
@@ -60,7 +61,7 @@ void  legacy_write(periph_t *per, periph_t *ign, uint32_t addr, uint32_t data)
     UNUSED(data);
 
     // Disallow writes to flat memory if JLP RAM / accelerators are on.
-    if (jlp_accel_on && addr >= 0x8000 && addr < 0x9FFF) return;
+    if (addr >= 0x8000 && addr < 0x9FFF && jlp_accel_on) return;
 
     // Disallow writes if range isn't marked writeable
     if ((l->loc[addr].flags & BC_SPAN_W) == 0)
@@ -81,7 +82,7 @@ void legacy_poke (periph_t *per, periph_t *ign, uint32_t addr, uint32_t data)
 
     UNUSED(ign);
     UNUSED(data);
-    if (jlp_accel_on && addr >= 0x8000 && addr <= 0x9FFF)
+    if (addr >= 0x8000 && addr <= 0x9FFF && jlp_accel_on)
         return;
 
     mask = ~(~0u << l->loc[addr].width);
@@ -618,6 +619,41 @@ LOCAL void legacy_dtor(periph_t *p)
         bc_free_cfg(l->bc);
 }
 
+/* ======================================================================== */
+/*  LEGACY_SER_INIT -- Register each run of writable locations with the     */
+/*                     serializer.  A legacy_loc_t is width/flags/data      */
+/*                     packed into 32 bits, so it is saved as one word.     */
+/* ======================================================================== */
+LOCAL void legacy_ser_init(periph_t *p)
+{
+#ifdef NO_SERIALIZER
+    UNUSED(p);
+#else
+    legacy_t *const l = PERIPH_AS(legacy_t, p);
+    ser_hier_t *hier;
+    char name[16];
+    int lo = -1;
+
+    hier = ser_new_hierarchy(NULL, p->name);
+
+    for (int addr = 0; addr <= 0x10000; addr++)
+    {
+        const int wr = addr <= 0xFFFF && (l->loc[addr].flags & BC_SPAN_W);
+
+        if (wr && lo < 0)
+            lo = addr;
+
+        if (!wr && lo >= 0)
+        {
+            snprintf(name, sizeof(name), "ram_%.4X", lo);
+            ser_register(hier, name, &l->loc[lo], ser_u32, addr - lo,
+                         SER_MAND|SER_HEX);
+            lo = -1;
+        }
+    }
+#endif
+}
+
 /* ======================================================================== */
 /*  LEGACY_BINCFG -- Try to determine if a file is BIN+CFG or ROM, and      */
 /*                   read it in if it is BIN+CFG.                           */
@@ -971,6 +1007,7 @@ finish:
     l->periph.peek        = legacy_read;
     l->periph.poke        = legacy_poke;
     l->periph.dtor        = legacy_dtor;
+    l->periph.ser_init    = legacy_ser_init;
 
     l->periph.tick        = NULL;
     l->periph.min_tick    = ~0U;
@@ -22,6 +22,7 @@
 #include "cp1600/cp1600.h"
 #include "cp1600/emu_link.h"
 #include "cheat/cheat.h"
+#include "prof/prof.h"
 #include "mem/mem.h"
 #include "ecs/ecs.h"
 #include "icart/icart.h"
@@ -31,6 +32,10 @@
 #include "pads/pads_cgc.h"
 #include "pads/pads_intv2pc.h"
 #include "avi/avi.h"
+#include "strm/strm.h"
+#include "rewind/rewind.h"
+#include "event/event_log.h"
+#include "netplay/netplay.h"
 #include "gfx/gfx.h"
 #include "gfx/palette.h"
 #include "snd/snd.h"
@@ -55,10 +60,11 @@
 #include "locutus/locutus_adapt.h"
 #include "mapping.h"
 #include "cfg.h"
+#include "launch.h"
 
 #include <errno.h>
 
-LOCAL path_t *rom_path;
+LOCAL THREAD_LOCAL path_t *rom_path;
 
 void cfg_default(event_t *event);
 
@@ -80,6 +86,16 @@ int cfg_get_evtact(const char *event_action_name)
     return -10;
 }
 
+/* ======================================================================== */
+/*  CFG_EVTACT_WORD  -- The word in 'cfg' that an event action modifies.    */
+/* ======================================================================== */
+LOCAL uint32_t *cfg_evtact_word(cfg_t *const cfg, const int action)
+{
+    const size_t ofs = cfg_event_action[action].word;
+
+    return ofs ? (uint32_t *)((char *)cfg + ofs) : NULL;
+}
+
 /* ======================================================================== */
 /*  CFG_SETBIND  -- Set all of the key-bindings for the Intellivision.      */
 /* ======================================================================== */
@@ -123,7 +139,7 @@ int cfg_setbind(cfg_t *cfg, const char *kbdhackfile)
             /*  Map the key to the event.                                   */
             /* ------------------------------------------------------------ */
             event_map(&cfg->event, cfg->binding[i].key, j, cfg_event_action[action].name,
-                      cfg_event_action[action].word,
+                      cfg_evtact_word(cfg, action),
                       cfg_event_action[action].and_mask,
                       cfg_event_action[action].or_mask);
         }
@@ -276,7 +292,7 @@ int cfg_setbind(cfg_t *cfg, const char *kbdhackfile)
         }
 
         event_map(&cfg->event, cmd, map, cfg_event_action[action].name,
-                  cfg_event_action[action].word,
+                  cfg_evtact_word(cfg, action),
                   cfg_event_action[action].and_mask,
                   cfg_event_action[action].or_mask);
     }
@@ -365,7 +381,11 @@ enum
     FLAG_GFX_BORD_X,    FLAG_GFX_BORD_Y,   FLAG_GUI_MODE,     FLAG_RAND_MEM,
     FLAG_START_DELAY,   FLAG_DBG_SCRIPT,   FLAG_DBG_SRCMAP,   FLAG_FILE_IO,
     FLAG_ENABLE_MOUSE,  FLAG_PRESCALE,     FLAG_JLP_SAVEGAME, FLAG_AVI_RATE,
-    FLAG_LOCUTUS,       FLAG_ECS_TAPE,     FLAG_ECS_PRINTER,  FLAG_CHEAT
+    FLAG_LOCUTUS,       FLAG_ECS_TAPE,     FLAG_ECS_PRINTER,  FLAG_CHEAT,
+    FLAG_SND_AUTO,      FLAG_STRM_OUT,     FLAG_STRM_FMT,     FLAG_STRM_PCM,
+    FLAG_REWIND,        FLAG_REWIND_MEM,   FLAG_RUN_AHEAD,    FLAG_REC_INPUT,
+    FLAG_PLAY_INPUT,    FLAG_NETPLAY,      FLAG_NETPLAY_WIN,  FLAG_NETPLAY_SIM,
+    FLAG_NETPLAY_TEST,  FLAG_MAX_FRAMES,   FLAG_PROF,         FLAG_PROF_FILE
 };
 
 struct option cfg_longopt[] =
@@ -388,6 +408,7 @@ struct option cfg_longopt[] =
     {   "audiowindow",  1,      NULL,       'w'                 },
     {   "audiobufsize", 1,      NULL,       'B'                 },
     {   "audiobufcnt",  1,      NULL,       'C'                 },
+    {   "snd-auto",     2,      NULL,       FLAG_SND_AUTO       },
     {   "audiomintick", 1,      NULL,       'M'                 },
     {   "voice",        2,      NULL,       'v'                 },
     {   "voicewindow",  2,      NULL,       'W'                 },
@@ -482,6 +503,22 @@ struct option cfg_longopt[] =
 
     {   "avirate",      1,      NULL,       FLAG_AVI_RATE       },
 
+    {   "stream-out",   1,      NULL,       FLAG_STRM_OUT       },
+    {   "stream-fmt",   1,      NULL,       FLAG_STRM_FMT       },
+    {   "stream-pcm",   1,      NULL,       FLAG_STRM_PCM       },
+    {   "rewind",       1,      NULL,       FLAG_REWIND         },
+    {   "rewind-mem",   1,      NULL,       FLAG_REWIND_MEM     },
+    {   "run-ahead",    1,      NULL,       FLAG_RUN_AHEAD      },
+    {   "record-input", 1,      NULL,       FLAG_REC_INPUT      },
+    {   "replay-input", 1,      NULL,       FLAG_PLAY_INPUT     },
+    {   "netplay",      1,      NULL,       FLAG_NETPLAY        },
+    {   "netplay-rollback",1,   NULL,       FLAG_NETPLAY_WIN    },
+    {   "netplay-sim",  1,      NULL,       FLAG_NETPLAY_SIM    },
+    {   "netplay-test", 1,      NULL,       FLAG_NETPLAY_TEST   },
+    {   "max-frames",   1,      NULL,       FLAG_MAX_FRAMES     },
+    {   "prof",         2,      NULL,       FLAG_PROF           },
+    {   "prof-file",    1,      NULL,       FLAG_PROF_FILE      },
+
     // --locutus for testing LUIGI files.
     {   "locutus",      0,      NULL,       FLAG_LOCUTUS        },
 
@@ -500,12 +537,22 @@ LOCAL const char *optchars= "b:E:e:G:g:s::f::F:?dhlqr:P::x::z:a:w:B:C:M:m:"
 /* ======================================================================== */
 const uint32_t i2pc_ports[4] = { 0x0, 0x378, 0x278, 0x3BC };
 
-LOCAL char *joy_cfg[MAX_JOY][MAX_STICKS];
+LOCAL THREAD_LOCAL char *joy_cfg[MAX_JOY][MAX_STICKS];
 
 /* ======================================================================== */
 /*  CFG_INIT     -- Parse command line and get started                      */
 /* ======================================================================== */
 int cfg_init(cfg_t *cfg, int argc, char * argv_orig[])
+{
+    return cfg_init_launch(cfg, argc, argv_orig, NULL);
+}
+
+/* ======================================================================== */
+/*  CFG_INIT_LAUNCH  -- Like CFG_INIT, but start from the fields of a       */
+/*                      launch descriptor, if any.  argv can override them. */
+/* ======================================================================== */
+int cfg_init_launch(cfg_t *cfg, int argc, char * argv_orig[],
+                    const struct jzintv_launch_t *const launch)
 {
     int c, option_idx = 0, rx, ry, rd, bx = -1, by = -1, bpct = -1;
     int exec_type = 0, legacy_rom = 0;
@@ -514,6 +561,11 @@ int cfg_init(cfg_t *cfg, int argc, char * argv_orig[])
     char *audiofile = NULL, *tmp;
     char *kbdhackfile = NULL;
     char *demofile = NULL;
+    char *strm_out = NULL, *strm_pcm = NULL;
+    char *evlog_fname = NULL;
+    evlog_mode_t evlog_mode = EVLOG_OFF;
+    char *np_spec = NULL, *np_sim = NULL, *np_test = NULL;
+    int   strm_fmt = STRM_FMT_RAW;
     char *jlpsg = NULL;
     char *elfi_prefix = NULL;
     char *gfx_palette = NULL;
@@ -526,8 +578,10 @@ int cfg_init(cfg_t *cfg, int argc, char * argv_orig[])
     char *debug_symtbl   = NULL;
     char *debug_script   = NULL;
     char *debug_srcmap   = NULL;
+    char *prof_file      = NULL;
     int snd_buf_size     = 0;
     int snd_buf_cnt      = 0;
+    int snd_auto         = 0;
     int gfx_verbose      = 0;
     int rand_mem         = 0;
     int enable_mouse     = 0;
@@ -619,6 +673,8 @@ int cfg_init(cfg_t *cfg, int argc, char * argv_orig[])
     cfg->accutick       = 1;            /* fully accurate audio.            */
     cfg->binding        = cfg_key_bind; /* default key bindings.            */
     cfg->start_dly      = -1;           /* No startup delay by default.     */
+    cfg->rewind_mem     = 32;           /* 32MB of rewind history, if any.  */
+    cfg->netplay_win    = 8;            /* Roll back up to 8 frames.        */
 
 #define STR_REPLACE(x,y) { CONDFREE(x); (x) = strdup(y); }
 
@@ -654,6 +710,35 @@ int cfg_init(cfg_t *cfg, int argc, char * argv_orig[])
     SER_REG(ivc_tname,  ser_string, 1,  SER_INIT|SER_MAND);
 #endif
 
+    /* -------------------------------------------------------------------- */
+    /*  Take what the launch descriptor gives us, same as the flags would.  */
+    /* -------------------------------------------------------------------- */
+    if (launch)
+    {
+        if (launch->fn_exec)  STR_REPLACE(cfg->fn_exec, launch->fn_exec);
+        if (launch->fn_grom)  STR_REPLACE(cfg->fn_grom, launch->fn_grom);
+        if (launch->fn_game)  STR_REPLACE(cfg->fn_game, launch->fn_game);
+        if (launch->disp_res) STR_REPLACE(disp_res,     launch->disp_res);
+        if (launch->rom_path)
+            rom_path = parse_path_string(rom_path, launch->rom_path);
+        if (launch->kbdhackfile)
+            STR_REPLACE(kbdhackfile, launch->kbdhackfile);
+        if (launch->gfx_palette)
+            STR_REPLACE(gfx_palette, launch->gfx_palette);
+        if (launch->ecs_tape)
+            STR_REPLACE(fn_ecs_tape, launch->ecs_tape);
+        if (launch->jlp_savegame)
+        {
+            STR_REPLACE(jlpsg, launch->jlp_savegame);
+            jlp_accel = 3;
+        }
+        if (launch->fullscreen)
+            cfg->gfx_flags |= GFX_FULLSC;
+
+        cfg->gram_size = launch->gram_size;
+        enable_mouse   = launch->enable_mouse;
+    }
+
     /* -------------------------------------------------------------------- */
     /*  Parse the commandline flags.                                        */
     /* -------------------------------------------------------------------- */
@@ -890,6 +975,50 @@ int cfg_init(cfg_t *cfg, int argc, char * argv_orig[])
                 break;
             }
 
+            case FLAG_SND_AUTO:
+            {
+                snd_auto = noarg ? SND_AUTO_THRESH_DEFAULT : value;
+                break;
+            }
+
+            case FLAG_STRM_OUT: STR_REPLACE(strm_out, optarg);          break;
+            case FLAG_STRM_PCM: STR_REPLACE(strm_pcm, optarg);          break;
+
+            case FLAG_REWIND:     cfg->rewind_ivl = value;              break;
+            case FLAG_REWIND_MEM: cfg->rewind_mem = value;              break;
+            case FLAG_RUN_AHEAD:  cfg->run_ahead  = value;              break;
+
+            case FLAG_REC_INPUT:
+            case FLAG_PLAY_INPUT:
+            {
+                STR_REPLACE(evlog_fname, optarg);
+                evlog_mode = c == FLAG_REC_INPUT ? EVLOG_RECORD
+                                                 : EVLOG_REPLAY;
+                break;
+            }
+
+            case FLAG_NETPLAY:      STR_REPLACE(np_spec, optarg);       break;
+            case FLAG_NETPLAY_WIN:  cfg->netplay_win = value;           break;
+            case FLAG_NETPLAY_SIM:  STR_REPLACE(np_sim,  optarg);       break;
+            case FLAG_NETPLAY_TEST: STR_REPLACE(np_test, optarg);       break;
+            case FLAG_MAX_FRAMES:   cfg->max_frames = value > 0 ? value : 0;
+                                    break;
+
+            case FLAG_PROF:      cfg->prof_ivl = noarg ? 1000
+                                               : value > 0 ? value : 0; break;
+            case FLAG_PROF_FILE: STR_REPLACE(prof_file, optarg);       break;
+
+            case FLAG_STRM_FMT:
+            {
+                if ((strm_fmt = strm_parse_fmt(optarg)) < 0)
+                {
+                    fprintf(stderr, "Unknown stream format '%s'.  "
+                                    "Use 'raw' or 'y4m'.\n", optarg);
+                    return -10;
+                }
+                break;
+            }
+
             case FLAG_CHEAT:
             {
                 if (cheat_add(&cfg->cheat, optarg))
@@ -1112,6 +1241,10 @@ int cfg_init(cfg_t *cfg, int argc, char * argv_orig[])
     /* -------------------------------------------------------------------- */
     cfg->intv = periph_new(16, 16, 4);
     strncpy(cfg->intv->periph.name, "MasterComponent", 16);
+#ifndef NO_SERIALIZER
+    periph_ser_register(AS_PERIPH(cfg->intv),
+                        ser_new_hierarchy(NULL, "MasterComponent"));
+#endif
 
     /* -------------------------------------------------------------------- */
     /*  Now, configure the Intellivision according to our flags.  Start     */
@@ -1483,12 +1616,40 @@ skip_ecs:;
     if (cfg->audio_rate && snd_init(&cfg->snd, cfg->audio_rate, audiofile,
                                     snd_buf_size, snd_buf_cnt, &cfg->avi,
                                     cfg->pal_mode,
-                                    cfg->rate_ctl))
+                                    cfg->rate_ctl, snd_auto))
     {
         fprintf(stderr, "WARNING:  Failed to initialize sound.  Disabled.\n");
         cfg->audio_rate = 0;
     }
 
+    /* -------------------------------------------------------------------- */
+    /*  Start streaming raw video/audio, if requested.                      */
+    /* -------------------------------------------------------------------- */
+    if (strm_out)
+    {
+        if (strm_init(&cfg->strm, strm_out, strm_pcm, strm_fmt,
+                      cfg->pal_mode, cfg->audio_rate, &cfg->palette))
+        {
+            fprintf(stderr, "ERROR:  Failed to initialize stream output\n");
+            return -10;
+        }
+
+        cfg->gfx.strm = &cfg->strm;
+        if (cfg->audio_rate)
+            cfg->snd.strm = &cfg->strm;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  A bounded run hashes its frames and audio, for regression tests.    */
+    /* -------------------------------------------------------------------- */
+    if (cfg->max_frames)
+    {
+        cfg->gfx.hash_left = cfg->max_frames;
+        cfg->gfx.hash      = 0xFFFFFFFF;
+        cfg->snd.hash_on   = true;
+        cfg->snd.hash      = 0xFFFFFFFF;
+    }
+
     if (cp1600_init(&cfg->cp1600, 0x1000, 0x1004, rand_mem))
     {
         fprintf(stderr, "ERROR:  Failed to initialize CP-1610 CPU\n");
@@ -1725,6 +1886,58 @@ skip_ecs:;
 
     periph_register    (P(event          ),  0x0000, 0x0000, "[Event]"     );
 
+    /* -------------------------------------------------------------------- */
+    /*  Record or replay the hand controller and ECS keyboard inputs.       */
+    /* -------------------------------------------------------------------- */
+    if (evlog_mode != EVLOG_OFF)
+    {
+        pad_t *const pad[2] = { &cfg->pad0, &cfg->pad1 };
+        uint32_t *word[2 * (18 + 18 + 8)];
+        int n = 0, p, i;
+
+        for (p = 0; p < 2; p++)
+        {
+            for (i = 0; i < 18; i++) word[n++] = &pad[p]->l[i];
+            for (i = 0; i < 18; i++) word[n++] = &pad[p]->r[i];
+            for (i = 0; i <  8; i++) word[n++] = &pad[p]->k[i];
+        }
+
+        if (event_log_init(&cfg->evlog, evlog_fname, evlog_mode, word, n,
+                           &cfg->cp1600.periph.now, &cfg->do_exit))
+        {
+            fprintf(stderr, "ERROR:  Failed to initialize input log\n");
+            return -10;
+        }
+
+        cfg->event.log = &cfg->evlog;
+        if (evlog_mode == EVLOG_REPLAY)
+            periph_register(P(evlog      ),  0x0000, 0x0000, "[Input Log]" );
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Netplay drives the base unit's two hand controllers.                */
+    /* -------------------------------------------------------------------- */
+    if (np_spec)
+    {
+        uint32_t *word[2 * NP_WORDS];
+        int i;
+
+        for (i = 0; i < NP_WORDS; i++)
+        {
+            word[i]            = &cfg->pad0.l[i];
+            word[NP_WORDS + i] = &cfg->pad0.r[i];
+        }
+
+        if (netplay_init(&cfg->netplay, np_spec, cfg->netplay_win, np_sim,
+                         np_test, word))
+        {
+            fprintf(stderr, "ERROR:  Failed to initialize netplay\n");
+            return -10;
+        }
+
+        cfg->event.netplay = &cfg->netplay;
+    }
+
     if (cfg->rate_ctl > 0.0)
         periph_register(P(speed          ),  0x0000, 0x0000, "[Rate Ctrl]" );
 
@@ -1784,15 +1997,40 @@ skip_ecs:;
     if (cheat_count(&cfg->cheat))
         periph_register(P(cheat),  0x0000, 0x0000, "[Cheat]");
 
+    /* -------------------------------------------------------------------- */
+    /*  Start the sampling profiler if requested.  It names functions from  */
+    /*  the debugger's symbol table, so load that even if not debugging.    */
+    /* -------------------------------------------------------------------- */
+    if (cfg->prof_ivl > 0)
+    {
+        if (!cfg->debugging && debug_symtbl)
+            debug_read_symtbl(debug_symtbl);
+
+        if (prof_init(&cfg->prof, &cfg->cp1600, cfg->prof_ivl,
+                      prof_file ? prof_file : "jzintv_prof"))
+        {
+            fprintf(stderr, "ERROR:  Failed to initialize profiler\n");
+            return -10;
+        }
+        periph_register(P(prof),   0x0000, 0x0000, "[Profiler]");
+    }
+
     /* -------------------------------------------------------------------- */
     /*  Free up all of our temporary variables.                             */
     /* -------------------------------------------------------------------- */
     CONDFREE(audiofile);
     CONDFREE(kbdhackfile);
     CONDFREE(demofile);
+    CONDFREE(strm_out);
+    CONDFREE(evlog_fname);
+    CONDFREE(np_spec);
+    CONDFREE(np_sim);
+    CONDFREE(np_test);
+    CONDFREE(strm_pcm);
     CONDFREE(jlpsg);
     CONDFREE(debug_symtbl);
     CONDFREE(debug_srcmap);
+    CONDFREE(prof_file);
     CONDFREE(elfi_prefix);
     return 0;
 }
@@ -1802,7 +2040,17 @@ skip_ecs:;
 /* ======================================================================== */
 void cfg_dtor(cfg_t *cfg)
 {
-    periph_delete(cfg->intv);
+#ifndef NO_SERIALIZER
+    rewind_dtor(&cfg->rewind);
+    ser_snap_dtor(cfg->snap);
+    ser_dtor();
+#endif
+    event_log_dtor(&cfg->evlog);
+    netplay_dtor(&cfg->netplay);
+    if (cfg->intv)
+        periph_delete(cfg->intv);
+    debug_free_symtbl();
+    strm_dtor(&cfg->strm);
     CONDFREE(cfg->ivc_tname);
     CONDFREE(cfg->cgc0_dev);
     CONDFREE(cfg->cgc1_dev);
@@ -41,6 +41,7 @@ typedef struct cfg_t
     event_t     event;          /* Event subsystem.                         */
     debug_t     debug;          /* Debugger hooks.                          */
     cheat_t     cheat;          /* Cheat commands.                          */
+    prof_t      prof;           /* Sampling profiler.                       */
 
     /* -------------------------------------------------------------------- */
     /*  Hardware peripherals -- these model actual pieces of the Intv.      */
@@ -111,6 +112,7 @@ typedef struct cfg_t
     uint32_t  do_pause;         /* Signal that we are paused.               */
     uint32_t  do_dump;          /* Signal that we'd like to save a game     */
     uint32_t  do_load;          /* Signal that we'd like to load a game     */
+    uint32_t  do_rewind;        /* Held while stepping back in time.        */
     uint32_t  do_reload;        /* Signal we'd like to reload jzIntv        */
     uint32_t  chg_evt_map;      /* Change the current input event map.      */
 
@@ -129,6 +131,45 @@ typedef struct cfg_t
     /* -------------------------------------------------------------------- */
     avi_writer_t avi;
 
+    /* -------------------------------------------------------------------- */
+    /*  Raw video/audio stream output.                                      */
+    /* -------------------------------------------------------------------- */
+    strm_t      strm;
+
+    /* -------------------------------------------------------------------- */
+    /*  Binary snapshot plan, built on first save/load.                     */
+    /* -------------------------------------------------------------------- */
+    struct ser_snap_t *snap;
+
+    /* -------------------------------------------------------------------- */
+    /*  Rewind history.                                                     */
+    /* -------------------------------------------------------------------- */
+    rewind_t    rewind;
+    int         rewind_ivl;     /* Frames between captures; 0 == off.       */
+    int         rewind_mem;     /* History size limit in megabytes.         */
+    int         run_ahead;      /* Frames to run ahead; 0 == off.           */
+
+    /* -------------------------------------------------------------------- */
+    /*  Input recording / replay.                                           */
+    /* -------------------------------------------------------------------- */
+    event_log_t evlog;
+
+    /* -------------------------------------------------------------------- */
+    /*  Bounded runs:  exit after max_frames, hashing what was output.      */
+    /* -------------------------------------------------------------------- */
+    uint32_t    max_frames;     /* Frames to run; 0 == no limit.            */
+
+    /* -------------------------------------------------------------------- */
+    /*  Sampling profiler.                                                  */
+    /* -------------------------------------------------------------------- */
+    uint32_t    prof_ivl;       /* Cycles between samples; 0 == off.        */
+
+    /* -------------------------------------------------------------------- */
+    /*  Rollback netplay.                                                   */
+    /* -------------------------------------------------------------------- */
+    netplay_t   netplay;
+    int         netplay_win;    /* Most frames to roll back.                */
+
     /* -------------------------------------------------------------------- */
     /*  Other misc details about the game                                   */
     /* -------------------------------------------------------------------- */
@@ -136,8 +177,6 @@ typedef struct cfg_t
     int         cart_year;
 } cfg_t;
 
-extern cfg_t intv;
-
 /* ======================================================================== */
 /*  CFG_GET_EVTACT   -- Convert an event action name into an event action   */
 /*                      index.  This is a horrible linear search.  :-P      */
@@ -155,6 +194,13 @@ int cfg_setbind(cfg_t *cfg, const char *kbdhackfile);
 /* ======================================================================== */
 int cfg_init(cfg_t *cfg, int argc, char * argv[]);
 
+/* ======================================================================== */
+/*  CFG_INIT_LAUNCH  -- CFG_INIT, starting from a launch descriptor.        */
+/* ======================================================================== */
+struct jzintv_launch_t;
+int cfg_init_launch(cfg_t *cfg, int argc, char * argv[],
+                    const struct jzintv_launch_t *const launch);
+
 /* ======================================================================== */
 /*  CFG_DTOR     -- Destroy a constructed Intellivision                     */
 /* ======================================================================== */
@@ -22,6 +22,10 @@
 #include "pads/pads_cgc.h"
 #include "pads/pads_intv2pc.h"
 #include "avi/avi.h"
+#include "strm/strm.h"
+#include "rewind/rewind.h"
+#include "event/event_log.h"
+#include "netplay/netplay.h"
 #include "gfx/gfx.h"
 #include "gfx/palette.h"
 #include "snd/snd.h"
@@ -37,12 +41,13 @@
 #include "jlp/jlp.h"
 #include "locutus/locutus_adapt.h"
 #include "cheat/cheat.h"
+#include "prof/prof.h"
 #include "mapping.h"
 #include "cfg.h"
 #include <errno.h>
 
 
-#define W(word) ((uint32_t*)&intv.word)
+#define W(word) offsetof(cfg_t, word)
 
 /* ------------------------------------------------------------------------ */
 /*  jzIntv internal event action table.  Keyboard and joystick inputs may   */
@@ -72,6 +77,7 @@ cfg_evtact_t  cfg_event_action[] =
     { "RESET",      W(do_reset          ),  { 0,   ~0U },   { 0,   ~0U } },
     { "DUMP",       W(do_dump           ),  { ~0U, 0   },   { 0,   1   } },
     { "LOAD",       W(do_load           ),  { ~0U, 0   },   { 0,   1   } },
+    { "REWIND",     W(do_rewind         ),  { 0,   0   },   { 0,   1   } },
     { "RELOAD",     W(do_reload         ),  { ~0U, 0   },   { 0,   1   } }, 
     { "MOVIE",      W(gfx.scrshot       ),  { ~0U, ~0U },   { GFX_MVTOG, 0} },
     { "AVI",        W(gfx.scrshot       ),  { ~0U, ~0U },   { GFX_AVTOG, 0} },
@@ -84,7 +90,7 @@ cfg_evtact_t  cfg_event_action[] =
     { "BREAK",      W(debug.step_count  ),  { ~0U, 0   },   { 0,   0   } },
     { "VOLUP",      W(snd.change_vol    ),  { ~0U, 0   },   { 0,   1   } },
     { "VOLDN",      W(snd.change_vol    ),  { ~0U, 0   },   { 0,   2   } },
-    { "NA",         NULL,                   { 0,   0   },   { 0,   0   } },
+    { "NA",         0,                      { 0,   0   },   { 0,   0   } },
 
     /* -------------------------------------------------------------------- */
     /*  A rich set of pause actions, so we can tie them to things such as   */
@@ -743,7 +749,7 @@ bits |   0       1    2  3  4    5        6      7
 
 { "SPACE",  {   "NA",           "NA",           "KEYB_SPACE",   "NA"        }},
 { "RETURN", {   "NA",           "NA",           "KEYB_ENTER",   "NA"        }},
-{"BACKSPACE",{  "NA",           "NA",           "KEYB_LEFT",    "NA"        }},
+{"BACKSPACE",{  "REWIND",       "REWIND",       "KEYB_LEFT",    "NA"        }},
 
 { "QUOTEDBL",{  "NA",           "NA",           "KEYB_QUOTE",   "NA"        }},
 { "QUOTE",  {   "NA",           "NA",           "KEYB_QUOTE",   "NA"        }},
@@ -22,7 +22,8 @@
 typedef struct cfg_evtact_t
 {
     const char  *name;          /* Event action name                        */
-    uint32_t    *word;          /* Word modified by an input.               */
+    size_t       word;          /* Offset in cfg_t of the word modified by  */
+                                /* an input, or 0 for none.                 */
     uint32_t    and_mask[2];    /* Up/down AND masks.                       */
     uint32_t    or_mask [2];    /* Up/down OR masks.                        */
 } cfg_evtact_t;
@@ -120,6 +120,9 @@ void usage(void)
 "    -w#     --audiowindow=#       Sets averaging window for audio filter." "\n"
 "    -B#     --audiobufsize=#      Internal audio buffer size."             "\n"
 "    -C#     --audiobufcnt=#       Internal audio buffer count."            "\n"
+"            --snd-auto[=#]        Auto-tune audio buffer count at runtime" "\n"
+"                                  to allow # underruns per 1000 audio"     "\n"
+"                                  callbacks (default 5)."                  "\n"
 "    -M#     --audiomintick=#      Minimum Intellivision cycles between"    "\n"
 "                                  explicit calls to snd_tick()."           "\n"
                                                                             "\n"
@@ -224,6 +227,56 @@ void usage(void)
 "            --avirate=#           Scales time by # when recording AVI files.\n"
 "                                  # can be floating point (e.g. 1.5)."     "\n"
                                                                             "\n"
+"            --stream-out=path     Stream uncompressed video (and audio)"   "\n"
+"                                  to a file, named pipe, or unix:socket,"  "\n"
+"                                  for encoding by an external program."    "\n"
+"            --stream-fmt=fmt      Stream format.  'raw' (default) sends"   "\n"
+"                                  palette-indexed frames and PCM with"     "\n"
+"                                  small headers.  'y4m' sends YUV4MPEG2"   "\n"
+"                                  video only."                             "\n"
+"            --stream-pcm=path     Send audio as raw 16-bit mono PCM to"    "\n"
+"                                  its own file, pipe, or socket instead."  "\n"
+                                                                            "\n"
+"            --rewind=#            Capture rewind history every # frames."  "\n"
+"                                  Hold Backspace to step back through it." "\n"
+"            --rewind-mem=#        Keep at most # MB of rewind history."    "\n"
+"                                  Default is 32."                          "\n"
+                                                                            "\n"
+"            --run-ahead=#         Run # frames ahead and show the result," "\n"
+"                                  to hide # frames of the game's own"      "\n"
+"                                  input lag.  Costs # extra frames of"     "\n"
+"                                  emulation per frame."                    "\n"
+                                                                            "\n"
+"            --record-input=path   Log every controller and keyboard input" "\n"
+"                                  change, tagged with its CPU cycle."      "\n"
+"            --replay-input=path   Replay a log from --record-input at the" "\n"
+"                                  same CPU cycles, ignoring live input,"   "\n"
+"                                  and exit when it ends.  Needs the same"  "\n"
+"                                  game and settings as the recording."    "\n"
+                                                                            "\n"
+"            --netplay=p:port:host:hport"                                  "\n"
+"                                  Play player p (1 = left controller, 2 =" "\n"
+"                                  right) against the jzIntv at host:hport" "\n"
+"                                  over UDP, listening on port.  Both"      "\n"
+"                                  sides need the same game and settings."  "\n"
+"            --netplay-rollback=#  Run up to # frames ahead of the peer on" "\n"
+"                                  predicted input, 1 to 16.  Default 8."   "\n"
+"            --netplay-sim=l,j,d   Delay outgoing packets l msec, +/- j"    "\n"
+"                                  msec jitter, and drop d percent."        "\n"
+"            --netplay-test=s,#    Play random input from seed s, and exit" "\n"
+"                                  after # frames."                         "\n"
+                                                                            "\n"
+"            --max-frames=#        Exit after # frames, printing a CRC32 of" "\n"
+"                                  the frames and one of the audio."        "\n"
+                                                                            "\n"
+"            --prof[=#]            Sample the PC and call stack every #"    "\n"
+"                                  cycles (default 1000) at full speed."    "\n"
+"                                  Writes collapsed stacks for flamegraphs" "\n"
+"                                  and a per-function report on exit."      "\n"
+"            --prof-file=path      Base name for the profile output files." "\n"
+"                                  Default is 'jzintv_prof'.  Use with"     "\n"
+"                                  --sym-file to name functions."           "\n"
+                                                                            "\n"
 "            --ecs-tape=path       Template for ECS tape file names."       "\n"
 "                                  An '#' in the name expands to the 4 char""\n"
 "                                  CSAV/CLOD name preceded by an '_', if"   "\n"
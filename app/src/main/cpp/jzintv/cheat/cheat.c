@@ -109,8 +109,8 @@ LOCAL const char *cheat_parse_get_cmd
 /* ======================================================================== */
 LOCAL cheat_cmd_t *cheat_parse(const int cheat_idx, const char *s)
 {
-    static cheat_cmd_t *cmd_buf = NULL;
-    static int cmd_buf_size = 0;
+    static THREAD_LOCAL cheat_cmd_t *cmd_buf = NULL;
+    static THREAD_LOCAL int cmd_buf_size = 0;
     int cmd_cnt = 0;
     bool first = true;
     const char *last_s = s;
@@ -485,6 +485,23 @@
 # define SND_BUF_CNT_DEFAULT  (2)
 #endif
 
+/* Starting point and limits for --snd-auto buffer tuning. */
+#if !defined(SND_AUTO_BUF_SIZE)
+# define SND_AUTO_BUF_SIZE    (512)
+#endif
+
+#if !defined(SND_AUTO_MIN_CNT)
+# define SND_AUTO_MIN_CNT     (2)
+#endif
+
+#if !defined(SND_AUTO_MAX_CNT)
+# define SND_AUTO_MAX_CNT     (16)
+#endif
+
+#if !defined(SND_AUTO_THRESH_DEFAULT)
+# define SND_AUTO_THRESH_DEFAULT (5)
+#endif
+
 #if !defined(LL_FMT)
 # define LL_FMT "ll"
 #endif
@@ -535,6 +552,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <time.h>
 #include <ctype.h>
 #include <assert.h>
@@ -620,6 +638,26 @@
 # warning "LOCAL already defined before config.h"
 #endif
 
+/*
+ * ============================================================================
+ *  Per-instance state.  The machine itself lives in a cfg_t; the rest of
+ *  what a running instance modifies is THREAD_LOCAL, so that each thread
+ *  can run an instance of its own.  Define NO_THREAD_LOCAL on targets
+ *  without TLS; they get one instance per process, as before.
+ * ============================================================================
+ */
+#if defined(NO_THREAD_LOCAL)
+# define THREAD_LOCAL
+#elif defined(__GNUC__)
+# define THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+# define THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+# define THREAD_LOCAL _Thread_local
+#else
+# define THREAD_LOCAL
+#endif
+
 /*
  * ============================================================================
  *  Indicate when we specifically intend to fall-through on a switch-case
@@ -669,8 +707,6 @@ extern void dump_state(void);
         (x) = NULL;                                                         \
     } while (0)
 
-#define NO_SERIALIZER
-
 /*
  * ============================================================================
  *  Version number
@@ -44,6 +44,7 @@
 
 
 LOCAL void cp1600_dtor(periph_t *const p);
+LOCAL void cp1600_ser_init(periph_t *const p);
 LOCAL void cp1600_rand_regs(cp1600_t *const cp1600);
 
 /*
@@ -141,6 +142,7 @@ int cp1600_init
     cp1600->periph.min_tick = 1;
     cp1600->periph.max_tick = 4;
     cp1600->periph.dtor     = cp1600_dtor;
+    cp1600->periph.ser_init = cp1600_ser_init;
 
     cp1600->snoop.read      = NULL;
     cp1600->snoop.write     = cp1600_write; /* Bus snoop for cache inval.   */
@@ -572,6 +574,23 @@ void cp1600_instr_tick
     cp1600->instr_tick_periph = instr_tick_periph;
 }
 
+/*
+ * ============================================================================
+ *  CP1600_DECODE_HOOK   -- Sets/unsets a decode-time hook
+ * ============================================================================
+ */
+void cp1600_decode_hook
+(
+    cp1600_t          *const cp1600,
+    cp1600_dec_hook_t *const decode_hook,
+    void              *const opaque
+)
+{
+    cp1600->decode_hook        = decode_hook;
+    cp1600->decode_hook_opaque = opaque;
+    cp1600_invalidate(cp1600, 0, 0xFFFF);
+}
+
 /*
  * ============================================================================
  *  CP1600_SET_BREAKPT   -- Sets a breakpoint at a given address.
@@ -675,6 +694,60 @@ LOCAL void cp1600_dtor(periph_t *const p)
     emu_link_dtor();
 }
 
+/*
+ * ============================================================================
+ *  CP1600_SER_INIT      -- Registers the CPU state w/ the serializer.
+ *
+ *  The decoded-instruction cache isn't state; whoever restores a snapshot
+ *  must invalidate it.  pend_reset is left out, as snapshots are only
+ *  taken between bus ticks where it has already been serviced.
+ * ============================================================================
+ */
+LOCAL void cp1600_ser_init(periph_t *const p)
+{
+#ifdef NO_SERIALIZER
+    UNUSED(p);
+#else
+    cp1600_t *const cp1600 = PERIPH_AS(cp1600_t, p);
+    req_q_t  *const req_q  = &cp1600->req_q;
+    ser_hier_t *hier, *phier, *qhier;
+
+    hier  = ser_new_hierarchy(NULL, p->name);
+    phier = ser_new_hierarchy(hier, "periph");
+    qhier = ser_new_hierarchy(hier, "req_q");
+
+    periph_ser_register(p, phier);
+
+#define SER_REG(x,t,l,f)\
+    ser_register(hier, #x, &cp1600->x, t, l, f)
+
+    SER_REG(r,         ser_u16, 8,  SER_MAND|SER_HEX);
+    SER_REG(xr,        ser_u16, 16, SER_MAND|SER_HEX);
+    SER_REG(oldpc,     ser_u16, 1,  SER_MAND|SER_HEX);
+    SER_REG(ext,       ser_u16, 1,  SER_MAND|SER_HEX);
+    SER_REG(int_vec,   ser_u16, 1,  SER_MAND|SER_HEX);
+    SER_REG(S,         ser_s32, 1,  SER_MAND);
+    SER_REG(C,         ser_s32, 1,  SER_MAND);
+    SER_REG(O,         ser_s32, 1,  SER_MAND);
+    SER_REG(Z,         ser_s32, 1,  SER_MAND);
+    SER_REG(I,         ser_s32, 1,  SER_MAND);
+    SER_REG(D,         ser_s32, 1,  SER_MAND);
+    SER_REG(intr,      ser_s32, 1,  SER_MAND);
+    SER_REG(tot_cycle, ser_u64, 1,  SER_MAND);
+    SER_REG(tot_instr, ser_u64, 1,  SER_MAND);
+#undef SER_REG
+
+    /* -------------------------------------------------------------------- */
+    /*  The request queue entries are plain data; save them as raw bytes.   */
+    /* -------------------------------------------------------------------- */
+    ser_register(qhier, "horizon", &req_q->horizon, ser_u64, 1, SER_MAND);
+    ser_register(qhier, "req",     req_q->req, ser_u8, sizeof(req_q->req),
+                 SER_MAND|SER_HEX);
+    ser_register(qhier, "wr",      &req_q->wr, ser_u8, 1, SER_MAND);
+    ser_register(qhier, "rd",      &req_q->rd, ser_u8, 1, SER_MAND);
+#endif
+}
+
 /*
  * ============================================================================
  *  CP1600_RAND_REGS     -- Randomize the register file.           
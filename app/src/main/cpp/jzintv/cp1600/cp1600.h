@@ -51,6 +51,11 @@ struct instr_t;     /* forward decl. */
 
 typedef int cp1600_ins_t(const struct instr_t *, struct cp1600_t *);
 
+/* Decode hook:  may replace the execute function chosen for an instr.     */
+typedef cp1600_ins_t *cp1600_dec_hook_t(void *opaque, uint32_t addr,
+                                        uint32_t w0, uint32_t w1,
+                                        cp1600_ins_t *execute);
+
 typedef struct cp1600_t
 {
     periph_t        periph;         /* The CP-1600 is a peripheral.         */
@@ -84,6 +89,9 @@ typedef struct cp1600_t
     int             step_count;         /* Number of instructions to run.   */
     int             steps_remaining;    /* Step down-counter.               */
 
+    cp1600_dec_hook_t *decode_hook;     /* Decode-time hook (profiler)      */
+    void           *decode_hook_opaque; /* Opaque ptr to pass along.        */
+
     uint64_t        tot_cycle;
     uint64_t        tot_instr;
     uint64_t        tot_cache;
@@ -165,6 +173,22 @@ cp1600_instr_tick
     periph_t      *const instr_tick_periph
 );
 
+/*
+ * ============================================================================
+ *  CP1600_DECODE_HOOK   -- Sets/unsets a hook that sees each instruction as
+ *                          it's decoded, and may substitute its own execute
+ *                          function.  Flushes the decoded instruction cache
+ *                          so that every instruction passes through it.
+ * ============================================================================
+ */
+void
+cp1600_decode_hook
+(
+    cp1600_t          *const cp1600,
+    cp1600_dec_hook_t *const decode_hook,
+    void              *const opaque
+);
+
 /*
  * ============================================================================
  *  CP1600_RUN           -- Runs the CP1600 for some number of microcycles
@@ -26,9 +26,10 @@
 #include "cp1600/emu_link.h"
 
 
-static emu_link_api_t **emu_link_api = NULL;
-static void **emu_link_opq = NULL;
-static int emu_link_api_cnt = 0, emu_link_api_alloc = 0;
+/* Each instance registers its own APIs, on the thread that runs it. */
+static THREAD_LOCAL emu_link_api_t **emu_link_api = NULL;
+static THREAD_LOCAL void **emu_link_opq = NULL;
+static THREAD_LOCAL int emu_link_api_cnt = 0, emu_link_api_alloc = 0;
 
 /* ======================================================================== */
 /*  EMU_LINK_PING -- Simple API for presence detect.                        */
@@ -101,7 +101,7 @@
  *  DEC_IMM_2OP         -- Decodes Immediate -> Register 2-op
  * ============================================================================
  */
-static  int prev_is_sdbd = 0;
+static THREAD_LOCAL int prev_is_sdbd = 0;
 
 LOCAL void dec_impl_1op_a(instr_t *, cp1600_ins_t **);
 LOCAL void dec_impl_1op_b(instr_t *, cp1600_ins_t **);
@@ -437,7 +437,7 @@ LOCAL   void     dec_ind_2op     (instr_t *instr, cp1600_ins_t **execute)
 LOCAL   void     dec_imm_2op     (instr_t *instr, cp1600_ins_t **execute)
 {
     uint32_t reg0, reg1 = 0, xreg0 = 0, imm0, imm1, amode = 0, no_dbd = 0;
-    extern int lto_isa_enabled;
+    extern THREAD_LOCAL int lto_isa_enabled;
 
     /* -------------------------------------------------------------------- */
     /*  Consider the "dead air" opcode 0xFFFF as "off in the weeds."  It    */
@@ -523,7 +523,7 @@ fn_decode
     cp1600_t *cp1600
 )
 {
-    uint16_t w, pw, pc, pc2, dpc, dpc2;
+    uint16_t w, w1 = 0, pw, pc, pc2, dpc, dpc2;
     int cycles, words;
     cp1600_ins_t *fn_execute = (cp1600_ins_t *)fn_invalid;
     instr_fmt_t format;
@@ -588,7 +588,7 @@ fn_decode
     if (words > 1)
     {
         cp1600->r[7] = pc + 1;
-        instr->opcode.encoded.word1 = CP1600_RD(cp1600, pc + 1);
+        instr->opcode.encoded.word1 = w1 = CP1600_RD(cp1600, pc + 1);
     }
     if (words > 2)
     {
@@ -603,6 +603,11 @@ fn_decode
     /* -------------------------------------------------------------------- */
     prev_is_sdbd = (pw == 0x0001);
     dec_decode[(int)format](instr, &fn_execute);
+
+    if (cp1600->decode_hook)
+        fn_execute = cp1600->decode_hook(cp1600->decode_hook_opaque,
+                                         pc, w, w1, fn_execute);
+
     cycles = fn_execute(instr,cp1600);
 
     /* -------------------------------------------------------------------- */
@@ -676,7 +681,7 @@ typedef union instr_list_t
     instr_t instr;
 } instr_list_t;
 
-instr_list_t *instr_list_head = NULL;
+THREAD_LOCAL instr_list_t *instr_list_head = NULL;
 #define INSTR_CHUNK (16)
 
 instr_t * get_instr (void)
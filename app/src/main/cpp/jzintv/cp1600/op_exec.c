@@ -32,8 +32,8 @@
 #include <limits.h>
 
 
-int first_dis = -1;
-int last_dis  = -1;
+THREAD_LOCAL int first_dis = -1;
+THREAD_LOCAL int last_dis  = -1;
 
 int fn_invalid  (const instr_t *instr, cp1600_t *cp1600)
 {
@@ -406,7 +406,7 @@ int fn_JSR_ir   (const instr_t *instr, cp1600_t *cp1600)
 
 LOCAL uint16_t ext_addr_read(const instr_t *instr, cp1600_t *cp1600)
 {
-    extern int lto_isa_enabled;
+    extern THREAD_LOCAL int lto_isa_enabled;
     const int amode = instr->opcode.decoder.amode;
     const uint16_t reg0 = instr->opcode.decoder.reg0;
     const uint16_t imm0 = instr->opcode.decoder.imm0;
@@ -441,7 +441,7 @@ LOCAL uint16_t ext_addr_read(const instr_t *instr, cp1600_t *cp1600)
 
 LOCAL void ext_addr_write(const instr_t *instr, cp1600_t *cp1600, uint16_t data)
 {
-    extern int lto_isa_enabled;
+    extern THREAD_LOCAL int lto_isa_enabled;
     const int amode = instr->opcode.decoder.amode;
     const uint16_t imm0 = instr->opcode.decoder.imm0;
     const uint16_t xreg = instr->opcode.decoder.xreg0;
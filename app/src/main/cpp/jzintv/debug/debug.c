@@ -29,6 +29,9 @@
 #include "debug_tag.h"
 #include "debug_dasm1600.h"
 #include "debug/source.h"
+#include "debug/itrace.h"
+#include "debug/expr.h"
+#include "debug/symidx.h"
 
 #ifdef USE_GNU_READLINE
 # include <readline/readline.h>
@@ -46,6 +49,12 @@ LOCAL void debug_poke(periph_t *p, periph_t *r, uint32_t a, uint32_t d);
 LOCAL void debug_disasm_cache_inval(void);
 LOCAL void debug_print_reghist(int count, int offset);
 
+/* ------------------------------------------------------------------------ */
+/*  The debugger's state is process-wide:  it owns the terminal, after all. */
+/*  Only one instance at a time gets to run with it.                        */
+/* ------------------------------------------------------------------------ */
+LOCAL debug_t *debug_owner = NULL;
+
 LOCAL int dc_hits = 0, dc_miss = 0, dc_nocache = 0;
 LOCAL int dc_unhook_ok = 0, dc_unhook_odd = 0;
 
@@ -54,9 +63,15 @@ LOCAL uint32_t *debug_profile = NULL;
 LOCAL uint8_t  *debug_memattr = NULL;
 LOCAL uint16_t *debug_mempc   = NULL;
 LOCAL int       debug_rh_ptr = -1;
+LOCAL itrace_t  debug_itrace = { NULL };
 LOCAL int       debug_histinit = 0;
 LOCAL void debug_write_reghist(const char *, periph_t *, cp1600_t *);
+
+/* History and instruction traces need a debugger tick every instruction. */
+#define DEBUG_PER_INSTR() \
+    (debug_rh_ptr >= 0 || itrace_is_active(&debug_itrace))
 LOCAL symtab_t *debug_symtab;
+LOCAL symidx_t  debug_symidx;       /* Rebuilt whenever symbols are read.  */
 LOCAL int disasm_mode = 0;  /* -1 is disasm only, 0 is mixed, 1 is src only */
 
 LOCAL uint32_t debug_watch_w[0x10000 >> 5];
@@ -64,6 +79,47 @@ LOCAL uint32_t debug_watch_r[0x10000 >> 5];
 #define WATCHING(x,y) ((int)((debug_watch_##y[(x) >> 5] >> ((x) & 31)) & 1))
 #define WATCHTOG(x,y) ((debug_watch_##y[(x) >> 5] ^= 1u << ((x) & 31)))
 
+/*
+ * Breakpoints set with 'b', and watchpoints that stop on a read or write.
+ * Either may have a condition, compiled when it's set and evaluated only
+ * when the breakpoint's address is reached or a watched address accessed.
+ * 'hits' counts those; 'stops' counts the times the condition held.  The
+ * CPU's own breakpoint flags still decide where execution gets trapped.
+ */
+#define DEBUG_BK_EXEC  (0)
+#define DEBUG_BK_READ  (1)
+#define DEBUG_BK_WRITE (2)
+
+typedef struct debug_bkpt_t
+{
+    uint32_t    lo, hi;         /* Address range.  lo == hi for 'b'.        */
+    int         kind;           /* DEBUG_BK_EXEC, _READ or _WRITE.          */
+    expr_t     *cond;           /* NULL if unconditional.                   */
+    uint64_t    hits, stops;
+} debug_bkpt_t;
+
+LOCAL debug_bkpt_t *debug_bkpt = NULL;
+LOCAL int debug_num_bkpt = 0, debug_max_bkpt = 0;
+
+LOCAL uint32_t debug_wpt_r[0x10000 >> 5];
+LOCAL uint32_t debug_wpt_w[0x10000 >> 5];
+#define WPT(x,y) ((int)((debug_wpt_##y[(x) >> 5] >> ((x) & 31)) & 1))
+
+/*
+ * The debugger only sits on the bus decode for pages that need it:  pages
+ * with watches, JSR return windows and the stack trace window.  Showing
+ * all reads/writes or exact attribute logging hooks every page.  These
+ * bitmaps track which bus pages the debugger is currently mapped on.
+ */
+LOCAL uint32_t debug_hooked_r[0x10000 >> 5];
+LOCAL uint32_t debug_hooked_w[0x10000 >> 5];
+LOCAL int      debug_hooks_dirty = 1;
+LOCAL int      debug_hooks_all_r = -1, debug_hooks_all_w = -1;
+#define HOOKED(x,y)   ((int)((debug_hooked_##y[(x) >> 5] >> ((x) & 31)) & 1))
+
+LOCAL int      debug_ma_exact = 0;  /* Log attributes on every access.   */
+LOCAL int      debug_ma_cover = 1;  /* Sample PC as code at each tick.   */
+
 /* JSR table:  The first address is the address of the JSR and the second is
  * the return address.  JSR_RET_WINDOW is the lookahead window for watching
  * reads past the address of a JSR instruction to detect data-after-JSR.
@@ -73,8 +129,8 @@ LOCAL uint32_t debug_watch_r[0x10000 >> 5];
 LOCAL uint16_t debug_jsrs[MAX_JSRS][2];
 LOCAL int debug_num_jsrs = 0;
 
-int debug_fault_detected = 0;
-const char *debug_halt_reason = NULL;
+THREAD_LOCAL int debug_fault_detected = 0;
+THREAD_LOCAL const char *debug_halt_reason = NULL;
 
 LOCAL char str_null[] = "(null)";
 
@@ -116,7 +172,13 @@ LOCAL void debug_print_usage(void)
 "  z            Toggle showing timestamps during 'step'\n"
 "  x            Toggle showing CPU reads and writes during 'step'\n"
 "  b <#>        Set a 'B'reakpoint at <#>.  <#> defaults to the current PC.\n"
-"  b?           List active breakpoints.\n"
+"  b <#> if <e> Set a breakpoint that only stops when the expression <e>\n"
+"               is true.  Hits are counted without stopping.\n"
+"  bw <#1> <#2> Stop after a write to <#1> through <#2>.  <#2> defaults to\n"
+"               <#1>.  Add \"if <e>\" to only stop when <e> is true.\n"
+"  br <#1> <#2> Like \"bw\", but stop after a read.\n"
+"  nw <#>       Remove write watchpoints covering <#>.  \"nr\" for reads.\n"
+"  b?           List active breakpoints and watchpoints, with hit counts.\n"
 "  n <#>        u'N'set a breakpoint at <#>.  <#> defaults to the current PC \n"
 "  rs           'R'e'S'et the machine.\n"
 "\n"
@@ -175,8 +237,15 @@ LOCAL void debug_print_usage(void)
 "               history or attribute logging to be enabled.\n"
 "  h            Toggle history logging.  Use \"d\" to dump to \"dump.hst\"\n"
 "               and \"dump.cpu\"\n"
+"  ht <path>    Toggle writing a compact trace of every instruction to\n"
+"               <path>, \"dump.trc\" by default.  Convert it to text with\n"
+"               itrace2txt.\n"
 "  a            Toggle memory attribute logging.  Use \"d\" to dump to \n"
-"               \"dump.atr\"\n"
+"               \"dump.atr\".  This hooks every bus access and slows\n"
+"               emulation.\n"
+"  ac           Toggle sampled code coverage.  Cheaper than \"a\":  only\n"
+"               notes where the CPU is each time the debugger runs.\n"
+"  ar           Reset the memory attribute map.\n"
 "  ! <#1> <#2>  Print the last <#1> instructions that ran, ending <#2>\n"
 "               cycles back. <#1> defaults to 40, <#2> defaults to 0.\n"
 "\n"
@@ -211,6 +280,12 @@ LOCAL void debug_print_usage(void)
 ">> symbol table file.  These are output by as1600's -s flag.  You can load a\n"
 ">> symbol table into jzIntv with the --sym-file=<path> command line flag or\n"
 ">> with the 'L'oad command shown above\n"
+"\n"
+">> Expressions after \"if\" use C's operators and precedence.  Numbers are\n"
+">> decimal unless they start with $ or 0x.  R0-R7, SP, PC and the flags\n"
+">> S Z O C I D name CPU state, and [<e>] reads memory.  For watchpoints,\n"
+">> A and V are the address and value accessed.  For example:\n"
+">>     b 5012 if R1 > 10 && [$102] == 3\n"
 "\n"
     );
 }
@@ -218,30 +293,35 @@ LOCAL void debug_print_usage(void)
 /* ======================================================================== */
 /*  DEBUG_TAG_RANGE                                                         */
 /* ======================================================================== */
-void debug_tag_range(uint32_t lo, uint32_t hi, uint32_t flags)
+LOCAL int debug_alloc_memattr(void)
 {
-    if (!debug_memattr)
-    {
-        debug_memattr = CALLOC(uint8_t ,  0x10000);
-        debug_mempc   = CALLOC(uint16_t,  0x10000);
-        if (!debug_memattr || !debug_mempc)
-        {
-            CONDFREE(debug_memattr);
-            CONDFREE(debug_mempc  );
-            return;
-        }
-    }
     if (debug_memattr)
+        return 0;
+
+    debug_memattr = CALLOC(uint8_t ,  0x10000);
+    debug_mempc   = CALLOC(uint16_t,  0x10000);
+    if (!debug_memattr || !debug_mempc)
     {
-        while (lo <= hi)
-            debug_memattr[lo++] |= flags;
+        CONDFREE(debug_memattr);
+        CONDFREE(debug_mempc  );
+        return -1;
     }
+    return 0;
+}
+
+void debug_tag_range(uint32_t lo, uint32_t hi, uint32_t flags)
+{
+    if (debug_alloc_memattr())
+        return;
+
+    while (lo <= hi)
+        debug_memattr[lo++] |= flags;
 }
 
 /* ======================================================================== */
-/*  DEBUG_READ_SYMTBL                                                       */
+/*  DEBUG_READ_SYMTBL    -- Add the symbols in an as1600 .sym file.         */
 /* ======================================================================== */
-LOCAL void debug_read_symtbl(const char *fname)
+void debug_read_symtbl(const char *fname)
 {
     LZFILE *f;
     char buf[512], symb[512];
@@ -298,6 +378,21 @@ LOCAL void debug_read_symtbl(const char *fname)
     }
 
     lzoe_fclose(f);
+
+    if (symidx_build(&debug_symidx, debug_symtab))
+        jzp_printf("debug: Out of memory indexing symbols\n");
+}
+
+/* ======================================================================== */
+/*  DEBUG_FREE_SYMTBL    -- Forget all symbols.                             */
+/* ======================================================================== */
+void debug_free_symtbl(void)
+{
+    if (debug_symtab)
+        symtab_destroy(debug_symtab);
+
+    debug_symtab = NULL;
+    symidx_free(&debug_symidx);
 }
 
 /* ======================================================================== */
@@ -312,7 +407,7 @@ LOCAL int debug_decode_val(const char *str, uint32_t maxval)
     int must_hex = 0;
 
     if (s[0] == '$') { s++; must_hex = 1; }
-    else if (debug_symtab && (symtab_getaddr(debug_symtab, s, &val) == 0))
+    else if (symidx_lookup(&debug_symidx, s, &val) == 0)
         goto got_it;
 
     for (x = s; *x; x++)
@@ -344,31 +439,15 @@ got_it:
 /*  DEBUG_SYMB_FOR_ADDR  -- Returns symbol associated with and address, or  */
 /*                          NULL if there is none.  Performs no formatting. */
 /*                                                                          */
-/*  Prefers symbols that start w/out a '.' if available.                    */
+/*  Prefers symbols that start w/out a '.' if available.  The symbol index  */
+/*  works that out ahead of time.                                           */
 /* ======================================================================== */
 const char *debug_symb_for_addr
 (
     const uint32_t addr
 )
 {
-    if (!debug_symtab)
-        return NULL;
-
-    const char *best_symb = NULL;
-    const char *curr_symb = NULL;
-    int which = 0;
-
-    do {
-        curr_symb = symtab_getsym(debug_symtab, addr, 0, which);
-        if (curr_symb)
-        {
-            if (!best_symb || curr_symb[0] != '.')
-                best_symb = curr_symb;
-        }
-        which++;
-    } while (curr_symb && best_symb[0] == '.');
-
-    return best_symb;
+    return symidx_best(&debug_symidx, addr);
 }
 
 /* ======================================================================== */
@@ -467,7 +546,13 @@ LOCAL void debug_search_symbol(const char *search_string)
     *s = 0;
 
     if (*start)
-        symtab_grep_for_symbol(debug_symtab, print_symbol, start);
+    {
+        int i;
+
+        for (i = 0; i < debug_symidx.num; i++)
+            if (strstr(debug_symidx.name[i], start))
+                print_symbol(debug_symidx.name[i], debug_symidx.addr[i], 0);
+    }
 
     for (s = start; *s; s++)
         if (!(isdigit(*s) || (toupper(*s) >= 'A' && toupper(*s) <= 'F')))
@@ -479,7 +564,7 @@ must_hex:
         int i = 0;
         const char *symb;
 
-        while ((symb = symtab_getsym(debug_symtab, addr, 0, i)) != NULL)
+        while ((symb = symidx_at(&debug_symidx, addr, i)) != NULL)
         {
             print_symbol(symb, addr, i);
             i++;
@@ -490,6 +575,159 @@ not_hex:
     free(copy);
 }
 
+/* ======================================================================== */
+/*  DEBUG_HOOK_ADDR   -- Map the debugger onto the bus page holding a read  */
+/*                       address right away.  This only adds to the bus     */
+/*                       decode, so it's safe from inside debug_rd.         */
+/* ======================================================================== */
+LOCAL void debug_hook_addr(uint32_t addr)
+{
+    debug_t *const debug = debug_owner;
+    periph_bus_t *bus;
+    uint32_t page, shift;
+
+    if (!debug || !(bus = debug->periph.bus))
+        return;
+
+    shift = bus->decode_shift;
+    page  = (addr & 0xFFFF) >> shift;
+
+    if (!HOOKED(page,r))
+    {
+        periph_map(bus, AS_PERIPH(debug), page << shift,
+                   ((page + 1) << shift) - 1, PERIPH_MAP_RD);
+        debug_hooked_r[page >> 5] |= 1u << (page & 31);
+    }
+}
+
+/* ======================================================================== */
+/*  DEBUG_SYNC_HOOKS  -- Bring the debugger's bus mappings in line with     */
+/*                       what it currently needs to see.  Called whenever   */
+/*                       control goes back to the CPU.  Does nothing unless */
+/*                       watches, tracepoints or display flags changed.     */
+/* ======================================================================== */
+LOCAL void debug_sync_page(periph_bus_t *bus, periph_t *p, uint32_t page,
+                           const uint32_t *want, uint32_t *hooked, int which)
+{
+    const uint32_t shift = bus->decode_shift;
+    const uint32_t bit   = 1u << (page & 31);
+    const int      is_on = (hooked[page >> 5] & bit) != 0;
+
+    if (((want[page >> 5] & bit) != 0) == is_on)
+        return;
+
+    if (is_on)
+        periph_unmap(bus, p, page << shift, ((page+1) << shift) - 1, which);
+    else
+        periph_map  (bus, p, page << shift, ((page+1) << shift) - 1, which);
+
+    hooked[page >> 5] ^= bit;
+}
+
+LOCAL int debug_count_hooked(const debug_t *const debug,
+                             const uint32_t *const hooked)
+{
+    const periph_bus_t *const bus = debug->periph.bus;
+    uint32_t page;
+    int count = 0;
+
+    if (bus)
+        for (page = 0; page < (0x10000u >> bus->decode_shift); page++)
+            count += (hooked[page >> 5] >> (page & 31)) & 1;
+
+    return count;
+}
+
+LOCAL void debug_sync_hooks(debug_t *const debug)
+{
+    static uint32_t want_r[0x10000 >> 5], want_w[0x10000 >> 5];
+    periph_bus_t *const bus = debug->periph.bus;
+    const int all_r = debug->show_rd || debug_ma_exact;
+    const int all_w = debug->show_wr || debug_ma_exact;
+    uint32_t shift, page, addr;
+    int i, j;
+
+    if (!bus)
+        return;
+
+    if (!debug_hooks_dirty && all_r == debug_hooks_all_r
+                           && all_w == debug_hooks_all_w)
+        return;
+
+    debug_hooks_dirty = 0;
+    debug_hooks_all_r = all_r;
+    debug_hooks_all_w = all_w;
+
+#define WANT(x,y) (want_##y[((x) >> shift) >> 5] |= \
+                                            1u << (((x) >> shift) & 31))
+    shift = bus->decode_shift;
+    memset(want_r, all_r ? 0xFF : 0, sizeof(want_r));
+    memset(want_w, all_w ? 0xFF : 0, sizeof(want_w));
+
+    /* -------------------------------------------------------------------- */
+    /*  Pages with read or write watches.                                   */
+    /* -------------------------------------------------------------------- */
+    for (i = 0; i < (0x10000 >> 5); i++)
+    {
+        if (!debug_watch_r[i] && !debug_watch_w[i])
+            continue;
+
+        for (addr = i << 5; addr < (uint32_t)(i + 1) << 5; addr++)
+        {
+            if (WATCHING(addr,r)) WANT(addr,r);
+            if (WATCHING(addr,w)) WANT(addr,w);
+        }
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Pages with watchpoints.                                             */
+    /* -------------------------------------------------------------------- */
+    for (i = 0; i < (0x10000 >> 5); i++)
+    {
+        if (!debug_wpt_r[i] && !debug_wpt_w[i])
+            continue;
+
+        for (addr = i << 5; addr < (uint32_t)(i + 1) << 5; addr++)
+        {
+            if (WPT(addr,r)) WANT(addr,r);
+            if (WPT(addr,w)) WANT(addr,w);
+        }
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Return windows of JSRs we're stepping over.  debug_chk_jsr_ret     */
+    /*  needs to see reads of any arguments that follow the JSR.            */
+    /* -------------------------------------------------------------------- */
+    for (i = 0; i < debug_num_jsrs; i++)
+        for (j = 0; j <= JSR_RET_WINDOW; j++)
+        {
+            addr = (debug_jsrs[i][1] + j) & 0xFFFF;
+            WANT(addr,r);
+        }
+
+#ifdef STK_TRC
+    /* -------------------------------------------------------------------- */
+    /*  The stack trace window, if we're tracing the stack.                 */
+    /* -------------------------------------------------------------------- */
+    if (stk_trc)
+        for (i = 0; i < MAX_STK; i++)
+        {
+            addr = (stk_base + i) & 0xFFFF;
+            WANT(addr,r);
+            WANT(addr,w);
+        }
+#endif
+#undef WANT
+
+    for (page = 0; page < (0x10000u >> shift); page++)
+    {
+        debug_sync_page(bus, AS_PERIPH(debug), page, want_r, debug_hooked_r,
+                        PERIPH_MAP_RD);
+        debug_sync_page(bus, AS_PERIPH(debug), page, want_w, debug_hooked_w,
+                        PERIPH_MAP_WR);
+    }
+}
+
 /* ======================================================================== */
 /*  DEBUG_HIT_JSR_RET -- Get JSR address for apparent "step over" PC addr,  */
 /*                       and remove address from list of active tracepoints */
@@ -510,6 +748,7 @@ LOCAL uint32_t debug_get_jsr_addr(uint32_t ret_addr)
                 debug_jsrs[i][1] = debug_jsrs[j][1];
             }
             debug_num_jsrs--;
+            debug_hooks_dirty = 1;
         }
     }
 
@@ -524,6 +763,8 @@ LOCAL void debug_set_jsr_ret(uint32_t jsr_addr, uint32_t ret_addr)
 {
     int i;
 
+    debug_hooks_dirty = 1;
+
     /* Replace redundant tracepoints */
     for (i = 0; i < debug_num_jsrs; i++)
         if (debug_jsrs[i][0] == jsr_addr)
@@ -549,7 +790,7 @@ LOCAL void debug_set_jsr_ret(uint32_t jsr_addr, uint32_t ret_addr)
 /* ======================================================================== */
 LOCAL void debug_chk_jsr_ret(cp1600_t *cp, uint32_t read_addr)
 {
-    int i;
+    int i, j;
 
     /* -------------------------------------------------------------------- */
     /*  Ignore reads if we have no tracepoints set or the read is an        */
@@ -574,6 +815,11 @@ LOCAL void debug_chk_jsr_ret(cp1600_t *cp, uint32_t read_addr)
             cp1600_clr_breakpt(cp, debug_jsrs[i][1], CP1600_BKPT_ONCE);
             cp1600_set_breakpt(cp, read_addr + 1,    CP1600_BKPT_ONCE);
             debug_jsrs[i][1] = read_addr + 1;
+
+            /* Keep seeing reads in the moved window; trim at next sync. */
+            for (j = 0; j <= JSR_RET_WINDOW; j++)
+                debug_hook_addr(read_addr + 1 + j);
+            debug_hooks_dirty = 1;
             return;
         }
     }
@@ -654,11 +900,11 @@ LOCAL uint16_t debug_infer_stack(cp1600_t *const cp)
     uint32_t val;
 
     /* First look for the symbol _m.stk */
-    if (debug_symtab && (symtab_getaddr(debug_symtab, "_m.stk", &val) == 0))
+    if (symidx_lookup(&debug_symidx, "_m.stk", &val) == 0)
         return val;
 
     /* Next look for the symbol STACK */
-    if (debug_symtab && (symtab_getaddr(debug_symtab, "STACK", &val) == 0))
+    if (symidx_lookup(&debug_symidx, "STACK", &val) == 0)
         return val;
 
     /* Finally, assume R6 is at bottom of stack. */
@@ -666,10 +912,303 @@ LOCAL uint16_t debug_infer_stack(cp1600_t *const cp)
 }
 #endif
 
+/* ======================================================================== */
+/*  DEBUG_EXPR_SYM   -- Look up a symbol for an expression.                 */
+/*  DEBUG_EXPR_PEEK  -- Read memory for an expression.  We may be called    */
+/*                      from inside a bus access, so don't disturb it.      */
+/* ======================================================================== */
+LOCAL int debug_expr_sym(void *opaque, const char *name, uint32_t *value)
+{
+    UNUSED(opaque);
+    return symidx_lookup(&debug_symidx, name, value);
+}
+
+LOCAL uint32_t debug_expr_peek(void *opaque, uint32_t addr)
+{
+    debug_t  *const debug = (debug_t *)opaque;
+    periph_t *const bus   = AS_PERIPH(debug->periph.bus);
+    periph_t *const req   = bus->req;
+    const int       busy  = bus->busy;
+    uint32_t        data;
+
+    data = periph_peek(bus, AS_PERIPH(debug), addr & 0xFFFF, ~0U);
+    bus->busy = busy;
+    bus->req  = req;
+
+    return data;
+}
+
+/* ======================================================================== */
+/*  DEBUG_COND_TRUE  -- Evaluate a breakpoint or watchpoint's condition.    */
+/* ======================================================================== */
+LOCAL int debug_cond_true(debug_t *const debug, const expr_t *const cond,
+                          const uint32_t addr, const uint32_t data)
+{
+    const cp1600_t *const cp = debug->cp1600;
+    expr_env_t env;
+    int i;
+
+    if (!cond)
+        return 1;
+
+    for (i = 0; i < 8; i++)
+        env.var[EXPR_R0 + i] = cp->r[i];
+
+    env.var[EXPR_S] = !!cp->S;
+    env.var[EXPR_Z] = !!cp->Z;
+    env.var[EXPR_O] = !!cp->O;
+    env.var[EXPR_C] = !!cp->C;
+    env.var[EXPR_I] = !!cp->I;
+    env.var[EXPR_D] = !!cp->D;
+    env.var[EXPR_A] = addr;
+    env.var[EXPR_V] = data;
+    env.peek        = debug_expr_peek;
+    env.opaque      = debug;
+
+    return expr_eval(cond, &env) != 0;
+}
+
+/* ======================================================================== */
+/*  DEBUG_FIND_BKPT  -- Find a breakpoint or watchpoint by kind and range.  */
+/*  DEBUG_ADD_BKPT   -- Add one, replacing any with the same kind and range */
+/*  DEBUG_DEL_BKPT   -- Remove those of a kind that cover an address.       */
+/*                      Returns the number removed.                         */
+/* ======================================================================== */
+LOCAL int debug_find_bkpt(const int kind, const uint32_t lo,
+                          const uint32_t hi)
+{
+    int i;
+
+    for (i = 0; i < debug_num_bkpt; i++)
+        if (debug_bkpt[i].kind == kind &&
+            debug_bkpt[i].lo == lo && debug_bkpt[i].hi == hi)
+            return i;
+
+    return -1;
+}
+
+LOCAL void debug_update_wpts(void)
+{
+    uint32_t addr;
+    int i;
+
+    memset(debug_wpt_r, 0, sizeof(debug_wpt_r));
+    memset(debug_wpt_w, 0, sizeof(debug_wpt_w));
+
+    for (i = 0; i < debug_num_bkpt; i++)
+    {
+        const int kind = debug_bkpt[i].kind;
+        uint32_t *const bmap = kind == DEBUG_BK_READ  ? debug_wpt_r
+                             : kind == DEBUG_BK_WRITE ? debug_wpt_w : NULL;
+        if (bmap)
+            for (addr = debug_bkpt[i].lo; addr <= debug_bkpt[i].hi; addr++)
+                bmap[addr >> 5] |= 1u << (addr & 31);
+    }
+
+    debug_hooks_dirty = 1;
+}
+
+LOCAL int debug_add_bkpt(const int kind, const uint32_t lo,
+                         const uint32_t hi, expr_t *const cond)
+{
+    int i = debug_find_bkpt(kind, lo, hi);
+
+    if (i < 0)
+    {
+        if (debug_num_bkpt == debug_max_bkpt)
+        {
+            debug_bkpt_t *const bkpt = REALLOC(debug_bkpt, debug_bkpt_t,
+                                               debug_max_bkpt * 2 + 16);
+            if (!bkpt)
+            {
+                jzp_printf("Out of memory\n");
+                expr_free(cond);
+                return -1;
+            }
+            debug_bkpt      = bkpt;
+            debug_max_bkpt  = debug_max_bkpt * 2 + 16;
+        }
+        i = debug_num_bkpt++;
+    } else
+        expr_free(debug_bkpt[i].cond);
+
+    debug_bkpt[i].lo    = lo;
+    debug_bkpt[i].hi    = hi;
+    debug_bkpt[i].kind  = kind;
+    debug_bkpt[i].cond  = cond;
+    debug_bkpt[i].hits  = 0;
+    debug_bkpt[i].stops = 0;
+
+    if (kind != DEBUG_BK_EXEC)
+        debug_update_wpts();
+
+    return 0;
+}
+
+LOCAL int debug_del_bkpt(const int kind, const uint32_t addr)
+{
+    int i, j, removed = 0;
+
+    for (i = j = 0; i < debug_num_bkpt; i++)
+    {
+        if (debug_bkpt[i].kind == kind &&
+            debug_bkpt[i].lo <= addr && addr <= debug_bkpt[i].hi)
+        {
+            expr_free(debug_bkpt[i].cond);
+            removed++;
+        } else
+            debug_bkpt[j++] = debug_bkpt[i];
+    }
+    debug_num_bkpt = j;
+
+    if (kind != DEBUG_BK_EXEC && removed)
+        debug_update_wpts();
+
+    return removed;
+}
+
+LOCAL void debug_free_bkpts(void)
+{
+    int i;
+
+    for (i = 0; i < debug_num_bkpt; i++)
+        expr_free(debug_bkpt[i].cond);
+
+    CONDFREE(debug_bkpt);
+    debug_num_bkpt = debug_max_bkpt = 0;
+    debug_update_wpts();
+}
+
+/* ======================================================================== */
+/*  DEBUG_CHECK_BKPT -- The CPU trapped on a breakpoint at 'pc'.  Count the */
+/*                      hit, and return non-zero if we should stop.         */
+/* ======================================================================== */
+LOCAL int debug_check_bkpt(debug_t *const debug, const uint32_t pc)
+{
+    const int i = debug_find_bkpt(DEBUG_BK_EXEC, pc, pc);
+
+    if (i < 0)
+        return 1;
+
+    debug_bkpt[i].hits++;
+    if (!debug_cond_true(debug, debug_bkpt[i].cond, pc, 0))
+        return 0;
+
+    debug_bkpt[i].stops++;
+    return 1;
+}
+
+/* ======================================================================== */
+/*  DEBUG_CHECK_WPT  -- A watched address was accessed.  Count the hit in   */
+/*                      each watchpoint that covers it, and if any of their */
+/*                      conditions hold, stop after this instruction.       */
+/* ======================================================================== */
+LOCAL void debug_check_wpt(debug_t *const debug, const int kind,
+                           const uint32_t addr, const uint32_t data)
+{
+    static char reason[100];
+    cp1600_t *const cp = debug->cp1600;
+    int i, stop = 0;
+
+    for (i = 0; i < debug_num_bkpt; i++)
+    {
+        debug_bkpt_t *const bk = &debug_bkpt[i];
+
+        if (bk->kind != kind || addr < bk->lo || addr > bk->hi)
+            continue;
+
+        bk->hits++;
+        if (debug_cond_true(debug, bk->cond, addr, data))
+        {
+            bk->stops++;
+            stop = 1;
+        }
+    }
+
+    if (!stop || debug_fault_detected)
+        return;
+
+    snprintf(reason, sizeof(reason), "%s watchpoint: $%.4X %s $%.4X at "
+             "PC = $%.4X", kind == DEBUG_BK_READ ? "Read" : "Write",
+             data & 0xFFFF, kind == DEBUG_BK_READ ? "from" : "to",
+             addr, cp->oldpc);
+
+    debug_fault_detected = DEBUG_ASYNC_HALT;
+    debug_halt_reason    = reason;
+    cp->steps_remaining  = 1;
+}
+
+/* ======================================================================== */
+/*  DEBUG_SPLIT_COND -- Split "<args> if <expr>" after the args.  Returns   */
+/*                      the expression, or NULL if there's no "if".         */
+/* ======================================================================== */
+LOCAL char *debug_split_cond(char *const s)
+{
+    char *t;
+
+    for (t = s; *t; t++)
+        if ((t == s || isspace(t[-1])) && toupper(t[0]) == 'I' &&
+            toupper(t[1]) == 'F' && (!t[2] || isspace(t[2])))
+        {
+            *t = 0;
+            for (t += 2; isspace(*t); t++)
+                ;
+            return t;
+        }
+
+    return NULL;
+}
+
+/* ======================================================================== */
+/*  DEBUG_COMPILE_COND   -- Compile a condition, complaining on failure.    */
+/* ======================================================================== */
+LOCAL int debug_compile_cond(const char *const text, expr_t **const cond)
+{
+    char err[100];
+
+    *cond = NULL;
+    if (!text)
+        return 0;
+
+    if (!(*cond = expr_compile(text, debug_expr_sym, NULL, err, sizeof(err))))
+    {
+        jzp_printf("Bad condition: %s\n", err);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* ======================================================================== */
+/*  DEBUG_PRINT_BKPT_INFO    -- Print a breakpoint's condition and counts.  */
+/* ======================================================================== */
+LOCAL void debug_print_bkpt_info(const debug_bkpt_t *const bk)
+{
+    if (bk->cond)
+        jzp_printf(" if %s  (%" U64_FMT " hits, %" U64_FMT " stops)",
+                   bk->cond->text, bk->hits, bk->stops);
+    else
+        jzp_printf("  (%" U64_FMT " hits)", bk->hits);
+}
+
 /* ======================================================================== */
 /*  DEBUG_PRINT_BREAKPT_CB   -- Callback for printing out a breakpoint.     */
+/*  DEBUG_PRINT_TRACEPT_CB   -- Callback for printing out a tracepoint.     */
 /* ======================================================================== */
 LOCAL void debug_print_breakpt_cb(void *opaque, uint32_t addr)
+{
+    debug_t *const debug = (debug_t *)opaque;
+    const int i = debug_find_bkpt(DEBUG_BK_EXEC, addr, addr);
+    char lblbuf[1024];
+
+    jzp_printf(">> %s",
+               debug_format_addr(debug, addr, lblbuf, sizeof(lblbuf)));
+    if (i >= 0)
+        debug_print_bkpt_info(&debug_bkpt[i]);
+    jzp_printf("\n");
+}
+
+LOCAL void debug_print_tracept_cb(void *opaque, uint32_t addr)
 {
     debug_t *const debug = (debug_t *)opaque;
     char lblbuf[1024];
@@ -677,19 +1216,38 @@ LOCAL void debug_print_breakpt_cb(void *opaque, uint32_t addr)
 }
 
 /* ======================================================================== */
-/*  DEBUG_LIST_BREAKPOINTS   -- List active breakpoints                     */
+/*  DEBUG_LIST_BREAKPOINTS   -- List active breakpoints and watchpoints     */
 /*  DEBUG_LIST_TRACEPOINTS   -- List active tracepoints                     */
 /* ======================================================================== */
 LOCAL void debug_list_breakpoints(debug_t *const debug, cp1600_t *const cp)
 {
+    char lblbuf[1024];
+    int i;
+
     jzp_printf("Breakpoints:\n");
     cp1600_list_breakpts(cp, CP1600_BKPT, debug_print_breakpt_cb, debug);
+
+    for (i = 0; i < debug_num_bkpt; i++)
+    {
+        const debug_bkpt_t *const bk = &debug_bkpt[i];
+
+        if (bk->kind == DEBUG_BK_EXEC)
+            continue;
+
+        jzp_printf(">> %s %s", bk->kind == DEBUG_BK_READ ? "Read" : "Write",
+                   debug_format_addr(debug, bk->lo, lblbuf, sizeof(lblbuf)));
+        if (bk->hi != bk->lo)
+            jzp_printf(" - %s",
+                   debug_format_addr(debug, bk->hi, lblbuf, sizeof(lblbuf)));
+        debug_print_bkpt_info(bk);
+        jzp_printf("\n");
+    }
 }
 
 LOCAL void debug_list_tracepoints(debug_t *const debug, cp1600_t *const cp)
 {
     jzp_printf("Tracepoints:\n");
-    cp1600_list_breakpts(cp, CP1600_BKPT_ONCE, debug_print_breakpt_cb, debug);
+    cp1600_list_breakpts(cp, CP1600_BKPT_ONCE, debug_print_tracept_cb, debug);
 }
 
 /* ======================================================================== */
@@ -824,13 +1382,21 @@ LOCAL int debug_readline(char *const buf, const size_t buf_size,
 }
 
 /* ======================================================================== */
-/*  DEBUG_READLINE_NO_COMPLETIONS    -- Never expand completions.  Sorry.   */
+/*  DEBUG_READLINE_COMPLETE_SYMBOL   -- Complete symbol names.  Readline    */
+/*                                      asks with state == 0 first, then    */
+/*                                      keeps asking until we return NULL.  */
 /* ======================================================================== */
-LOCAL char *debug_readline_no_completions(const char *text, int state)
+LOCAL char *debug_readline_complete_symbol(const char *text, int state)
 {
-    UNUSED(text);
-    UNUSED(state);
-    return NULL;
+    static int next = 0, last = 0;
+
+    if (state == 0)
+    {
+        const int count = symidx_prefix(&debug_symidx, text, &next);
+        last = next + count;
+    }
+
+    return next < last ? strdup(debug_symidx.name[next++]) : NULL;
 }
 
 /* ======================================================================== */
@@ -870,6 +1436,9 @@ uint32_t debug_rd(periph_t *p, periph_t *r, uint32_t a, uint32_t d)
 
     debug_chk_jsr_ret(cp, a);
 
+    if (WPT(a,r))
+        debug_check_wpt(debug, DEBUG_BK_READ, a, debug_expr_peek(debug, a));
+
     if (debug->show_rd || WATCHING(a,r))
     {
         jzp_printf(" RD a=%s d=%.4X %-16s (PC = %s) t=%" U64_FMT "\n",
@@ -879,7 +1448,7 @@ uint32_t debug_rd(periph_t *p, periph_t *r, uint32_t a, uint32_t d)
                 cp->periph.now);
     }
 
-    if (debug_memattr)
+    if (debug_ma_exact && debug_memattr)
     {
         if (cp->r[7] == a)
             debug_memattr[a] |= DEBUG_MA_CODE;
@@ -922,6 +1491,9 @@ void    debug_wr(periph_t *p, periph_t *r, uint32_t a, uint32_t d)
     if (p == r->req)
         return;
 
+    if (WPT(a,w))
+        debug_check_wpt(debug, DEBUG_BK_WRITE, a, d);
+
     if (debug->show_wr || WATCHING(a,w))
     {
         jzp_printf(" WR a=%s d=%.4X %-16s (PC = %s) t=%" U64_FMT "\n",
@@ -931,7 +1503,7 @@ void    debug_wr(periph_t *p, periph_t *r, uint32_t a, uint32_t d)
                 cp->periph.now);
     }
 
-    if (debug_memattr)
+    if (debug_ma_exact && debug_memattr)
     {
         debug_memattr[a] |= DEBUG_MA_DATA | DEBUG_MA_WRITE;
         debug_mempc  [a]  = cp->r[7];
@@ -995,6 +1567,18 @@ static const char *symb_format_desc[4] =
 
 static int non_int_threshold = 54;
 
+LOCAL uint32_t debug_pack_flags(const cp1600_t *const cp, const int req_ack)
+{
+    return 1 + ((!!cp->S    ) << 1) +
+               ((!!cp->C    ) << 2) +
+               ((!!cp->O    ) << 3) +
+               ((!!cp->Z    ) << 4) +
+               ((!!cp->I    ) << 5) +
+               ((!!cp->D    ) << 6) +
+               ((!!cp->intr ) << 7) +
+               ((req_ack    ) << 8);
+}
+
 LOCAL void debug_record_registers(debug_t *const debug, const uint64_t now,
                              const int req_ack)
 {
@@ -1006,15 +1590,8 @@ LOCAL void debug_record_registers(debug_t *const debug, const uint64_t now,
 
     memcpy(debug_reghist + debug_rh_ptr * RH_RECSIZE, cp->r, 16);
 
-    debug_reghist[debug_rh_ptr * RH_RECSIZE + 8] = 1 +
-                                          ((!!cp->S    ) << 1) +
-                                          ((!!cp->C    ) << 2) +
-                                          ((!!cp->O    ) << 3) +
-                                          ((!!cp->Z    ) << 4) +
-                                          ((!!cp->I    ) << 5) +
-                                          ((!!cp->D    ) << 6) +
-                                          ((!!cp->intr ) << 7) +
-                                          ((req_ack    ) << 8);
+    debug_reghist[debug_rh_ptr * RH_RECSIZE + 8] =
+        debug_pack_flags(cp, req_ack);
 
     for (int i = 0; i < 3; i++)
         debug_reghist[debug_rh_ptr * RH_RECSIZE + 9 + i] =
@@ -1028,7 +1605,33 @@ LOCAL void debug_record_registers(debug_t *const debug, const uint64_t now,
     debug_rh_ptr = (debug_rh_ptr + 1) & HISTMASK;
 }
 
-uint32_t debug_tk(periph_t *p, uint32_t len)
+/* ======================================================================== */
+/*  DEBUG_TRACE_INSTR    -- Append the current instruction to the compact   */
+/*                          instruction trace.  Only peeks the opcode words */
+/*                          the instruction actually has.                   */
+/* ======================================================================== */
+LOCAL void debug_trace_instr(debug_t *const debug, const uint64_t now,
+                             const int req_ack)
+{
+    cp1600_t *const cp  = debug->cp1600;
+    periph_t *const bus = AS_PERIPH(debug->periph.bus);
+    const uint32_t  pc  = cp->r[7];
+    uint16_t regs[8], words[3] = { 0, 0, 0 };
+    int i, n;
+
+    for (i = 0; i < 8; i++)
+        regs[i] = cp->r[i];
+
+    words[0] = periph_peek(bus, AS_PERIPH(debug), pc, ~0);
+    n = itrace_num_words(words[0], cp->D);
+    for (i = 1; i < n; i++)
+        words[i] = periph_peek(bus, AS_PERIPH(debug), (pc + i) & 0xFFFF, ~0);
+
+    itrace_record(&debug_itrace, regs, debug_pack_flags(cp, req_ack),
+                  words, now);
+}
+
+LOCAL uint32_t debug_tk_cmd(periph_t *p, uint32_t len)
 {
     debug_t  *debug = PERIPH_AS(debug_t, p);
     cp1600_t *cp = debug->cp1600;
@@ -1043,6 +1646,8 @@ uint32_t debug_tk(periph_t *p, uint32_t len)
     static   uint32_t fast_fwd  = 0, ff_bkpt = 0;
     static   uint64_t prev_rh_now     = 0;
     static   int      prev_rh_req_ack = 0;
+    static   uint64_t prev_it_now     = 0;
+    static   int      prev_it_req_ack = 0;
     int32_t  slen = (int32_t)len;
     uint64_t instrs = cp->tot_instr - debug->tot_instr;
     uint64_t now = cp->periph.now;
@@ -1102,6 +1707,17 @@ uint32_t debug_tk(periph_t *p, uint32_t len)
     }
     prev_pc = pc;
 
+    /* -------------------------------------------------------------------- */
+    /*  If we're writing an instruction trace, append this instruction.     */
+    /* -------------------------------------------------------------------- */
+    if (itrace_is_active(&debug_itrace) &&
+        (now != prev_it_now || req_ack != prev_it_req_ack))
+    {
+        prev_it_now     = now;
+        prev_it_req_ack = req_ack;
+        debug_trace_instr(debug, now, req_ack);
+    }
+
     /* -------------------------------------------------------------------- */
     /*  If slen == -CYC_MAX, we're crashing.                                */
     /* -------------------------------------------------------------------- */
@@ -1191,20 +1807,32 @@ uint32_t debug_tk(periph_t *p, uint32_t len)
             if (debug->step_count > 0)
                 debug->step_count--;
 
-            if (debug_rh_ptr < 0)
+            if (!DEBUG_PER_INSTR())
                 cp->step_count = 1;
         }
 
         /* ---------------------------------------------------------------- */
-        /*  If we hit a breakpoint or anything other than a tracepoint,     */
-        /*  drop into the debugger.  In the case of a breakpoint, let the   */
-        /*  user know that we hit a breakpoint.                             */
+        /*  If we hit a breakpoint whose condition is false, just count it  */
+        /*  and carry on as if it weren't there.                            */
+        /*                                                                  */
+        /*  Otherwise, if we hit a breakpoint or anything other than a      */
+        /*  tracepoint, drop into the debugger.  In the case of a           */
+        /*  breakpoint, let the user know that we hit a breakpoint.         */
         /* ---------------------------------------------------------------- */
-        if (cp->hit_breakpoint == BK_BREAKPOINT)
-            jzp_printf(fast_fwd ? "Fast forwarded to $%.4X\n" :
-                                  "Hit breakpoint at $%.4X\n", pc);
-        if (cp->hit_breakpoint != BK_TRACEPOINT)
-            debug->step_count = 0;
+        if (cp->hit_breakpoint == BK_BREAKPOINT && slen != -CYC_MAX &&
+            !fast_fwd && !debug_check_bkpt(debug, pc))
+        {
+            cp->hit_breakpoint = BK_NONE;
+            if (debug->step_count < 0 && !debug->show_ins)
+                return len;
+        } else
+        {
+            if (cp->hit_breakpoint == BK_BREAKPOINT)
+                jzp_printf(fast_fwd ? "Fast forwarded to $%.4X\n" :
+                                      "Hit breakpoint at $%.4X\n", pc);
+            if (cp->hit_breakpoint != BK_TRACEPOINT)
+                debug->step_count = 0;
+        }
     }
 
     /* -------------------------------------------------------------------- */
@@ -1298,7 +1926,7 @@ show_disassem:
     if (debug->step_count == 0 /*|| !len*/)
     {
         int cmd = 0, c, c2 = -1, c3 = -1, arg = -1, arg2 = -1;
-        char argstr[101], argstr2[101];
+        char argstr[101], argstr2[101], *cond_text = NULL;
         static int over = 0;
 
         if (wind < 0)
@@ -1320,6 +1948,7 @@ next_cmd:
             s = buf;
 
             cmd = -1;
+            cond_text = NULL;
 
             /* ignore leading whitespace */
             while (*s && isspace(*s)) s++;
@@ -1364,13 +1993,14 @@ next_cmd:
             /* NI for non-interruptible threshold. */
             if (c == 'N')
             {
-                if (c2 == 'I' && isspace(c3)) s++;
+                if ((c2 == 'I' || c2 == 'W' || c2 == 'R') && isspace(c3)) s++;
                 else c2 = -1;
             }
 
             if (c == 'B')
             {
-                if ((c2 == 'B' || c2 == 'I') && isspace(c3)) s++;
+                if ((c2 == 'B' || c2 == 'I' || c2 == 'W' || c2 == 'R') &&
+                    isspace(c3)) s++;
                 else if (c2 != '?') c2 = -1;
             }
 
@@ -1388,6 +2018,20 @@ next_cmd:
                 else c2 = -1;
             }
 
+            /* HT toggles the compact instruction trace. */
+            if (c == 'H')
+            {
+                if (c2 == 'T' && isspace(c3)) s++;
+                else c2 = -1;
+            }
+
+            /* AC for sampled coverage, AR to reset the attribute map. */
+            if (c == 'A')
+            {
+                if ((c2 == 'C' || c2 == 'R') && isspace(c3)) s++;
+                else c2 = -1;
+            }
+
             /* RS means reset. */
             if (c == 'R')
             {
@@ -1411,6 +2055,8 @@ next_cmd:
             if (c == 'B' && c2 == 'B') cmd = 37;   /* Break on missing BUSRQ */
             if (c == 'B' && c2 == 'I') cmd = 38;   /* Break on missing INTRM */
             if (c == 'B' && c2 == '?') cmd = 40;         /* List breakpoints */
+            if (c == 'B' && c2 == 'W') cmd = 51;    /* Break on write watch */
+            if (c == 'B' && c2 == 'R') cmd = 52;     /* Break on read watch */
             if (c == 'M') cmd = 6;                               /* mem dump */
             if (c == 'U') cmd = 7;                          /* 'Un'assemble. */
             if (c == 'C') cmd = 8;               /* Disassembly Cache stats. */
@@ -1420,12 +2066,17 @@ next_cmd:
             if (c == 'G' && c2 == 'Q') cmd = 35;               /* debuG reQs */
             if (c == 'N' && c2 == -1 ) cmd = 10;         /* uNset breakpoint */
             if (c == 'N' && c2 == 'I') cmd = 36;  /* Non-Interrupt threshold */
-            if (c == 'H') cmd = 11;                        /* toggle History */
+            if (c == 'N' && c2 == 'W') cmd = 53;  /* uNset write watchpoint */
+            if (c == 'N' && c2 == 'R') cmd = 54;   /* uNset read watchpoint */
+            if (c == 'H' && c2 == -1 ) cmd = 11;           /* toggle History */
+            if (c == 'H' && c2 == 'T') cmd = 50;  /* toggle instruction Trace */
             if (c == 'W' && c2 == -1 ) cmd = 12;       /* toggle watch write */
             if (c == 'W' && c2 == '?') cmd = 41;       /* List write-watches */
             if (c == '@' && c2 == -1 ) cmd = 17;        /* toggle watch read */
             if (c == '@' && c2 == '?') cmd = 42;        /* List read-watches */
-            if (c == 'A') cmd = 13;     /* enable memory Attribute discovery */
+            if (c == 'A' && c2 == -1 ) cmd = 13;  /* toggle Attribute logging */
+            if (c == 'A' && c2 == 'C') cmd = 48;   /* toggle sampled coverage */
+            if (c == 'A' && c2 == 'R') cmd = 49;    /* reset attribute map */
             if (c == 'P') cmd = 14;    /* poke into memory. (no side effect) */
             if (c == 'E') cmd = 15;       /* write to memory. (side effects) */
 #ifdef STK_TRC
@@ -1467,6 +2118,9 @@ next_cmd:
                 if (sscanf(s, "%d", &arg) != 1)
                     arg = -1;
             } else if (cmd == 5 || cmd == 10 || cmd == 23) {
+                if (cmd == 5)
+                    cond_text = debug_split_cond(s);
+
                 if (sscanf(s, "%100s", argstr) != 1)
                     arg = pc;
                 else
@@ -1534,6 +2188,35 @@ next_cmd:
 
                 if (args == 1) arg2 = arg;
                 if (arg2 < arg) { int tmp = arg2; arg2 = arg; arg = tmp; }
+            } else if (cmd == 51 || cmd == 52) {
+                int args;
+
+                cond_text = debug_split_cond(s);
+                args = sscanf(s, "%100s %100s", argstr, argstr2);
+
+                if (args < 1)
+                {
+                    jzp_printf("Usage: %s <#1> <#2> [if <expr>]\n",
+                               cmd == 51 ? "bw" : "br");
+                    goto next_cmd;
+                }
+
+                arg = debug_decode_val(argstr, 0xFFFF);
+                arg2 = args >= 2 ? debug_decode_val(argstr2, 0xFFFF) : arg;
+
+                if (arg == -1 || arg2 == -1)
+                    goto next_cmd;
+
+                if (arg2 < arg) { int tmp = arg2; arg2 = arg; arg = tmp; }
+            } else if (cmd == 53 || cmd == 54) {
+                if (sscanf(s, "%100s", argstr) != 1)
+                {
+                    jzp_printf("Usage: %s <#>\n", cmd == 53 ? "nw" : "nr");
+                    goto next_cmd;
+                }
+
+                if ((arg = debug_decode_val(argstr, 0xFFFF)) == -1)
+                    goto next_cmd;
             } else if (cmd == 14 || cmd == 15) {
                 int args = sscanf(s, "%100s %100s", argstr, argstr2);
 
@@ -1596,7 +2279,7 @@ next_cmd:
                 debug->step_count = arg;
                 debug->show_ins   = cmd == 1 || cmd == 47;
                 debug->show_rd = debug->show_wr = cmd == 1 ? show_rdwr : 0;
-                if (debug_rh_ptr < 0)
+                if (!DEBUG_PER_INSTR())
                     cp->step_count = cmd == 1 ? 1 : arg > 0 ? arg : 0;
 
                 if (cmd == 47)
@@ -1614,7 +2297,7 @@ next_cmd:
                     debug->show_ins    = 0;
                     debug->show_rd     = 0;
                     debug->show_wr     = 0;
-                    if (debug_rh_ptr < 0)
+                    if (!DEBUG_PER_INSTR())
                         cp->step_count = 0;
                     ff_bkpt = cp1600_set_breakpt(cp, arg, CP1600_BKPT);
                 }
@@ -1638,11 +2321,48 @@ next_cmd:
             case 10:
             {
                 int set = cmd == 5;
+                expr_t *cond = NULL;
+
+                if (set && debug_compile_cond(cond_text, &cond))
+                    goto next_cmd;
+
+                jzp_printf("%s breakpoint at $%.4X%s%s\n",
+                           set ? "Set" : "Unset", arg,
+                           cond ? " if " : "", cond ? cond_text : "");
                 if (set)
+                {
                     cp1600_set_breakpt(cp, arg, CP1600_BKPT);
-                else
+                    debug_add_bkpt(DEBUG_BK_EXEC, arg, arg, cond);
+                } else
+                {
                     cp1600_clr_breakpt(cp, arg, CP1600_BKPT);
-                jzp_printf("%s breakpoint at $%.4X\n", set ? "Set" : "Unset", arg);
+                    debug_del_bkpt(DEBUG_BK_EXEC, arg);
+                }
+                goto next_cmd;
+            }
+            case 51:
+            case 52:
+            {
+                const int kind = cmd == 51 ? DEBUG_BK_WRITE : DEBUG_BK_READ;
+                expr_t *cond = NULL;
+
+                if (debug_compile_cond(cond_text, &cond))
+                    goto next_cmd;
+
+                jzp_printf("Stop on %s $%.4X - $%.4X%s%s\n",
+                           cmd == 51 ? "writes to" : "reads of", arg, arg2,
+                           cond ? " if " : "", cond ? cond_text : "");
+                debug_add_bkpt(kind, arg, arg2, cond);
+                goto next_cmd;
+            }
+            case 53:
+            case 54:
+            {
+                const int kind = cmd == 53 ? DEBUG_BK_WRITE : DEBUG_BK_READ;
+
+                jzp_printf("Removed %d %s watchpoint(s) covering $%.4X\n",
+                           debug_del_bkpt(kind, arg),
+                           cmd == 53 ? "write" : "read", arg);
                 goto next_cmd;
             }
             case 6:
@@ -1703,7 +2423,7 @@ next_cmd:
                                RH_RECSIZE*sizeof(uint16_t)*HISTSIZE);
                         memset(debug_profile, 0, 0x10000 * sizeof(uint32_t));
                     }
-                    cp->step_count = debug_rh_ptr ? 0 : 1;
+                    cp->step_count = DEBUG_PER_INSTR() ? 1 : 0;
                 }
                 jzp_flush();
                 goto next_cmd;
@@ -1715,6 +2435,7 @@ next_cmd:
                     {
                         WATCHTOG(i,w);
                     }
+                    debug_hooks_dirty = 1;
 
                     for (i = arg, watch=-1; i <= arg2; i++)
                     {
@@ -1741,6 +2462,7 @@ next_cmd:
                     {
                         WATCHTOG(i,r);
                     }
+                    debug_hooks_dirty = 1;
 
                     for (i = arg, watch=-1; i <= arg2; i++)
                     {
@@ -1760,20 +2482,39 @@ next_cmd:
                 }
                 goto next_cmd;
             case 13:
-                if (!debug_memattr)
+            case 48:
+            {
+                int *const flag = cmd == 13 ? &debug_ma_exact
+                                            : &debug_ma_cover;
+
+                if (!*flag && debug_alloc_memattr())
                 {
-                    debug_memattr = CALLOC(uint8_t ,  0x10000);
-                    debug_mempc   = CALLOC(uint16_t,  0x10000);
-                    if (!debug_memattr || !debug_mempc)
-                    {
-                        CONDFREE(debug_memattr);
-                        CONDFREE(debug_mempc  );
-                        jzp_printf("Couldn't allocate memory attribute map\n");
-                    } else
-                    {
-                        jzp_printf("Memory attribute map enabled.\n");
-                    }
+                    jzp_printf("Couldn't allocate memory attribute map\n");
+                    goto next_cmd;
+                }
+                *flag = !*flag;
+                jzp_printf("%s is now %s.\n",
+                           cmd == 13 ? "Memory attribute logging"
+                                     : "Sampled code coverage",
+                           *flag ? "ON" : "off");
+                goto next_cmd;
+            }
+            case 50:
+                if (itrace_is_active(&debug_itrace))
+                {
+                    itrace_close(&debug_itrace);
                 } else
+                {
+                    const char *const fname = *s ? s : "dump.trc";
+                    if (itrace_open(&debug_itrace, fname) == 0)
+                        jzp_printf("Writing instruction trace to '%s'\n",
+                                   fname);
+                }
+                cp->step_count = DEBUG_PER_INSTR() ? 1 : 0;
+                jzp_flush();
+                goto next_cmd;
+            case 49:
+                if (debug_memattr)
                 {
                     memset(debug_memattr, 0, 0x10000 * sizeof(uint8_t));
                     memset(debug_mempc  , 0, 0x10000 * sizeof(uint16_t));
@@ -1826,6 +2567,7 @@ next_cmd:
                     fclose(stk_trc);
                     stk_trc = NULL;
                 }
+                debug_hooks_dirty = 1;
                 goto next_cmd;
             }
 #endif
@@ -2002,11 +2744,21 @@ next_cmd:
                              : debug->symb_addr_format;
                 const uint32_t sf = debug->stic->debug_flags;
                 /* Print debugger status (command "??") */
+                debug_sync_hooks(debug);
                 jzp_printf("Debugger misc status:\n");
                 jzp_printf("  Register history:         %s\n",
                             debug_rh_ptr < 0 ? "Off" : "On");
                 jzp_printf("  Memory attribute map:     %s\n",
                             debug_memattr ? "On" : "Off");
+                jzp_printf("  Instruction trace:        %s\n",
+                            itrace_is_active(&debug_itrace) ? "On" : "Off");
+                jzp_printf("  Attribute logging:        %s\n",
+                            debug_ma_exact ? "On" : "Off");
+                jzp_printf("  Sampled code coverage:    %s\n",
+                            debug_ma_cover ? "On" : "Off");
+                jzp_printf("  Hooked bus pages:         %d read, %d write\n",
+                            debug_count_hooked(debug, debug_hooked_r),
+                            debug_count_hooked(debug, debug_hooked_w));
                 jzp_printf("  Show cycles:              %s\n",
                             show_time ? "Yes" : "No");
                 jzp_printf("  Show read/write:          %s\n",
@@ -2066,6 +2818,33 @@ next_cmd:
     return len;
 }
 
+uint32_t debug_tk(periph_t *p, uint32_t len)
+{
+    debug_t *debug = PERIPH_AS(debug_t, p);
+    uint32_t ret;
+
+    /* -------------------------------------------------------------------- */
+    /*  Sampled code coverage:  mark where the CPU is as code.  This runs   */
+    /*  once per tick rather than once per bus access.                      */
+    /* -------------------------------------------------------------------- */
+    if (debug_ma_cover && debug_memattr)
+    {
+        const uint32_t pc = debug->cp1600->r[7] & 0xFFFF;
+        debug_memattr[pc] |= DEBUG_MA_CODE;
+        debug_mempc  [pc]  = pc;
+    }
+
+    ret = debug_tk_cmd(p, len);
+
+    /* -------------------------------------------------------------------- */
+    /*  Commands may have changed what we need to watch on the bus.  Fix    */
+    /*  up our page mappings before the CPU runs again.                     */
+    /* -------------------------------------------------------------------- */
+    debug_sync_hooks(debug);
+
+    return ret;
+}
+
 
 /*
  * ============================================================================
@@ -2675,7 +3454,8 @@ LOCAL void debug_dtor(periph_t *const p)
 {
     debug_t *debug = PERIPH_AS(debug_t, p);
 
-    UNUSED(debug);
+    if (debug_owner == debug)
+        debug_owner = NULL;
 
     dc_hits = dc_miss = dc_nocache = dc_unhook_ok = dc_unhook_odd = 0;
 
@@ -2685,16 +3465,19 @@ LOCAL void debug_dtor(periph_t *const p)
     CONDFREE(debug_reghist);
     CONDFREE(debug_profile);
 
-    if (debug_symtab)
-        symtab_destroy(debug_symtab);
+    debug_free_symtbl();
+    debug_free_bkpts();
 
-    debug_symtab         = NULL;
     debug_histinit       = 0;
     debug_rh_ptr         = -1;
     debug_fault_detected = 0;
     debug_halt_reason    = NULL;
     debug_num_jsrs       = 0;
 
+    itrace_close(&debug_itrace);
+    debug_ma_exact       = 0;
+    debug_ma_cover       = 1;
+
 #ifdef STK_TRC
     if (stk_trc)
         fclose(stk_trc);
@@ -2719,6 +3502,13 @@ int debug_init(debug_t *debug, cp1600_t *cp1600, speed_t *speed, gfx_t *gfx,
 {
     static uint8_t dummy  = 0;
 
+    if (debug_owner)
+    {
+        fprintf(stderr, "debug:  Another instance is using the debugger\n");
+        return -1;
+    }
+    debug_owner = debug;
+
     /* -------------------------------------------------------------------- */
     /*  Set up the debugger's state.                                        */
     /* -------------------------------------------------------------------- */
@@ -2777,6 +3567,15 @@ int debug_init(debug_t *debug, cp1600_t *cp1600, speed_t *speed, gfx_t *gfx,
     memset(debug_watch_r, 0, sizeof(debug_watch_r));
     memset(debug_watch_w, 0, sizeof(debug_watch_w));
 
+    /* -------------------------------------------------------------------- */
+    /*  We start out registered on the whole bus.  The first tick trims     */
+    /*  that down to just the pages we need.                                */
+    /* -------------------------------------------------------------------- */
+    memset(debug_hooked_r, 0xFF, sizeof(debug_hooked_r));
+    memset(debug_hooked_w, 0xFF, sizeof(debug_hooked_w));
+    debug_hooks_dirty = 1;
+    debug_hooks_all_r = debug_hooks_all_w = -1;
+
     /* -------------------------------------------------------------------- */
     /*  Read symbol table if requested to do so.                            */
     /* -------------------------------------------------------------------- */
@@ -2791,9 +3590,9 @@ int debug_init(debug_t *debug, cp1600_t *cp1600, speed_t *speed, gfx_t *gfx,
 
 #ifdef USE_GNU_READLINE
     /* -------------------------------------------------------------------- */
-    /*  For now, disable Readline completions.                              */
+    /*  Readline completes symbol names.                                    */
     /* -------------------------------------------------------------------- */
-    rl_completion_entry_function = debug_readline_no_completions;
+    rl_completion_entry_function = debug_readline_complete_symbol;
     rl_event_hook = debug_readline_event_hook;
     readline_hook = debug;  /* Ugh. Readline uses globals, so we must also. */
 #endif
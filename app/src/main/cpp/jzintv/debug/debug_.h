@@ -103,6 +103,15 @@ int debug_init(debug_t *debug,
                const char *script,
                uint32_t *exit_flag);
 
+/* ======================================================================== */
+/*  DEBUG_READ_SYMTBL    -- Add the symbols in an as1600 .sym file.  These  */
+/*                          are shared with anything else that looks up     */
+/*                          symbols, such as the profiler.                  */
+/*  DEBUG_FREE_SYMTBL    -- Forget all symbols.                             */
+/* ======================================================================== */
+void debug_read_symtbl(const char *fname);
+void debug_free_symtbl(void);
+
 /* ======================================================================== */
 /*  DEBUG_SYMB_FOR_ADDR  -- Returns symbol associated with and address, or  */
 /*                          NULL if there is none.  Performs no formatting. */
@@ -19,7 +19,7 @@
 #define DEBUG_CRASHING   ( 1)
 #define DEBUG_NO_FAULT   ( 0)
 #define DEBUG_ASYNC_HALT (-1)
-extern        int  debug_fault_detected;
-extern const char *debug_halt_reason;
+extern THREAD_LOCAL int         debug_fault_detected;
+extern THREAD_LOCAL const char *debug_halt_reason;
 
 #endif
@@ -0,0 +1,454 @@
+/*
+ * ============================================================================
+ *  Title:    Debugger Expressions
+ * ============================================================================
+ *  A recursive-descent parser that emits code for a little stack machine
+ *  as it goes.  Each instruction is one word, and OP_IMM, OP_VAR and the
+ *  short-circuit jumps take one more word of operand.
+ *
+ *  The short-circuit operators compile  a && b  to
+ *
+ *      <a>  OP_LAND end  <b>  OP_BOOL  end:
+ *
+ *  OP_LAND leaves a false 'a' on the stack as the result and jumps;
+ *  otherwise it pops it and falls into 'b'.  OP_LOR is the same, but
+ *  for a true 'a', which it turns into 1.
+ * ============================================================================
+ */
+
+#include "config.h"
+#include "debug/expr.h"
+
+#define EXPR_MAX_DEPTH  (32)        /* Evaluation stack depth.              */
+#define EXPR_MAX_NEST   (64)        /* Parser recursion.                    */
+#define EXPR_MAX_NAME   (64)
+
+enum
+{
+    OP_IMM, OP_VAR, OP_PEEK,
+    OP_NEG, OP_NOT, OP_LNOT, OP_BOOL,
+    OP_MUL, OP_DIV, OP_MOD, OP_ADD, OP_SUB, OP_SHL, OP_SHR,
+    OP_LT,  OP_LE,  OP_GT,  OP_GE,  OP_EQ,  OP_NE,
+    OP_AND, OP_XOR, OP_OR,
+    OP_LAND, OP_LOR
+};
+
+/* ------------------------------------------------------------------------ */
+/*  Binary operators.  Two-character ones come first so "<=" isn't "<".     */
+/* ------------------------------------------------------------------------ */
+LOCAL const struct
+{
+    char    tok[3];
+    int     prec;
+    int     op;
+} expr_binop[] =
+{
+    { "||", 1, OP_LOR  },   { "&&", 2, OP_LAND },
+    { "==", 6, OP_EQ   },   { "!=", 6, OP_NE   },
+    { "<=", 7, OP_LE   },   { ">=", 7, OP_GE   },
+    { "<<", 8, OP_SHL  },   { ">>", 8, OP_SHR  },
+    { "|",  3, OP_OR   },   { "^",  4, OP_XOR  },   { "&",  5, OP_AND  },
+    { "<",  7, OP_LT   },   { ">",  7, OP_GT   },
+    { "+",  9, OP_ADD  },   { "-",  9, OP_SUB  },
+    { "*", 10, OP_MUL  },   { "/", 10, OP_DIV  },   { "%", 10, OP_MOD  },
+};
+
+#define NUM_BINOP ((int)(sizeof(expr_binop) / sizeof(expr_binop[0])))
+
+/* ------------------------------------------------------------------------ */
+/*  Names that always mean the same thing.  Matched without case.           */
+/* ------------------------------------------------------------------------ */
+LOCAL const struct
+{
+    char    name[3];
+    int     var;
+} expr_var[] =
+{
+    { "R0", 0 }, { "R1", 1 }, { "R2", 2 }, { "R3", 3 },
+    { "R4", 4 }, { "R5", 5 }, { "R6", 6 }, { "R7", 7 },
+    { "SP", 6 }, { "PC", 7 },
+    { "S", EXPR_S }, { "Z", EXPR_Z }, { "O", EXPR_O },
+    { "C", EXPR_C }, { "I", EXPR_I }, { "D", EXPR_D },
+    { "A", EXPR_A }, { "V", EXPR_V },
+};
+
+#define NUM_VAR ((int)(sizeof(expr_var) / sizeof(expr_var[0])))
+
+typedef struct expr_parse_t
+{
+    const char     *s;
+    expr_sym_fn    *sym;
+    void           *opaque;
+    uint32_t       *code;
+    int             len, max_len;
+    int             depth, max_depth;
+    int             nest;
+    char           *err;
+    int             err_len;
+    int             failed;
+} expr_parse_t;
+
+/* ======================================================================== */
+/*  EXPR_ERROR   -- Note the first thing that went wrong, and where.        */
+/* ======================================================================== */
+LOCAL void expr_error(expr_parse_t *const p, const char *const msg)
+{
+    if (p->failed)
+        return;
+
+    p->failed = 1;
+
+    if (!p->err || p->err_len <= 0)
+        return;
+
+    if (*p->s)
+        snprintf(p->err, p->err_len, "%s at '%.16s'", msg, p->s);
+    else
+        snprintf(p->err, p->err_len, "%s at end of expression", msg);
+}
+
+/* ======================================================================== */
+/*  EXPR_EMIT    -- Append a word of code.  'effect' is its stack effect.   */
+/* ======================================================================== */
+LOCAL void expr_emit(expr_parse_t *const p, const uint32_t word,
+                     const int effect)
+{
+    if (p->failed)
+        return;
+
+    if (p->len == p->max_len)
+    {
+        p->max_len = p->max_len ? p->max_len * 2 : 16;
+        p->code    = REALLOC(p->code, uint32_t, p->max_len);
+        if (!p->code)
+        {
+            expr_error(p, "Out of memory");
+            return;
+        }
+    }
+
+    p->code[p->len++] = word;
+
+    p->depth += effect;
+    if (p->depth > p->max_depth)
+        p->max_depth = p->depth;
+    if (p->max_depth > EXPR_MAX_DEPTH)
+        expr_error(p, "Expression too complex");
+}
+
+LOCAL void expr_skip_ws(expr_parse_t *const p)
+{
+    while (isspace(*p->s))
+        p->s++;
+}
+
+LOCAL int expr_is_name(const int c)
+{
+    return isalnum(c) || c == '_' || c == '.';
+}
+
+LOCAL void expr_binary(expr_parse_t *const p, const int min_prec);
+
+/* ======================================================================== */
+/*  EXPR_NUMBER  -- $hex, 0xhex or decimal.                                 */
+/* ======================================================================== */
+LOCAL void expr_number(expr_parse_t *const p)
+{
+    const char *s = p->s;
+    char *end;
+    unsigned long val;
+    int base = 10;
+
+    if (s[0] == '$')
+    {
+        s++;
+        base = 16;
+    } else if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+    {
+        s += 2;
+        base = 16;
+    }
+
+    val = isxdigit(*s) ? strtoul(s, &end, base) : 0;
+    if (!isxdigit(*s) || expr_is_name(*end) || val > 0xFFFFFFFFul)
+    {
+        expr_error(p, "Bad number");
+        return;
+    }
+
+    p->s = end;
+    expr_emit(p, OP_IMM, 1);
+    expr_emit(p, (uint32_t)val, 0);
+}
+
+/* ======================================================================== */
+/*  EXPR_NAME    -- A register, flag or symbol.                             */
+/* ======================================================================== */
+LOCAL void expr_name(expr_parse_t *const p)
+{
+    char name[EXPR_MAX_NAME + 1], upper[EXPR_MAX_NAME + 1];
+    uint32_t val;
+    int len = 0, i;
+
+    while (expr_is_name(p->s[len]))
+    {
+        if (len == EXPR_MAX_NAME)
+        {
+            expr_error(p, "Name too long");
+            return;
+        }
+        name[len]  = p->s[len];
+        upper[len] = toupper(p->s[len]);
+        len++;
+    }
+    name[len] = upper[len] = 0;
+
+    for (i = 0; i < NUM_VAR; i++)
+        if (!strcmp(upper, expr_var[i].name))
+        {
+            p->s += len;
+            expr_emit(p, OP_VAR, 1);
+            expr_emit(p, expr_var[i].var, 0);
+            return;
+        }
+
+    if (!p->sym || p->sym(p->opaque, name, &val) != 0)
+    {
+        expr_error(p, "Unknown symbol");
+        return;
+    }
+
+    p->s += len;
+    expr_emit(p, OP_IMM, 1);
+    expr_emit(p, val, 0);
+}
+
+/* ======================================================================== */
+/*  EXPR_CLOSE   -- Expect a closing ')' or ']'.                            */
+/* ======================================================================== */
+LOCAL void expr_close(expr_parse_t *const p, const char c)
+{
+    expr_skip_ws(p);
+    if (*p->s != c)
+        expr_error(p, c == ')' ? "Expected ')'" : "Expected ']'");
+    else
+        p->s++;
+}
+
+/* ======================================================================== */
+/*  EXPR_UNARY   -- Unary operators, and the things they apply to.          */
+/* ======================================================================== */
+LOCAL void expr_unary(expr_parse_t *const p)
+{
+    char c;
+
+    if (p->failed)
+        return;
+
+    if (++p->nest > EXPR_MAX_NEST)
+    {
+        expr_error(p, "Expression nested too deeply");
+        return;
+    }
+
+    expr_skip_ws(p);
+    c = *p->s;
+
+    if (c == '-' || c == '~' || c == '!' || c == '+')
+    {
+        p->s++;
+        expr_unary(p);
+        if (c != '+')
+            expr_emit(p, c == '-' ? OP_NEG : c == '~' ? OP_NOT : OP_LNOT, 0);
+    }
+    else if (c == '(' || c == '[')
+    {
+        p->s++;
+        expr_binary(p, 1);
+        expr_close(p, c == '(' ? ')' : ']');
+        if (c == '[')
+            expr_emit(p, OP_PEEK, 0);
+    }
+    else if (c == '$' || isdigit(c))
+        expr_number(p);
+    else if (expr_is_name(c))
+        expr_name(p);
+    else
+        expr_error(p, "Expected a value");
+
+    p->nest--;
+}
+
+/* ======================================================================== */
+/*  EXPR_BINARY  -- Binary operators of precedence min_prec and higher, by  */
+/*                  precedence climbing.  All are left-associative.         */
+/* ======================================================================== */
+LOCAL void expr_binary(expr_parse_t *const p, const int min_prec)
+{
+    expr_unary(p);
+
+    while (!p->failed)
+    {
+        int i, prec, op, patch;
+
+        expr_skip_ws(p);
+        for (i = 0; i < NUM_BINOP; i++)
+            if (!strncmp(p->s, expr_binop[i].tok, strlen(expr_binop[i].tok)))
+                break;
+
+        if (i == NUM_BINOP || expr_binop[i].prec < min_prec)
+            return;
+
+        prec = expr_binop[i].prec;
+        op   = expr_binop[i].op;
+        p->s += strlen(expr_binop[i].tok);
+
+        if (op == OP_LAND || op == OP_LOR)
+        {
+            expr_emit(p, op, -1);
+            patch = p->len;
+            expr_emit(p, 0, 0);
+            expr_binary(p, prec + 1);
+            expr_emit(p, OP_BOOL, 0);
+            if (!p->failed)
+                p->code[patch] = p->len;
+        } else
+        {
+            expr_binary(p, prec + 1);
+            expr_emit(p, op, -1);
+        }
+    }
+}
+
+/* ======================================================================== */
+/*  EXPR_COMPILE -- Compile an expression.  Returns NULL on failure, with   */
+/*                  a message in err.  'sym' may be NULL.                   */
+/* ======================================================================== */
+expr_t *expr_compile(const char *const text, expr_sym_fn *const sym,
+                     void *const opaque, char *const err, const int err_len)
+{
+    expr_parse_t p;
+    expr_t *expr;
+
+    memset(&p, 0, sizeof(p));
+    p.s       = text;
+    p.sym     = sym;
+    p.opaque  = opaque;
+    p.err     = err;
+    p.err_len = err_len;
+
+    expr_binary(&p, 1);
+
+    expr_skip_ws(&p);
+    if (*p.s)
+        expr_error(&p, "Unexpected text");
+
+    if (!p.failed)
+    {
+        expr = CALLOC(expr_t, 1);
+        if (expr && (expr->text = strdup(text)) != NULL)
+        {
+            expr->code  = p.code;
+            expr->len   = p.len;
+            expr->depth = p.max_depth;
+            return expr;
+        }
+        CONDFREE(expr);
+        expr_error(&p, "Out of memory");
+    }
+
+    CONDFREE(p.code);
+    return NULL;
+}
+
+/* ======================================================================== */
+/*  EXPR_EVAL    -- Evaluate a compiled expression.                         */
+/* ======================================================================== */
+int32_t expr_eval(const expr_t *const expr, const expr_env_t *const env)
+{
+    int32_t stack[EXPR_MAX_DEPTH];
+    int32_t *sp = stack - 1;
+    const uint32_t *const code = expr->code;
+    int pc = 0;
+    uint32_t a, b;
+
+#define BINARY(x) sp--; a = sp[0]; b = sp[1]; sp[0] = (x); break
+    while (pc < expr->len)
+    {
+        switch (code[pc++])
+        {
+            case OP_IMM:  *++sp = code[pc++];                           break;
+            case OP_VAR:  *++sp = env->var[code[pc++]];                 break;
+            case OP_PEEK:
+                *sp = env->peek ? env->peek(env->opaque, *sp & 0xFFFF)
+                                  & 0xFFFF : 0;
+                break;
+
+            case OP_NEG:  *sp = -(uint32_t)*sp;                         break;
+            case OP_NOT:  *sp = ~*sp;                                   break;
+            case OP_LNOT: *sp = !*sp;                                   break;
+            case OP_BOOL: *sp = !!*sp;                                  break;
+
+            case OP_MUL:  BINARY(a * b);
+            case OP_ADD:  BINARY(a + b);
+            case OP_SUB:  BINARY(a - b);
+            case OP_SHL:  BINARY(a << (b & 31));
+            case OP_SHR:  BINARY((int32_t)a >> (b & 31));
+            case OP_DIV:  BINARY(b == 0 ? 0 : b == ~0u ? -a
+                                 : (uint32_t)((int32_t)a / (int32_t)b));
+            case OP_MOD:  BINARY(b == 0 || b == ~0u ? 0
+                                 : (uint32_t)((int32_t)a % (int32_t)b));
+            case OP_LT:   BINARY((int32_t)a <  (int32_t)b);
+            case OP_LE:   BINARY((int32_t)a <= (int32_t)b);
+            case OP_GT:   BINARY((int32_t)a >  (int32_t)b);
+            case OP_GE:   BINARY((int32_t)a >= (int32_t)b);
+            case OP_EQ:   BINARY(a == b);
+            case OP_NE:   BINARY(a != b);
+            case OP_AND:  BINARY(a & b);
+            case OP_XOR:  BINARY(a ^ b);
+            case OP_OR:   BINARY(a | b);
+
+            case OP_LAND:
+                if (*sp) { sp--; pc++; }
+                else     pc = code[pc];
+                break;
+
+            case OP_LOR:
+                if (*sp) { *sp = 1; pc = code[pc]; }
+                else     { sp--; pc++; }
+                break;
+        }
+    }
+#undef BINARY
+
+    return sp >= stack ? *sp : 0;
+}
+
+/* ======================================================================== */
+/*  EXPR_FREE    -- Release a compiled expression.  NULL is fine.           */
+/* ======================================================================== */
+void expr_free(expr_t *const expr)
+{
+    if (!expr)
+        return;
+
+    CONDFREE(expr->text);
+    CONDFREE(expr->code);
+    free(expr);
+}
+
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
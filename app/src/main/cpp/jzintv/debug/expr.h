@@ -0,0 +1,94 @@
+/*
+ * ============================================================================
+ *  Title:    Debugger Expressions
+ * ============================================================================
+ *  Conditions for breakpoints and watchpoints, such as
+ *
+ *      R1 > 10 && [$102] == 3
+ *
+ *  are parsed once, when they're set, into a small stack-machine program.
+ *  Evaluating one is then just a loop over that program, so a condition
+ *  on a hot breakpoint costs far less than stopping in the debugger.
+ *
+ *  Syntax is C's, with the C precedence rules:
+ *
+ *      Numbers     $1F3 or 0x1F3 is hex; 499 is decimal.
+ *      Registers   R0 - R7, SP (R6), PC (R7).
+ *      Flags       S, Z, O, C, I, D:  1 if set, else 0.
+ *      Accesses    A and V are the address and value of the access that
+ *                  triggered a watchpoint.  At a breakpoint, A is the PC
+ *                  and V is 0.
+ *      Memory      [expr] reads the 16-bit word at expr.
+ *      Symbols     Any other name is looked up when the expression is
+ *                  compiled.  Register and flag names don't match case.
+ *      Operators   unary - ~ !, * / %, + -, << >>, < <= > >=, == !=,
+ *                  &, ^, |, &&, || and ( ).
+ *
+ *  Arithmetic is on signed 32-bit values.  Division by zero gives 0.
+ * ============================================================================
+ */
+#ifndef DEBUG_EXPR_H_
+#define DEBUG_EXPR_H_
+
+/* ------------------------------------------------------------------------ */
+/*  Values an expression can name.                                          */
+/* ------------------------------------------------------------------------ */
+enum
+{
+    EXPR_R0 = 0, EXPR_R7 = 7,
+    EXPR_S, EXPR_Z, EXPR_O, EXPR_C, EXPR_I, EXPR_D,
+    EXPR_A, EXPR_V,
+    EXPR_NUM_VARS
+};
+
+typedef struct expr_env_t
+{
+    int32_t     var[EXPR_NUM_VARS];
+    uint32_t  (*peek)(void *opaque, uint32_t addr);
+    void       *opaque;
+} expr_env_t;
+
+typedef struct expr_t
+{
+    char       *text;           /* The source, for listing.                 */
+    uint32_t   *code;
+    int         len;            /* Words of code.                           */
+    int         depth;          /* Evaluation stack it needs.               */
+} expr_t;
+
+/* Looks up a symbol.  Returns 0 and sets *value if found. */
+typedef int expr_sym_fn(void *opaque, const char *name, uint32_t *value);
+
+/* ======================================================================== */
+/*  EXPR_COMPILE -- Compile an expression.  Returns NULL on failure, with   */
+/*                  a message in err.  'sym' may be NULL.                   */
+/* ======================================================================== */
+expr_t *expr_compile(const char *const text, expr_sym_fn *const sym,
+                     void *const opaque, char *const err, const int err_len);
+
+/* ======================================================================== */
+/*  EXPR_EVAL    -- Evaluate a compiled expression.                         */
+/* ======================================================================== */
+int32_t expr_eval(const expr_t *const expr, const expr_env_t *const env);
+
+/* ======================================================================== */
+/*  EXPR_FREE    -- Release a compiled expression.  NULL is fine.           */
+/* ======================================================================== */
+void expr_free(expr_t *const expr);
+
+#endif
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
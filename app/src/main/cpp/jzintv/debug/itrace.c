@@ -0,0 +1,415 @@
+/*
+ * ============================================================================
+ *  Title:    Compact Instruction Trace
+ * ============================================================================
+ *  The emulator thread encodes records straight into a chunk buffer.  When
+ *  a chunk fills, it's handed to a worker thread that compresses it and
+ *  writes it out, while the emulator carries on filling the next buffer.
+ *  If the worker falls behind and every buffer is full, the emulator waits
+ *  for it.  A trace never drops records.
+ *
+ *  Without threads, chunks are compressed and written inline.
+ * ============================================================================
+ */
+
+#include "config.h"
+#include "plat/plat.h"
+#include "plat/plat_lib.h"
+#include "debug/itrace.h"
+
+#ifndef NO_LZO
+# include "minilzo/minilzo.h"
+#endif
+
+#define IT_SLOTS        (4)         /* Chunks that may wait on the worker.  */
+#define IT_OUT_BYTES    (ITRACE_CHUNK + ITRACE_CHUNK / 16 + 67)
+
+typedef struct itrace_pvt_t
+{
+    FILE           *f;
+    char           *fname;
+
+    /* -------------------------------------------------------------------- */
+    /*  Delta state.  Owned by the emulator thread.                         */
+    /* -------------------------------------------------------------------- */
+    uint16_t        regs[8];
+    uint32_t        req_ack;
+    uint64_t        now;
+    uint16_t      (*words)[3];      /* Last opcode words seen per address.  */
+
+    /* -------------------------------------------------------------------- */
+    /*  Chunk buffers.  'wr' and 'rd' are free-running; mod IT_SLOTS.       */
+    /*  The emulator fills slot 'wr' while the worker drains 'rd'.          */
+    /* -------------------------------------------------------------------- */
+    uint8_t        *slot[IT_SLOTS];
+    uint32_t        slot_len[IT_SLOTS];
+    uint8_t        *fill;           /* Next free byte in slot 'wr'.         */
+    uint8_t        *fill_end;       /* Start a new chunk beyond this.       */
+    uint32_t        wr, rd;
+    int             quit;
+
+    /* -------------------------------------------------------------------- */
+    /*  Compressor state.  Owned by whoever writes chunks.                  */
+    /* -------------------------------------------------------------------- */
+    uint8_t        *out;
+    uint8_t        *wrk;
+    int             write_err;
+
+    plat_thread_t  *worker;
+    plat_mutex_t   *lock;
+    plat_cond_t    *not_empty, *not_full;
+
+    /* -------------------------------------------------------------------- */
+    /*  Statistics.                                                         */
+    /* -------------------------------------------------------------------- */
+    uint64_t        records, raw_bytes, file_bytes;
+    uint32_t        chunks, stalls;
+} itrace_pvt_t;
+
+/* ======================================================================== */
+/*  IT_PUT32     -- Little-endian 32-bit store.                             */
+/* ======================================================================== */
+LOCAL void it_put32(uint8_t *const p, const uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+/* ======================================================================== */
+/*  IT_WRITE_CHUNK -- Compress one chunk and append it to the file.         */
+/* ======================================================================== */
+LOCAL void it_write_chunk(itrace_pvt_t *const pvt, const uint8_t *const raw,
+                          const uint32_t raw_len)
+{
+    const uint8_t *data = raw;
+    uint32_t len = raw_len;
+    uint8_t hdr[8];
+
+    if (!raw_len || pvt->write_err)
+        return;
+
+#ifndef NO_LZO
+    {
+        lzo_uint lzo_len = 0;
+        const int r = lzo1x_1_compress(raw, raw_len, pvt->out, &lzo_len,
+                                       (lzo_voidp)pvt->wrk);
+
+        if (r == LZO_E_OK && lzo_len < raw_len)
+        {
+            data = pvt->out;
+            len  = lzo_len;
+        }
+    }
+#endif
+
+    it_put32(hdr + 0, raw_len);
+    it_put32(hdr + 4, len);
+
+    if (fwrite(hdr,  1, 8,   pvt->f) != 8 ||
+        fwrite(data, 1, len, pvt->f) != len)
+    {
+        fprintf(stderr, "itrace: Error writing '%s'; trace truncated\n",
+                pvt->fname);
+        pvt->write_err = 1;
+        return;
+    }
+
+    pvt->chunks++;
+    pvt->raw_bytes  += raw_len;
+    pvt->file_bytes += 8 + len;
+}
+
+/* ======================================================================== */
+/*  IT_WORKER    -- Write chunks out in order until told to quit.           */
+/* ======================================================================== */
+LOCAL int it_worker(void *opaque)
+{
+    itrace_pvt_t *const pvt = (itrace_pvt_t *)opaque;
+
+    plat_mutex_lock(pvt->lock);
+    for (;;)
+    {
+        uint32_t s;
+
+        while (pvt->rd == pvt->wr && !pvt->quit)
+            plat_cond_wait(pvt->not_empty, pvt->lock);
+
+        if (pvt->rd == pvt->wr)     /* quit, and nothing left to do */
+            break;
+
+        s = pvt->rd % IT_SLOTS;
+        plat_mutex_unlock(pvt->lock);
+
+        it_write_chunk(pvt, pvt->slot[s], pvt->slot_len[s]);
+
+        plat_mutex_lock(pvt->lock);
+        pvt->rd++;
+        plat_cond_signal(pvt->not_full);
+    }
+    plat_mutex_unlock(pvt->lock);
+
+    return 0;
+}
+
+/* ======================================================================== */
+/*  IT_SUBMIT    -- Hand off the chunk being filled and start the next.     */
+/* ======================================================================== */
+LOCAL void it_submit(itrace_pvt_t *const pvt)
+{
+    const uint32_t s = pvt->wr % IT_SLOTS;
+
+    pvt->slot_len[s] = pvt->fill - pvt->slot[s];
+
+    if (!pvt->worker)
+    {
+        it_write_chunk(pvt, pvt->slot[s], pvt->slot_len[s]);
+        pvt->fill = pvt->slot[s];
+        return;
+    }
+
+    plat_mutex_lock(pvt->lock);
+    pvt->wr++;
+    plat_cond_signal(pvt->not_empty);
+
+    if (pvt->wr - pvt->rd >= IT_SLOTS)
+    {
+        pvt->stalls++;
+        while (pvt->wr - pvt->rd >= IT_SLOTS)
+            plat_cond_wait(pvt->not_full, pvt->lock);
+    }
+    plat_mutex_unlock(pvt->lock);
+
+    pvt->fill     = pvt->slot[pvt->wr % IT_SLOTS];
+    pvt->fill_end = pvt->fill + ITRACE_CHUNK - ITRACE_MAX_REC;
+}
+
+/* ======================================================================== */
+/*  IT_FREE      -- Release everything.  The worker must already be gone.   */
+/* ======================================================================== */
+LOCAL void it_free(itrace_pvt_t *const pvt)
+{
+    int i;
+
+    plat_cond_destroy(pvt->not_full);
+    plat_cond_destroy(pvt->not_empty);
+    plat_mutex_destroy(pvt->lock);
+
+    for (i = 0; i < IT_SLOTS; i++)
+        CONDFREE(pvt->slot[i]);
+
+    CONDFREE(pvt->words);
+    CONDFREE(pvt->out);
+    CONDFREE(pvt->wrk);
+    CONDFREE(pvt->fname);
+
+    if (pvt->f)
+        fclose(pvt->f);
+
+    free(pvt);
+}
+
+/* ======================================================================== */
+/*  ITRACE_OPEN  -- Start a trace to 'fname'.                               */
+/* ======================================================================== */
+int itrace_open(itrace_t *const it, const char *const fname)
+{
+    itrace_pvt_t *pvt;
+    uint8_t hdr[8] = { 'J', 'Z', 'T', 'R', ITRACE_VERSION, 0, 0, 0 };
+    int i;
+
+    it->pvt = NULL;
+
+    if (!(pvt = CALLOC(itrace_pvt_t, 1)))
+        goto oom;
+
+    for (i = 0; i < IT_SLOTS; i++)
+        if (!(pvt->slot[i] = CALLOC(uint8_t, ITRACE_CHUNK)))
+            goto oom;
+
+    if (!(pvt->words = (uint16_t (*)[3])CALLOC(uint16_t, 3 * 0x10000)) ||
+        !(pvt->out   = CALLOC(uint8_t, IT_OUT_BYTES))                   ||
+        !(pvt->fname = strdup(fname)))
+        goto oom;
+
+#ifndef NO_LZO
+    if (!(pvt->wrk = CALLOC(uint8_t, LZO1X_1_MEM_COMPRESS)))
+        goto oom;
+#endif
+
+    if (!(pvt->f = fopen(fname, "wb")) || fwrite(hdr, 1, 8, pvt->f) != 8)
+    {
+        fprintf(stderr, "itrace: Could not open '%s' for writing\n", fname);
+        it_free(pvt);
+        return -1;
+    }
+    pvt->file_bytes = 8;
+
+    pvt->fill     = pvt->slot[0];
+    pvt->fill_end = pvt->fill + ITRACE_CHUNK - ITRACE_MAX_REC;
+
+    /* -------------------------------------------------------------------- */
+    /*  Without threads, it_submit() writes inline.                         */
+    /* -------------------------------------------------------------------- */
+    pvt->lock      = plat_mutex_create();
+    pvt->not_empty = plat_cond_create();
+    pvt->not_full  = plat_cond_create();
+
+    if (pvt->lock && pvt->not_empty && pvt->not_full)
+        pvt->worker = plat_thread_create(it_worker, "jzintv itrace",
+                                         (void *)pvt);
+
+    it->pvt = pvt;
+    return 0;
+
+oom:
+    fprintf(stderr, "itrace: Out of memory\n");
+    if (pvt)
+        it_free(pvt);
+    return -1;
+}
+
+/* ======================================================================== */
+/*  ITRACE_RECORD -- Append one instruction.                                */
+/* ======================================================================== */
+void itrace_record
+(
+    itrace_t       *const it,
+    const uint16_t *const regs,
+    const uint32_t        flags,
+    const uint16_t *const words,
+    const uint64_t        now
+)
+{
+    itrace_pvt_t *const pvt = it->pvt;
+    uint8_t *p, *const rec = pvt ? pvt->fill : NULL;
+    const uint32_t pc      = regs[7];
+    const uint32_t req_ack = (flags >> 8) & 15;
+    const int      dbd     = (flags >> 6) & 1;
+    uint16_t *const seen   = pvt ? pvt->words[pc] : NULL;
+    uint32_t zz;
+    uint64_t dt;
+    int i, n, mask = 0;
+
+    if (!pvt)
+        return;
+
+    /* -------------------------------------------------------------------- */
+    /*  Header:  what changed, the flags, and the req/ack state if new.     */
+    /* -------------------------------------------------------------------- */
+    for (i = 0; i < 7; i++)
+        if (regs[i] != pvt->regs[i])
+            mask |= 1 << i;
+
+    n = itrace_num_words(words[0], dbd);
+    for (i = 0; i < n; i++)
+        if (words[i] != seen[i])
+            mask |= ITRACE_MASK_WORDS;
+
+    p = rec;
+    *p++ = mask;
+    *p++ = ((flags >> 1) & 0x7F) |
+           (req_ack != pvt->req_ack ? ITRACE_FLAG_REQACK : 0);
+    if (req_ack != pvt->req_ack)
+        *p++ = req_ack;
+
+    /* -------------------------------------------------------------------- */
+    /*  PC and cycle deltas as varints.                                     */
+    /* -------------------------------------------------------------------- */
+    {
+        const int16_t dpc = (int16_t)(uint16_t)(pc - pvt->regs[7]);
+        zz = ((uint32_t)dpc << 1) ^ (uint32_t)(dpc < 0 ? -1 : 0);
+        zz &= 0x1FFFF;
+    }
+    while (zz >= 0x80) { *p++ = 0x80 | (zz & 0x7F); zz >>= 7; }
+    *p++ = zz;
+
+    dt = now - pvt->now;
+    while (dt >= 0x80) { *p++ = 0x80 | (dt & 0x7F); dt >>= 7; }
+    *p++ = dt;
+
+    /* -------------------------------------------------------------------- */
+    /*  Changed registers, then opcode words if they differ from last time. */
+    /* -------------------------------------------------------------------- */
+    for (i = 0; i < 7; i++)
+        if (mask & (1 << i))
+        {
+            *p++ = regs[i];
+            *p++ = regs[i] >> 8;
+        }
+
+    if (mask & ITRACE_MASK_WORDS)
+        for (i = 0; i < n; i++)
+        {
+            *p++ = words[i];
+            *p++ = words[i] >> 8;
+            seen[i] = words[i];
+        }
+
+    memcpy(pvt->regs, regs, sizeof(pvt->regs));
+    pvt->req_ack = req_ack;
+    pvt->now     = now;
+    pvt->records++;
+
+    pvt->fill = p;
+    if (p > pvt->fill_end)
+        it_submit(pvt);
+}
+
+/* ======================================================================== */
+/*  ITRACE_IS_ACTIVE -- Returns non-zero if a trace is being written.       */
+/* ======================================================================== */
+int itrace_is_active(const itrace_t *const it)
+{
+    return it->pvt != NULL;
+}
+
+/* ======================================================================== */
+/*  ITRACE_CLOSE -- Flush, stop the worker, report statistics.              */
+/* ======================================================================== */
+void itrace_close(itrace_t *const it)
+{
+    itrace_pvt_t *const pvt = it->pvt;
+
+    if (!pvt)
+        return;
+
+    it_submit(pvt);
+
+    if (pvt->worker)
+    {
+        plat_mutex_lock(pvt->lock);
+        pvt->quit = 1;
+        plat_cond_signal(pvt->not_empty);
+        plat_mutex_unlock(pvt->lock);
+        plat_thread_join(pvt->worker);
+        pvt->worker = NULL;
+    }
+
+    jzp_printf("itrace: %" U64_FMT " instructions to '%s', %.1f bytes "
+               "each raw, %.1f in the file (%u chunks, %u stalls)\n",
+               pvt->records, pvt->fname,
+               pvt->records ? (double)pvt->raw_bytes  / pvt->records : 0.,
+               pvt->records ? (double)pvt->file_bytes / pvt->records : 0.,
+               pvt->chunks, pvt->stalls);
+
+    it_free(pvt);
+    it->pvt = NULL;
+}
+
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
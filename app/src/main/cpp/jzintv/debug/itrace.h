@@ -0,0 +1,113 @@
+/*
+ * ============================================================================
+ *  Title:    Compact Instruction Trace
+ * ============================================================================
+ *  Records one variable-length record per instruction to a file, for
+ *  tracing far more instructions than the debugger's register history
+ *  holds.  Records are delta-encoded against the previous instruction,
+ *  gathered into chunks, and each chunk is compressed with minilzo on a
+ *  worker thread.  util/itrace2txt turns a trace back into the text
+ *  format of the debugger's "dump.hst".
+ *
+ *  File layout (all multi-byte fields little-endian):
+ *
+ *      "JZTR" version(u8) 0(u8) 0(u8) 0(u8)
+ *      chunk*:   raw_len(u32) stored_len(u32) data[stored_len]
+ *
+ *  A chunk is stored as-is if stored_len == raw_len, otherwise it is
+ *  LZO1X compressed.  Chunks always end on a record boundary.  Delta
+ *  state carries over from one chunk to the next, so a trace must be
+ *  decoded from the start.  Each record is:
+ *
+ *      mask(u8)    Bits 0-6:  R0-R6 follow.  Bit 7:  opcode words follow.
+ *      flags(u8)   Bits 0-6:  S, C, O, Z, I, D, intr.
+ *                  Bit 7:  a req/ack byte follows.
+ *      [reqack(u8)]    BUSAK/BUSRQ/INTAK/INTRQ; sticky until changed.
+ *      pc(varint)      zigzag of the signed 16-bit PC delta.
+ *      cycles(varint)  cycles since the previous record.
+ *      R0-R6(u16)      Only those named in 'mask'.
+ *      words(u16)      Only if 'mask' bit 7.  As many words as the
+ *                      instruction at PC has, given its D flag.
+ *
+ *  Both sides keep the last opcode words seen at each address; words are
+ *  only written when they differ from that.  Varints hold 7 bits per byte,
+ *  least-significant first, with bit 7 set on all but the last byte.
+ * ============================================================================
+ */
+#ifndef DEBUG_ITRACE_H_
+#define DEBUG_ITRACE_H_
+
+#define ITRACE_MAGIC       "JZTR"
+#define ITRACE_VERSION     (1)
+#define ITRACE_CHUNK       (1 << 18)    /* Raw bytes per chunk, at most.    */
+#define ITRACE_MAX_REC     (48)         /* Largest possible record.         */
+
+#define ITRACE_MASK_WORDS  (0x80)
+#define ITRACE_FLAG_REQACK (0x80)
+
+/* ======================================================================== */
+/*  ITRACE_NUM_WORDS -- How many words the instruction with first word w1   */
+/*                      has, given the D flag it runs with.                 */
+/* ======================================================================== */
+static inline int itrace_num_words(const uint32_t w1, const int dbd)
+{
+    const uint32_t op = w1 & 0x3FF;
+
+    if (op == 0x0004)               return 3;   /* J, JSR and friends     */
+    if ((op & 0x3C0) == 0x200)      return 2;   /* Branches               */
+    if ((op & 0x3F8) == 0x278)      return 2;   /* MVO to immediate       */
+    if ((op & 0x238) == 0x200)      return 2;   /* Direct mode            */
+    if ((op & 0x238) == 0x238)      return 2 + !!dbd;   /* Immediate     */
+    return 1;
+}
+
+typedef struct itrace_t
+{
+    struct itrace_pvt_t *pvt;
+} itrace_t;
+
+/* ======================================================================== */
+/*  ITRACE_OPEN   -- Start a trace to 'fname'.  Returns 0 on success, or    */
+/*                   -1 if the file couldn't be opened.                     */
+/* ======================================================================== */
+int itrace_open(itrace_t *const it, const char *const fname);
+
+/* ======================================================================== */
+/*  ITRACE_RECORD -- Append one instruction.  'regs' holds R0-R7.  'flags'  */
+/*                   uses the same layout as the register history:  bit 0  */
+/*                   valid, bits 1-7 S C O Z I D intr, bits 8-11 req/ack.   */
+/*                   'words' holds the opcode words at R7; only as many as  */
+/*                   the instruction has are looked at.                     */
+/* ======================================================================== */
+void itrace_record
+(
+    itrace_t       *const it,
+    const uint16_t *const regs,
+    const uint32_t        flags,
+    const uint16_t *const words,
+    const uint64_t        now
+);
+
+/* ======================================================================== */
+/*  ITRACE_IS_ACTIVE -- Returns non-zero if a trace is being written.       */
+/*  ITRACE_CLOSE     -- Flush, stop the worker, report statistics.          */
+/* ======================================================================== */
+int  itrace_is_active(const itrace_t *const it);
+void itrace_close(itrace_t *const it);
+
+#endif
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
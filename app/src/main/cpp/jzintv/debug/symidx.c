@@ -0,0 +1,304 @@
+/*
+ * ============================================================================
+ *  Title:    Debugger Symbol Index
+ * ============================================================================
+ *  Built in one go from the symbol table:  collect every symbol, sort by
+ *  name to assign indices, then sort by address and definition order to
+ *  chain up the symbols at each address.
+ * ============================================================================
+ */
+
+#include "config.h"
+#include "util/symtab.h"
+#include "debug/symidx.h"
+
+typedef struct symidx_tmp_t
+{
+    const char *name;
+    uint32_t    addr;
+    int         seq;
+    int32_t     idx;
+} symidx_tmp_t;
+
+/* ------------------------------------------------------------------------ */
+/*  The symbols collected so far, while building.                           */
+/* ------------------------------------------------------------------------ */
+typedef struct symidx_list_t
+{
+    symidx_tmp_t *tmp;
+    int           num, max, oom;
+} symidx_list_t;
+
+LOCAL void symidx_collect(void *opaque, const char *name, uint32_t addr,
+                          int seq)
+{
+    symidx_list_t *const list = (symidx_list_t *)opaque;
+
+    if (list->num == list->max)
+    {
+        const int new_max = list->max ? list->max * 2 : 256;
+        symidx_tmp_t *const tmp = REALLOC(list->tmp, symidx_tmp_t, new_max);
+
+        if (!tmp)
+        {
+            list->oom = 1;
+            return;
+        }
+        list->tmp = tmp;
+        list->max = new_max;
+    }
+
+    list->tmp[list->num].name = name;
+    list->tmp[list->num].addr = addr;
+    list->tmp[list->num].seq  = seq;
+    list->num++;
+}
+
+LOCAL int symidx_cmp_name(const void *a, const void *b)
+{
+    return strcmp(((const symidx_tmp_t *)a)->name,
+                  ((const symidx_tmp_t *)b)->name);
+}
+
+LOCAL int symidx_cmp_addr(const void *a, const void *b)
+{
+    const symidx_tmp_t *const ta = (const symidx_tmp_t *)a;
+    const symidx_tmp_t *const tb = (const symidx_tmp_t *)b;
+
+    if (ta->addr != tb->addr) return ta->addr < tb->addr ? -1 : 1;
+    return ta->seq < tb->seq ? -1 : ta->seq > tb->seq;
+}
+
+/* ------------------------------------------------------------------------ */
+/*  FNV-1a.                                                                 */
+/* ------------------------------------------------------------------------ */
+LOCAL uint32_t symidx_hash(const char *s)
+{
+    uint32_t h = 2166136261u;
+
+    while (*s)
+        h = (h ^ (uint8_t)*s++) * 16777619u;
+
+    return h;
+}
+
+/* ======================================================================== */
+/*  SYMIDX_FREE      -- Empty the index.                                    */
+/* ======================================================================== */
+void symidx_free(symidx_t *const idx)
+{
+    CONDFREE(idx->name);
+    CONDFREE(idx->addr);
+    CONDFREE(idx->next_at);
+    CONDFREE(idx->hash);
+    CONDFREE(idx->best);
+    CONDFREE(idx->at);
+    CONDFREE(idx->pool);
+    memset(idx, 0, sizeof(symidx_t));
+}
+
+/* ======================================================================== */
+/*  SYMIDX_BUILD     -- (Re)build the index from a symbol table.  Returns   */
+/*                      0 on success.  On failure, the index is empty.      */
+/* ======================================================================== */
+int symidx_build(symidx_t *const idx, symtab_t *const symtab)
+{
+    symidx_list_t list = { NULL, 0, 0, 0 };
+    symidx_tmp_t *tmp;
+    size_t pool_len = 0;
+    uint32_t hash_size = 16, a;
+    char *p;
+    int n, i;
+
+    symidx_free(idx);
+
+    if (!symtab)
+        return 0;
+
+    symtab_for_each(symtab, symidx_collect, &list);
+
+    if (list.oom)
+        goto fail;
+
+    tmp = list.tmp;
+    n   = list.num;
+    for (i = 0; i < n; i++)
+        pool_len += strlen(tmp[i].name) + 1;
+
+    while (hash_size < 2u * n)
+        hash_size <<= 1;
+
+    idx->name    = CALLOC(const char *, n + 1);
+    idx->addr    = CALLOC(uint32_t,     n + 1);
+    idx->next_at = CALLOC(int32_t,      n + 1);
+    idx->hash    = CALLOC(int32_t,      hash_size);
+    idx->best    = CALLOC(int32_t,      0x10000);
+    idx->at      = CALLOC(int32_t,      0x10000);
+    idx->pool    = CALLOC(char,         pool_len + 1);
+
+    if (!idx->name || !idx->addr || !idx->next_at || !idx->hash ||
+        !idx->best || !idx->at   || !idx->pool)
+        goto fail;
+
+    idx->num       = n;
+    idx->hash_mask = hash_size - 1;
+
+    /* -------------------------------------------------------------------- */
+    /*  Names, in sorted order, all in one block.                           */
+    /* -------------------------------------------------------------------- */
+    qsort(tmp, n, sizeof(symidx_tmp_t), symidx_cmp_name);
+
+    for (i = 0, p = idx->pool; i < n; i++)
+    {
+        strcpy(p, tmp[i].name);
+        idx->name[i]    = p;
+        idx->addr[i]    = tmp[i].addr;
+        idx->next_at[i] = -1;
+        tmp[i].idx = i;
+        p += strlen(p) + 1;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Name hash, with linear probing.                                     */
+    /* -------------------------------------------------------------------- */
+    memset(idx->hash, 0xFF, hash_size * sizeof(int32_t));
+
+    for (i = 0; i < n; i++)
+    {
+        uint32_t h = symidx_hash(idx->name[i]) & idx->hash_mask;
+
+        while (idx->hash[h] >= 0)
+            h = (h + 1) & idx->hash_mask;
+
+        idx->hash[h] = i;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Chain up the symbols at each address, in the order defined, and     */
+    /*  pick the preferred one.                                             */
+    /* -------------------------------------------------------------------- */
+    memset(idx->best, 0xFF, 0x10000 * sizeof(int32_t));
+    memset(idx->at,   0xFF, 0x10000 * sizeof(int32_t));
+
+    qsort(tmp, n, sizeof(symidx_tmp_t), symidx_cmp_addr);
+
+    for (i = n - 1; i >= 0; i--)
+    {
+        if ((a = tmp[i].addr) > 0xFFFF)
+            continue;
+
+        idx->next_at[tmp[i].idx] = idx->at[a];
+        idx->at[a] = tmp[i].idx;
+    }
+
+    for (a = 0; a < 0x10000; a++)
+    {
+        int32_t j = idx->at[a];
+
+        if (j < 0)
+            continue;
+
+        idx->best[a] = j;
+        for (; j >= 0; j = idx->next_at[j])
+            if (idx->name[j][0] != '.')
+            {
+                idx->best[a] = j;
+                break;
+            }
+    }
+
+    CONDFREE(list.tmp);
+    return 0;
+
+fail:
+    CONDFREE(list.tmp);
+    symidx_free(idx);
+    return -1;
+}
+
+/* ======================================================================== */
+/*  SYMIDX_AT        -- The which'th symbol defined at addr, or NULL.       */
+/* ======================================================================== */
+const char *symidx_at(const symidx_t *const idx, const uint32_t addr,
+                      int which)
+{
+    int32_t j;
+
+    if (!idx->at || addr > 0xFFFF)
+        return NULL;
+
+    for (j = idx->at[addr]; j >= 0 && which > 0; j = idx->next_at[j])
+        which--;
+
+    return j >= 0 ? idx->name[j] : NULL;
+}
+
+/* ======================================================================== */
+/*  SYMIDX_LOOKUP    -- Find a name's address.  Returns 0 if found.         */
+/* ======================================================================== */
+int symidx_lookup(const symidx_t *const idx, const char *const name,
+                  uint32_t *const addr)
+{
+    uint32_t h;
+
+    if (!idx->hash)
+        return -1;
+
+    for (h = symidx_hash(name) & idx->hash_mask; idx->hash[h] >= 0;
+         h = (h + 1) & idx->hash_mask)
+        if (!strcmp(idx->name[idx->hash[h]], name))
+        {
+            *addr = idx->addr[idx->hash[h]];
+            return 0;
+        }
+
+    return -1;
+}
+
+/* ======================================================================== */
+/*  SYMIDX_PREFIX    -- Find the names starting with 'prefix'.  Returns     */
+/*                      how many; they're name[*first] onward.              */
+/* ======================================================================== */
+int symidx_prefix(const symidx_t *const idx, const char *const prefix,
+                  int *const first)
+{
+    const size_t len = strlen(prefix);
+    int lo = 0, hi = idx->num, mid, start;
+
+    /* First name not less than the prefix. */
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (strcmp(idx->name[mid], prefix) < 0) lo  = mid + 1;
+        else                                    hi  = mid;
+    }
+    start = lo;
+
+    /* First name past the ones that start with it. */
+    hi = idx->num;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (strncmp(idx->name[mid], prefix, len) <= 0) lo = mid + 1;
+        else                                           hi = mid;
+    }
+
+    *first = start;
+    return lo - start;
+}
+
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
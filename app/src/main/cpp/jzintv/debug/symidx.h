@@ -0,0 +1,96 @@
+/*
+ * ============================================================================
+ *  Title:    Debugger Symbol Index
+ * ============================================================================
+ *  A flat, read-only index over the debugger's symbol table, rebuilt each
+ *  time symbols are loaded.  The symbol table's AVL trees are fine for
+ *  building up the symbols, but every line of disassembly and every traced
+ *  read or write looks up a symbol or two.  This answers those with array
+ *  lookups instead of tree walks:
+ *
+ *   -- A 64K table gives each address's preferred symbol directly.  That's
+ *      the first one defined there that doesn't start with a '.', or the
+ *      first one if they all do.  Other symbols at the same address are
+ *      chained in the order they were defined.
+ *
+ *   -- Names are sorted, so all names with a given prefix are adjacent.
+ *
+ *   -- An open-addressed hash finds a name's address.
+ * ============================================================================
+ */
+#ifndef DEBUG_SYMIDX_H_
+#define DEBUG_SYMIDX_H_
+
+typedef struct symidx_t
+{
+    int             num;
+    const char    **name;           /* Sorted by strcmp().                  */
+    uint32_t       *addr;           /* Address of each name.                */
+    int32_t        *next_at;        /* Next symbol at the same address.     */
+    int32_t        *hash;           /* Name hash -> index, or -1.           */
+    uint32_t        hash_mask;
+    int32_t        *best;           /* 64K:  preferred symbol, or -1.       */
+    int32_t        *at;             /* 64K:  first symbol defined, or -1.   */
+    char           *pool;           /* Storage for all the names.           */
+} symidx_t;
+
+/* ======================================================================== */
+/*  SYMIDX_BUILD     -- (Re)build the index from a symbol table.  Returns   */
+/*                      0 on success.  On failure, the index is empty.      */
+/* ======================================================================== */
+int symidx_build(symidx_t *const idx, symtab_t *const symtab);
+
+/* ======================================================================== */
+/*  SYMIDX_FREE      -- Empty the index.                                    */
+/* ======================================================================== */
+void symidx_free(symidx_t *const idx);
+
+/* ======================================================================== */
+/*  SYMIDX_AT        -- The which'th symbol defined at addr, or NULL.       */
+/* ======================================================================== */
+const char *symidx_at(const symidx_t *const idx, const uint32_t addr,
+                      int which);
+
+/* ======================================================================== */
+/*  SYMIDX_LOOKUP    -- Find a name's address.  Returns 0 if found.         */
+/* ======================================================================== */
+int symidx_lookup(const symidx_t *const idx, const char *const name,
+                  uint32_t *const addr);
+
+/* ======================================================================== */
+/*  SYMIDX_PREFIX    -- Find the names starting with 'prefix'.  Returns     */
+/*                      how many; they're name[*first] onward.              */
+/* ======================================================================== */
+int symidx_prefix(const symidx_t *const idx, const char *const prefix,
+                  int *const first);
+
+/* ======================================================================== */
+/*  SYMIDX_BEST      -- The preferred symbol for an address, or NULL.       */
+/* ======================================================================== */
+static inline const char *symidx_best(const symidx_t *const idx,
+                                      const uint32_t addr)
+{
+    int32_t i;
+
+    if (!idx->best || addr > 0xFFFF || (i = idx->best[addr]) < 0)
+        return NULL;
+
+    return idx->name[i];
+}
+
+#endif
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
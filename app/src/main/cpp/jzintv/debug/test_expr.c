@@ -0,0 +1,129 @@
+#include "config.h"
+#include "debug/expr.h"
+
+/* ======================================================================== */
+/*  Test harness for debugger expressions.  Build with something like:      */
+/*                                                                          */
+/*    gcc -I. -o test_expr debug/test_expr.c debug/expr.c plat/plat_gen.c   */
+/* ======================================================================== */
+
+static uint16_t mem[0x10000];
+
+static uint32_t peek(void *opaque, uint32_t addr)
+{
+    (void)opaque;
+    return mem[addr];
+}
+
+static int sym(void *opaque, const char *name, uint32_t *value)
+{
+    (void)opaque;
+    if (!strcmp(name, "CARD")) { *value = 0x5012; return 0; }
+    if (!strcmp(name, "_m.x")) { *value = 0x0102; return 0; }
+    return -1;
+}
+
+static const struct { const char *text; int32_t want; } good[] =
+{
+    { "1 + 2 * 3",                  7       },
+    { "(1 + 2) * 3",                9       },
+    { "$10 + 0x10 + 10",            42      },
+    { "R1 > 10 && [$102] == 3",     1       },
+    { "R1 > 10 && [$102] == 4",     0       },
+    { "r1 == 12 || 1 / 0",          1       },
+    { "0 && [R2]",                  0       },
+    { "2 || 0",                     1       },
+    { "-1 < 0",                     1       },
+    { "~0 == -1",                   1       },
+    { "!R0 + !!R1",                 2       },
+    { "1 << 4 >> 2",                4       },
+    { "7 % 3 - 7 / 2",              -2      },
+    { "5 / 0",                      0       },
+    { "$FF & ~$0F ^ 1 | 2",         0xF3    },
+    { "1 == 1 == 1",                1       },
+    { "3 > 2 > 1",                  0       },
+    { "PC == CARD",                 1       },
+    { "[_m.x] + SP",                3 + 0x2F0 },
+    { "S + Z*2 + C*8 + D*32",       1 + 8   },
+    { "A == $102 && V == 3",        1       },
+    { "[[$200]]",                   3       },
+};
+
+static const char *const bad[] =
+{
+    "", "1 +", "(1", "[2", "1 2", "FOO", "$", "12abc", "1 ** 2",
+    "((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((1",
+};
+
+int main(void)
+{
+    expr_env_t env;
+    char err[80];
+    int i, fails = 0;
+
+    memset(&env, 0, sizeof(env));
+    env.var[1]      = 12;
+    env.var[6]      = 0x2F0;
+    env.var[7]      = 0x5012;
+    env.var[EXPR_S] = 1;
+    env.var[EXPR_C] = 1;
+    env.var[EXPR_A] = 0x102;
+    env.var[EXPR_V] = 3;
+    env.peek        = peek;
+    mem[0x102]      = 3;
+    mem[0x200]      = 0x102;
+
+    for (i = 0; i < (int)(sizeof(good) / sizeof(good[0])); i++)
+    {
+        expr_t *e = expr_compile(good[i].text, sym, NULL, err, sizeof(err));
+        int32_t got;
+
+        if (!e)
+        {
+            printf("FAIL: '%s': %s\n", good[i].text, err);
+            fails++;
+            continue;
+        }
+
+        got = expr_eval(e, &env);
+        if (got != good[i].want)
+        {
+            printf("FAIL: '%s' = %d, expected %d\n",
+                   good[i].text, got, good[i].want);
+            fails++;
+        }
+        expr_free(e);
+    }
+
+    for (i = 0; i < (int)(sizeof(bad) / sizeof(bad[0])); i++)
+    {
+        expr_t *e = expr_compile(bad[i], sym, NULL, err, sizeof(err));
+
+        if (e)
+        {
+            printf("FAIL: '%s' compiled\n", bad[i]);
+            fails++;
+            expr_free(e);
+        } else
+            printf("ok:   '%.20s': %s\n", bad[i], err);
+    }
+
+    printf(fails ? "%d FAILURES\n" : "All tests passed\n", fails);
+    return fails != 0;
+}
+
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
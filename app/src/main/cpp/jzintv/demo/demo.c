@@ -104,7 +104,7 @@ LOCAL const int stic_regs[32] =
 /*      N bytes     PSG1 registers (1 byte each)                            */
 /*                                                                          */
 /* ======================================================================== */
-LOCAL uint8_t demo_buf[54 + 32*2 + 64*8 + 240*2 + 16 + 16];
+LOCAL THREAD_LOCAL uint8_t demo_buf[54 + 32*2 + 64*8 + 240*2 + 16 + 16];
 
 #define EMIT_32(buf, word)  do {\
                                 buf[0]   = ((word) >>  0) & 0xFF;           \
@@ -46,6 +46,8 @@
 #include "cp1600/cp1600.h"
 #include "cp1600/emu_link.h"
 #include "event/event.h"
+#include "event/event_log.h"
+#include "netplay/netplay.h"
 #include "event/event_tbl.h"
 #include "event/event_plat.h"
 
@@ -318,6 +320,13 @@ LOCAL uint32_t event_tick(periph_t *const p, uint32_t len)
     if (event_plat_tick(pvt, pvt->plat_pvt))
         return len;     /* Early exit; likely corking input. */
 
+    /* -------------------------------------------------------------------- */
+    /*  Under netplay, events act on the live inputs, not what the game     */
+    /*  is being shown.                                                     */
+    /* -------------------------------------------------------------------- */
+    if (event->netplay)
+        netplay_live(event->netplay);
+
     /* -------------------------------------------------------------------- */
     /*  Drain the internal event queue and trigger all the event.s          */
     /* -------------------------------------------------------------------- */
@@ -342,6 +351,15 @@ LOCAL uint32_t event_tick(periph_t *const p, uint32_t len)
         *event_mask->word |= event_mask->or_mask [event_updn];
     }
 
+    /* -------------------------------------------------------------------- */
+    /*  Log the input changes, or override them with the log's.  Netplay    */
+    /*  captures the live inputs and puts back what it applied.             */
+    /* -------------------------------------------------------------------- */
+    if (event->log)
+        event_log_sync(event->log);
+    if (event->netplay)
+        netplay_sync(event->netplay);
+
     /* -------------------------------------------------------------------- */
     /*  Allow the platform to perform any late event processing tasks.      */
     /* -------------------------------------------------------------------- */
@@ -19,6 +19,8 @@ typedef struct event_t
 {
     periph_t    periph;         /* Yes, it's a peripheral.  Surprise!       */
     evt_pvt_t  *pvt;            /* Private structure                        */
+    struct event_log_t *log;    /* Input log we record to or replay from.   */
+    struct netplay_t   *netplay;/* Netplay session owning the controllers.  */
 } event_t;
 
 /* ======================================================================== */
@@ -0,0 +1,376 @@
+/*
+ * ============================================================================
+ *  Title:    Input Log
+ * ============================================================================
+ *  Records and replays changes to the controller inputs, keyed by CPU
+ *  cycle.  See event_log.h for the file format.
+ *
+ *  Recording hooks the end of each event tick:  any input word that
+ *  differs from our shadow copy gets a record stamped with the CPU's
+ *  current cycle.
+ *
+ *  Replay registers a peripheral on the bus.  It shortens its max_tick
+ *  so the bus stops at the next record's cycle, and applies the record
+ *  once the CPU gets there.  Live input to the logged words is undone at
+ *  the end of every event tick, so only the recording reaches the game.
+ * ============================================================================
+ */
+
+#include "config.h"
+#include "periph/periph.h"
+#include "event/event_log.h"
+
+#define EVLOG_VERSION   (1)
+#define EVLOG_END       (0xFF)
+#define EVLOG_IDLE      (1u << 30)      /* max_tick with nothing pending    */
+
+typedef struct evlog_pvt_t
+{
+    evlog_mode_t    mode;
+    uint32_t      **word;               /* Input words we log.              */
+    uint32_t       *shadow;             /* Their last logged values.        */
+    int             count;
+    const uint64_t *clock;              /* CPU cycle counter.               */
+    uint32_t       *done;               /* Set when replay runs out.        */
+    char           *fname;
+
+    /* Recording */
+    FILE           *f;
+    uint64_t        last;               /* Cycle of the previous record.    */
+    uint32_t        records;
+
+    /* Replay */
+    uint8_t        *buf;
+    size_t          len, pos;
+    uint64_t        next;               /* Cycle of the pending record.     */
+    int             next_idx;           /* Its word index, or EVLOG_END.    */
+    uint32_t        next_val;
+} evlog_pvt_t;
+
+/* ======================================================================== */
+/*  EVLOG_PUT_ULEB  -- Write an unsigned LEB128 value.                      */
+/*  EVLOG_GET_ULEB  -- Read one.  Returns -1 if the buffer runs out.        */
+/* ======================================================================== */
+LOCAL void evlog_put_uleb(FILE *const f, uint64_t v)
+{
+    do
+    {
+        const int b = v & 0x7F;
+        v >>= 7;
+        putc(b | (v ? 0x80 : 0), f);
+    } while (v);
+}
+
+LOCAL int evlog_get_uleb(evlog_pvt_t *const pvt, uint64_t *const v)
+{
+    int shift = 0;
+
+    *v = 0;
+    while (pvt->pos < pvt->len && shift < 64)
+    {
+        const uint8_t b = pvt->buf[pvt->pos++];
+        *v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return 0;
+        shift += 7;
+    }
+    return -1;
+}
+
+/* ======================================================================== */
+/*  EVLOG_FETCH     -- Decode the next replay record into next/next_idx.    */
+/*                     A truncated or damaged log just ends early.          */
+/* ======================================================================== */
+LOCAL void evlog_fetch(evlog_pvt_t *const pvt)
+{
+    uint64_t delta, value = 0;
+    int idx = EVLOG_END;
+
+    if (evlog_get_uleb(pvt, &delta) || pvt->pos >= pvt->len)
+    {
+        fprintf(stderr, "event_log: %s is truncated\n", pvt->fname);
+        delta = 0;
+    } else
+    {
+        idx = pvt->buf[pvt->pos++];
+        if (idx != EVLOG_END &&
+            (idx >= pvt->count || evlog_get_uleb(pvt, &value)))
+        {
+            fprintf(stderr, "event_log: %s is damaged\n", pvt->fname);
+            idx = EVLOG_END;
+        }
+    }
+
+    pvt->next    += delta;
+    pvt->next_idx = idx;
+    pvt->next_val = (uint32_t)value;
+}
+
+/* ======================================================================== */
+/*  EVLOG_SCHEDULE  -- Make sure the bus stops for the pending record.      */
+/*                     If the CPU hasn't caught up to a record we've        */
+/*                     already passed, take a minimal step and look again.  */
+/* ======================================================================== */
+LOCAL void evlog_schedule(periph_t *const p, const evlog_pvt_t *const pvt,
+                          const uint64_t now)
+{
+    if (pvt->next_idx < 0)
+        p->max_tick = EVLOG_IDLE;
+    else if (pvt->next > now)
+        p->max_tick = pvt->next - now < EVLOG_IDLE ? pvt->next - now
+                                                   : EVLOG_IDLE;
+    else
+        p->max_tick = 1;
+}
+
+/* ======================================================================== */
+/*  EVLOG_TICK      -- Apply the records the CPU has reached.               */
+/* ======================================================================== */
+LOCAL uint32_t evlog_tick(periph_t *const p, uint32_t len)
+{
+    event_log_t *const log = PERIPH_AS(event_log_t, p);
+    evlog_pvt_t *const pvt = log->pvt;
+    while (pvt->next_idx >= 0 && pvt->next <= *pvt->clock)
+    {
+        if (pvt->next_idx == EVLOG_END)
+        {
+            jzp_printf("Input replay finished at cycle %llu\n",
+                       (unsigned long long)pvt->next);
+            pvt->next_idx = -1;
+            if (pvt->done)
+                *pvt->done = 1;
+            break;
+        }
+
+        pvt->shadow[pvt->next_idx]  = pvt->next_val;
+        *pvt->word[pvt->next_idx]   = pvt->next_val;
+        pvt->records++;
+        evlog_fetch(pvt);
+    }
+
+    evlog_schedule(p, pvt, p->now + len);
+    return len;
+}
+
+/* ======================================================================== */
+/*  EVENT_LOG_INIT  -- Open a recording or a replay.                        */
+/* ======================================================================== */
+int event_log_init
+(
+    event_log_t    *const log,
+    const char     *const fname,
+    const evlog_mode_t    mode,
+    uint32_t      **const word,
+    const int             count,
+    const uint64_t *const clock,
+    uint32_t       *const done
+)
+{
+    static const periph_t evlog_periph =
+    {
+        PERIPH_NO_RDWR,
+        .min_tick = 1, .max_tick = EVLOG_IDLE,
+        .tick = evlog_tick
+    };
+    evlog_pvt_t *pvt = NULL;
+    FILE *f = NULL;
+    long flen;
+    int i;
+
+    memset(log, 0, sizeof(*log));
+
+    if (mode == EVLOG_OFF)
+        return 0;
+
+    if (count < 1 || count >= EVLOG_END)
+        return -1;
+
+    if (!(pvt = CALLOC(evlog_pvt_t, 1))             ||
+        !(pvt->word   = CALLOC(uint32_t *, count))  ||
+        !(pvt->shadow = CALLOC(uint32_t,   count))  ||
+        !(pvt->fname  = strdup(fname)))
+        goto fail;
+
+    pvt->mode  = mode;
+    pvt->count = count;
+    pvt->clock = clock;
+    pvt->done  = done;
+    memcpy(pvt->word, word, count * sizeof(uint32_t *));
+
+    /* -------------------------------------------------------------------- */
+    /*  Recording:  Write the header.  Records go through stdio's buffer.   */
+    /* -------------------------------------------------------------------- */
+    if (mode == EVLOG_RECORD)
+    {
+        if (!(pvt->f = fopen(fname, "wb")))
+        {
+            perror("fopen()");
+            fprintf(stderr, "event_log: Unable to open %s for writing\n",
+                    fname);
+            goto fail;
+        }
+
+        fputs("jzIL", pvt->f);
+        putc(EVLOG_VERSION, pvt->f);
+        putc(count, pvt->f);
+
+        /* Replay starts with everything released, as does our shadow.  */
+        pvt->last = *clock;
+        log->pvt  = pvt;
+        return 0;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Replay:  Slurp the whole log.  They're small.                       */
+    /* -------------------------------------------------------------------- */
+    if (!(f = fopen(fname, "rb")))
+    {
+        perror("fopen()");
+        fprintf(stderr, "event_log: Unable to open %s\n", fname);
+        goto fail;
+    }
+
+    if (fseek(f, 0, SEEK_END) || (flen = ftell(f)) < 6 ||
+        fseek(f, 0, SEEK_SET))
+    {
+        fprintf(stderr, "event_log: %s is not an input log\n", fname);
+        goto fail;
+    }
+
+    pvt->len = flen;
+    if (!(pvt->buf = CALLOC(uint8_t, pvt->len)) ||
+        fread(pvt->buf, 1, pvt->len, f) != pvt->len)
+        goto fail;
+
+    fclose(f);
+    f = NULL;
+
+    if (memcmp(pvt->buf, "jzIL", 4) || pvt->buf[4] != EVLOG_VERSION ||
+        pvt->buf[5] != count)
+    {
+        fprintf(stderr, "event_log: %s is not a version %d input log for "
+                        "this configuration\n", fname, EVLOG_VERSION);
+        goto fail;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Start from all inputs released, and queue the first record.         */
+    /* -------------------------------------------------------------------- */
+    for (i = 0; i < count; i++)
+        *pvt->word[i] = 0;
+
+    pvt->pos = 6;
+    pvt->next = *clock;
+    evlog_fetch(pvt);
+
+    log->periph = evlog_periph;
+    log->pvt    = pvt;
+    evlog_schedule(&log->periph, pvt, *clock);
+    return 0;
+
+fail:
+    if (f)
+        fclose(f);
+    if (pvt)
+    {
+        if (pvt->f)
+            fclose(pvt->f);
+        CONDFREE(pvt->word);
+        CONDFREE(pvt->shadow);
+        CONDFREE(pvt->fname);
+        CONDFREE(pvt->buf);
+        free(pvt);
+    }
+    return -1;
+}
+
+/* ======================================================================== */
+/*  EVENT_LOG_SYNC  -- Log changed inputs, or undo live input on replay.    */
+/* ======================================================================== */
+void event_log_sync(event_log_t *const log)
+{
+    evlog_pvt_t *const pvt = log->pvt;
+    int i;
+
+    if (!pvt)
+        return;
+
+    for (i = 0; i < pvt->count; i++)
+    {
+        if (*pvt->word[i] == pvt->shadow[i])
+            continue;
+
+        if (pvt->mode == EVLOG_REPLAY)
+        {
+            *pvt->word[i] = pvt->shadow[i];
+            continue;
+        }
+
+        evlog_put_uleb(pvt->f, *pvt->clock - pvt->last);
+        putc(i, pvt->f);
+        evlog_put_uleb(pvt->f, *pvt->word[i]);
+
+        pvt->shadow[i] = *pvt->word[i];
+        pvt->last      = *pvt->clock;
+        pvt->records++;
+    }
+}
+
+/* ======================================================================== */
+/*  EVENT_LOG_MODE  -- What are we doing?                                   */
+/* ======================================================================== */
+evlog_mode_t event_log_mode(const event_log_t *const log)
+{
+    return log->pvt ? log->pvt->mode : EVLOG_OFF;
+}
+
+/* ======================================================================== */
+/*  EVENT_LOG_DTOR  -- Finish the recording, report, and free it all.       */
+/* ======================================================================== */
+void event_log_dtor(event_log_t *const log)
+{
+    evlog_pvt_t *const pvt = log->pvt;
+
+    if (!pvt)
+        return;
+
+    if (pvt->mode == EVLOG_RECORD)
+    {
+        evlog_put_uleb(pvt->f, *pvt->clock - pvt->last);
+        putc(EVLOG_END, pvt->f);
+
+        jzp_printf("Input log: %u changes over %llu cycles, %ld bytes, "
+                   "written to %s\n", pvt->records,
+                   (unsigned long long)*pvt->clock, ftell(pvt->f),
+                   pvt->fname);
+
+        if (fclose(pvt->f))
+            fprintf(stderr, "event_log: Error writing %s\n", pvt->fname);
+    } else
+    {
+        jzp_printf("Input replay: %u changes applied from %s\n",
+                   pvt->records, pvt->fname);
+    }
+
+    CONDFREE(pvt->word);
+    CONDFREE(pvt->shadow);
+    CONDFREE(pvt->fname);
+    CONDFREE(pvt->buf);
+    CONDFREE(log->pvt);
+}
+
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
@@ -0,0 +1,86 @@
+/*
+ * ============================================================================
+ *  Title:    Input Log
+ * ============================================================================
+ *  Records every change the event subsystem makes to the controller inputs,
+ *  tagged with the CPU cycle it happened on, and plays a recording back
+ *  at exactly the same cycles.  A replayed run sees the same inputs at the
+ *  same instructions as the recorded one, regardless of wall-clock timing.
+ *
+ *  File format, all integers unsigned LEB128 unless noted:
+ *
+ *      "jzIL"          4 byte magic
+ *      version         1 byte, currently 1
+ *      words           1 byte, number of input words logged
+ *      records...      delta, index (1 byte), value
+ *      end             delta, 0xFF
+ *
+ *  'delta' is the number of CPU cycles since the previous record, or since
+ *  the log started.  'index' selects one of the input words, and 'value'
+ *  is its new value.  The end record marks the cycle recording stopped at.
+ * ============================================================================
+ */
+#ifndef EVENT_EVENT_LOG_H_
+#define EVENT_EVENT_LOG_H_
+
+typedef enum
+{
+    EVLOG_OFF = 0,
+    EVLOG_RECORD,
+    EVLOG_REPLAY
+} evlog_mode_t;
+
+typedef struct event_log_t
+{
+    periph_t            periph; /* Ticked on the bus while replaying.       */
+    struct evlog_pvt_t *pvt;    /* Private state.                           */
+} event_log_t;
+
+/* ======================================================================== */
+/*  EVENT_LOG_INIT  -- Open 'fname' to record or replay changes to the      */
+/*                     'count' words in 'word'.  'clock' is the CPU's       */
+/*                     cycle counter.  Replay sets '*done' when the         */
+/*                     recording runs out.  Returns 0 on success, -1 on     */
+/*                     failure.                                             */
+/* ======================================================================== */
+int event_log_init
+(
+    event_log_t    *const log,
+    const char     *const fname,
+    const evlog_mode_t    mode,
+    uint32_t      **const word,
+    const int             count,
+    const uint64_t *const clock,
+    uint32_t       *const done
+);
+
+/* ======================================================================== */
+/*  EVENT_LOG_SYNC  -- Call after the event subsystem has updated the       */
+/*                     inputs.  Recording logs whatever changed.  Replay    */
+/*                     puts back the replayed values over any live input.   */
+/* ======================================================================== */
+void event_log_sync(event_log_t *const log);
+
+/* ======================================================================== */
+/*  EVENT_LOG_MODE  -- Returns EVLOG_RECORD, EVLOG_REPLAY or EVLOG_OFF.     */
+/*  EVENT_LOG_DTOR  -- Finish the recording, report, and free it all.       */
+/* ======================================================================== */
+evlog_mode_t event_log_mode(const event_log_t *const log);
+void event_log_dtor(event_log_t *const log);
+
+#endif
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
@@ -68,6 +68,25 @@ void event_plat_tick_late(evt_pvt_t *const pvt, void *const plat_pvt)
     UNUSED(plat_pvt);
 }
 
+/* ======================================================================== */
+/*  TICK_CALLED, MAP_EVENT -- event.c reports ticks and input map changes   */
+/*                            to the GUI front end.  There's no front end   */
+/*                            here.                                         */
+/* ======================================================================== */
+void tick_called(void);
+void map_event(const char *msg, const char *num, int map);
+
+void tick_called(void)
+{
+}
+
+void map_event(const char *msg, const char *num, int map)
+{
+    UNUSED(msg);
+    UNUSED(num);
+    UNUSED(map);
+}
+
 /* ======================================================================== */
 /*  This program is free software; you can redistribute it and/or modify    */
 /*  it under the terms of the GNU General Public License as published by    */
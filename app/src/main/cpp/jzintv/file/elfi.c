@@ -37,9 +37,9 @@
 #include "elfi.h"
 #include <ctype.h>
 
-LOCAL int   fd_map[MAX_ELFI_FD];     /* map Intellivision fd to system fd */
-LOCAL char *elfi_fname = NULL;
-LOCAL char *elfi_fname_end;
+LOCAL THREAD_LOCAL int   fd_map[MAX_ELFI_FD];  /* Intellivision fd to system fd */
+LOCAL THREAD_LOCAL char *elfi_fname = NULL;
+LOCAL THREAD_LOCAL char *elfi_fname_end;
 
 LOCAL int elfi_open   (cp1600_t *, int *, void *);
 LOCAL int elfi_close  (cp1600_t *, int *, void *);
@@ -29,8 +29,8 @@ void gfx_scrshot(const gfx_t *const gfx)
 {
     const uint8_t *const scr = gfx->vid;
     const palette_t *const palette = &gfx->palette;
-    static uint8_t scrshot_buf[320*200];
-    static unique_filename_t shot_file_tmpl =
+    uint8_t *scrshot_buf;
+    static THREAD_LOCAL unique_filename_t shot_file_tmpl =
     {
         "shot", ".gif", NULL, 0, 4, 0
     };
@@ -48,6 +48,13 @@ void gfx_scrshot(const gfx_t *const gfx)
         return;
     }
 
+    if (!(scrshot_buf = CALLOC(uint8_t, 320*200)))
+    {
+        fprintf(stderr, "Error:  Out of memory for screen dump.\n");
+        fclose(f);
+        return;
+    }
+
     /* -------------------------------------------------------------------- */
     /*  Do the screen dump.  Write it as a nice GIF.  We need to pixel      */
     /*  double the image ahead of time.                                     */
@@ -56,6 +63,7 @@ void gfx_scrshot(const gfx_t *const gfx)
         scrshot_buf[i*2 + 0] = scrshot_buf[i*2 + 1] = scr[i];
 
     len = gif_write(f, scrshot_buf, 320, 200, (gif_pal_t)palette->color, 16);
+    free(scrshot_buf);
     if (len > 0)
     {
         jzp_printf("\nWrote screen shot to '%s', %d bytes\n",
@@ -81,7 +89,7 @@ void gfx_movieupd(gfx_t *const gfx)
     /* -------------------------------------------------------------------- */
     if (gfx->scrshot & GFX_MVTOG)
     {
-        static unique_filename_t mvi_file_tmpl = 
+        static THREAD_LOCAL unique_filename_t mvi_file_tmpl =
         {
             "mvi_", ".imv", NULL, 0, 4, 0
         };
@@ -115,6 +123,7 @@ void gfx_movieupd(gfx_t *const gfx)
         {
             if (gfx->movie->f)
             {
+                mvi_wr_index(gfx->movie);
                 fclose(gfx->movie->f);
                 jzp_printf("\nDone writing movie:\n"
                        "    Total frames:        %10d\n"
@@ -125,6 +134,7 @@ void gfx_movieupd(gfx_t *const gfx)
 #endif
                        "    Dupe frames:         %10d\n"
                        "    Dupe rows:           %10d\n"
+                       "    Keyframes:           %10d\n"
                        "    Compression ratio:   %8.2f:1\n",
                        gfx->movie->fr,
                        gfx->movie->tot_bytes,
@@ -134,6 +144,7 @@ void gfx_movieupd(gfx_t *const gfx)
 #endif
                        gfx->movie->rpt_frames,
                        gfx->movie->rpt_rows,
+                       gfx->movie->idx_cnt,
                        (16032.*gfx->movie->fr) / gfx->movie->tot_bytes);
                 jzp_flush();
             }
@@ -198,8 +209,12 @@ void gfx_aviupd(gfx_t *const gfx)
                 avi_end_video(avi);     // does not invalidate 'info'
 
                 jzp_printf("\nDone writing AVI\n"
-                       "    Total frames:        %10d\n",
-                       info->total_frames);
+                       "    Total frames:        %10d\n"
+                       "    Encoder queue peak:  %10u\n"
+                       "    Encoder stalls:      %10u\n"
+                       "    Audio frames padded: %10u\n",
+                       info->total_frames, info->queue_high_water,
+                       info->queue_stalls, info->audio_padded);
                 jzp_flush();
             }
 
@@ -210,7 +225,7 @@ void gfx_aviupd(gfx_t *const gfx)
         /* ---------------------------------------------------------------- */
         /*  Open a unique file for the AVI.                                 */
         /* ---------------------------------------------------------------- */
-        static unique_filename_t avi_file_tmpl =
+        static THREAD_LOCAL unique_filename_t avi_file_tmpl =
         {
             "avi_", ".avi", NULL, 0, 4, 0
         };
@@ -252,11 +267,12 @@ void gfx_resync(gfx_t *const gfx)
 }
 
 /* ======================================================================== */
-/*  GFX_HIDDEN       -- Returns true if the graphics window is hidden.      */
+/*  GFX_HIDDEN       -- Returns true if the graphics window is hidden, or   */
+/*                      if run-ahead won't show the frame anyway.           */
 /* ======================================================================== */
 bool gfx_hidden(const gfx_t *const gfx)
 {
-    return gfx->hidden;
+    return gfx->hidden || (gfx->run_ahead & GFX_RA_NOSHOW) != 0;
 }
 
 /* ======================================================================== */
@@ -52,6 +52,7 @@
 struct avi_writer_t;    /* forward decl */
 struct gfx_pvt_t;       /* forward decl */
 struct mvi_t;           /* forward decl */
+struct strm_t;          /* forward decl */
 
 typedef struct gfx_t
 {
@@ -67,6 +68,7 @@ typedef struct gfx_t
     uint32_t    hidden;             /*  Visibility flag (set by event_t)    */
     uint32_t    scrshot;            /*  Screen-shot/movie requested         */
     uint32_t    toggle;             /*  Toggle full-screen / windowed       */
+    uint32_t    run_ahead;          /*  GFX_RA_xxx flags for this frame.    */
 
     int         b_color, b_dirty;   /*  Border color and dirty flag.        */
     int         x_blank, y_blank;   /*  FLAG: Blank top row, left column.   */
@@ -82,6 +84,10 @@ typedef struct gfx_t
     int         audio_rate;         /*  Ugh... only needed for AVI.         */
     int         fps;                /*  Frame rate.                         */
 
+    struct strm_t *strm;            /*  Raw stream output, if any.          */
+    uint32_t    hash_left;          /*  Frames still to add to 'hash'.      */
+    uint32_t    hash;               /*  CRC32 of the frames hashed so far.  */
+
     palette_t   palette;            /*  Current graphics palette.           */
     struct gfx_pvt_t *pvt;          /*  Private data.                       */
 } gfx_t;
@@ -134,6 +140,9 @@ int gfx_set_title(gfx_t *gfx, const char *title);
 #define GFX_AVTOG   (1 << 4)
 #define GFX_AVI     (1 << 5)
 
+#define GFX_RA_NOSHOW (1 << 0)  /* Run-ahead: don't display this frame.  */
+#define GFX_RA_NOREC  (1 << 1)  /* Run-ahead: don't record this frame.   */
+
 #define GFX_WIND_TOG  (1)   /* Toggle windowed / fullscreen */
 #define GFX_WIND_ON   (2)   /* Go to windowed mode.         */
 #define GFX_WIND_OFF  (3)   /* Go to fullscreen mode.       */
@@ -385,7 +385,10 @@ LOCAL void gfx_dtor(periph_t *const p)
         gfx->pvt->movie)
     {
         if (gfx->pvt->movie->f)
+        {
+            mvi_wr_index(gfx->pvt->movie);
             fclose(gfx->pvt->movie->f);
+        }
 
         CONDFREE(gfx->pvt->movie);
     }
@@ -771,6 +774,7 @@ void gfx_movieupd(gfx_t *gfx)
         {
             if (pvt->movie->f)
             {
+                mvi_wr_index(pvt->movie);
                 fclose(pvt->movie->f);
                 jzp_printf("\nDone writing movie:\n"
                        "    Total frames:        %10d\n"
@@ -781,6 +785,7 @@ void gfx_movieupd(gfx_t *gfx)
 #endif
                        "    Dupe frames:         %10d\n"
                        "    Dupe rows:           %10d\n"
+                       "    Keyframes:           %10d\n"
                        "    Compression ratio:   %8.2f:1\n",
                        pvt->movie->fr,
                        pvt->movie->tot_bytes,
@@ -790,6 +795,7 @@ void gfx_movieupd(gfx_t *gfx)
 #endif
                        pvt->movie->rpt_frames,
                        pvt->movie->rpt_rows,
+                       pvt->movie->idx_cnt,
                        (16032.*pvt->movie->fr) / pvt->movie->tot_bytes);
                 jzp_flush();
             }
@@ -27,6 +27,8 @@
 //#include "file/file.h"
 #include "mvi/mvi.h"
 #include "avi/avi.h"
+#include "strm/strm.h"
+#include "misc/crc32.h"
 #include "lzoe/lzoe.h"
 #include "file/file.h"
 
@@ -140,7 +142,10 @@ LOCAL void gfx_dtor(periph_t *const p)
     if (gfx->movie)
     {
         if (gfx->movie->f)
+        {
+            mvi_wr_index(gfx->movie);
             fclose(gfx->movie->f);
+        }
 
         CONDFREE(gfx->movie);
     }
@@ -228,22 +233,46 @@ void gfx_refresh(gfx_t *const gfx)
 /* ======================================================================== */
 void gfx_stic_tick(gfx_t *const gfx)
 {
-    gfx->tot_frames++;
-
     /* -------------------------------------------------------------------- */
     /*  Update a movie if one's active, or user requested toggle in movie   */
     /*  state.  We do this prior to dropping frames so that movies always   */
     /*  have a consistent frame rate.                                       */
     /* -------------------------------------------------------------------- */
-    if (gfx->scrshot & (GFX_MOVIE | GFX_MVTOG))
+    if ((gfx->scrshot & (GFX_MOVIE | GFX_MVTOG)) &&
+        !(gfx->run_ahead & GFX_RA_NOREC))
         gfx_movieupd(gfx);
 
     /* -------------------------------------------------------------------- */
     /*  Update an AVI if one's active, or if user requested a toggle.       */
     /* -------------------------------------------------------------------- */
-    if (gfx->scrshot & (GFX_AVI | GFX_AVTOG))
+    if ((gfx->scrshot & (GFX_AVI | GFX_AVTOG)) &&
+        !(gfx->run_ahead & GFX_RA_NOREC))
         gfx_aviupd(gfx);
 
+    /* -------------------------------------------------------------------- */
+    /*  Send the frame to the raw stream output, if there is one.           */
+    /* -------------------------------------------------------------------- */
+    if (gfx->strm && !(gfx->run_ahead & GFX_RA_NOREC))
+        strm_video(gfx->strm, gfx->vid, gfx->periph.now);
+
+    /* -------------------------------------------------------------------- */
+    /*  Hash the frame, if this is a bounded run (--max-frames).            */
+    /* -------------------------------------------------------------------- */
+    if (gfx->hash_left && !(gfx->run_ahead & GFX_RA_NOREC))
+    {
+        gfx->hash = crc32_block(gfx->hash, gfx->vid, 160 * 200);
+        gfx->hash_left--;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Run-ahead hides most frames.  Those don't count as dropped.         */
+    /* -------------------------------------------------------------------- */
+    if (gfx->run_ahead & GFX_RA_NOSHOW)
+    {
+        gfx->tot_frames++;
+        return;
+    }
+
     /* -------------------------------------------------------------------- */
     /*  Drop a frame if we need to.                                         */
     /* -------------------------------------------------------------------- */
@@ -313,6 +342,17 @@ void gfx_set_bord
     if (dirty & 2) { gfx->b_dirty |= 2; }
 }
 
+/* ======================================================================== */
+/*  MANAGE_SCREENSHOT_FILE -- gfx.c hands each new screenshot to the GUI    */
+/*                            front end.  There's no front end here.        */
+/* ======================================================================== */
+void manage_screenshot_file(char *filename);
+
+void manage_screenshot_file(char *filename)
+{
+    UNUSED(filename);
+}
+
 /* ======================================================================== */
 /*  This program is free software; you can redistribute it and/or modify    */
 /*  it under the terms of the GNU General Public License as published by    */
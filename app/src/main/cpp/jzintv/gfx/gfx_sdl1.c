@@ -28,6 +28,8 @@
 //#include "file/file.h"
 #include "mvi/mvi.h"
 #include "avi/avi.h"
+#include "strm/strm.h"
+#include "misc/crc32.h"
 #include "lzoe/lzoe.h"
 #include "file/file.h"
 
@@ -631,7 +633,10 @@ LOCAL void gfx_dtor(periph_t *const p)
     if (gfx->movie)
     {
         if (gfx->movie->f)
+        {
+            mvi_wr_index(gfx->movie);
             fclose(gfx->movie->f);
+        }
 
         CONDFREE(gfx->movie);
     }
@@ -892,15 +897,41 @@ void gfx_stic_tick(gfx_t *const gfx)
     /*  state.  We do this prior to dropping frames so that movies always   */
     /*  have a consistent frame rate.                                       */
     /* -------------------------------------------------------------------- */
-    if (gfx->scrshot & (GFX_MOVIE | GFX_MVTOG))
+    if ((gfx->scrshot & (GFX_MOVIE | GFX_MVTOG)) &&
+        !(gfx->run_ahead & GFX_RA_NOREC))
         gfx_movieupd(gfx);
 
     /* -------------------------------------------------------------------- */
     /*  Update an AVI if one's active, or if user requested a toggle.       */
     /* -------------------------------------------------------------------- */
-    if (gfx->scrshot & (GFX_AVI | GFX_AVTOG))
+    if ((gfx->scrshot & (GFX_AVI | GFX_AVTOG)) &&
+        !(gfx->run_ahead & GFX_RA_NOREC))
         gfx_aviupd(gfx);
 
+    /* -------------------------------------------------------------------- */
+    /*  Send the frame to the raw stream output, if there is one.           */
+    /* -------------------------------------------------------------------- */
+    if (gfx->strm && !(gfx->run_ahead & GFX_RA_NOREC))
+        strm_video(gfx->strm, gfx->vid, gfx->periph.now);
+
+    /* -------------------------------------------------------------------- */
+    /*  Hash the frame, if this is a bounded run (--max-frames).            */
+    /* -------------------------------------------------------------------- */
+    if (gfx->hash_left && !(gfx->run_ahead & GFX_RA_NOREC))
+    {
+        gfx->hash = crc32_block(gfx->hash, gfx->vid, 160 * 200);
+        gfx->hash_left--;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Run-ahead hides most frames.  Those don't count as dropped.         */
+    /* -------------------------------------------------------------------- */
+    if (gfx->run_ahead & GFX_RA_NOSHOW)
+    {
+        gfx->tot_frames++;
+        return;
+    }
+
     /* -------------------------------------------------------------------- */
     /*  Toggle full-screen/windowed if requested.  Pause for a short time   */
     /*  if we do toggle between windowed and full-screen.                   */
@@ -8,28 +8,83 @@
 /*  This GIF encoder doesn't trust that the decoder honors the aspect       */
 /*  ratio stored in the GIF.  We just set it to 0.                          */
 /*                                                                          */
-/*  None of this code's thread-safe/reentrant.  BFD.                        */
+/*  Only one GIF may be in progress at a time, as the encoder keeps its     */
+/*  scratch buffers in statics.  Multi-frame GIFs can farm the compression  */
+/*  of each frame out to worker threads, though.  See gif_set_threads().    */
 /* ======================================================================== */
 
 
 #include "config.h"
+#include "plat/plat.h"
 #include "gif/gif_enc.h"
 #include "gif/lzw_enc.h"
 
-LOCAL uint8_t *gif_enc_buf = NULL;
-LOCAL int      gif_enc_buf_sz = 0;
+LOCAL THREAD_LOCAL uint8_t *gif_enc_buf = NULL;
+LOCAL THREAD_LOCAL int      gif_enc_buf_sz = 0;
 
-LOCAL uint8_t *gif_img_tr  = NULL;
-LOCAL uint8_t *gif_img_a   = NULL;
-LOCAL uint8_t *gif_img_b   = NULL;
-LOCAL uint8_t *gif_img_d   = NULL, *gif_pal_d = NULL;
-LOCAL uint8_t *gif_img_e   = NULL, *gif_pal_e = NULL;
-LOCAL uint8_t *gif_img_f   = NULL, *gif_pal_f = NULL;
-LOCAL int      gif_img_sz  = 0;
-
-LOCAL int gen_mpi(uint8_t *src, uint8_t *xtra, uint8_t *dst,
+LOCAL int gen_mpi(const uint8_t *src, const uint8_t *xtra, uint8_t *dst,
                   int cnt, uint8_t *pal);
 
+/* ======================================================================== */
+/*  GIF_JOB_T  -- One frame of a multi-frame GIF on its way to the file.    */
+/*                                                                          */
+/*  gif_frame_prep() crops the frame against the previous one.  That has    */
+/*  to happen in order, on the caller's thread.  gif_frame_enc() does the   */
+/*  rest:  palette reduction, the trial compressions, and the headers.  It  */
+/*  only touches the job and the GIF's fixed palette, so frames can go      */
+/*  through it in parallel.  The frames then get written in order.          */
+/*                                                                          */
+/*  Each trial compresses into lzw[1] just after GIF_HDR_ROOM bytes of      */
+/*  headroom.  A new best trial swaps into lzw[0], so the winner is never   */
+/*  compressed twice, and its headers get built in the headroom.            */
+/* ======================================================================== */
+#define GIF_HDR_ROOM (8 + 10 + 3*256)   /* GCE, image descriptor, max LCT   */
+
+typedef struct gif_job_t
+{
+    int         sz;             /* Pixels the buffers below can hold.       */
+    uint8_t    *mem;            /* Single allocation behind all buffers.    */
+    uint8_t    *img_a, *img_b, *img_d, *img_e, *img_f;
+    uint8_t    *pal_d, *pal_e, *pal_f;
+    uint8_t    *lzw[2];         /* Best so far, and the current trial.      */
+
+    int         min_x, min_y;   /* Cropped frame position and size.         */
+    int         width, height;
+    int         delay;          /* Frame delay in 100ths of a second.       */
+    int         trans;          /* Non-zero: try transparency (b,c,e,f).    */
+
+    const uint8_t *out;         /* The finished frame, ready to write...    */
+    int         out_len;        /* ...and its length, or -1 on error.       */
+    int         best;           /* Winning image type, 0 thru 5 == a thru f */
+    int         done;           /* Pipelined:  gif_frame_enc() finished.    */
+} gif_job_t;
+
+/* ======================================================================== */
+/*  GIF_PIPE_T -- Worker threads for multi-frame GIFs.  Frames are queued   */
+/*                in a ring of jobs.  sub_seq counts frames submitted,      */
+/*                enc_seq frames claimed by a worker, and wr_seq frames     */
+/*                written, so wr_seq <= enc_seq <= sub_seq.                 */
+/* ======================================================================== */
+typedef struct gif_pipe_t
+{
+    const gif_t    *gif;
+    plat_mutex_t   *lock;
+    plat_cond_t    *work;       /* Signaled when a job is submitted.        */
+    plat_cond_t    *done;       /* Signaled when a job is finished.         */
+    plat_thread_t **thread;
+    int             threads;
+    gif_job_t      *job;
+    int             n_job;
+    unsigned        sub_seq, enc_seq, wr_seq;
+    int             quit;
+    int             err;        /* Sticky:  a frame failed to encode/write. */
+} gif_pipe_t;
+
+LOCAL THREAD_LOCAL
+      gif_job_t gif_job;        /* Job for non-pipelined gif_wr_frame_m.    */
+
+LOCAL int gif_pipe_dtor(gif_t *gif);
+
 int gif_best_stat[6];
 
 /* ======================================================================== */
@@ -55,6 +110,7 @@ int gif_start
     /* -------------------------------------------------------------------- */
     memset(gif, 0, sizeof(gif_t));
     gif->f     = f;
+    gif->pipe  = NULL;
     gif->x_dim = x_dim;
     gif->y_dim = y_dim;
     if (multi)
@@ -186,6 +242,14 @@ int gif_start
 /* ======================================================================== */
 int gif_finish(gif_t *gif)
 {
+    int ret = 1;
+
+    /* -------------------------------------------------------------------- */
+    /*  Write out any frames still in the pipeline, and stop the workers.   */
+    /* -------------------------------------------------------------------- */
+    if (gif->pipe && gif_pipe_dtor(gif) < 0)
+        ret = -1;
+
     /* -------------------------------------------------------------------- */
     /*  Write an image terminator.                                          */
     /* -------------------------------------------------------------------- */
@@ -198,7 +262,7 @@ int gif_finish(gif_t *gif)
     if (gif->vid) { free(gif->vid); gif->vid = NULL; }
     if (gif->pal) { free(gif->pal); gif->pal = NULL; }
 
-    return 1;   /* wrote 1 byte. */
+    return ret;   /* wrote 1 byte. */
 }
 
 
@@ -303,88 +367,54 @@ int gif_write
 
 
 /* ======================================================================== */
-/*  GIF_WR_FRAME_M -- Writes next frame to a multi-frame GIF.               */
-/*                    Attempts to optimize image.                           */
+/*  GIF_JOB_ALLOC -- Size a job's buffers for sz-pixel frames.              */
 /* ======================================================================== */
-int gif_wr_frame_m
+LOCAL int gif_job_alloc(gif_job_t *job, int sz)
+{
+    int lzw_sz = GIF_HDR_ROOM + 2 * sz;
+
+    if (job->mem && job->sz >= sz)
+        return 0;
+
+    CONDFREE(job->mem);
+    job->sz  = 0;
+    job->mem = CALLOC(uint8_t, 5 * sz + 3 * 256 + 2 * lzw_sz);
+    if (!job->mem)
+        return -1;
+
+    job->sz     = sz;
+    job->img_a  = job->mem;
+    job->img_b  = job->img_a + sz;
+    job->img_d  = job->img_b + sz;
+    job->img_e  = job->img_d + sz;
+    job->img_f  = job->img_e + sz;
+    job->pal_d  = job->img_f + sz;
+    job->pal_e  = job->pal_d + 256;
+    job->pal_f  = job->pal_e + 256;
+    job->lzw[0] = job->pal_f + 256;
+    job->lzw[1] = job->lzw[0] + lzw_sz;
+
+    return 0;
+}
+
+/* ======================================================================== */
+/*  GIF_FRAME_PREP -- Steps 1 through 3 of gif_wr_frame_m's optimization.   */
+/*                    Returns 0 if the frame matches the previous one, and  */
+/*                    makes vid the new previous frame otherwise.           */
+/* ======================================================================== */
+LOCAL int gif_frame_prep
 (
     gif_t         *gif,
+    gif_job_t     *job,
     const uint8_t *vid,
     int            delay,
     int            mode
 )
 {
-    int trans = gif->trans >= 0;
-    uint8_t *enc_ptr = gif_enc_buf;
     const uint8_t *vid_ptr, *prv_ptr;
-    uint8_t *trn_ptr;
-    uint8_t *best_img1, *best_img2, *best_lct;
-    int x, y, xx, yy, min_x, min_y, max_x, max_y, width, height;
-    int n_col_d, n_col_e = 0, n_col_f = 0, lct_sz_d, lct_sz_e, lct_sz_f;
-    int enc_sz_a, enc_sz_b, enc_sz_c, enc_sz_d, enc_sz_e, enc_sz_f;
-    int best_sz, best_lct_sz, trans_idx, do_trans = 0;
-    int lzw_len;
-    int cnt, num_trans = 0;
-    char best = '*';
-    size_t wrote;
-
-    assert(enc_ptr);
-
-    /* -------------------------------------------------------------------- */
-    /*  Allocate our image optimization scratch buffers, if necessary.      */
-    /* -------------------------------------------------------------------- */
-    if (gif_img_sz < gif->x_dim * gif->y_dim)
-    {
-        if (gif_img_tr) free(gif_img_tr);
-        gif_img_sz = gif->x_dim * gif->y_dim;
-        gif_img_tr = CALLOC(uint8_t, 7 * gif->x_dim * gif->y_dim + 3*256);
-
-        if (!gif_img_tr)
-        {
-            fprintf(stderr, "gif_wr_frame_m: out of memory\n");
-            return -1;
-        }
-
-        gif_img_a = gif_img_tr + gif_img_sz * 2;
-        gif_img_b = gif_img_a  + gif_img_sz;
-        gif_img_d = gif_img_b  + gif_img_sz;
-        gif_img_e = gif_img_d  + gif_img_sz;
-        gif_img_f = gif_img_e  + gif_img_sz;
-        gif_pal_d = gif_img_f  + gif_img_sz;
-        gif_pal_e = gif_pal_d  + 256;
-        gif_pal_f = gif_pal_e  + 256;
-    }
-
-    /* -------------------------------------------------------------------- */
-    /*  Optimize image:                                                     */
-    /*                                                                      */
-    /*   1. Generate "transparency" image with trans pixels wherever this   */
-    /*      image is the same as the previous one.                          */
-    /*                                                                      */
-    /*   2. Compute tighter bounding box on image--that is, smallest box    */
-    /*      that contains all the non-trans pixels.                         */
-    /*                                                                      */
-    /*   3. Crop the incoming image based on the tighter bounding box.      */
-    /*                                                                      */
-    /*   4. Generate "minimal palette" images that renumber all the         */
-    /*      pixels into the smallest possible numbering space.              */
-    /*                                                                      */
-    /*   5. Compress the image multiple ways, and take the best:            */
-    /*                                                                      */
-    /*       a. Cropped image, orig palette, no trans pixels                */
-    /*       b. Cropped image, orig palette, trans pixels                   */
-    /*       c. Cropped image, orig palette, "wildcard" trans/no-trans      */
-    /*       d. Cropped image, new palette, no trans pixels                 */
-    /*       e. Cropped image, new palette, trans pixels                    */
-    /*       f. Cropped image, new palette, "wildcard" trans/no-trans       */
-    /*                                                                      */
-    /*      When comparing new palette to orig palette, include cost        */
-    /*      of sending local palette.  If the global palette has too        */
-    /*      many colors, we may not be able to try b or c.  If the local    */
-    /*      palette has too many colors, we may not be able to try e or     */
-    /*      f.                                                              */
-    /*                                                                      */
-    /* -------------------------------------------------------------------- */
+    uint8_t *trn_ptr, *img_tr = job->lzw[0] + GIF_HDR_ROOM;
+    int x, y, xx, yy, min_x, min_y, max_x, max_y, width;
+    int num_trans = 0;
 
     /* -------------------------------------------------------------------- */
     /*   1. Generate "transparency" image...                                */
@@ -397,7 +427,7 @@ int gif_wr_frame_m
 
     vid_ptr = vid;
     prv_ptr = gif->vid;
-    trn_ptr = gif_img_tr;
+    trn_ptr = img_tr;
 
     for (y = 0; y < gif->y_dim; y++)
         for (x = 0; x < gif->x_dim; x++)
@@ -418,7 +448,6 @@ int gif_wr_frame_m
             *trn_ptr++ = tran;
         }
 
-
     /* -------------------------------------------------------------------- */
     /*  Stop now if current image matches previous image.                   */
     /* -------------------------------------------------------------------- */
@@ -433,9 +462,7 @@ int gif_wr_frame_m
         max_y = gif->y_dim - 1;
     }
 
-    width  = max_x - min_x + 1;
-    height = max_y - min_y + 1;
-    cnt    = width*height;
+    width = max_x - min_x + 1;
 
     /* -------------------------------------------------------------------- */
     /*   3. Crop the incoming image based on the tighter bounding box.      */
@@ -445,26 +472,70 @@ int gif_wr_frame_m
         {
             /*  a. Cropped image, orig palette, no trans pixels             */
             /*  b. Cropped image, orig palette, trans pixels                */
-            gif_img_a[xx + yy*width] = vid       [x + y*gif->x_dim];
-            gif_img_b[xx + yy*width] = gif_img_tr[x + y*gif->x_dim];
+            job->img_a[xx + yy*width] = vid   [x + y*gif->x_dim];
+            job->img_b[xx + yy*width] = img_tr[x + y*gif->x_dim];
 
-            if (gif_img_tr[x + y*gif->x_dim] == gif->trans)
+            if (img_tr[x + y*gif->x_dim] == gif->trans)
                 num_trans++;
         }
 
-    if (num_trans == 0) trans = 0;
-    if (mode != 0)      trans = 0;
-#if 0
-    {
-        FILE *ff;
-        ff = fopen("debug", "wb");
-        if (ff)
-        {
-            fwrite(gif_img_a, 1, cnt, ff);
-            fclose(ff);
-        }
-    }
-#endif
+    job->min_x  = min_x;
+    job->min_y  = min_y;
+    job->width  = width;
+    job->height = max_y - min_y + 1;
+    job->delay  = delay;
+    job->trans  = gif->trans >= 0 && num_trans != 0 && mode == 0;
+
+    /* -------------------------------------------------------------------- */
+    /*  Make the current image the new previous image.                      */
+    /* -------------------------------------------------------------------- */
+    memcpy(gif->vid, vid, gif->x_dim * gif->y_dim);
+
+    return 1;
+}
+
+/* ======================================================================== */
+/*  GIF_TRIAL     -- Where the next trial compression goes.                 */
+/* ======================================================================== */
+LOCAL INLINE uint8_t *gif_trial(const gif_job_t *job)
+{
+    return job->lzw[1] + GIF_HDR_ROOM;
+}
+
+/* ======================================================================== */
+/*  GIF_KEEP_BEST -- A trial just compressed into job->lzw[1].  If it beats */
+/*                   the best so far, counting the cost of any local color  */
+/*                   table, swap it into job->lzw[0].  Ties go to the       */
+/*                   earlier trial.                                         */
+/* ======================================================================== */
+LOCAL void gif_keep_best(gif_job_t *job, int type, int len, int lct_cost,
+                         int *best_sz, int *best_len)
+{
+    uint8_t *tmp;
+
+    if (len < 0 || len + lct_cost >= *best_sz)
+        return;
+
+    *best_sz    = len + lct_cost;
+    *best_len   = len;
+    job->best   = type;
+    tmp         = job->lzw[0];
+    job->lzw[0] = job->lzw[1];
+    job->lzw[1] = tmp;
+}
+
+/* ======================================================================== */
+/*  GIF_FRAME_ENC -- Steps 4 and 5 of gif_wr_frame_m's optimization, then   */
+/*                   the frame's headers.  Leaves the result in job->out.   */
+/* ======================================================================== */
+LOCAL void gif_frame_enc(const gif_t *gif, gif_job_t *job)
+{
+    const uint8_t *best_lct = NULL;
+    uint8_t *enc_ptr;
+    int cnt = job->width * job->height, trans = job->trans;
+    int n_col_d, n_col_e = 0, n_col_f = 0, lct_sz_d, lct_sz_e, lct_sz_f;
+    int best_sz = INT_MAX, best_len = 0, best_lct_sz = 0;
+    int trans_idx = 0xFF, do_trans = 0, hdr_len, len, i;
 
     /* -------------------------------------------------------------------- */
     /*   4. Generate "minimal palette" images...                            */
@@ -472,9 +543,12 @@ int gif_wr_frame_m
     /*       e. Cropped image, new palette, trans pixels                    */
     /*       f. Cropped image, new palette, "wildcard" trans/no-trans       */
     /* -------------------------------------------------------------------- */
-              n_col_d = gen_mpi(gif_img_a, NULL,    gif_img_d, cnt, gif_pal_d);
-    if(trans) n_col_e = gen_mpi(gif_img_b, NULL,    gif_img_e, cnt, gif_pal_e);
-    if(trans) n_col_f = gen_mpi(gif_img_b,gif_img_a,gif_img_f, cnt, gif_pal_f);
+    n_col_d = gen_mpi(job->img_a, NULL, job->img_d, cnt, job->pal_d);
+    if (trans)
+    {
+        n_col_e = gen_mpi(job->img_b, NULL,       job->img_e, cnt, job->pal_e);
+        n_col_f = gen_mpi(job->img_b, job->img_a, job->img_f, cnt, job->pal_f);
+    }
 
     for (lct_sz_d = 1; (2 << lct_sz_d) < n_col_d; lct_sz_d++);
     for (lct_sz_e = 1; (2 << lct_sz_e) < n_col_e; lct_sz_e++);
@@ -482,129 +556,74 @@ int gif_wr_frame_m
 
     if (trans)
     {
-        int i;
         for (i = 0; i < n_col_d; i++)
-            assert(gif_pal_d[i] == gif_pal_f[i]);
-/*printf("n_col_d=%d, n_col_f=%d gif_pal_f[n_col_f-1]=%d gif->trans=%d\n", n_col_d, n_col_f, gif_pal_f[n_col_f-1], gif->trans);*/
+            assert(job->pal_d[i] == job->pal_f[i]);
         assert(n_col_d < n_col_f);
-        assert(gif_pal_f[n_col_f - 1] == gif->trans);
+        assert(job->pal_f[n_col_f - 1] == gif->trans);
     }
 
-
     /* -------------------------------------------------------------------- */
     /*   5. Compress the image multiple ways, and take the best...          */
     /*                                                                      */
-    /*  We reuse gif_img_tr as a compression buffer here, since we don't    */
-    /*  need that image any longer, but we do need a temp buffer for LZW.   */
-    /* -------------------------------------------------------------------- */
-    enc_sz_a  = lzw_encode(gif_img_a, gif_img_tr, cnt, gif_img_sz*2);
-    enc_sz_b  = -1;
-    enc_sz_c  = -1;
-    enc_sz_d  = lzw_encode(gif_img_d, gif_img_tr, cnt, gif_img_sz*2);
-    enc_sz_e  = -1;
-    enc_sz_f  = -1;
+    /*  Trials run in tie-break order:  a, b, d, e, c, f.  When comparing   */
+    /*  new palette to orig palette, include cost of sending local palette. */
+    /* -------------------------------------------------------------------- */
+    job->best = -1;
+
+    len = lzw_encode(job->img_a, gif_trial(job), cnt, 2 * job->sz);
+    gif_keep_best(job, 0, len, 0, &best_sz, &best_len);
+
     if (trans)
     {
-        enc_sz_b = lzw_encode(gif_img_b, gif_img_tr, cnt, gif_img_sz*2);
-        enc_sz_e = lzw_encode(gif_img_e, gif_img_tr, cnt, gif_img_sz*2);
-#if 1
-        enc_sz_c = lzw_encode2(gif_img_b,  gif_img_a,
-                               gif_img_tr, cnt, gif_img_sz);
-        enc_sz_f = lzw_encode2(gif_img_f,  gif_img_d,
-                               gif_img_tr, cnt, gif_img_sz);
-#endif
+        len = lzw_encode(job->img_b, gif_trial(job), cnt, 2 * job->sz);
+        gif_keep_best(job, 1, len, 0, &best_sz, &best_len);
     }
 
-    if (enc_sz_d > 0) enc_sz_d += 3 << (lct_sz_d + 1);
-    if (enc_sz_e > 0) enc_sz_e += 3 << (lct_sz_e + 1);
-    if (enc_sz_f > 0) enc_sz_f += 3 << (lct_sz_f + 1);
-
-    if (enc_sz_a < 0) enc_sz_a = INT_MAX;
-    if (enc_sz_b < 0) enc_sz_b = INT_MAX;
-    if (enc_sz_c < 0) enc_sz_c = INT_MAX;
-    if (enc_sz_d < 0) enc_sz_d = INT_MAX;
-    if (enc_sz_e < 0) enc_sz_e = INT_MAX;
-    if (enc_sz_f < 0) enc_sz_f = INT_MAX;
-
-    /* Initially assume A's the best. */
-    best_img1   = gif_img_a;
-    best_img2   = NULL;
-    best_lct    = NULL;
-    best_lct_sz = 0;
-    best_sz     = enc_sz_a;
-    trans_idx   = 0xFF;
-    do_trans    = 0;
-    best        = 'a';
-
-#if 1
-    if (enc_sz_b < best_sz)
-    {
-        best_img1   = gif_img_b;
-        best_img2   = NULL;
-        best_lct    = NULL;
-        best_lct_sz = 0;
-        best_sz     = enc_sz_b;
-        trans_idx   = gif->trans;
-        do_trans    = 1;
-        best        = 'b';
-    }
+    len = lzw_encode(job->img_d, gif_trial(job), cnt, 2 * job->sz);
+    gif_keep_best(job, 3, len, 3 << (lct_sz_d + 1), &best_sz, &best_len);
 
-    if (enc_sz_d < best_sz)
+    if (trans)
     {
-        best_img1   = gif_img_d;
-        best_img2   = NULL;
-        best_lct    = gif_pal_d;
-        best_lct_sz = lct_sz_d;
-        best_sz     = enc_sz_d;
-        trans_idx   = 0xFF;
-        do_trans    = 0;
-        best        = 'd';
-    }
+        len = lzw_encode(job->img_e, gif_trial(job), cnt, 2 * job->sz);
+        gif_keep_best(job, 4, len, 3 << (lct_sz_e + 1), &best_sz, &best_len);
 
-    if (enc_sz_e < best_sz)
-    {
-        best_img1   = gif_img_e;
-        best_img2   = NULL;
-        best_lct    = gif_pal_e;
-        best_lct_sz = lct_sz_e;
-        best_sz     = enc_sz_e;
-        trans_idx   = n_col_e - 1;
-        do_trans    = 1;
-        best        = 'e';
-    }
+        len = lzw_encode2(job->img_b, job->img_a, gif_trial(job), cnt,
+                          job->sz);
+        gif_keep_best(job, 2, len, 0, &best_sz, &best_len);
 
-    if (enc_sz_c < best_sz)
-    {
-        best_img1   = gif_img_b;
-        best_img2   = gif_img_a;
-        best_lct    = NULL;
-        best_lct_sz = 0;
-        best_sz     = enc_sz_c;
-        trans_idx   = gif->trans;
-        do_trans    = 1;
-        best        = 'c';
+        len = lzw_encode2(job->img_f, job->img_d, gif_trial(job), cnt,
+                          job->sz);
+        gif_keep_best(job, 5, len, 3 << (lct_sz_f + 1), &best_sz, &best_len);
     }
 
-    if (enc_sz_f < best_sz)
+    if (job->best < 0)
     {
-        best_img1   = gif_img_f;
-        best_img2   = gif_img_d;
-        best_lct    = gif_pal_f;
-        best_lct_sz = lct_sz_f;
-        best_sz     = enc_sz_f;
-        trans_idx   = n_col_f - 1;
-        do_trans    = 1;
-        best        = 'f';
+        fprintf(stderr, "gif_wr_frame_m: Image overflowed compression "
+                        "buffer.\n");
+        job->out_len = -1;
+        return;
     }
 
-    if (best_sz < 0 || best_sz == INT_MAX)
+    switch (job->best)
     {
-        fprintf(stderr, "gif_wr_frame_m: Image overflowed compression "
-                        "buffer.\n");
-        return -1;
+        case 0: /* a */                                             break;
+        case 1: /* b */ trans_idx = gif->trans;     do_trans = 1;   break;
+        case 2: /* c */ trans_idx = gif->trans;     do_trans = 1;   break;
+        case 3: /* d */ best_lct  = job->pal_d;     best_lct_sz = lct_sz_d;
+                                                                    break;
+        case 4: /* e */ best_lct  = job->pal_e;     best_lct_sz = lct_sz_e;
+                        trans_idx = n_col_e - 1;    do_trans = 1;   break;
+        case 5: /* f */ best_lct  = job->pal_f;     best_lct_sz = lct_sz_f;
+                        trans_idx = n_col_f - 1;    do_trans = 1;   break;
     }
-#endif
-    gif_best_stat[best - 'a']++;
+
+    /* -------------------------------------------------------------------- */
+    /*  The headers go in the headroom just ahead of the winning image.     */
+    /* -------------------------------------------------------------------- */
+    hdr_len = 8 + 10 + (best_lct_sz ? 3 * (2 << best_lct_sz) : 0);
+    enc_ptr = job->lzw[0] + GIF_HDR_ROOM - hdr_len;
+    job->out     = enc_ptr;
+    job->out_len = hdr_len + best_len;
 
     /* -------------------------------------------------------------------- */
     /*  Output a Graphic Control Ext.                                       */
@@ -613,35 +632,31 @@ int gif_wr_frame_m
     *enc_ptr++ = 0xF9;                  /* Graphic control extension        */
     *enc_ptr++ = 0x04;                  /* Length of block:  Fixed at 4.    */
     *enc_ptr++ = 0x04 | do_trans;       /* Disposal 01, No input, Trans     */
-    *enc_ptr++ = (delay >> 0) & 0xFF;   /* delay in 100ths of a second LSB  */
-    *enc_ptr++ = (delay >> 8) & 0xFF;   /* delay in 100ths of a second MSB  */
+    *enc_ptr++ = (job->delay >> 0) & 0xFF;  /* delay in 100ths of sec LSB   */
+    *enc_ptr++ = (job->delay >> 8) & 0xFF;  /* delay in 100ths of sec MSB   */
     *enc_ptr++ = trans_idx;             /* Transparency index, if any.      */
     *enc_ptr++ = 0x00;                  /* GCE block terminator.            */
 
     /* -------------------------------------------------------------------- */
     /*  Output an Image Descriptor.                                         */
     /* -------------------------------------------------------------------- */
-    *enc_ptr++ = 0x2C;                  /* Image Separator                  */
-    *enc_ptr++ = (min_x >> 0) & 0xFF;   /* Left edge, LSB                   */
-    *enc_ptr++ = (min_x >> 8) & 0xFF;   /* Left edge, MSB                   */
-    *enc_ptr++ = (min_y >> 0) & 0xFF;   /* Top edge, LSB                    */
-    *enc_ptr++ = (min_y >> 8) & 0xFF;   /* Top edge, MSB                    */
-    *enc_ptr++ = (width >> 0) & 0xFF;   /* Image width, LSB                 */
-    *enc_ptr++ = (width >> 8) & 0xFF;   /* Image width, MSB                 */
-    *enc_ptr++ = (height >> 0) & 0xFF;  /* Image height, LSB                */
-    *enc_ptr++ = (height >> 8) & 0xFF;  /* Image height, MSB                */
+    *enc_ptr++ = 0x2C;                          /* Image Separator          */
+    *enc_ptr++ = (job->min_x  >> 0) & 0xFF;     /* Left edge, LSB           */
+    *enc_ptr++ = (job->min_x  >> 8) & 0xFF;     /* Left edge, MSB           */
+    *enc_ptr++ = (job->min_y  >> 0) & 0xFF;     /* Top edge, LSB            */
+    *enc_ptr++ = (job->min_y  >> 8) & 0xFF;     /* Top edge, MSB            */
+    *enc_ptr++ = (job->width  >> 0) & 0xFF;     /* Image width, LSB         */
+    *enc_ptr++ = (job->width  >> 8) & 0xFF;     /* Image width, MSB         */
+    *enc_ptr++ = (job->height >> 0) & 0xFF;     /* Image height, LSB        */
+    *enc_ptr++ = (job->height >> 8) & 0xFF;     /* Image height, MSB        */
     *enc_ptr++ = best_lct_sz == 0 ? 0   /* no local color table?            */
                : best_lct_sz | 0x80;    /* or yes local color table?        */
 
-/*printf("[%3d,%3d] [%3d,%3d] [%3d,%3d] delay=%-3d trans=%-3d%c lct=%d\n", min_x, min_y, width, height, min_x + width, min_y + height, delay, trans_idx, do_trans ? '*' : ' ', best_lct_sz);*/
-
     /* -------------------------------------------------------------------- */
     /*  If we're sending a local color table, put it here.                  */
     /* -------------------------------------------------------------------- */
     if (best_lct_sz)
     {
-        int i;
-
         for (i = 0; i < (2 << best_lct_sz); i++)
         {
             if (best_lct[i] < gif->n_cols)
@@ -658,45 +673,265 @@ int gif_wr_frame_m
         }
     }
 
-    /* -------------------------------------------------------------------- */
-    /*  Now, re-encode the winning image.                                   */
-    /* -------------------------------------------------------------------- */
-    if (best_img2)
+    assert(enc_ptr == job->lzw[0] + GIF_HDR_ROOM);
+}
+
+/* ======================================================================== */
+/*  GIF_JOB_WRITE -- Write a finished frame out to the GIF.                 */
+/* ======================================================================== */
+LOCAL int gif_job_write(gif_t *gif, const gif_job_t *job)
+{
+    size_t wrote;
+
+    if (job->out_len < 0)
+        return -1;
+
+    gif_best_stat[job->best]++;
+
+    wrote = fwrite(job->out, 1, job->out_len, gif->f);
+    if (wrote < (unsigned)job->out_len)
     {
-        lzw_len = lzw_encode2(best_img1, best_img2, enc_ptr, cnt,
-                              gif_enc_buf_sz - (enc_ptr - gif_enc_buf) - 1);
+        fprintf(stderr, "gif_wr_frame_m: Short write? %ld vs %ld\n",
+                (long)wrote, (long)job->out_len);
+        return -1;
+    }
 
-    } else
+    return wrote;
+}
+
+/* ======================================================================== */
+/*  GIF_WORKER -- Worker thread.  Encodes submitted frames in order until   */
+/*                told to quit and the queue is empty.                      */
+/* ======================================================================== */
+LOCAL int gif_worker(void *opaque)
+{
+    gif_pipe_t *const pipe = (gif_pipe_t *)opaque;
+    gif_job_t *job;
+
+    plat_mutex_lock(pipe->lock);
+    for (;;)
     {
-        lzw_len = lzw_encode(best_img1, enc_ptr, cnt,
-                             gif_enc_buf_sz - (enc_ptr - gif_enc_buf) - 1);
+        while (!pipe->quit && pipe->enc_seq == pipe->sub_seq)
+            plat_cond_wait(pipe->work, pipe->lock);
+
+        if (pipe->enc_seq == pipe->sub_seq)
+            break;
+
+        job = &pipe->job[pipe->enc_seq++ % pipe->n_job];
+        plat_mutex_unlock(pipe->lock);
+
+        gif_frame_enc(pipe->gif, job);
+
+        plat_mutex_lock(pipe->lock);
+        job->done = 1;
+        plat_cond_broadcast(pipe->done);
     }
-    if (lzw_len < 0)
+    plat_mutex_unlock(pipe->lock);
+
+    return 0;
+}
+
+/* ======================================================================== */
+/*  GIF_PIPE_WRITE -- Write finished frames, in order, up to frame 'upto'.  */
+/*                    If 'wait' is zero, stop at the first unfinished one.  */
+/* ======================================================================== */
+LOCAL int gif_pipe_write(gif_t *gif, unsigned upto, int wait)
+{
+    gif_pipe_t *const pipe = gif->pipe;
+
+    while (pipe->wr_seq != upto)
     {
-        fprintf(stderr, "gif_wr_frame_m: Final encode failed?\n");
-        return -1;
+        gif_job_t *const job = &pipe->job[pipe->wr_seq % pipe->n_job];
+
+        plat_mutex_lock(pipe->lock);
+        while (wait && !job->done)
+            plat_cond_wait(pipe->done, pipe->lock);
+        if (!job->done)
+        {
+            plat_mutex_unlock(pipe->lock);
+            break;
+        }
+        job->done = 0;
+        plat_mutex_unlock(pipe->lock);
+
+        if (!pipe->err && gif_job_write(gif, job) < 0)
+            pipe->err = 1;
+
+        pipe->wr_seq++;
     }
 
-    enc_ptr += lzw_len;
-    assert(enc_ptr < gif_enc_buf + gif_enc_buf_sz);
+    return pipe->err ? -1 : 0;
+}
+
+/* ======================================================================== */
+/*  GIF_PIPE_DTOR -- Write out everything in flight, stop the workers, and  */
+/*                   free the pipeline.                                     */
+/* ======================================================================== */
+LOCAL int gif_pipe_dtor(gif_t *gif)
+{
+    gif_pipe_t *const pipe = gif->pipe;
+    int i, ret;
+
+    ret = gif_pipe_write(gif, pipe->sub_seq, 1);
+
+    plat_mutex_lock(pipe->lock);
+    pipe->quit = 1;
+    plat_cond_broadcast(pipe->work);
+    plat_mutex_unlock(pipe->lock);
+
+    for (i = 0; i < pipe->threads; i++)
+        plat_thread_join(pipe->thread[i]);
+
+    for (i = 0; pipe->job && i < pipe->n_job; i++)
+        CONDFREE(pipe->job[i].mem);
+
+    plat_cond_destroy(pipe->work);
+    plat_cond_destroy(pipe->done);
+    plat_mutex_destroy(pipe->lock);
+    CONDFREE(pipe->thread);
+    CONDFREE(pipe->job);
+    free(pipe);
+    gif->pipe = NULL;
+
+    return ret;
+}
+
+/* ======================================================================== */
+/*  GIF_SET_THREADS -- Compress a multi-frame GIF's frames on worker        */
+/*                     threads.  Returns the number of threads started.     */
+/*                     Zero means frames get compressed inline, as before.  */
+/* ======================================================================== */
+int gif_set_threads(gif_t *gif, int threads)
+{
+    gif_pipe_t *pipe;
+    int i;
+
+    if (threads <= 0 || gif->pipe || !gif->vid)
+        return 0;
+
+    if (!(pipe = CALLOC(gif_pipe_t, 1)))
+        return 0;
+
+    gif->pipe    = pipe;
+    pipe->gif    = gif;
+    pipe->n_job  = 2 * threads;
+    pipe->lock   = plat_mutex_create();
+    pipe->work   = plat_cond_create();
+    pipe->done   = plat_cond_create();
+    pipe->job    = CALLOC(gif_job_t,       pipe->n_job);
+    pipe->thread = CALLOC(plat_thread_t *, threads);
+
+    if (!pipe->lock || !pipe->work || !pipe->done ||
+        !pipe->job  || !pipe->thread)
+        goto fail;
+
+    for (i = 0; i < pipe->n_job; i++)
+        if (gif_job_alloc(&pipe->job[i], gif->x_dim * gif->y_dim) < 0)
+            goto fail;
+
+    for (i = 0; i < threads; i++)
+    {
+        pipe->thread[i] = plat_thread_create(gif_worker, "gif_enc", pipe);
+        if (!pipe->thread[i])
+            break;
+        pipe->threads++;
+    }
+
+    if (pipe->threads == 0)
+        goto fail;
+
+    return pipe->threads;
+
+fail:
+    gif_pipe_dtor(gif);
+    return 0;
+}
+
+/* ======================================================================== */
+/*  GIF_WR_FRAME_M -- Writes next frame to a multi-frame GIF.               */
+/*                    Attempts to optimize image.                           */
+/*                                                                          */
+/*  Optimize image:                                                         */
+/*                                                                          */
+/*   1. Generate "transparency" image with trans pixels wherever this       */
+/*      image is the same as the previous one.                              */
+/*                                                                          */
+/*   2. Compute tighter bounding box on image--that is, smallest box        */
+/*      that contains all the non-trans pixels.                             */
+/*                                                                          */
+/*   3. Crop the incoming image based on the tighter bounding box.          */
+/*                                                                          */
+/*   4. Generate "minimal palette" images that renumber all the             */
+/*      pixels into the smallest possible numbering space.                  */
+/*                                                                          */
+/*   5. Compress the image multiple ways, and take the best:                */
+/*                                                                          */
+/*       a. Cropped image, orig palette, no trans pixels                    */
+/*       b. Cropped image, orig palette, trans pixels                       */
+/*       c. Cropped image, orig palette, "wildcard" trans/no-trans          */
+/*       d. Cropped image, new palette, no trans pixels                     */
+/*       e. Cropped image, new palette, trans pixels                        */
+/*       f. Cropped image, new palette, "wildcard" trans/no-trans           */
+/*                                                                          */
+/*      When comparing new palette to orig palette, include cost            */
+/*      of sending local palette.  If the global palette has too            */
+/*      many colors, we may not be able to try b or c.  If the local        */
+/*      palette has too many colors, we may not be able to try e or         */
+/*      f.                                                                  */
+/*                                                                          */
+/*  With worker threads, steps 1 - 3 happen here and the rest happens on    */
+/*  a worker.  The frame gets written once it and all frames ahead of it    */
+/*  are done.                                                               */
+/* ======================================================================== */
+int gif_wr_frame_m
+(
+    gif_t         *gif,
+    const uint8_t *vid,
+    int            delay,
+    int            mode
+)
+{
+    gif_pipe_t *const pipe = gif->pipe;
+    gif_job_t *job;
 
     /* -------------------------------------------------------------------- */
-    /*  Write the compressed image out.                                     */
+    /*  No workers:  Do it all right here.                                  */
     /* -------------------------------------------------------------------- */
-    wrote = fwrite(gif_enc_buf, 1, enc_ptr - gif_enc_buf, gif->f);
-    if (wrote < (unsigned)(enc_ptr - gif_enc_buf))
+    if (!pipe)
     {
-        fprintf(stderr, "gif_wr_frame_m: Short write? %ld vs %ld\n",
-                (long)wrote, (long)(enc_ptr - gif_enc_buf));
-        return -1;
+        if (gif_job_alloc(&gif_job, gif->x_dim * gif->y_dim) < 0)
+        {
+            fprintf(stderr, "gif_wr_frame_m: out of memory\n");
+            return -1;
+        }
+
+        if (!gif_frame_prep(gif, &gif_job, vid, delay, mode))
+            return 0;
+
+        gif_frame_enc(gif, &gif_job);
+        return gif_job_write(gif, &gif_job);
     }
 
     /* -------------------------------------------------------------------- */
-    /*  Make the current image the new previous image.                      */
+    /*  If the ring's full, wait for the oldest frame and write it out.     */
     /* -------------------------------------------------------------------- */
-    memcpy(gif->vid, vid, gif->x_dim * gif->y_dim);
+    if (pipe->sub_seq - pipe->wr_seq == (unsigned)pipe->n_job)
+        gif_pipe_write(gif, pipe->wr_seq + 1, 1);
 
-    return wrote;
+    job = &pipe->job[pipe->sub_seq % pipe->n_job];
+
+    if (!gif_frame_prep(gif, job, vid, delay, mode))
+        return pipe->err ? -1 : 0;
+
+    plat_mutex_lock(pipe->lock);
+    pipe->sub_seq++;
+    plat_cond_signal(pipe->work);
+    plat_mutex_unlock(pipe->lock);
+
+    /* -------------------------------------------------------------------- */
+    /*  Write out whatever's finished, without waiting on the rest.         */
+    /* -------------------------------------------------------------------- */
+    return gif_pipe_write(gif, pipe->sub_seq, 0) < 0 ? -1 : 1;
 }
 
 /* ======================================================================== */
@@ -704,11 +939,11 @@ int gif_wr_frame_m
 /* ======================================================================== */
 LOCAL int gen_mpi
 (
-    uint8_t *src,
-    uint8_t *xtra,
-    uint8_t *dst,
-    int      cnt,
-    uint8_t *pal_map
+    const uint8_t *src,
+    const uint8_t *xtra,
+    uint8_t       *dst,
+    int            cnt,
+    uint8_t       *pal_map
 )
 {
     int hist1[256];
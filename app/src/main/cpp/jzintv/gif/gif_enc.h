@@ -8,17 +8,21 @@
 /*  This GIF encoder doesn't trust that the decoder honors the aspect       */
 /*  ratio stored in the GIF.  We just set it to 0.                          */
 /*                                                                          */
-/*  None of this code's thread-safe/reentrant.  BFD.                        */
+/*  Only one GIF may be in progress at a time.  A multi-frame GIF may       */
+/*  compress its frames on worker threads, though.  See gif_set_threads.    */
 /* ======================================================================== */
 #ifndef GIF_ENC_H_
 #define GIF_ENC_H_
 
+struct gif_pipe_t;      /* forward decl */
+
 typedef struct gif_t
 {
     FILE    *f;
     int     x_dim, y_dim;
     int     trans, n_cols;
     uint8_t  *vid, *pal;
+    struct gif_pipe_t *pipe;    /* Worker threads, if any.                  */
 } gif_t;
 
 extern int gif_best_stat[6];
@@ -68,9 +72,24 @@ int gif_write
 );
 
 
+/* ======================================================================== */
+/*  GIF_SET_THREADS -- Compress a multi-frame GIF's frames on worker        */
+/*                     threads.  Call after gif_start.  Returns the number  */
+/*                     of threads started, which is 0 if the platform has   */
+/*                     no threads.  Frames then get compressed inline.      */
+/* ======================================================================== */
+int gif_set_threads(gif_t *gif, int threads);
+
 /* ======================================================================== */
 /*  GIF_WR_FRAME_M -- Writes next frame to a multi-frame GIF.               */
-/*                    Attempts to optimize image.                           */
+/*                    Attempts to optimize image.  Returns the number of    */
+/*                    bytes written, 0 if the frame matched the previous    */
+/*                    one and was dropped, or -1 on error.                  */
+/*                                                                          */
+/*                    With worker threads, frames get written later, in     */
+/*                    order, and a queued frame returns 1.  An error may    */
+/*                    belong to an earlier frame.  gif_finish writes out    */
+/*                    anything still in flight.                             */
 /* ======================================================================== */
 int gif_wr_frame_m
 (
@@ -5,10 +5,20 @@
 /*  by the GIF standard.  This includes dividing the compressed output      */
 /*  into MAX_BLOCK_BYTES blocks.                                            */
 /*                                                                          */
-/*  My data structure is entirely uncreative.  I use an N-way tree to       */
-/*  represent the current code table.  It's dirt simple to implement, but   */
-/*  it's a memory pig.  Since the longest code is 12 bits, I use indices    */
-/*  instead of pointers, and use a static table of codes.                   */
+/*  The code table maps (prefix code, next symbol) to a code.  It comes in  */
+/*  two flavors, picked per call from the input's symbol range:             */
+/*                                                                          */
+/*   -- Small alphabets (the usual 16-32 color case) index a 2-D table      */
+/*      directly by code and symbol.  That's the fastest lookup there is.   */
+/*      Only the rows the input could reach get allocated and cleared, so   */
+/*      a tiny delta frame no longer pays to clear all 4096 rows.           */
+/*                                                                          */
+/*   -- Larger alphabets use an open-addressed hash table, which stays at   */
+/*      32K no matter the input.  A direct table for 256 symbols is 2MB,    */
+/*      all of which got cleared at every 4K-code reset.                    */
+/*                                                                          */
+/*  Each call allocates its own table, so these routines are reentrant and  */
+/*  may run on several threads at once.                                     */
 /* ======================================================================== */
 
 #include "config.h"
@@ -22,11 +32,123 @@
 
 #define MAX_BLOCK_BYTES (255)
 
+/* ======================================================================== */
+/*  LZW_DICT_T -- The code table.  In hash mode, each slot packs a 20-bit   */
+/*                key (prefix code << 8 | symbol) above the 12-bit code it  */
+/*                maps to.  Valid codes are never 0, so 0 marks an empty    */
+/*                entry in either mode.  At most 4096 codes are live        */
+/*                between clears, so 8192 slots keep the load factor at or  */
+/*                under 1/2.                                                */
+/* ======================================================================== */
+#define LZW_DIRECT_MAX  (32)        /* Largest alphabet for direct mode.    */
+#define LZW_HASH_BITS   (13)
+#define LZW_HASH_SIZE   (1 << LZW_HASH_BITS)
+#define LZW_HASH_MASK   (LZW_HASH_SIZE - 1)
+
+typedef struct lzw_dict_t
+{
+    int       stride;           /* Direct mode row length, or 0 if hashed.  */
+    int       rows;             /* Direct mode rows allocated.              */
+    uint16_t *row;              /* Direct mode table:  rows x stride.       */
+    uint32_t *slot;             /* Hash mode table:  LZW_HASH_SIZE entries. */
+} lzw_dict_t;
+
+/* ======================================================================== */
+/*  LZW_DICT_INIT -- Allocate a table for symbols 0 .. max_sym.  Codes      */
+/*                   past first_code + i_len can never become a prefix, so  */
+/*                   direct mode only needs that many rows.  The table is   */
+/*                   not cleared here; the encoder's first act is a clear.  */
+/* ======================================================================== */
+LOCAL int lzw_dict_init(lzw_dict_t *dict, int max_sym, int first_code,
+                        int i_len)
+{
+    memset(dict, 0, sizeof(lzw_dict_t));
+
+    if (max_sym < LZW_DIRECT_MAX)
+    {
+        dict->stride = max_sym + 1;
+        dict->rows   = i_len < 4096 - first_code ? first_code + i_len : 4096;
+        dict->row    = (uint16_t *)malloc(sizeof(uint16_t) *
+                                          dict->rows * dict->stride);
+        return dict->row ? 0 : -1;
+    }
+
+    dict->slot = (uint32_t *)malloc(sizeof(uint32_t) * LZW_HASH_SIZE);
+    return dict->slot ? 0 : -1;
+}
+
+/* ======================================================================== */
+/*  LZW_DICT_DTOR -- Release the table.                                     */
+/* ======================================================================== */
+LOCAL void lzw_dict_dtor(lzw_dict_t *dict)
+{
+    CONDFREE(dict->row);
+    CONDFREE(dict->slot);
+}
+
+/* ======================================================================== */
+/*  LZW_DICT_CLEAR -- Empty the table.  Only codes below next_code can      */
+/*                    have been used as prefixes since the last clear.      */
+/* ======================================================================== */
+LOCAL void lzw_dict_clear(lzw_dict_t *dict, int next_code)
+{
+    if (dict->row)
+    {
+        if (next_code > dict->rows)
+            next_code = dict->rows;
+        memset(dict->row, 0, sizeof(uint16_t) * next_code * dict->stride);
+    } else
+        memset(dict->slot, 0, sizeof(uint32_t) * LZW_HASH_SIZE);
+}
+
+/* ======================================================================== */
+/*  LZW_DICT_FIND -- Look up prefix code + symbol.  Returns 0 if absent,    */
+/*                   and sets *hole to where lzw_dict_add should put it.    */
+/* ======================================================================== */
+LOCAL INLINE int lzw_dict_find(const lzw_dict_t *dict, int code, int sym,
+                               uint32_t *hole)
+{
+    uint32_t key, h, ent;
+
+    if (dict->row)
+    {
+        h = code * dict->stride + sym;
+        *hole = h;
+        return dict->row[h];
+    }
+
+    key = ((uint32_t)code << 8) | (uint32_t)sym;
+    h   = (key * 0x9E3779B1u) >> (32 - LZW_HASH_BITS);  /* Fibonacci hash */
+
+    while ((ent = dict->slot[h]) != 0)
+    {
+        if ((ent >> 12) == key)
+            return ent & 0xFFF;
+        h = (h + 1) & LZW_HASH_MASK;
+    }
+
+    *hole = h;
+    return 0;
+}
+
+/* ======================================================================== */
+/*  LZW_DICT_ADD  -- Add a new code where the failed lookup said it goes.   */
+/* ======================================================================== */
+LOCAL INLINE void lzw_dict_add(lzw_dict_t *dict, uint32_t hole,
+                               int code, int sym, int new_code)
+{
+    if (dict->row)
+        dict->row[hole] = new_code;
+    else
+        dict->slot[hole] = ((uint32_t)code << 20) | ((uint32_t)sym << 12)
+                         | (uint32_t)new_code;
+}
+
 
 int lzw_encode(const uint8_t *i_buf, uint8_t *o_buf, int i_len, int max_o_len)
 {
-    static uint16_t *dict = NULL;
-    static int      dict_size = 0;
+    lzw_dict_t dict;
+    uint32_t hole = 0;
     const uint8_t *i_end = i_buf + i_len;
     const uint8_t *i_ptr;
     uint8_t *o_end = o_buf + max_o_len - 1;
@@ -34,7 +156,7 @@ int lzw_encode(const uint8_t *i_buf, uint8_t *o_buf, int i_len, int max_o_len)
     uint8_t *last_len_byte;
     int i;
     int code_size;
-    int max_sym = 0, dict_stride;
+    int max_sym = 0;
     uint32_t curr_word = 0;
     int curr_bits = 0;
     int code = 0, next_new_code, curr_size;
@@ -48,7 +170,6 @@ int lzw_encode(const uint8_t *i_buf, uint8_t *o_buf, int i_len, int max_o_len)
     for (i = 0; i < i_len; i++)
         if (i_buf[i] > max_sym)
             max_sym = i_buf[i];
-    dict_stride = max_sym + 1;
     Dprintf(("max_sym = %.2X\n", max_sym));
 
     /* -------------------------------------------------------------------- */
@@ -59,17 +180,13 @@ int lzw_encode(const uint8_t *i_buf, uint8_t *o_buf, int i_len, int max_o_len)
             break;
     Dprintf(("code_size = %.2X\n", code_size));
     /* -------------------------------------------------------------------- */
-    /*  Allocate the dictionary.  We store the tree in a 2-D array.  One    */
-    /*  dimension is the code number, and the other is the codes it chains  */
-    /*  to.  We size this to the maximum number of symbols in the input,    */
-    /*  so that it's not too big.                                           */
+    /*  Allocate the dictionary.  It gets cleared before its first use, as  */
+    /*  the first thing we send is a clear code.                            */
     /* -------------------------------------------------------------------- */
-    if (dict_size < dict_stride)
+    if (lzw_dict_init(&dict, max_sym, (1 << code_size) + 2, i_len) < 0)
     {
-        if (dict)
-            free(dict);
-        dict      = CALLOC(uint16_t, 4096 * dict_stride);
-        dict_size = dict_stride;
+        lzw_dict_dtor(&dict);
+        return -1;
     }
 
     /* -------------------------------------------------------------------- */
@@ -124,15 +241,15 @@ int lzw_encode(const uint8_t *i_buf, uint8_t *o_buf, int i_len, int max_o_len)
                 curr_bits  -= 8;
             }
 
+            lzw_dict_clear(&dict, next_new_code);
             curr_size = code_size + 1;
             next_new_code = (1 << code_size) + 2;
-            memset(dict, 0, 4096*sizeof(uint16_t)*dict_stride);
         } else if (i_ptr != i_end)
         {
             Dprintf(("new code: %.3X = %.3X + %.2X\n", next_new_code,
                      code, next_char));
 
-            dict[code*dict_stride + next_char] = next_new_code;
+            lzw_dict_add(&dict, hole, code, next_char, next_new_code);
             if (next_new_code == (1 << curr_size))
                 curr_size++;
             next_new_code++;
@@ -154,7 +271,7 @@ int lzw_encode(const uint8_t *i_buf, uint8_t *o_buf, int i_len, int max_o_len)
             while (next_code && i_ptr < i_end)
             {
                 next_char = *i_ptr++;
-                next_code = dict[code*dict_stride + next_char];
+                next_code = lzw_dict_find(&dict, code, next_char, &hole);
                 Dprintf(("--> code: %.3X + %.2X = %.3X\n", code,
                          next_char, next_code));
 
@@ -230,9 +347,11 @@ int lzw_encode(const uint8_t *i_buf, uint8_t *o_buf, int i_len, int max_o_len)
 
     Dprintf(("encoded %d bytes\n", o_ptr - o_buf));
 
+    lzw_dict_dtor(&dict);
     return o_ptr - o_buf;
 
 overflow:
+    lzw_dict_dtor(&dict);
     return -1;
 }
 
@@ -247,15 +366,15 @@ overflow:
 int lzw_encode2(const uint8_t *i_buf, const uint8_t *i_buf_alt,
                 uint8_t *o_buf, int i_len, int max_o_len)
 {
-    static uint16_t *dict = NULL;
-    static int      dict_size = 0;
+    lzw_dict_t dict;
+    uint32_t hole = 0, hole_alt = 0;
     int i_idx = 0;
     uint8_t *o_end = o_buf + max_o_len - 1;
     uint8_t *o_ptr;
     uint8_t *last_len_byte;
     int i;
     int code_size;
-    int max_sym = 0, dict_stride;
+    int max_sym = 0;
     uint32_t curr_word = 0;
     int curr_bits = 0;
     int code = 0, next_new_code, curr_size;
@@ -274,7 +393,6 @@ int lzw_encode2(const uint8_t *i_buf, const uint8_t *i_buf_alt,
             max_sym = i_buf_alt[i];
     }
 
-    dict_stride = max_sym + 1;
     Dprintf(("max_sym = %.2X\n", max_sym));
 
     /* -------------------------------------------------------------------- */
@@ -285,17 +403,13 @@ int lzw_encode2(const uint8_t *i_buf, const uint8_t *i_buf_alt,
             break;
     Dprintf(("code_size = %.2X\n", code_size));
     /* -------------------------------------------------------------------- */
-    /*  Allocate the dictionary.  We store the tree in a 2-D array.  One    */
-    /*  dimension is the code number, and the other is the codes it chains  */
-    /*  to.  We size this to the maximum number of symbols in the input,    */
-    /*  so that it's not too big.                                           */
+    /*  Allocate the dictionary.  It gets cleared before its first use, as  */
+    /*  the first thing we send is a clear code.                            */
     /* -------------------------------------------------------------------- */
-    if (dict_size < dict_stride)
+    if (lzw_dict_init(&dict, max_sym, (1 << code_size) + 2, i_len) < 0)
     {
-        if (dict)
-            free(dict);
-        dict      = CALLOC(uint16_t, 4096 * dict_stride);
-        dict_size = dict_stride;
+        lzw_dict_dtor(&dict);
+        return -1;
     }
 
     /* -------------------------------------------------------------------- */
@@ -348,15 +462,15 @@ int lzw_encode2(const uint8_t *i_buf, const uint8_t *i_buf_alt,
                 curr_bits  -= 8;
             }
 
+            lzw_dict_clear(&dict, next_new_code);
             curr_size = code_size + 1;
             next_new_code = (1 << code_size) + 2;
-            memset(dict, 0, 4096*sizeof(uint16_t)*dict_stride);
         } else if ( i_idx != i_len )
         {
             Dprintf(("new code: %.3X = %.3X + %.2X\n", next_new_code,
                      code, next_char));
 
-            dict[code*dict_stride + next_char] = next_new_code;
+            lzw_dict_add(&dict, hole, code, next_char, next_new_code);
             if (next_new_code == (1 << curr_size))
                 curr_size++;
             next_new_code++;
@@ -377,18 +491,18 @@ int lzw_encode2(const uint8_t *i_buf, const uint8_t *i_buf_alt,
             next_code = -1;
             while (next_code && i_idx < i_len)
             {
-                int tmp;
+                int tmp, alt = i_buf_alt[i_idx];
 
                 next_char = i_buf[i_idx];
-                if ((tmp = dict[code*dict_stride + i_buf[i_idx]]) != 0)
+                if ((tmp = lzw_dict_find(&dict, code, next_char, &hole)) != 0)
                 {
                     next_code = tmp;
                     Dprintf(("--> code: %.3X + %.2X(a) = %.3X\n", code,
                              next_char, next_code));
                 } else
-                if ((tmp = dict[code*dict_stride + i_buf_alt[i_idx]]) != 0)
+                if ((tmp = lzw_dict_find(&dict, code, alt, &hole_alt)) != 0)
                 {
-                    next_char = i_buf_alt[i_idx];
+                    next_char = alt;
                     next_code = tmp;
                     Dprintf(("--> code: %.3X + %.2X(b) = %.3X\n", code,
                              next_char, next_code));
@@ -471,9 +585,11 @@ int lzw_encode2(const uint8_t *i_buf, const uint8_t *i_buf_alt,
 
     Dprintf(("encoded %d bytes\n", o_ptr - o_buf));
 
+    lzw_dict_dtor(&dict);
     return o_ptr - o_buf;
 
 overflow:
+    lzw_dict_dtor(&dict);
     return -1;
 }
 
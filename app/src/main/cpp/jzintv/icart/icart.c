@@ -200,6 +200,42 @@ LOCAL void icart_dtor(periph_t *const p)
     }
 }
 
+/* ======================================================================== */
+/*  ICART_SER_INIT   -- Register the bankswitch table and each run of       */
+/*                      writable pages with the serializer.                 */
+/* ======================================================================== */
+LOCAL void icart_ser_init(periph_t *const p)
+{
+#ifdef NO_SERIALIZER
+    UNUSED(p);
+#else
+    icart_t *const ic = PERIPH_AS(icart_t, p);
+    ser_hier_t *hier;
+    char name[16];
+    int lo = -1;
+
+    hier = ser_new_hierarchy(NULL, p->name);
+
+    ser_register(hier, "bs_tbl", ic->bs_tbl, ser_u32, 32, SER_MAND|SER_HEX);
+
+    for (int i = 0; i <= 256; i++)
+    {
+        const int wr = i < 256 && ((ic->rom.writable[i >> 5] >> (i & 31)) & 1);
+
+        if (wr && lo < 0)
+            lo = i;
+
+        if (!wr && lo >= 0)
+        {
+            snprintf(name, sizeof(name), "ram_%.4X", lo << 8);
+            ser_register(hier, name, &ic->rom.image[lo << 8], ser_u16,
+                         (i - lo) << 8, SER_MAND|SER_HEX);
+            lo = -1;
+        }
+    }
+#endif
+}
+
 /* ======================================================================== */
 /*  ICART_INIT       -- Initialize the Intellicart w/ a ROM image.          */
 /* ======================================================================== */
@@ -317,6 +353,7 @@ int icart_init
     ic->base.addr_mask = 0;
     ic->base.parent    = ic;
     ic->base.dtor      = icart_dtor;
+    ic->base.ser_init  = icart_ser_init;
 
     /* -------------------------------------------------------------------- */
     /*  If asked to randomize, also randomize the bankswitch table.         */
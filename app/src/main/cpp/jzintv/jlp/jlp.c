@@ -34,9 +34,9 @@
 
 #define JLP_CRC_POLY (0xAD52)
 
-static int jlp_accel_on_reset = 0;
-int jlp_accel_on = 0;
-int lto_isa_enabled = 0;
+static THREAD_LOCAL int jlp_accel_on_reset = 0;
+THREAD_LOCAL int jlp_accel_on = 0;
+THREAD_LOCAL int lto_isa_enabled = 0;
 
 /* ======================================================================== */
 /*  JLP_SG_VALIDATE_ARGS    -- Helper:  Make sure args are OK for fxn       */
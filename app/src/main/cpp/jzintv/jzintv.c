@@ -26,6 +26,11 @@
 #include "pads/pads_cgc.h"
 #include "pads/pads_intv2pc.h"
 #include "avi/avi.h"
+#include "strm/strm.h"
+#include "rewind/rewind.h"
+#include "event/event_log.h"
+#include "netplay/netplay.h"
+#include "misc/crc32.h"
 #include "gfx/gfx.h"
 #include "gfx/palette.h"
 #include "snd/snd.h"
@@ -40,14 +45,35 @@
 #include "jlp/jlp.h"
 #include "locutus/locutus_adapt.h"
 #include "cheat/cheat.h"
+#include "prof/prof.h"
 #include "cfg/mapping.h"
 #include "cfg/cfg.h"
+#include "launch.h"
 
-cfg_t intv;
+/* ------------------------------------------------------------------------ */
+/*  The machine this thread is running.  Each thread can run one of its     */
+/*  own; jzintv_run() allocates it and frees it again on the way out.       */
+/* ------------------------------------------------------------------------ */
+LOCAL THREAD_LOCAL cfg_t *intv = NULL;
 
 double elapsed(const bool);
-void save_state(int);
+void save_state(void);
 void load_dump(void);
+LOCAL void rewind_start(void);
+LOCAL void snap_resync(const bool retime);
+LOCAL uint32_t cpu_step(const uint32_t cap);
+LOCAL void run_ahead_start(void);
+LOCAL void run_ahead(void);
+LOCAL void run_ahead_stats(const bool final);
+LOCAL void run_ahead_stop(void);
+LOCAL void netplay_start(void);
+LOCAL void netplay_frame(void);
+LOCAL void netplay_stop(void);
+LOCAL uint32_t netplay_step(uint32_t step);
+#ifdef BENCHMARK_MEM_DIRTY
+LOCAL void mem_dirty_bench(void);
+LOCAL void mem_dirty_bench_reset(void);
+#endif
 static void fake_osd(uint8_t*, uint32_t);
 
 /*
@@ -57,7 +83,7 @@ static void fake_osd(uint8_t*, uint32_t);
  */
 static char * release(void)
 {
-    static char buf[30];
+    static THREAD_LOCAL char buf[30];
 
     snprintf(buf, 30, "%s", "jzintv-20200712\0");
 
@@ -72,8 +98,8 @@ static char * release(void)
  */
 static const char * cart_name(void)
 {
-    static char *name_buf = NULL;
-    static size_t name_buf_alloc = 0;
+    static THREAD_LOCAL char *name_buf = NULL;
+    static THREAD_LOCAL size_t name_buf_alloc = 0;
     const size_t max_header_name_len = 64;
     uint16_t title_addr, lo, hi, ch;
     int year = 0;
@@ -85,20 +111,20 @@ static const char * cart_name(void)
     if (name_buf)
         name_buf[0] = 0;
 
-    if ((base_name = intv.cart_name) != NULL)
+    if ((base_name = intv->cart_name) != NULL)
     {
         i = 0;
-        year = intv.cart_year;
+        year = intv->cart_year;
         goto got_name;
     }
 
-    if ((base_name = strrchr(intv.fn_game, '/')) == NULL &&
-        (base_name = strrchr(intv.fn_game, '\\')) == NULL)
-        base_name = intv.fn_game;
+    if ((base_name = strrchr(intv->fn_game, '/')) == NULL &&
+        (base_name = strrchr(intv->fn_game, '\\')) == NULL)
+        base_name = intv->fn_game;
     else
         base_name++;
 
-    periph_t *const intv_periph = AS_PERIPH(intv.intv);
+    periph_t *const intv_periph = AS_PERIPH(intv->intv);
 
     lo = periph_peek(intv_periph, intv_periph, 0x500A, ~0U);
     hi = periph_peek(intv_periph, intv_periph, 0x500B, ~0U);
@@ -189,14 +215,17 @@ got_name:
  */
 static void graceful_death(int x)
 {
-    if (intv.debugging && intv.debug.step_count)
+    if (!intv)                      /* Not a thread running an instance.    */
+        return;
+
+    if (intv->debugging && intv->debug.step_count)
     {
         fprintf(stderr, "Requesting debugger halt.\n");
-        intv.debug.step_count = 0;
+        intv->debug.step_count = 0;
         return;
-    } else if (intv.do_exit < 2)
+    } else if (intv->do_exit < 2)
     {
-        if (intv.do_exit) fprintf(stderr, "\nOUCH!\n");
+        if (intv->do_exit) fprintf(stderr, "\nOUCH!\n");
         fprintf(stderr,
                 "\nRequesting exit:  Received signal %d.\n"
                 "(You may need to press enter if you're at a prompt.)\n", x);
@@ -205,7 +234,7 @@ static void graceful_death(int x)
         fprintf(stderr, "\nReceived 3 signals:  Aborting on signal %d.\n", x);
         exit(1);
     }
-    intv.do_exit++;
+    intv->do_exit++;
 }
 
 /*
@@ -216,8 +245,8 @@ static void graceful_death(int x)
  */
 double elapsed(const bool restart)
 {
-    static double start;
-    static int init = 0;
+    static THREAD_LOCAL double start;
+    static THREAD_LOCAL int init = 0;
     double now;
 
     if (!init || restart)
@@ -228,7 +257,7 @@ double elapsed(const bool restart)
 
     now = get_time();
 
-    return (now - start) * (intv.pal_mode ? 1000000. : 894886.25);
+    return (now - start) * (intv->pal_mode ? 1000000. : 894886.25);
 }
 
 /*
@@ -246,9 +275,9 @@ static void do_gui_mode(void)
         switch (cmd)
         {
             case '\r' : case '\n' : goto na;        /* ignore CR, LF */
-            case 'p'  : intv.do_pause = PAUSE_TOG;          break;
-            case 'q'  : intv.do_exit  = 1;                  break;
-            case 'r'  : intv.do_reset = 2;                  break;
+            case 'p'  : intv->do_pause = PAUSE_TOG;          break;
+            case 'q'  : intv->do_exit  = 1;                  break;
+            case 'r'  : intv->do_reset = 2;                  break;
             default   : putchar('!');  goto bad;
         }
 
@@ -265,19 +294,113 @@ na:     ;
  *  In the beginning, there was a main....
  * ============================================================================
  */
-extern int jlp_accel_on;
-extern int lto_isa_enabled;
+extern THREAD_LOCAL int jlp_accel_on;
+extern THREAD_LOCAL int lto_isa_enabled;
+
+LOCAL int    warm_plat = 0;         /* plat_init done, SDL left running.    */
+LOCAL THREAD_LOCAL
+      double launch_ms = 0;         /* Request to first frame, last launch. */
+LOCAL THREAD_LOCAL
+      jzintv_stats_t last_stats;    /* How this thread's last run went.     */
+
+LOCAL int jzintv_run(int argc, char *argv[],
+                     const jzintv_launch_t *const launch);
+LOCAL int jzintv_run_machine(int argc, char *argv[],
+                             const jzintv_launch_t *const launch);
+
 int jzintv_entry_point(int argc, char *argv[])
+{
+    return jzintv_run(argc, argv, NULL);
+}
+
+/* ======================================================================== */
+/*  JZINTV_LAUNCH        -- Run from a launch descriptor.  Warm state is    */
+/*                          dropped first if this launch doesn't want it.   */
+/* ======================================================================== */
+int jzintv_launch(const jzintv_launch_t *const launch)
+{
+    if (!launch->warm)
+        jzintv_warm_release();
+
+    snd_warm(launch->warm);
+
+    return jzintv_run(launch->argc, launch->argv, launch);
+}
+
+/* ======================================================================== */
+/*  JZINTV_IS_WARM       -- Non-zero while SDL and friends are kept up.     */
+/*  JZINTV_WARM_RELEASE  -- Let go of the audio device and SDL.            */
+/*  JZINTV_LAUNCH_MS     -- Request to first frame of the last launch.      */
+/*  JZINTV_LAST_STATS    -- Counters and hashes from this thread's last run.*/
+/* ======================================================================== */
+int jzintv_is_warm(void)
+{
+    return warm_plat;
+}
+
+void jzintv_warm_release(void)
+{
+    snd_warm(0);
+    warm_plat = 0;
+}
+
+double jzintv_launch_ms(void)
+{
+    return launch_ms;
+}
+
+void jzintv_last_stats(jzintv_stats_t *const stats)
+{
+    *stats = last_stats;
+}
+
+/* ======================================================================== */
+/*  JZINTV_RUN           -- Give this thread a machine, run it, free it.    */
+/* ======================================================================== */
+LOCAL int jzintv_run(int argc, char *argv[],
+                     const jzintv_launch_t *const launch)
+{
+    int rc;
+
+    if (intv)
+    {
+        fprintf(stderr, "jzintv:  This thread is already running jzIntv\n");
+        return -10;
+    }
+
+    if (!(intv = CALLOC(cfg_t, 1)))
+    {
+        fprintf(stderr, "jzintv:  Out of memory\n");
+        return -10;
+    }
+
+    /* A fault left over from an earlier machine on this thread isn't ours. */
+    debug_fault_detected = DEBUG_NO_FAULT;
+    debug_halt_reason    = NULL;
+    memset(&last_stats, 0, sizeof(last_stats));
+
+    rc = jzintv_run_machine(argc, argv, launch);
+
+    free(intv);
+    intv = NULL;
+    return rc;
+}
+
+LOCAL int jzintv_run_machine(int argc, char *argv[],
+                             const jzintv_launch_t *const launch)
 {
     jlp_accel_on=0;
     lto_isa_enabled=0;
-    int iter = 0, arg;
-    double cycles = 0, rate, irate, then, now, icyc;
+    int iter = 0, arg, init_rc, rc;
+    double cycles = 0, rate, irate, then, now, icyc, run_start = 0;
     double disp_time = get_time(), reset_time = disp_time, curr_time = disp_time;
+    double launch_time = 0, setup_time = 0;
+    const bool warm_start = warm_plat;
     double pause_until = disp_time;
     bool pause_key = false, was_paused = false;
     bool first = true;
     uint32_t s_cnt = 0;
+    uint32_t last_frame = 0, rw_stepped = ~0U;
     char title[128];
 
     /* -------------------------------------------------------------------- */
@@ -302,7 +425,7 @@ int jzintv_entry_point(int argc, char *argv[])
     /*  Sneak real quick and see if the user included -h, --help, -?, or    */
     /*  no flags whatsoever.  In those cases, print a message and leave.    */
     /* -------------------------------------------------------------------- */
-    if (argc < 2)
+    if (argc < 2 && !launch)
     {
         license();
     }
@@ -320,12 +443,24 @@ int jzintv_entry_point(int argc, char *argv[])
 #endif
 
     /* -------------------------------------------------------------------- */
-    /*  Platform-specific initialization.                                   */
+    /*  Time the launch from the user's request, if we know when that was.  */
     /* -------------------------------------------------------------------- */
-    if (plat_init())
+    launch_ms = 0;
+    if (launch)
+        launch_time = launch->request_time > 0 ? launch->request_time
+                                               : disp_time;
+
+    /* -------------------------------------------------------------------- */
+    /*  Platform-specific initialization.  Warm launches only need it once. */
+    /* -------------------------------------------------------------------- */
+    if (!warm_plat)
     {
-        fprintf(stderr, "Error initializing.\n");
-        return -10;;
+        if (plat_init())
+        {
+            fprintf(stderr, "Error initializing.\n");
+            return -10;;
+        }
+        warm_plat = launch && launch->warm;
     }
 
     /* -------------------------------------------------------------------- */
@@ -344,9 +479,24 @@ int jzintv_entry_point(int argc, char *argv[])
 	optind=0;
 #endif
 reload:
-    if (-10 == cfg_init(&intv, argc, argv)) {
+#ifdef BENCHMARK_MEM_DIRTY
+    mem_dirty_bench_reset();
+#endif
+    /* -------------------------------------------------------------------- */
+    /*  Building the machine isn't reentrant (getopt, the BIN+CFG parser),  */
+    /*  so instances on other threads take turns at it.                     */
+    /* -------------------------------------------------------------------- */
+    plat_global_lock();
+    init_rc = cfg_init_launch(intv, argc, argv, launch);
+    if (-10 == init_rc) {
+        /* Drop the half-built machine, or the next launch trips over it.  */
+        cfg_dtor(intv);
+        plat_global_unlock();
         return -10;
     }
+    plat_global_unlock();
+    if (launch_time > 0)
+        setup_time = get_time();
     init_disp_width(0);
     jzp_flush();
 
@@ -356,7 +506,7 @@ reload:
     /*  access, if UserPort is active.                                      */
     /* -------------------------------------------------------------------- */
 #ifdef WIN32
-    if (intv.i2pc0_port || intv.i2pc1_port)
+    if (intv->i2pc0_port || intv->i2pc1_port)
     {
         FILE *UserPortFP;
 
@@ -396,15 +546,58 @@ reload:
         /*
         fprintf(stderr, "t = \'%s\', len = %d\n", title, (int)strlen(title));
         */
-        gfx_set_title(&intv.gfx,title);
+        gfx_set_title(&intv->gfx,title);
     }
     #endif
 
+    /* -------------------------------------------------------------------- */
+    /*  The input log assumes time only runs forward.                       */
+    /* -------------------------------------------------------------------- */
+    if (event_log_mode(&intv->evlog) != EVLOG_OFF &&
+        (intv->rewind_ivl > 0 || intv->run_ahead > 0))
+    {
+        fprintf(stderr, "WARNING:  Rewind and run-ahead don't work while "
+                        "recording or replaying input.  Disabled.\n");
+        intv->rewind_ivl = 0;
+        intv->run_ahead  = 0;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Netplay owns time and the controllers, so it rules out all three.   */
+    /* -------------------------------------------------------------------- */
+    if (intv->event.netplay &&
+        (intv->rewind_ivl > 0 || intv->run_ahead > 0 ||
+         event_log_mode(&intv->evlog) != EVLOG_OFF))
+    {
+        fprintf(stderr, "WARNING:  Rewind, run-ahead and input logs don't "
+                        "work with netplay.  Netplay disabled.\n");
+        netplay_stop();
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Start the rewind history, if requested.                             */
+    /* -------------------------------------------------------------------- */
+    if (intv->rewind_ivl > 0)
+        rewind_start();
+
+    /* -------------------------------------------------------------------- */
+    /*  Likewise run-ahead.                                                 */
+    /* -------------------------------------------------------------------- */
+    if (intv->run_ahead > 0)
+        run_ahead_start();
+
+    /* -------------------------------------------------------------------- */
+    /*  Connect to the netplay peer, if requested.                          */
+    /* -------------------------------------------------------------------- */
+    if (intv->event.netplay)
+        netplay_start();
+
     /* -------------------------------------------------------------------- */
     /*  Run the simulator.                                                  */
     /* -------------------------------------------------------------------- */
     jzp_printf("Starting jzIntv...\n");
     jzp_flush();
+    run_start = get_time();
 
 restart:
 
@@ -415,11 +608,11 @@ restart:
     icyc   = 0;
     s_cnt  = 0;
     cycles = 0;
-    if (intv.rate_ctl > 0.0)
-        speed_resync(&(intv.speed));
+    if (intv->rate_ctl > 0.0)
+        speed_resync(&(intv->speed));
 
-    if (!intv.debugging)
-        intv.debug.step_count = -1;
+    if (!intv->debugging)
+        intv->debug.step_count = -1;
 
     pause_key   = false;
     was_paused  = false;
@@ -427,42 +620,63 @@ restart:
     disp_time   = curr_time;
     pause_until = curr_time;
 
-    if (first && intv.start_dly > 0)
-        pause_until += intv.start_dly / 1000.;
+    if (first && intv->start_dly > 0)
+        pause_until += intv->start_dly / 1000.;
 
     first = false;
 
-    while (intv.do_exit == 0 && intv.do_reload == 0)
+    while (intv->do_exit == 0 && intv->do_reload == 0)
     {
         uint32_t max_step;
-        uint32_t do_reset = intv.do_reset;
+        uint32_t do_reset;
+
+        /* A reset on one side only would desync netplay. */
+        if (intv->event.netplay)
+            intv->do_reset = 0;
+        do_reset = intv->do_reset;
 
-        if (intv.gui_mode)
+        if (intv->gui_mode)
             do_gui_mode();
 
-        if (intv.do_dump)
+        if (intv->do_dump)
         {
 			jzp_printf("\nDump requested.\n");
-            intv.do_dump = 0;
-			save_state(0);
+            intv->do_dump = 0;
+			save_state();
 		}
 
-        if (intv.do_load)
+        if (intv->do_load)
         {
 			jzp_printf("\nLoad requested.\n");
-            intv.do_load = 0;
-			load_dump();
+            intv->do_load = 0;
+            if (event_log_mode(&intv->evlog) == EVLOG_OFF &&
+                !intv->event.netplay)
+                load_dump();
+            else
+                jzp_printf("Not while recording or replaying input, or "
+                           "during netplay.\n");
 		}
 
+        /* ---------------------------------------------------------------- */
+        /*  While REWIND is held, step back once per displayed frame.       */
+        /* ---------------------------------------------------------------- */
+        if (intv->do_rewind && rw_stepped != intv->gfx.tot_frames &&
+            rewind_is_active(&intv->rewind))
+        {
+            rw_stepped = intv->gfx.tot_frames;
+            rewind_step(&intv->rewind);
+            snap_resync(true);
+        }
+
         if (do_reset)
         {
-            if (intv.do_reset == 2)
-                intv.do_reset = 0;
+            if (intv->do_reset == 2)
+                intv->do_reset = 0;
             max_step = 1000; /* arbitrary */
-            intv.gfx.scrshot |= GFX_RESET;
-            gfx_vid_enable(&(intv.gfx), 0);
+            intv->gfx.scrshot |= GFX_RESET;
+            gfx_vid_enable(&(intv->gfx), 0);
             if (s_cnt == 40)
-                gfx_set_bord(&(intv.gfx), 0);
+                gfx_set_bord(&(intv->gfx), 0);
         } else
         {
             if (s_cnt > 140)
@@ -471,78 +685,102 @@ restart:
             } else if (s_cnt)
             {
                 s_cnt = 0;
-                periph_reset(intv.intv);
+                periph_reset(intv->intv);
             }
-            /* This is incredibly hackish, and is an outgrowth of my
-             * decoupled tick architecture.  */
-            if (intv.cp1600.req_q.horizon > intv.cp1600.periph.now)
-                max_step = 
-                    (uint32_t)
-                        (intv.cp1600.req_q.horizon - intv.cp1600.periph.now);
-            else
-                max_step = 5;
-            if (max_step > 20000) max_step = 20000;
-            if (max_step < 5) max_step = 5;
+            max_step = cpu_step(20000);
         }
 
 #if 0
-jzp_printf("cpu.now = %-8d  stic.now = %-8d diff = %-8d step = %-8d\n", (int)intv.cp1600.periph.now, (int)intv.stic.stic_cr.now, (int)intv.cp1600.periph.now-(int)intv.stic.stic_cr.now, (int)max_step);
+jzp_printf("cpu.now = %-8d  stic.now = %-8d diff = %-8d step = %-8d\n", (int)intv->cp1600.periph.now, (int)intv->stic.stic_cr.now, (int)intv->cp1600.periph.now-(int)intv->stic.stic_cr.now, (int)max_step);
 #endif
-        if (intv.gfx.req_pause && intv.do_pause == PAUSE_NOP)
+        if (intv->gfx.req_pause && intv->do_pause == PAUSE_NOP)
         {
-            intv.do_pause = PAUSE_2SEC;
-            intv.gfx.req_pause = false;
+            intv->do_pause = PAUSE_2SEC;
+            intv->gfx.req_pause = false;
         }
 
-        if (intv.do_pause != PAUSE_NOP)
+        if (intv->do_pause != PAUSE_NOP)
         {
-            if (intv.do_pause == PAUSE_2SEC)
+            if (intv->do_pause == PAUSE_2SEC)
             {
                 pause_until = curr_time + 2.0;
             } else
             {
-                pause_key = intv.do_pause == PAUSE_TOG ? !pause_key
-                          : intv.do_pause == PAUSE_OFF ? false : true;
+                pause_key = intv->do_pause == PAUSE_TOG ? !pause_key
+                          : intv->do_pause == PAUSE_OFF ? false : true;
             }
 
-            intv.do_pause = PAUSE_NOP;
+            intv->do_pause = PAUSE_NOP;
         }
 
         bool paused = pause_key || pause_until > curr_time;
 
         if (was_paused && !paused)
-            speed_resync(&(intv.speed));
+            speed_resync(&(intv->speed));
 
         was_paused = paused;
 
-        if (intv.chg_evt_map)
+        if (intv->chg_evt_map)
         {
-            event_change_active_map(&intv.event,
-                                    (ev_map_change_req)intv.chg_evt_map);
-            pad_reset_inputs(&intv.pad0);
-            pad_reset_inputs(&intv.pad1);
-            intv.chg_evt_map = 0;
+            event_change_active_map(&intv->event,
+                                    (ev_map_change_req)intv->chg_evt_map);
+            pad_reset_inputs(&intv->pad0);
+            pad_reset_inputs(&intv->pad1);
+            intv->chg_evt_map = 0;
         }
 
         if (paused || do_reset)
         {
-            intv.gfx.dirty = 1;
-            gfx_refresh(&intv.gfx);
-            snd_play_silence(&(intv.snd));
-            intv.event.periph.tick(AS_PERIPH(&intv.event), 0);
+            intv->gfx.dirty = 1;
+            gfx_refresh(&intv->gfx);
+            snd_play_silence(&(intv->snd));
+            intv->event.periph.tick(AS_PERIPH(&intv->event), 0);
             plat_delay(1000/240);
         } else
         {
-            intv.gfx.scrshot &= ~GFX_RESET;
-            cycles += periph_tick(AS_PERIPH(intv.intv), max_step);
+            intv->gfx.scrshot &= ~GFX_RESET;
+            cycles += periph_tick(AS_PERIPH(intv->intv), max_step);
         }
 
-        if (!intv.debugging && intv.debug.step_count == 0)
-            intv.debug.step_count = -1;
+        /* ---------------------------------------------------------------- */
+        /*  Once per frame, feed the rewind history and run ahead.  Show    */
+        /*  the real frames while rewinding, though.                        */
+        /* ---------------------------------------------------------------- */
+        if (last_frame != intv->gfx.tot_frames)
+        {
+            if (intv->do_rewind)
+            {
+                intv->gfx.run_ahead = 0;
+            } else
+            {
+                rewind_frame(&intv->rewind);
+                run_ahead();
+            }
+            netplay_frame();
+            if (intv->max_frames && !intv->gfx.hash_left)
+                intv->do_exit = 1;
+#ifdef BENCHMARK_MEM_DIRTY
+            mem_dirty_bench();
+#endif
+            last_frame = intv->gfx.tot_frames;
+
+            if (launch_time > 0)
+            {
+                launch_ms = (get_time() - launch_time) * 1000.;
+                jzp_printf("jzintv:  First frame %.1f ms after the launch "
+                           "request (%.1f ms setting up, %s start)\n",
+                           launch_ms, (setup_time - launch_time) * 1000.,
+                           warm_start ? "warm" : "cold");
+                launch_time = 0;
+            }
+        }
+
+        if (!intv->debugging && intv->debug.step_count == 0)
+            intv->debug.step_count = -1;
 
         curr_time = get_time();
 
-        if (!intv.debugging && !do_reset && (curr_time > disp_time + 1.0))
+        if (!intv->debugging && !do_reset && (curr_time > disp_time + 1.0))
         {
             disp_time = curr_time;
             then  = now;
@@ -554,20 +792,40 @@ jzp_printf("cpu.now = %-8d  stic.now = %-8d diff = %-8d step = %-8d\n", (int)int
                 icyc  = cycles;
 
                 jzp_printf("Rate: [%6.2f%% %6.2f%%]  Drop Gfx:[%6.2f%% %6d] "
-                       "Snd:[%6.2f%% %2d %6.3f]\r",
+                       "Snd:[%6.2f%% %2d %6.3f]",
                         rate * 100., irate * 100.,
-                        100. * intv.gfx.tot_dropped_frames / intv.gfx.tot_frames,
-                        (int)intv.gfx.tot_dropped_frames,
-                        100. * intv.snd.mixbuf.tot_drop / intv.snd.tot_frame,
-                        (int)intv.snd.mixbuf.tot_drop,
-                        (double)intv.snd.tot_dirty / intv.snd.tot_frame);
+                        100. * intv->gfx.tot_dropped_frames
+                             / intv->gfx.tot_frames,
+                        (int)intv->gfx.tot_dropped_frames,
+                        100. * intv->snd.mixbuf.tot_drop / intv->snd.tot_frame,
+                        (int)intv->snd.mixbuf.tot_drop,
+                        (double)intv->snd.tot_dirty / intv->snd.tot_frame);
+
+                /* -------------------------------------------------------- */
+                /*  Audio latency p50/p95/p99 and jitter p99 in msec, plus  */
+                /*  the buffer configuration currently in effect.           */
+                /* -------------------------------------------------------- */
+                if (intv->audio_rate)
+                {
+                    snd_lat_stats_t lat;
+
+                    snd_get_lat_stats(&intv->snd, &lat);
+                    jzp_printf(" Lat:[%5.1f %5.1f %5.1f J%4.1f] "
+                               "Buf:[%dx%d%s %d]",
+                               lat.lat_p50, lat.lat_p95, lat.lat_p99,
+                               lat.jit_p99, lat.buf_size, lat.buf_cnt,
+                               lat.auto_tune ? "a" : "", (int)lat.underruns);
+                }
+                run_ahead_stats(false);
+                netplay_status(&intv->netplay);
+                jzp_printf("\r");
 
 #if 0
                 jzp_printf("speed: min=%-8d max=%-8d thresh=%-8.1f frame=%-8d\n",
-                        intv.speed.periph.min_tick,
-                        intv.speed.periph.max_tick,
-                        intv.speed.threshold * 1e6,
-                        intv.gfx.tot_frames);
+                        intv->speed.periph.min_tick,
+                        intv->speed.periph.max_tick,
+                        intv->speed.threshold * 1e6,
+                        intv->gfx.tot_frames);
 #endif
                 jzp_flush();
             }
@@ -582,44 +840,44 @@ jzp_printf("cpu.now = %-8d  stic.now = %-8d diff = %-8d step = %-8d\n", (int)int
 
         if (do_reset)
         {
-            intv.cp1600.r[7] = 0x1000;
-            gfx_vid_enable(&(intv.gfx), 0);
+            intv->cp1600.r[7] = 0x1000;
+            gfx_vid_enable(&(intv->gfx), 0);
             s_cnt++;
             debug_fault_detected = DEBUG_NO_FAULT;
         }
 
-        if (debug_fault_detected && !intv.debugging && plat_is_batch_mode())
-            intv.do_exit = -1;
+        if (debug_fault_detected && !intv->debugging && plat_is_batch_mode())
+            intv->do_exit = -1;
     }
 
     uint64_t seed = 0x2A3A4A5A;
 
     arg = 0;
-    gfx_set_bord  (&(intv.gfx), 0);
-    gfx_vid_enable(&(intv.gfx), 1);
-    intv.gfx.scrshot |= GFX_RESET;
+    gfx_set_bord  (&(intv->gfx), 0);
+    gfx_vid_enable(&(intv->gfx), 1);
+    intv->gfx.scrshot |= GFX_RESET;
     iter = 0;
 
-    while (intv.do_exit == 0 && intv.do_reload == 0)
+    while (intv->do_exit == 0 && intv->do_reload == 0)
     {
         int i, j;
         uint8_t p;
 
-        if (intv.gui_mode)
+        if (intv->gui_mode)
             do_gui_mode();
 
-        if (intv.do_reset) arg = 1;
-        if ((intv.do_reset == 0 && arg) || intv.do_reset == 2)
+        if (intv->do_reset) arg = 1;
+        if ((intv->do_reset == 0 && arg) || intv->do_reset == 2)
         {
-            intv.do_reset = 0;
+            intv->do_reset = 0;
 
-            p = intv.stic.raw[0x2C] & 15;
+            p = intv->stic.raw[0x2C] & 15;
             for (i = 0; i < 160 * 200; i++)
-                intv.stic.disp[i] = p;
+                intv->stic.disp[i] = p;
 
-            gfx_set_bord(&(intv.gfx), p);
-            intv.gfx.scrshot &= ~GFX_RESET;
-            periph_reset(intv.intv);
+            gfx_set_bord(&(intv->gfx), p);
+            intv->gfx.scrshot &= ~GFX_RESET;
+            periph_reset(intv->intv);
             goto restart;
         }
 
@@ -632,39 +890,69 @@ jzp_printf("cpu.now = %-8d  stic.now = %-8d diff = %-8d step = %-8d\n", (int)int
             p = (seed & 0xF) + 17 + fade;
             if (p > 31) p = 31;
 
-            intv.stic.disp[i] = p;
+            intv->stic.disp[i] = p;
         }
         if (iter < 100)
         {
-            snd_play_static(&intv.snd);
+            snd_play_static(&intv->snd);
             iter++;
         } else
         {
-            snd_play_silence(&(intv.snd));
-            fake_osd(intv.stic.disp, (uint32_t)seed);
+            snd_play_silence(&(intv->snd));
+            fake_osd(intv->stic.disp, (uint32_t)seed);
         }
 
-        intv.gfx.dirty = 1;
-        gfx_refresh(&intv.gfx);
-        intv.event.periph.tick(AS_PERIPH(&intv.event), 0);
+        intv->gfx.dirty = 1;
+        gfx_refresh(&intv->gfx);
+        intv->event.periph.tick(AS_PERIPH(&intv->event), 0);
         plat_delay(1000/60);
     }
 
-    if (intv.do_exit)
+    if (intv->do_exit)
         jzp_printf(
-            intv.do_exit > 0 ? "\nExited on user request.\n"
+            intv->do_exit > 0 ? "\nExited on user request.\n"
                              : "\nExited because game crashed.\n");
 
-    if (intv.do_reload)
+    if (intv->do_reload)
     {
-        intv.do_reload = 0;
+        intv->do_reload = 0;
         jzp_printf("\nAttempting reload.\n");
-        cfg_dtor(&intv);
+        run_ahead_stop();
+        netplay_stop();
+        plat_global_lock();
+        cfg_dtor(intv);
+        plat_global_unlock();
         goto reload;
     }
 
-    cfg_dtor(&intv);
-    return intv.do_exit > 0 ? 0 : 1;
+    run_ahead_stop();
+    netplay_stop();
+
+    /* -------------------------------------------------------------------- */
+    /*  Note how the run went, before cfg_dtor wipes the machine.           */
+    /* -------------------------------------------------------------------- */
+    rc = intv->do_exit > 0 ? 0 : 1;
+    if (netplay_finish(&intv->netplay))
+        rc = 1;
+    last_stats.cycles   = intv->cp1600.tot_cycle;
+    last_stats.instrs   = intv->cp1600.tot_instr;
+    last_stats.frames   = intv->max_frames
+                        ? intv->max_frames - intv->gfx.hash_left
+                        : intv->gfx.tot_frames;
+    last_stats.vid_hash = intv->gfx.hash;
+    last_stats.snd_hash = intv->snd.hash;
+    last_stats.fault    = debug_fault_detected;
+    last_stats.run_ms   = (get_time() - run_start) * 1000.;
+
+    if (intv->max_frames)
+        jzp_printf("Frame hash: %.8X  Audio hash: %.8X  (%u frames)\n",
+                   last_stats.vid_hash, last_stats.snd_hash,
+                   (unsigned)last_stats.frames);
+
+    plat_global_lock();
+    cfg_dtor(intv);
+    plat_global_unlock();
+    return rc;
 }
 
 
@@ -690,11 +978,11 @@ void dump_state(void)
     }
     else
     {
-        intv.debug.show_rd = 0;
-        intv.debug.show_wr = 0;
+        intv->debug.show_rd = 0;
+        intv->debug.show_wr = 0;
         for (addr = 0; addr <= 0xFFFF; addr++)
         {
-            data = periph_peek(AS_PERIPH(intv.intv), AS_PERIPH(intv.intv),
+            data = periph_peek(AS_PERIPH(intv->intv), AS_PERIPH(intv->intv),
                                addr, 0);
             fputc((data >> 8) & 0xFF, f);
             fputc((data     ) & 0xFF, f);
@@ -711,19 +999,19 @@ void dump_state(void)
     }
 
     fprintf(f, "CP-1600 State Dump\n");
-    fprintf(f, "Tot Cycles:   %" U64_FMT "\n", intv.cp1600.tot_cycle);
-    fprintf(f, "Tot Instrs:   %" U64_FMT "\n", intv.cp1600.tot_instr);
-    fprintf(f, "Tot Cache:    %" U64_FMT "\n", intv.cp1600.tot_cache);
-    fprintf(f, "Tot NonCache: %" U64_FMT "\n", intv.cp1600.tot_noncache);
+    fprintf(f, "Tot Cycles:   %" U64_FMT "\n", intv->cp1600.tot_cycle);
+    fprintf(f, "Tot Instrs:   %" U64_FMT "\n", intv->cp1600.tot_instr);
+    fprintf(f, "Tot Cache:    %" U64_FMT "\n", intv->cp1600.tot_cache);
+    fprintf(f, "Tot NonCache: %" U64_FMT "\n", intv->cp1600.tot_noncache);
     fprintf(f, "Registers:    %.4x %.4x %.4x %.4x %.4x %.4x %.4x %.4x\n",
-            intv.cp1600.r[0], intv.cp1600.r[1],
-            intv.cp1600.r[2], intv.cp1600.r[3],
-            intv.cp1600.r[4], intv.cp1600.r[5],
-            intv.cp1600.r[6], intv.cp1600.r[7]);
+            intv->cp1600.r[0], intv->cp1600.r[1],
+            intv->cp1600.r[2], intv->cp1600.r[3],
+            intv->cp1600.r[4], intv->cp1600.r[5],
+            intv->cp1600.r[6], intv->cp1600.r[7]);
     fprintf(f, "Flags:        S:%d C:%d O:%d Z:%d I:%d D:%d intr:%d irq:%d\n",
-            intv.cp1600.S, intv.cp1600.C, intv.cp1600.O, intv.cp1600.Z,
-            intv.cp1600.I, intv.cp1600.D,
-            intv.cp1600.intr, intv.cp1600.req_ack_state);
+            intv->cp1600.S, intv->cp1600.C, intv->cp1600.O, intv->cp1600.Z,
+            intv->cp1600.I, intv->cp1600.D,
+            intv->cp1600.intr, intv->cp1600.req_ack_state);
 
     fprintf(f, "Cacheability Map:\n");
 
@@ -734,7 +1022,7 @@ void dump_state(void)
         fprintf(f, "   %.4x-%.4x:", addr, addr+(32<<CP1600_DECODE_PAGE)-1);
         for (j = 0; j < 32; j++)
         {
-            fprintf(f, " %d", 1 & (intv.cp1600.cacheable[i] >> j));
+            fprintf(f, " %d", 1 & (intv->cp1600.cacheable[i] >> j));
         }
         fprintf(f, "\n");
     }
@@ -750,9 +1038,9 @@ void dump_state(void)
         for (j = 0; j < 64; j++)
         {
             fprintf(f, "%c",
-                    intv.cp1600.execute[addr + j] == fn_decode_1st ? '-' :
-                    intv.cp1600.execute[addr + j] == fn_decode     ? 'N' :
-                    intv.cp1600.execute[addr + j] == fn_invalid    ? '!' :
+                    intv->cp1600.execute[addr + j] == fn_decode_1st ? '-' :
+                    intv->cp1600.execute[addr + j] == fn_decode     ? 'N' :
+                    intv->cp1600.execute[addr + j] == fn_invalid    ? '!' :
                                                                      'C');
         }
         fprintf(f, "\n");
@@ -763,665 +1051,729 @@ void dump_state(void)
 
 /*
  * ============================================================================
- *  SAVE_STATE
+ *  SNAP_PLAN    -- Build the snapshot copy plan on first use.  Everything
+ *                  registers with the serializer during cfg_init, so by
+ *                  the time a save or load is requested the plan is final.
  * ============================================================================
  */
+#ifndef NO_SERIALIZER
+LOCAL ser_snap_t *snap_plan(void)
+{
+    if (!intv->snap && !(intv->snap = ser_snap_plan()))
+        fprintf(stderr, "Nothing is registered for save states.\n");
 
-void save_state(int altname)
+    return intv->snap;
+}
+#endif
+
+/*
+ * ============================================================================
+ *  SNAP_RESYNC  -- Rebuild everything derived from a restored snapshot:
+ *                  cached CPU decodes (bankswitching may differ), the
+ *                  display, and the notion of 'now' for everything that
+ *                  isn't part of the machine proper.  'retime' also
+ *                  restarts rate control, for when time jumped.
+ * ============================================================================
+ */
+LOCAL void snap_resync(const bool retime)
 {
-#if 1
-    UNUSED(altname);
-    jzp_printf("Loading and saving dumps currently disabled.\n");
+    cp1600_invalidate(&intv->cp1600, 0x0000, 0xFFFF);
+    periph_resync(intv->intv, intv->snap);
+    stic_resync(&(intv->stic));
+    gfx_resync(&(intv->gfx));
+    if (retime)
+        speed_resync(&(intv->speed));
+}
+
+/*
+ * ============================================================================
+ *  CPU_STEP     -- How far to tick the machine next:  up to the CPU's
+ *                  horizon, clamped to [5, cap].  The steps depend only on
+ *                  machine state, so the same state and cap always run the
+ *                  same way.
+ * ============================================================================
+ */
+LOCAL uint32_t cpu_step(const uint32_t cap)
+{
+    /* This is incredibly hackish, and is an outgrowth of my
+     * decoupled tick architecture.  */
+    const uint64_t now = intv->cp1600.periph.now;
+    uint32_t step = intv->cp1600.req_q.horizon > now
+                  ? (uint32_t)(intv->cp1600.req_q.horizon - now) : 5;
+
+    if (step > cap) step = cap;
+    if (step < 5)   step = 5;
+    return netplay_step(step);
+}
+
+/*
+ * ============================================================================
+ *  REWIND_START -- Start capturing rewind history.  --rewind=N captures
+ *                  every N frames; --rewind-mem caps the history in MB.
+ * ============================================================================
+ */
+LOCAL void rewind_start(void)
+{
+#ifdef NO_SERIALIZER
+    rewind_init(&intv->rewind, NULL, intv->rewind_ivl, 0);
 #else
-    FILE *f;
-    int addr, i, k;
-	unsigned short data;
-
-	if (altname) {
-		f = fopen("dump_check.sav","wb");
-	} else {
-		f = fopen("dump.sav","wb");
-	}
-    if (!f)
+    const ser_snap_t *const snap = snap_plan();
+    const size_t mem_cap =
+        (size_t)(intv->rewind_mem > 0 ? intv->rewind_mem : 1) << 20;
+
+    if (snap && rewind_init(&intv->rewind, snap, intv->rewind_ivl, mem_cap))
+        fprintf(stderr, "WARNING:  Failed to start rewind.  Disabled.\n");
+#endif
+}
+
+#ifdef BENCHMARK_MEM_DIRTY
+/*
+ * ============================================================================
+ *  MEM_DIRTY_BENCH -- How many bytes would a snapshot that copies only the
+ *                     dirty pages of RAM move each frame, vs. all of it?
+ * ============================================================================
+ */
+#define MDB_N_RAM (5)
+LOCAL THREAD_LOCAL int      mdb_started = 0, mdb_tracked[MDB_N_RAM];
+LOCAL THREAD_LOCAL uint32_t mdb_frames = 0;
+LOCAL THREAD_LOCAL uint32_t mdb_dirty[MDB_N_RAM], mdb_max[MDB_N_RAM];
+
+/* ======================================================================== */
+/*  MEM_DIRTY_BENCH_RESET -- Forget the old machine; a reload builds a new  */
+/*                           one whose RAMs aren't tracking dirty pages.    */
+/* ======================================================================== */
+LOCAL void mem_dirty_bench_reset(void)
+{
+    mdb_started = 0;
+    mdb_frames  = 0;
+    memset(mdb_tracked, 0, sizeof(mdb_tracked));
+    memset(mdb_dirty,   0, sizeof(mdb_dirty));
+    memset(mdb_max,     0, sizeof(mdb_max));
+}
+
+LOCAL void mem_dirty_bench(void)
+{
+    mem_t *const ram[MDB_N_RAM] =
     {
-        perror("fopen(\"dump.sav\", \"w\")");
-        jzp_printf("couldn't open dump.sav.\n");
+        &intv->scr_ram, &intv->sys_ram, &intv->sys_ram2, &intv->glt_ram,
+        &intv->ecs.ram
+    };
+    static const char *const name[MDB_N_RAM] =
+    {
+        "scr_ram", "sys_ram", "sys_ram2", "glt_ram", "ecs_ram"
+    };
+    int i;
 
-		return;
+    /* Start everything clean; the first frame would count all of RAM.     */
+    if (!mdb_started)
+    {
+        for (i = 0; i < MDB_N_RAM; i++)
+        {
+            mdb_tracked[i] = ram[i]->periph.bus
+                          && !mem_track_dirty(ram[i], 1);
+            if (mdb_tracked[i])
+                mem_fetch_dirty(ram[i], NULL, 1);
+        }
+        mdb_started = 1;
+        return;
     }
 
-    char phase[7];
-    memcpy(phase, "phase_1", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
-
-    fwrite(&intv.cp1600.periph.addr_base, sizeof(intv.cp1600.periph.addr_base), 1, f);
-    fwrite(&intv.cp1600.periph.addr_mask, sizeof(intv.cp1600.periph.addr_mask), 1, f);
-    fwrite(&intv.cp1600.periph.now, sizeof(intv.cp1600.periph.now), 1, f);
-    fwrite(&intv.cp1600.periph.min_tick, sizeof(intv.cp1600.periph.min_tick), 1, f);
-    fwrite(&intv.cp1600.periph.max_tick, sizeof(intv.cp1600.periph.max_tick), 1, f);
-    fwrite(&intv.cp1600.periph.next_tick, sizeof(intv.cp1600.periph.next_tick), 1, f);
-
-    fwrite(&intv.cp1600.snoop.addr_base, sizeof(intv.cp1600.snoop.addr_base), 1, f);
-    fwrite(&intv.cp1600.snoop.addr_mask, sizeof(intv.cp1600.snoop.addr_mask), 1, f);
-    fwrite(&intv.cp1600.snoop.now, sizeof(intv.cp1600.snoop.now), 1, f);
-    fwrite(&intv.cp1600.snoop.min_tick, sizeof(intv.cp1600.snoop.min_tick), 1, f);
-    fwrite(&intv.cp1600.snoop.max_tick, sizeof(intv.cp1600.snoop.max_tick), 1, f);
-    fwrite(&intv.cp1600.snoop.next_tick, sizeof(intv.cp1600.snoop.next_tick), 1, f);
-
-    fwrite(&intv.cp1600.tot_cycle, sizeof(intv.cp1600.tot_cycle), 1, f);
-    fwrite(&intv.cp1600.tot_instr, sizeof(intv.cp1600.tot_instr), 1, f);
-    fwrite(&intv.cp1600.tot_cache, sizeof(intv.cp1600.tot_cache), 1, f);
-    fwrite(&intv.cp1600.tot_noncache, sizeof(intv.cp1600.tot_noncache), 1, f);
-
-    for (i = 0; i <= 7; i++)
+    for (i = 0; i < MDB_N_RAM; i++)
     {
-        fwrite(&intv.cp1600.r[i], sizeof(intv.cp1600.r[i]), 1, f);
-    }
+        uint32_t pages;
 
-    fwrite(&intv.cp1600.S, sizeof(intv.cp1600.S), 1, f);
-    fwrite(&intv.cp1600.C, sizeof(intv.cp1600.C), 1, f);
-    fwrite(&intv.cp1600.O, sizeof(intv.cp1600.O), 1, f);
-    fwrite(&intv.cp1600.Z, sizeof(intv.cp1600.Z), 1, f);
-    fwrite(&intv.cp1600.I, sizeof(intv.cp1600.I), 1, f);
-    fwrite(&intv.cp1600.D, sizeof(intv.cp1600.D), 1, f);
+        if (!mdb_tracked[i])
+            continue;
 
-    fwrite(&intv.cp1600.intr, sizeof(intv.cp1600.intr), 1, f);
+        pages         = mem_fetch_dirty(ram[i], NULL, 1);
+        mdb_dirty[i] += pages;
+        if (mdb_max[i] < pages)
+            mdb_max[i] = pages;
+    }
 
-//  fwrite(&intv.cp1600.req_bus.intrq, sizeof(intv.cp1600.req_bus.intrq), 1, f);
+    if (++mdb_frames < 600)
+        return;
+
+    jzp_printf("mem dirty-page update (%d word pages):\n", MEM_DIRTY_WORDS);
+    for (i = 0; i < MDB_N_RAM; i++)
+    {
+        const uint32_t full = ram[i]->img_length * sizeof(uint16_t);
+        const double   avg  = (double)mdb_dirty[i] * MEM_DIRTY_WORDS
+                            * sizeof(uint16_t) / mdb_frames;
 
-    memcpy(phase, "phase_2", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
+        if (!mdb_tracked[i])
+            continue;
 
-//  fwrite(&intv.cp1600.req_bus.intrq_until, sizeof(intv.cp1600.req_bus.intrq_until), 1, f);
-//  fwrite(&intv.cp1600.req_bus.busrq_until, sizeof(intv.cp1600.req_bus.busrq_until), 1, f);
-//  fwrite(&intv.cp1600.req_bus.next_intrq, sizeof(intv.cp1600.req_bus.next_intrq), 1, f);
-//  fwrite(&intv.cp1600.req_bus.next_busrq, sizeof(intv.cp1600.req_bus.next_busrq), 1, f);
-//  fwrite(&intv.cp1600.req_bus.intak, sizeof(intv.cp1600.req_bus.intak), 1, f);
-//  fwrite(&intv.cp1600.req_bus.busak, sizeof(intv.cp1600.req_bus.busak), 1, f);
+        jzp_printf("  %-8s %9.1f bytes/frame avg, %6u max, of %6u\n",
+                   name[i], avg,
+                   (unsigned)(mdb_max[i] * MEM_DIRTY_WORDS * sizeof(uint16_t)),
+                   (unsigned)full);
+    }
+    jzp_flush();
 
-    memcpy(phase, "phase_3", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
+    mdb_frames = 0;
+    memset(mdb_dirty, 0, sizeof(mdb_dirty));
+    memset(mdb_max,   0, sizeof(mdb_max));
+}
+#endif
 
-    fwrite(&intv.cp1600.oldpc, sizeof(intv.cp1600.oldpc), 1, f);
-    fwrite(&intv.cp1600.ext, sizeof(intv.cp1600.ext), 1, f);
-    fwrite(&intv.cp1600.int_vec, sizeof(intv.cp1600.int_vec), 1, f);
+/*
+ * ============================================================================
+ *  RUN_AHEAD    -- Hide the game's own input lag by showing the future.
+ *
+ *  At each frame boundary, snapshot the machine, run K frames with the
+ *  current input, show only the last one, and restore the snapshot.  The
+ *  real frame that follows runs hidden, and so on.  The displayed frame
+ *  reacts to input K frames sooner, at the cost of K extra frames of
+ *  emulation per frame.
+ *
+ *  Only the machine proper is in the snapshot.  Everything outside it
+ *  sits out the look-ahead:  Sound output, rate control and input polling
+ *  aren't ticked, the PSGs don't generate samples, and the Intellivoice
+ *  is disconnected.  Peripherals with state the snapshot can't capture
+ *  (JLP, Locutus) rule run-ahead out entirely.
+ * ============================================================================
+ */
+#define RA_FROZEN   (0x7FFFFFFF)        /* min_tick nothing can reach       */
+#define RA_STEP     (5000)              /* Well under a frame per tick      */
 
-    memcpy(phase, "phase_4", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
+/* ======================================================================== */
+/*  SNAP_QUIET   -- Quiet everything outside the snapshot, so we can run    */
+/*                  the machine through frames nobody should see or hear.   */
+/*  SNAP_UNQUIET -- And let it all back in.                                 */
+/*  RUN_FRAMES   -- Run until frame 'target'.  'last' is the gfx run_ahead  */
+/*                  mode for the final frame; the rest are neither shown    */
+/*                  nor recorded.                                           */
+/* ======================================================================== */
+LOCAL const size_t snap_quiet_list[] =
+{
+    offsetof(cfg_t, snd),   offsetof(cfg_t, speed), offsetof(cfg_t, event),
+    offsetof(cfg_t, psg0),  offsetof(cfg_t, psg1)
+};
+#define SNAP_N_QUIET (sizeof(snap_quiet_list) / sizeof(snap_quiet_list[0]))
+#define SNAP_QUIET(i) ((periph_t *)((char *)intv + snap_quiet_list[i]))
 
-    for (i = 0; i < 1 << (CP1600_MEMSIZE-CP1600_DECODE_PAGE - 5); i++)
-    {
-        fwrite(&intv.cp1600.cacheable[i], sizeof(intv.cp1600.cacheable[i]), 1, f);
-    }
+typedef struct snap_quiet_t
+{
+    uint32_t    min_tick[SNAP_N_QUIET];
+    uint64_t    accutick0, accutick1;
+} snap_quiet_t;
 
-    memcpy(phase, "phase_5", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
-
-//  fwrite(&intv.cp1600.instr_tick_per, sizeof(intv.cp1600.instr_tick_per), 1, f);
-
-	for (addr = 0; addr <= 0xFFFF; addr++)
-	{
-		data = periph_peek(AS_PERIPH(intv.intv), AS_PERIPH(intv.intv),
-						   addr, 0);
-        fwrite(&data, sizeof(data), 1, f);
-	}
-
-    memcpy(phase, "phase_6", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
-
-    fwrite(&intv.stic.stic_cr.addr_base, sizeof(intv.stic.stic_cr.addr_base), 1, f);
-    fwrite(&intv.stic.stic_cr.addr_mask, sizeof(intv.stic.stic_cr.addr_mask), 1, f);
-    fwrite(&intv.stic.stic_cr.now, sizeof(intv.stic.stic_cr.now), 1, f);
-    fwrite(&intv.stic.stic_cr.min_tick, sizeof(intv.stic.stic_cr.min_tick), 1, f);
-    fwrite(&intv.stic.stic_cr.max_tick, sizeof(intv.stic.stic_cr.max_tick), 1, f);
-    fwrite(&intv.stic.stic_cr.next_tick, sizeof(intv.stic.stic_cr.next_tick), 1, f);
-
-    fwrite(&intv.stic.snoop_btab.addr_base, sizeof(intv.stic.snoop_btab.addr_base), 1, f);
-    fwrite(&intv.stic.snoop_btab.addr_mask, sizeof(intv.stic.snoop_btab.addr_mask), 1, f);
-    fwrite(&intv.stic.snoop_btab.now, sizeof(intv.stic.snoop_btab.now), 1, f);
-    fwrite(&intv.stic.snoop_btab.min_tick, sizeof(intv.stic.snoop_btab.min_tick), 1, f);
-    fwrite(&intv.stic.snoop_btab.max_tick, sizeof(intv.stic.snoop_btab.max_tick), 1, f);
-    fwrite(&intv.stic.snoop_btab.next_tick, sizeof(intv.stic.snoop_btab.next_tick), 1, f);
-
-    fwrite(&intv.stic.snoop_gram.addr_base, sizeof(intv.stic.snoop_gram.addr_base), 1, f);
-    fwrite(&intv.stic.snoop_gram.addr_mask, sizeof(intv.stic.snoop_gram.addr_mask), 1, f);
-    fwrite(&intv.stic.snoop_gram.now, sizeof(intv.stic.snoop_gram.now), 1, f);
-    fwrite(&intv.stic.snoop_gram.min_tick, sizeof(intv.stic.snoop_gram.min_tick), 1, f);
-    fwrite(&intv.stic.snoop_gram.max_tick, sizeof(intv.stic.snoop_gram.max_tick), 1, f);
-    fwrite(&intv.stic.snoop_gram.next_tick, sizeof(intv.stic.snoop_gram.next_tick), 1, f);
-
-//  fwrite(&intv.stic.req_bus->intrq, sizeof(intv.stic.req_bus->intrq), 1, f);
-//  fwrite(&intv.stic.req_bus->intrq_until, sizeof(intv.stic.req_bus->intrq_until), 1, f);
-//  fwrite(&intv.stic.req_bus->busrq_until, sizeof(intv.stic.req_bus->busrq_until), 1, f);
-//  fwrite(&intv.stic.req_bus->next_intrq, sizeof(intv.stic.req_bus->next_intrq), 1, f);
-//  fwrite(&intv.stic.req_bus->next_busrq, sizeof(intv.stic.req_bus->next_busrq), 1, f);
-//  fwrite(&intv.stic.req_bus->intak, sizeof(intv.stic.req_bus->intak), 1, f);
-//  fwrite(&intv.stic.req_bus->busak, sizeof(intv.stic.req_bus->busak), 1, f);
-
-//  fwrite(&intv.stic.cp_row, sizeof(intv.stic.cp_row), 1, f);
-    fwrite(&intv.stic.prev_vid_enable, sizeof(intv.stic.prev_vid_enable), 1, f);
-    fwrite(&intv.stic.vid_enable, sizeof(intv.stic.vid_enable), 1, f);
-    fwrite(&intv.stic.mode, sizeof(intv.stic.mode), 1, f);
-    fwrite(&intv.stic.p_mode, sizeof(intv.stic.p_mode), 1, f);
-    fwrite(&intv.stic.bt_dirty, sizeof(intv.stic.bt_dirty), 1, f);
-    fwrite(&intv.stic.gr_dirty, sizeof(intv.stic.gr_dirty), 1, f);
-    fwrite(&intv.stic.ob_dirty, sizeof(intv.stic.ob_dirty), 1, f);
-
-    fwrite(&intv.stic.rand_regs, sizeof(intv.stic.rand_regs), 1, f);
-    fwrite(&intv.stic.pal, sizeof(intv.stic.pal), 1, f);
-    fwrite(&intv.stic.drop_frame, sizeof(intv.stic.drop_frame), 1, f);
-    fwrite(&intv.stic.gmem_accessible, sizeof(intv.stic.gmem_accessible), 1, f);
-    fwrite(&intv.stic.stic_accessible, sizeof(intv.stic.stic_accessible), 1, f);
-//  fwrite(&intv.stic.next_irq, sizeof(intv.stic.next_irq), 1, f);
-
-    memcpy(phase, "phase_7", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
-
-//  fwrite(&intv.stic.phase, sizeof(intv.stic.phase), 1, f);
-//  fwrite(&intv.stic.next_phase, sizeof(intv.stic.next_phase), 1, f);
-
-    memcpy(phase, "phase_8", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
-
-    for (i=0; i<0x40; i++) {
-        fwrite(&intv.stic.raw[i], sizeof(intv.stic.raw[i]), 1, f);
-    }
+LOCAL void snap_quiet(snap_quiet_t *const q)
+{
+    unsigned i;
 
-    for (i=0; i<0x140 * 8; i++) {
-        fwrite(&intv.stic.gmem[i], sizeof(intv.stic.gmem[i]), 1, f);
+    for (i = 0; i < SNAP_N_QUIET; i++)
+    {
+        q->min_tick[i] = SNAP_QUIET(i)->min_tick;
+        SNAP_QUIET(i)->min_tick = RA_FROZEN;
     }
+    q->accutick0        = intv->psg0.accutick;
+    q->accutick1        = intv->psg1.accutick;
+    intv->psg0.accutick  = ~0ULL >> 1;
+    intv->psg1.accutick  = ~0ULL >> 1;
+    intv->ivoice.periph.busy = 1;
+}
 
-//  fwrite(&intv.stic.fifo_ptr, sizeof(intv.stic.fifo_ptr), 1, f);
+LOCAL void snap_unquiet(const snap_quiet_t *const q)
+{
+    unsigned i;
 
-    memcpy(phase, "phase8a", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
+    for (i = 0; i < SNAP_N_QUIET; i++)
+        SNAP_QUIET(i)->min_tick = q->min_tick[i];
+    intv->psg0.accutick  = q->accutick0;
+    intv->psg1.accutick  = q->accutick1;
+    intv->ivoice.periph.busy = 0;
+}
 
-    for (i=0; i<240; i++) {
-        fwrite(&intv.stic.btab_sr[i], sizeof(intv.stic.btab_sr[i]), 1, f);
-    }
-    for (i=0; i<240; i++) {
-        fwrite(&intv.stic.btab[i], sizeof(intv.stic.btab[i]), 1, f);
-    }
-    for (i=0; i<12; i++) {
-        fwrite(&intv.stic.last_bg[i], sizeof(intv.stic.last_bg[i]), 1, f);
+LOCAL void run_frames(const uint32_t target, const uint32_t cap,
+                      const int last)
+{
+    while ((int32_t)(target - intv->gfx.tot_frames) > 0 && !intv->do_exit)
+    {
+        intv->gfx.run_ahead = (int32_t)(target - intv->gfx.tot_frames) > 1
+                           ? GFX_RA_NOSHOW | GFX_RA_NOREC : last;
+        periph_tick(AS_PERIPH(intv->intv), cpu_step(cap));
     }
-    memcpy(phase, "phase8b", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
+}
 
-    fwrite(&intv.stic.time, sizeof(intv.stic.time), 1, f);
+LOCAL THREAD_LOCAL struct
+{
+    uint8_t    *state;                  /* Machine at the frame boundary.   */
+    int         frames;                 /* K                                */
+    uint32_t    count,  sec_count;      /* Frames we've run ahead from.     */
+    double      save, run, restore;     /* Total time in each step.         */
+    double      sec_time;               /* Total time since last report.    */
+} ra;
+
+LOCAL void run_ahead_start(void)
+{
+#ifdef NO_SERIALIZER
+    fprintf(stderr, "Run-ahead is not supported in this build.\n");
+#else
+    const ser_snap_t *const snap = snap_plan();
 
-    memcpy(phase, "phase8c", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
+    if (!snap)
+        return;
 
-    for (i=0; i<240*8; i++) {
-        fwrite(&intv.stic.bt_bmp[i], sizeof(intv.stic.bt_bmp[i]), 1, f);
-    }
-    for (i=0; i<16*16  / 8; i++) {
-        fwrite(&intv.stic.mob_img[i], sizeof(intv.stic.mob_img[i]), 1, f);
-    }
-    for (i=0; i<8; i++) {
-        for (k=0; k<16; k++) {
-            fwrite(&intv.stic.mob_bmp[i][k], sizeof(intv.stic.mob_bmp[i][k]), 1, f);
-        }
-    }
-    for (i=0; i<192*224 / 8; i++) {
-        fwrite(&intv.stic.mpl_img[i], sizeof(intv.stic.mpl_img[i]), 1, f);
-    }
-    for (i=0; i<192*224 /32; i++) {
-        fwrite(&intv.stic.mpl_vsb[i], sizeof(intv.stic.mpl_vsb[i]), 1, f);
-    }
-    for (i=0; i<192*224 /32; i++) {
-        fwrite(&intv.stic.mpl_pri[i], sizeof(intv.stic.mpl_pri[i]), 1, f);
-    }
-    for (i=0; i<192*224 / 8; i++) {
-        fwrite(&intv.stic.xbt_img[i], sizeof(intv.stic.xbt_img[i]), 1, f);
-    }
-    for (i=0; i<192*224 /32; i++) {
-        fwrite(&intv.stic.xbt_bmp[i], sizeof(intv.stic.xbt_bmp[i]), 1, f);
-    }
-    for (i=0; i<192*224 / 8; i++) {
-        fwrite(&intv.stic.image[i], sizeof(intv.stic.image[i]), 1, f);
+    if (intv->debugging || intv->jlp.periph.bus || intv->locutus.periph.bus)
+    {
+        fprintf(stderr, "WARNING:  Run-ahead doesn't work with the debugger,"
+                        " JLP or Locutus.  Disabled.\n");
+        return;
     }
 
-    memcpy(phase, "phase8d", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
-
-    for (i=0; i<8; i++) {
-        for (k=0; k<4; k++) {
-            fwrite(&intv.stic.gfx->bbox[i][k], sizeof(intv.stic.gfx->bbox[i][k]), 1, f);
-        }
+    if (!(ra.state = CALLOC(uint8_t, snap->size)))
+    {
+        fprintf(stderr, "WARNING:  Out of memory for run-ahead.  "
+                        "Disabled.\n");
+        return;
     }
 
-    fwrite(&intv.stic.gfx->dirty, sizeof(intv.stic.gfx->dirty), 1, f);
-    fwrite(&intv.stic.gfx->drop_frame, sizeof(intv.stic.gfx->drop_frame), 1, f);
-    fwrite(&intv.stic.gfx->dropped_frames, sizeof(intv.stic.gfx->dropped_frames), 1, f);
-    fwrite(&intv.stic.gfx->tot_frames, sizeof(intv.stic.gfx->tot_frames), 1, f);
-    fwrite(&intv.stic.gfx->tot_dropped_frames, sizeof(intv.stic.gfx->tot_dropped_frames), 1, f);
-
-    fwrite(&intv.stic.gfx->b_color, sizeof(intv.stic.gfx->b_color), 1, f);
-    fwrite(&intv.stic.gfx->b_dirty, sizeof(intv.stic.gfx->b_dirty), 1, f);
-    fwrite(&intv.stic.gfx->x_blank, sizeof(intv.stic.gfx->x_blank), 1, f);
-    fwrite(&intv.stic.gfx->y_blank, sizeof(intv.stic.gfx->y_blank), 1, f);
-    fwrite(&intv.stic.gfx->x_delay, sizeof(intv.stic.gfx->x_delay), 1, f);
-    fwrite(&intv.stic.gfx->y_delay, sizeof(intv.stic.gfx->y_delay), 1, f);
-    fwrite(&intv.stic.gfx->debug_blank, sizeof(intv.stic.gfx->debug_blank), 1, f);
+    ra.frames = intv->run_ahead;
+    jzp_printf("Running %d frame%s ahead\n", ra.frames,
+               ra.frames == 1 ? "" : "s");
+#endif
+}
 
-    memcpy(phase, "phase8e", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
+LOCAL void run_ahead(void)
+{
+#ifndef NO_SERIALIZER
+    const uint32_t target = intv->gfx.tot_frames + ra.frames;
+    snap_quiet_t quiet;
+    double t0, t1, t2, t3;
 
-    fwrite(&intv.stic.gfx->periph.addr_base, sizeof(intv.stic.gfx->periph.addr_base), 1, f);
-    fwrite(&intv.stic.gfx->periph.addr_mask, sizeof(intv.stic.gfx->periph.addr_mask), 1, f);
-    fwrite(&intv.stic.gfx->periph.now, sizeof(intv.stic.gfx->periph.now), 1, f);
-    fwrite(&intv.stic.gfx->periph.min_tick, sizeof(intv.stic.gfx->periph.min_tick), 1, f);
-    fwrite(&intv.stic.gfx->periph.max_tick, sizeof(intv.stic.gfx->periph.max_tick), 1, f);
-    fwrite(&intv.stic.gfx->periph.next_tick, sizeof(intv.stic.gfx->periph.next_tick), 1, f);
+    if (!ra.state)
+        return;
 
-    fwrite(&intv.stic.gfx->periph.next_tick, sizeof(intv.stic.gfx->periph.next_tick), 1, f);
+    t0 = get_time();
+    ser_snap_save(intv->snap, ra.state);
+    t1 = get_time();
 
-    memcpy(phase, "phase_9", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
+    /* -------------------------------------------------------------------- */
+    /*  Quiet everything outside the snapshot.  Run K frames.  Show only    */
+    /*  the last, and record none of them.                                  */
+    /* -------------------------------------------------------------------- */
+    snap_quiet(&quiet);
+    run_frames(target, RA_STEP, GFX_RA_NOREC);
+    t2 = get_time();
 
-#if 0
-	for (k=0; k<32; k++) {
-        fwrite(&intv.exec.banksw[k], sizeof(intv.exec.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fwrite(&intv.exec2.banksw[k], sizeof(intv.exec2.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fwrite(&intv.sys_ram.banksw[k], sizeof(intv.sys_ram.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fwrite(&intv.sys_ram2.banksw[k], sizeof(intv.sys_ram2.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fwrite(&intv.scr_ram.banksw[k], sizeof(intv.scr_ram.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fwrite(&intv.glt_ram.banksw[k], sizeof(intv.glt_ram.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fwrite(&intv.game0.banksw[k], sizeof(intv.game0.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fwrite(&intv.game1.banksw[k], sizeof(intv.game1.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fwrite(&intv.game2.banksw[k], sizeof(intv.game2.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fwrite(&intv.ecs0.banksw[k], sizeof(intv.ecs0.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fwrite(&intv.ecs1.banksw[k], sizeof(intv.ecs1.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fwrite(&intv.ecs2.banksw[k], sizeof(intv.ecs2.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fwrite(&intv.ecs_ram.banksw[k], sizeof(intv.ecs_ram.banksw[k]), 1, f);
-	}
+    /* -------------------------------------------------------------------- */
+    /*  Put the machine back, and hide the real frame that comes next.      */
+    /* -------------------------------------------------------------------- */
+    ser_snap_restore(intv->snap, ra.state);
+    snap_unquiet(&quiet);
+    snap_resync(false);
+    intv->gfx.run_ahead = GFX_RA_NOSHOW;
+    t3 = get_time();
+
+    ra.save     += t1 - t0;
+    ra.run      += t2 - t1;
+    ra.restore  += t3 - t2;
+    ra.sec_time += t3 - t0;
+    ra.count++;
+    ra.sec_count++;
 #endif
+}
 
-    memcpy(phase, "phase10", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
-
-	for (k=0; k<4096 + 256; k++) {
-        fwrite(&intv.exec_img[k], sizeof(intv.exec_img[k]), 1, f);
-	}
-	for (k=0; k<2048; k++) {
-        fwrite(&intv.grom_img[k], sizeof(intv.grom_img[k]), 1, f);
-	}
-	for (k=0; k<4096 * 3; k++) {
-        fwrite(&intv.ecs_img[k], sizeof(intv.ecs_img[k]), 1, f);
-	}
-
-    memcpy(phase, "phase11", sizeof(phase));
-	fwrite(phase, sizeof(phase), 1, f);
+/* ======================================================================== */
+/*  RUN_AHEAD_STATS  -- Report the per-frame cost, so users can pick K.     */
+/*                      Appends to the status line every second, and        */
+/*                      gives a breakdown on the way out.                   */
+/* ======================================================================== */
+LOCAL void run_ahead_stats(const bool final)
+{
+    if (!ra.state)
+        return;
 
-    // Write periph's notion of 'now'
-    fwrite(&intv.intv->periph.now, sizeof(intv.intv->periph.now), 1, f);
+    if (!final)
+    {
+        if (ra.sec_count)
+            jzp_printf(" RA:[%d %5.2fms]", ra.frames,
+                       1e3 * ra.sec_time / ra.sec_count);
+        ra.sec_time  = 0;
+        ra.sec_count = 0;
+        return;
+    }
 
-    fclose(f);
-#endif
+    if (ra.count)
+        jzp_printf("\nRun-ahead: %d frame%s, %u times, %.2f msec per frame"
+                   " (save %.1f usec, run %.2f msec, restore %.1f usec)\n",
+                   ra.frames, ra.frames == 1 ? "" : "s", ra.count,
+                   1e3 * (ra.save + ra.run + ra.restore) / ra.count,
+                   1e6 * ra.save / ra.count, 1e3 * ra.run / ra.count,
+                   1e6 * ra.restore / ra.count);
 }
 
+LOCAL void run_ahead_stop(void)
+{
+    run_ahead_stats(true);
+    CONDFREE(ra.state);
+    memset(&ra, 0, sizeof(ra));
+    intv->gfx.run_ahead = 0;
+}
 
 /*
  * ============================================================================
- *  LOAD_DUMP
+ *  NETPLAY      -- Rollback netplay over the netplay module's transport.
+ *
+ *  At each frame boundary F:  hand over local input, take in the peer's,
+ *  and if a frame r < F ran on a wrong prediction, restore the snapshot
+ *  from the start of r and quietly re-run r..F-1 with the input we know
+ *  now.  Then snapshot F and apply F's input.  The snapshots form a ring
+ *  one longer than the rollback window, plus one for F itself.
+ *
+ *  Once a frame's input is confirmed on both sides, the state at its end
+ *  is final.  Both sides hash it and compare.  Only CPU-visible state
+ *  goes into the hash:  registers, STIC registers and GRAM, and RAM.  The
+ *  PSGs' counters run on the host's audio timing, so they're left out.
  * ============================================================================
  */
+#define NP_MAX_RANGE (8)
 
-void load_dump()
+LOCAL THREAD_LOCAL struct
 {
-#if 1
-    jzp_printf("Loading and saving dumps currently disabled.\n");
-#else
-    FILE *f;
-    int addr, i, k;
-	unsigned short data;
-	char phase[8];
-    memset(phase, 0, sizeof(phase));
-
-    f = fopen("dump.sav","rb");
-    if (!f)
-    {
-        perror("fopen(\"dump.sav\", \"r\")");
-        jzp_printf("couldn't open dump.sav.\n");
+    uint8_t    *state;                  /* Ring of snapshots.               */
+    uint32_t    size, slots;            /* Snapshot size, ring length.      */
+    uint32_t    frame;                  /* Frame about to run.              */
+    uint32_t    hashed;                 /* Frames hashed so far.            */
+    int         n_range;                /* Hashed parts of a snapshot.      */
+    int32_t     range_ofs[NP_MAX_RANGE];
+    uint32_t    range_len[NP_MAX_RANGE];
+} np;
+
+/* ------------------------------------------------------------------------ */
+/*  Both sides snapshot and apply input at each frame's end, so the CPU     */
+/*  has to be in the same place then.  How far it overshoots a tick         */
+/*  depends on how the bus slices time, and that differs between machines   */
+/*  and between a run and its re-run.  So never ask it to run past the      */
+/*  frame's render point:  it then stops on the first instruction at or     */
+/*  after it either way.  Once there, it sits out while the rest catch up   */
+/*  and render the frame.                                                   */
+/* ------------------------------------------------------------------------ */
+LOCAL uint32_t netplay_step(const uint32_t step)
+{
+    const uint64_t cpu = intv->cp1600.periph.now;
+    const uint64_t bus = intv->intv->periph.now;
+    uint64_t end = intv->stic.next_frame_render;
 
-		return;
-    }
+    if (!np.state)
+        return step;
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase);//1
-
-    fread(&intv.cp1600.periph.addr_base, sizeof(intv.cp1600.periph.addr_base), 1, f);
-    fread(&intv.cp1600.periph.addr_mask, sizeof(intv.cp1600.periph.addr_mask), 1, f);
-    fread(&intv.cp1600.periph.now, sizeof(intv.cp1600.periph.now), 1, f);
-    fread(&intv.cp1600.periph.min_tick, sizeof(intv.cp1600.periph.min_tick), 1, f);
-    fread(&intv.cp1600.periph.max_tick, sizeof(intv.cp1600.periph.max_tick), 1, f);
-    fread(&intv.cp1600.periph.next_tick, sizeof(intv.cp1600.periph.next_tick), 1, f);
-
-    fread(&intv.cp1600.snoop.addr_base, sizeof(intv.cp1600.snoop.addr_base), 1, f);
-    fread(&intv.cp1600.snoop.addr_mask, sizeof(intv.cp1600.snoop.addr_mask), 1, f);
-    fread(&intv.cp1600.snoop.now, sizeof(intv.cp1600.snoop.now), 1, f);
-    fread(&intv.cp1600.snoop.min_tick, sizeof(intv.cp1600.snoop.min_tick), 1, f);
-    fread(&intv.cp1600.snoop.max_tick, sizeof(intv.cp1600.snoop.max_tick), 1, f);
-    fread(&intv.cp1600.snoop.next_tick, sizeof(intv.cp1600.snoop.next_tick), 1, f);
-
-    fread(&intv.cp1600.tot_cycle, sizeof(intv.cp1600.tot_cycle), 1, f);
-    fread(&intv.cp1600.tot_instr, sizeof(intv.cp1600.tot_instr), 1, f);
-    fread(&intv.cp1600.tot_cache, sizeof(intv.cp1600.tot_cache), 1, f);
-    fread(&intv.cp1600.tot_noncache, sizeof(intv.cp1600.tot_noncache), 1, f);
-
-    for (i = 0; i <= 7; i++)
-    {
-        fread(&intv.cp1600.r[i], sizeof(intv.cp1600.r[i]), 1, f);
-    }
+    if (cpu >= end)
+        return cpu >= bus ? (uint32_t)(cpu + 1 - bus) : 1;
 
-    fread(&intv.cp1600.S, sizeof(intv.cp1600.S), 1, f);
-    fread(&intv.cp1600.C, sizeof(intv.cp1600.C), 1, f);
-    fread(&intv.cp1600.O, sizeof(intv.cp1600.O), 1, f);
-    fread(&intv.cp1600.Z, sizeof(intv.cp1600.Z), 1, f);
-    fread(&intv.cp1600.I, sizeof(intv.cp1600.I), 1, f);
-    fread(&intv.cp1600.D, sizeof(intv.cp1600.D), 1, f);
+    /* The CPU won't tick for less than 2.  It's on an instruction         */
+    /* boundary, and no instruction is that short, so this stops it in the */
+    /* same place.                                                         */
+    if (end < cpu + 2)
+        end = cpu + 2;
 
-    fread(&intv.cp1600.intr, sizeof(intv.cp1600.intr), 1, f);
+    return end - bus < step ? (uint32_t)(end - bus) : step;
+}
 
+#ifndef NO_SERIALIZER
+LOCAL uint8_t *netplay_slot(const uint32_t frame)
+{
+    return np.state + (size_t)(frame % np.slots) * np.size;
+}
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //2
+LOCAL uint32_t netplay_state_hash(const uint8_t *const state)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    int i;
 
-//  fread(&intv.cp1600.req_bus.intrq, sizeof(intv.cp1600.req_bus.intrq), 1, f);
-//  fread(&intv.cp1600.req_bus.intrq_until, sizeof(intv.cp1600.req_bus.intrq_until), 1, f);
-//  fread(&intv.cp1600.req_bus.busrq_until, sizeof(intv.cp1600.req_bus.busrq_until), 1, f);
-//  fread(&intv.cp1600.req_bus.next_intrq, sizeof(intv.cp1600.req_bus.next_intrq), 1, f);
-//  fread(&intv.cp1600.req_bus.next_busrq, sizeof(intv.cp1600.req_bus.next_busrq), 1, f);
-//  fread(&intv.cp1600.req_bus.intak, sizeof(intv.cp1600.req_bus.intak), 1, f);
-//  fread(&intv.cp1600.req_bus.busak, sizeof(intv.cp1600.req_bus.busak), 1, f);
+    for (i = 0; i < np.n_range; i++)
+        crc = crc32_block(crc, state + np.range_ofs[i], np.range_len[i]);
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //3
+    return ~crc;
+}
 
-    fread(&intv.cp1600.oldpc, sizeof(intv.cp1600.oldpc), 1, f);
-    fread(&intv.cp1600.ext, sizeof(intv.cp1600.ext), 1, f);
-    fread(&intv.cp1600.int_vec, sizeof(intv.cp1600.int_vec), 1, f);
+/* ------------------------------------------------------------------------ */
+/*  The pads only look at new input when they next tick, and when that is   */
+/*  depends on how the bus slices up time, which a re-run doesn't repeat.   */
+/*  Have them look right away, so the game sees the same thing both times.  */
+/* ------------------------------------------------------------------------ */
+LOCAL void netplay_input(const uint32_t frame)
+{
+    netplay_apply(&intv->netplay, frame);
+    intv->pad0.stale = 1;
+    intv->pad1.stale = 1;
+}
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //4
+LOCAL void netplay_add_range(const ser_snap_t *const snap,
+                             const void *const object, const uint32_t len)
+{
+    const int32_t ofs = object ? ser_snap_offset(snap, object, len) : -1;
 
-    for (i = 0; i < 1 << (CP1600_MEMSIZE-CP1600_DECODE_PAGE - 5); i++)
-    {
-        fread(&intv.cp1600.cacheable[i], sizeof(intv.cp1600.cacheable[i]), 1, f);
-    }
+    if (ofs < 0 || np.n_range == NP_MAX_RANGE)
+        return;
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //5
+    np.range_ofs[np.n_range] = ofs;
+    np.range_len[np.n_range] = len;
+    np.n_range++;
+}
+#endif
 
-//  fread(&intv.cp1600.instr_tick_per, sizeof(intv.cp1600.instr_tick_per), 1, f);
+LOCAL void netplay_start(void)
+{
+#ifdef NO_SERIALIZER
+    fprintf(stderr, "Netplay is not supported in this build.\n");
+    netplay_stop();
+#else
+    const ser_snap_t *const snap = snap_plan();
+    mem_t *const ram[] =
+    {
+        &intv->scr_ram, &intv->sys_ram, &intv->sys_ram2, &intv->ecs.ram
+    };
+    unsigned i;
 
-	for (addr = 0; addr <= 0xFFFF; addr++)
-	{
-        fread(&data, sizeof(data), 1, f);
-        if (addr > 0x40)
-        {
-            periph_write(AS_PERIPH(intv.intv), AS_PERIPH(intv.intv),
-                               addr, data);
-        }
-	}
-
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //6
-
-    fread(&intv.stic.stic_cr.addr_base, sizeof(intv.stic.stic_cr.addr_base), 1, f);
-    fread(&intv.stic.stic_cr.addr_mask, sizeof(intv.stic.stic_cr.addr_mask), 1, f);
-    fread(&intv.stic.stic_cr.now, sizeof(intv.stic.stic_cr.now), 1, f);
-    fread(&intv.stic.stic_cr.min_tick, sizeof(intv.stic.stic_cr.min_tick), 1, f);
-    fread(&intv.stic.stic_cr.max_tick, sizeof(intv.stic.stic_cr.max_tick), 1, f);
-    fread(&intv.stic.stic_cr.next_tick, sizeof(intv.stic.stic_cr.next_tick), 1, f);
-
-    fread(&intv.stic.snoop_btab.addr_base, sizeof(intv.stic.snoop_btab.addr_base), 1, f);
-    fread(&intv.stic.snoop_btab.addr_mask, sizeof(intv.stic.snoop_btab.addr_mask), 1, f);
-    fread(&intv.stic.snoop_btab.now, sizeof(intv.stic.snoop_btab.now), 1, f);
-    fread(&intv.stic.snoop_btab.min_tick, sizeof(intv.stic.snoop_btab.min_tick), 1, f);
-    fread(&intv.stic.snoop_btab.max_tick, sizeof(intv.stic.snoop_btab.max_tick), 1, f);
-    fread(&intv.stic.snoop_btab.next_tick, sizeof(intv.stic.snoop_btab.next_tick), 1, f);
-
-    fread(&intv.stic.snoop_gram.addr_base, sizeof(intv.stic.snoop_gram.addr_base), 1, f);
-    fread(&intv.stic.snoop_gram.addr_mask, sizeof(intv.stic.snoop_gram.addr_mask), 1, f);
-    fread(&intv.stic.snoop_gram.now, sizeof(intv.stic.snoop_gram.now), 1, f);
-    fread(&intv.stic.snoop_gram.min_tick, sizeof(intv.stic.snoop_gram.min_tick), 1, f);
-    fread(&intv.stic.snoop_gram.max_tick, sizeof(intv.stic.snoop_gram.max_tick), 1, f);
-    fread(&intv.stic.snoop_gram.next_tick, sizeof(intv.stic.snoop_gram.next_tick), 1, f);
-
-//  fread(&intv.stic.req_bus->intrq, sizeof(intv.stic.req_bus->intrq), 1, f);
-//  fread(&intv.stic.req_bus->intrq_until, sizeof(intv.stic.req_bus->intrq_until), 1, f);
-//  fread(&intv.stic.req_bus->busrq_until, sizeof(intv.stic.req_bus->busrq_until), 1, f);
-//  fread(&intv.stic.req_bus->next_intrq, sizeof(intv.stic.req_bus->next_intrq), 1, f);
-//  fread(&intv.stic.req_bus->next_busrq, sizeof(intv.stic.req_bus->next_busrq), 1, f);
-//  fread(&intv.stic.req_bus->intak, sizeof(intv.stic.req_bus->intak), 1, f);
-//  fread(&intv.stic.req_bus->busak, sizeof(intv.stic.req_bus->busak), 1, f);
-
-//  fread(&intv.stic.cp_row, sizeof(intv.stic.cp_row), 1, f);
-    fread(&intv.stic.prev_vid_enable, sizeof(intv.stic.prev_vid_enable), 1, f);
-    fread(&intv.stic.vid_enable, sizeof(intv.stic.vid_enable), 1, f);
-    fread(&intv.stic.mode, sizeof(intv.stic.mode), 1, f);
-
-    fread(&intv.stic.p_mode, sizeof(intv.stic.p_mode), 1, f);
-    fread(&intv.stic.bt_dirty, sizeof(intv.stic.bt_dirty), 1, f);
-    fread(&intv.stic.gr_dirty, sizeof(intv.stic.gr_dirty), 1, f);
-    fread(&intv.stic.ob_dirty, sizeof(intv.stic.ob_dirty), 1, f);
-    fread(&intv.stic.rand_regs, sizeof(intv.stic.rand_regs), 1, f);
-
-    fread(&intv.stic.pal, sizeof(intv.stic.pal), 1, f);
-    fread(&intv.stic.drop_frame, sizeof(intv.stic.drop_frame), 1, f);
-    fread(&intv.stic.gmem_accessible, sizeof(intv.stic.gmem_accessible), 1, f);
-    fread(&intv.stic.stic_accessible, sizeof(intv.stic.stic_accessible), 1, f);
-//  fread(&intv.stic.next_irq, sizeof(intv.stic.next_irq), 1, f);
-
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //7
-
-//  fread(&intv.stic.phase, sizeof(intv.stic.phase), 1, f);
-//  fread(&intv.stic.next_phase, sizeof(intv.stic.next_phase), 1, f);
-
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //8
-
-    for (i=0; i<0x40; i++) {
-        fread(&intv.stic.raw[i], sizeof(intv.stic.raw[i]), 1, f);
+    if (!snap)
+    {
+        netplay_stop();
+        return;
     }
 
-    for (i=0; i<0x140 * 8; i++) {
-        fread(&intv.stic.gmem[i], sizeof(intv.stic.gmem[i]), 1, f);
+    if (intv->debugging || intv->jlp.periph.bus || intv->locutus.periph.bus)
+    {
+        fprintf(stderr, "WARNING:  Netplay doesn't work with the debugger,"
+                        " JLP or Locutus.  Disabled.\n");
+        netplay_stop();
+        return;
     }
 
-//  fread(&intv.stic.fifo_ptr, sizeof(intv.stic.fifo_ptr), 1, f);
+    np.size  = snap->size;
+    np.slots = intv->netplay_win + 2;
+    if (!(np.state = CALLOC(uint8_t, (size_t)np.size * np.slots)))
+    {
+        fprintf(stderr, "WARNING:  Out of memory for netplay.  "
+                        "Disabled.\n");
+        netplay_stop();
+        return;
+    }
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //8a
+    /* -------------------------------------------------------------------- */
+    /*  Pick out the CPU-visible state to hash.                             */
+    /* -------------------------------------------------------------------- */
+    netplay_add_range(snap, intv->cp1600.r,  sizeof(intv->cp1600.r));
+    netplay_add_range(snap, &intv->cp1600.tot_cycle,
+                      sizeof(intv->cp1600.tot_cycle));
+    netplay_add_range(snap, intv->stic.raw,  sizeof(intv->stic.raw));
+    netplay_add_range(snap, intv->stic.gmem, sizeof(intv->stic.gmem));
+    for (i = 0; i < sizeof(ram) / sizeof(ram[0]); i++)
+        if (ram[i]->periph.bus)
+            netplay_add_range(snap, ram[i]->image,
+                              ram[i]->img_length * sizeof(uint16_t));
 
-    for (i=0; i<240; i++) {
-        fread(&intv.stic.btab_sr[i], sizeof(intv.stic.btab_sr[i]), 1, f);
-    }
-    for (i=0; i<240; i++) {
-        fread(&intv.stic.btab[i], sizeof(intv.stic.btab[i]), 1, f);
-    }
-    for (i=0; i<12; i++) {
-        fread(&intv.stic.last_bg[i], sizeof(intv.stic.last_bg[i]), 1, f);
+    /* -------------------------------------------------------------------- */
+    /*  Both sides should be starting from the same place.                  */
+    /* -------------------------------------------------------------------- */
+    ser_snap_save(intv->snap, np.state);
+    if (netplay_connect(&intv->netplay, netplay_state_hash(np.state)))
+    {
+        fprintf(stderr, "WARNING:  Netplay failed to connect.  "
+                        "Disabled.\n");
+        netplay_stop();
+        return;
     }
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //8b
+    netplay_frame();
+#endif
+}
+
+/* ======================================================================== */
+/*  NETPLAY_FRAME    -- Everything netplay does at a frame boundary.        */
+/* ======================================================================== */
+LOCAL void netplay_frame(void)
+{
+#ifndef NO_SERIALIZER
+    netplay_t *const net = &intv->netplay;
+    const uint32_t frame = np.frame;
+    uint32_t final;
+    int32_t  back;
 
-    fread(&intv.stic.time, sizeof(intv.stic.time), 1, f);
+    if (!np.state)
+        return;
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //8c
+    if (netplay_local(net, frame))
+        intv->do_exit = 1;
 
-    for (i=0; i<240*8; i++) {
-        fread(&intv.stic.bt_bmp[i], sizeof(intv.stic.bt_bmp[i]), 1, f);
-    }
-    for (i=0; i<16*16  / 8; i++) {
-        fread(&intv.stic.mob_img[i], sizeof(intv.stic.mob_img[i]), 1, f);
+    if (netplay_wait(net, frame))
+    {
+        netplay_stop();
+        return;
     }
-    for (i=0; i<8; i++) {
-        for (k=0; k<16; k++) {
-            fread(&intv.stic.mob_bmp[i][k], sizeof(intv.stic.mob_bmp[i][k]), 1, f);
+
+    /* -------------------------------------------------------------------- */
+    /*  Roll back and re-simulate, if we guessed wrong.                     */
+    /* -------------------------------------------------------------------- */
+    if ((back = netplay_rollback(net)) >= 0 && (uint32_t)back < frame)
+    {
+        const uint64_t snd0 = intv->psg0.sound_current;
+        const uint64_t snd1 = intv->psg1.sound_current;
+        const uint64_t now0 = intv->psg0.periph.now;
+        const uint64_t now1 = intv->psg1.periph.now;
+        const double start = get_time();
+        snap_quiet_t quiet;
+        uint32_t f;
+
+        /* ---------------------------------------------------------------- */
+        /*  The snapshot we'd need is gone.  Any older one ran on the wrong */
+        /*  input, so there's no way back into sync.                        */
+        /* ---------------------------------------------------------------- */
+        if (frame - back >= np.slots)
+        {
+            fprintf(stderr, "\nNetplay: Can't roll back %u frames.  "
+                            "Stopping.\n", frame - back);
+            netplay_desync(net, back);
+            netplay_finish(net);
+            netplay_stop();
+            return;
         }
-    }
-    for (i=0; i<192*224 / 8; i++) {
-        fread(&intv.stic.mpl_img[i], sizeof(intv.stic.mpl_img[i]), 1, f);
-    }
-    for (i=0; i<192*224 /32; i++) {
-        fread(&intv.stic.mpl_vsb[i], sizeof(intv.stic.mpl_vsb[i]), 1, f);
-    }
-    for (i=0; i<192*224 /32; i++) {
-        fread(&intv.stic.mpl_pri[i], sizeof(intv.stic.mpl_pri[i]), 1, f);
-    }
-    for (i=0; i<192*224 / 8; i++) {
-        fread(&intv.stic.xbt_img[i], sizeof(intv.stic.xbt_img[i]), 1, f);
-    }
-    for (i=0; i<192*224 /32; i++) {
-        fread(&intv.stic.xbt_bmp[i], sizeof(intv.stic.xbt_bmp[i]), 1, f);
-    }
-    for (i=0; i<192*224 / 8; i++) {
-        fread(&intv.stic.image[i], sizeof(intv.stic.image[i]), 1, f);
-    }
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //8d
+        ser_snap_restore(intv->snap, netplay_slot(back));
+        snap_resync(false);
+        snap_quiet(&quiet);
+
+        /* The PSGs stay put.  Keep them from complaining about writes     */
+        /* from the past.                                                  */
+        intv->psg0.sound_current = intv->cp1600.periph.now;
+        intv->psg1.sound_current = intv->cp1600.periph.now;
 
-    for (i=0; i<8; i++) {
-        for (k=0; k<4; k++) {
-            fread(&intv.stic.gfx->bbox[i][k], sizeof(intv.stic.gfx->bbox[i][k]), 1, f);
+        for (f = back; f != frame && !intv->do_exit; f++)
+        {
+            if (f != (uint32_t)back)
+                ser_snap_save(intv->snap, netplay_slot(f));
+            netplay_input(f);
+            run_frames(intv->gfx.tot_frames + 1, 20000,
+                       GFX_RA_NOSHOW | GFX_RA_NOREC);
         }
-    }
 
-    fread(&intv.stic.gfx->dirty, sizeof(intv.stic.gfx->dirty), 1, f);
-    fread(&intv.stic.gfx->drop_frame, sizeof(intv.stic.gfx->drop_frame), 1, f);
-    fread(&intv.stic.gfx->dropped_frames, sizeof(intv.stic.gfx->dropped_frames), 1, f);
-    fread(&intv.stic.gfx->tot_frames, sizeof(intv.stic.gfx->tot_frames), 1, f);
-    fread(&intv.stic.gfx->tot_dropped_frames, sizeof(intv.stic.gfx->tot_dropped_frames), 1, f);
+        /* The PSGs have already played up to here.  Carry on from there. */
+        snap_unquiet(&quiet);
+        intv->psg0.sound_current = snd0;
+        intv->psg1.sound_current = snd1;
+        intv->psg0.periph.now    = now0;
+        intv->psg1.periph.now    = now1;
+        snap_resync(false);
+        intv->gfx.run_ahead = 0;
+        netplay_resim(net, frame - back, get_time() - start);
+    }
 
-    fread(&intv.stic.gfx->b_color, sizeof(intv.stic.gfx->b_color), 1, f);
-    fread(&intv.stic.gfx->b_dirty, sizeof(intv.stic.gfx->b_dirty), 1, f);
-    fread(&intv.stic.gfx->x_blank, sizeof(intv.stic.gfx->x_blank), 1, f);
-    fread(&intv.stic.gfx->y_blank, sizeof(intv.stic.gfx->y_blank), 1, f);
-    fread(&intv.stic.gfx->x_delay, sizeof(intv.stic.gfx->x_delay), 1, f);
-    fread(&intv.stic.gfx->y_delay, sizeof(intv.stic.gfx->y_delay), 1, f);
-    fread(&intv.stic.gfx->debug_blank, sizeof(intv.stic.gfx->debug_blank), 1, f);
+    /* -------------------------------------------------------------------- */
+    /*  Keep this frame's start, and check every frame that became final.   */
+    /* -------------------------------------------------------------------- */
+    ser_snap_save(intv->snap, netplay_slot(frame));
+
+    final = netplay_confirmed(net);
+    if (final > frame)
+        final = frame;
+    if (np.hashed + np.slots <= frame)
+        np.hashed = frame - np.slots + 1;
+    for (; np.hashed <= final; np.hashed++)
+        netplay_hash(net, np.hashed,
+                     netplay_state_hash(netplay_slot(np.hashed)));
+
+    netplay_input(frame);
+    np.frame = frame + 1;
+#endif
+}
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //9
+/* ======================================================================== */
+/*  NETPLAY_STOP     -- Go back to local play.  The session itself reports  */
+/*                      and closes in cfg_dtor.                             */
+/* ======================================================================== */
+LOCAL void netplay_stop(void)
+{
+    CONDFREE(np.state);
+    memset(&np, 0, sizeof(np));
+    intv->event.netplay = NULL;
+}
 
-    fread(&intv.stic.gfx->periph.addr_base, sizeof(intv.stic.gfx->periph.addr_base), 1, f);
-    fread(&intv.stic.gfx->periph.addr_mask, sizeof(intv.stic.gfx->periph.addr_mask), 1, f);
-    fread(&intv.stic.gfx->periph.now, sizeof(intv.stic.gfx->periph.now), 1, f);
-    fread(&intv.stic.gfx->periph.min_tick, sizeof(intv.stic.gfx->periph.min_tick), 1, f);
-    fread(&intv.stic.gfx->periph.max_tick, sizeof(intv.stic.gfx->periph.max_tick), 1, f);
-    fread(&intv.stic.gfx->periph.next_tick, sizeof(intv.stic.gfx->periph.next_tick), 1, f);
+/*
+ * ============================================================================
+ *  SAVE_STATE   -- Snapshot the machine and write it to dump.sav.
+ * ============================================================================
+ */
+void save_state(void)
+{
+#ifdef NO_SERIALIZER
+    jzp_printf("Save states are not supported in this build.\n");
+#else
+    ser_snap_t *const snap = snap_plan();
+    FILE *f;
+    double t0, t1;
 
-    fread(&intv.stic.gfx->periph.next_tick, sizeof(intv.stic.gfx->periph.next_tick), 1, f);
+    if (!snap)
+        return;
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //9
+    t0 = get_time();
+    ser_snap_save(snap, snap->arena);
+    t1 = get_time();
 
-#if 0
-	for (k=0; k<32; k++) {
-        fread(&intv.exec.banksw[k], sizeof(intv.exec.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fread(&intv.exec2.banksw[k], sizeof(intv.exec2.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fread(&intv.sys_ram.banksw[k], sizeof(intv.sys_ram.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fread(&intv.sys_ram2.banksw[k], sizeof(intv.sys_ram2.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fread(&intv.scr_ram.banksw[k], sizeof(intv.scr_ram.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fread(&intv.glt_ram.banksw[k], sizeof(intv.glt_ram.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fread(&intv.game0.banksw[k], sizeof(intv.game0.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fread(&intv.game1.banksw[k], sizeof(intv.game1.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fread(&intv.game2.banksw[k], sizeof(intv.game2.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fread(&intv.ecs0.banksw[k], sizeof(intv.ecs0.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fread(&intv.ecs1.banksw[k], sizeof(intv.ecs1.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fread(&intv.ecs2.banksw[k], sizeof(intv.ecs2.banksw[k]), 1, f);
-	}
-	for (k=0; k<32; k++) {
-        fread(&intv.ecs_ram.banksw[k], sizeof(intv.ecs_ram.banksw[k]), 1, f);
-	}
-#endif
+    if (!(f = fopen("dump.sav", "wb")))
+    {
+        perror("fopen(\"dump.sav\", \"wb\")");
+        return;
+    }
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //10
+    if (ser_snap_write(snap, snap->arena, f))
+    {
+        perror("fwrite(\"dump.sav\")");
+        fclose(f);
+        return;
+    }
+    fclose(f);
 
-	for (k=0; k<4096 + 256; k++) {
-        fread(&intv.exec_img[k], sizeof(intv.exec_img[k]), 1, f);
-	}
-	for (k=0; k<2048; k++) {
-        fread(&intv.grom_img[k], sizeof(intv.grom_img[k]), 1, f);
-	}
-	for (k=0; k<4096 * 3; k++) {
-        fread(&intv.ecs_img[k], sizeof(intv.ecs_img[k]), 1, f);
-	}
+    jzp_printf("Saved %u bytes of state to dump.sav "
+               "(%d copies, %.1f usec)\n",
+               snap->size, snap->copy_cnt, (t1 - t0) * 1e6);
+#endif
+}
 
-	fread(phase, sizeof(phase)-1, 1, f);
-	jzp_printf("phase read: %s\n", phase); //10
+/*
+ * ============================================================================
+ *  LOAD_DUMP    -- Read dump.sav back into the machine.  The file is fully
+ *                  validated before anything is restored, so a bad file
+ *                  leaves the running game untouched.
+ * ============================================================================
+ */
+void load_dump(void)
+{
+#ifdef NO_SERIALIZER
+    jzp_printf("Save states are not supported in this build.\n");
+#else
+    ser_snap_t *const snap = snap_plan();
+    FILE *f;
+    int err;
+    double t0, t1;
 
+    if (!snap)
+        return;
 
-    // Get periph's notion of 'now'
-    fread(&intv.intv->periph.now, sizeof(intv.intv->periph.now), 1, f);
+    if (!(f = fopen("dump.sav", "rb")))
+    {
+        perror("fopen(\"dump.sav\", \"rb\")");
+        return;
+    }
 
+    err = ser_snap_read(snap, snap->arena, f);
     fclose(f);
 
-	save_state(1);
+    if (err)
+    {
+        jzp_printf("Not loading dump.sav.\n");
+        return;
+    }
 
-    // Force display refreshes everywhere
-    stic_resync(&(intv.stic));
-    gfx_resync(&(intv.gfx));
+    t0 = get_time();
+    ser_snap_restore(snap, snap->arena);
+    t1 = get_time();
 
-    // Force time to resync
-    speed_resync(&(intv.speed));
+    snap_resync(true);
 
-	jzp_printf("load ended\n");
+    jzp_printf("Loaded %u bytes of state from dump.sav (%.1f usec)\n",
+               snap->size, (t1 - t0) * 1e6);
 #endif
 }
 
@@ -24,6 +24,10 @@
 #include "pads/pads_cgc.h"
 #include "pads/pads_intv2pc.h"
 #include "avi/avi.h"
+#include "strm/strm.h"
+#include "rewind/rewind.h"
+#include "event/event_log.h"
+#include "netplay/netplay.h"
 #include "gfx/gfx.h"
 #include "gfx/palette.h"
 #include "snd/snd.h"
@@ -37,6 +41,7 @@
 #include "jlp/jlp.h"
 #include "locutus/locutus_adapt.h"
 #include "cheat/cheat.h"
+#include "prof/prof.h"
 #include "cfg/mapping.h"
 #include "cfg/cfg.h"
 
@@ -0,0 +1,88 @@
+/*
+ * ============================================================================
+ *  Title:    Launch Descriptor
+ * ============================================================================
+ *  An embedding front end can describe the game to run as a structure
+ *  rather than as a command line.  The fields below are the options a
+ *  launcher always sets; anything else still goes through argv, and is
+ *  parsed after the fields, so it can override them.
+ *
+ *  With 'warm' set, jzIntv keeps the platform init and the audio device
+ *  (paused) when it returns, and the next warm launch reuses them.  The
+ *  front end must not shut SDL down while jzintv_is_warm() says so;
+ *  jzintv_warm_release() lets go of all of it.
+ * ============================================================================
+ */
+#ifndef LAUNCH_H_
+#define LAUNCH_H_
+
+typedef struct jzintv_launch_t
+{
+    const char *fn_exec;        /* EXEC image (-e)                          */
+    const char *fn_grom;        /* GROM image (-g)                          */
+    const char *fn_game;        /* Game image                               */
+    const char *rom_path;       /* ROM search path (-p), or NULL            */
+    const char *disp_res;       /* Display resolution (-z), or NULL         */
+    const char *kbdhackfile;    /* --kbdhackfile, or NULL                   */
+    const char *gfx_palette;    /* --gfx-palette, or NULL                   */
+    const char *ecs_tape;       /* --ecs-tape, or NULL                      */
+    const char *jlp_savegame;   /* --jlp-savegame, or NULL                  */
+    int         gram_size;      /* -G, or -1 for automatic                  */
+    int         fullscreen;     /* --fullscreen                             */
+    int         enable_mouse;   /* --enable-mouse                           */
+    int         warm;           /* Keep the warm state for the next launch  */
+    int         argc;           /* Remaining flags; argv[0] is the program  */
+    char      **argv;           /* name and isn't looked at.                */
+    double      request_time;   /* get_time() of the user's request, or 0.  */
+} jzintv_launch_t;
+
+/* ======================================================================== */
+/*  JZINTV_STATS_T       -- How a run went.  The hashes are CRC32s of the   */
+/*                          frames and audio of a --max-frames run, and 0   */
+/*                          otherwise; 'frames' counts the frames hashed.   */
+/*                          'fault' is a DEBUG_xxx code from debug_if.h,    */
+/*                          or 0 if the game ran cleanly.                   */
+/* ======================================================================== */
+typedef struct jzintv_stats_t
+{
+    uint64_t    cycles;         /* CPU cycles run                           */
+    uint64_t    instrs;         /* CPU instructions executed                */
+    uint32_t    frames;         /* Frames output                            */
+    uint32_t    vid_hash;       /* CRC32 of the frames                      */
+    uint32_t    snd_hash;       /* CRC32 of the audio samples               */
+    int         fault;          /* Fault at exit, if any                    */
+    double      run_ms;         /* Wall time from start to exit             */
+} jzintv_stats_t;
+
+/* ======================================================================== */
+/*  JZINTV_LAUNCH        -- Run a game described by 'launch'.  Returns as   */
+/*                          jzintv_entry_point does.                        */
+/*  JZINTV_IS_WARM       -- Non-zero while warm state is held.              */
+/*  JZINTV_WARM_RELEASE  -- Close and free everything kept warm.            */
+/*  JZINTV_LAUNCH_MS     -- Milliseconds from the request to the first      */
+/*                          frame of the last launch, or 0 if unknown.      */
+/*  JZINTV_LAST_STATS    -- Stats of the last run on the calling thread.    */
+/*                          Zeroed if it didn't get as far as running.      */
+/* ======================================================================== */
+int    jzintv_launch(const jzintv_launch_t *const launch);
+int    jzintv_is_warm(void);
+void   jzintv_warm_release(void);
+double jzintv_launch_ms(void);
+void   jzintv_last_stats(jzintv_stats_t *const stats);
+
+#endif
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
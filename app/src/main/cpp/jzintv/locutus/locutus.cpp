@@ -19,8 +19,8 @@
 using namespace std;
 extern "C"
 {
-    extern int jlp_accel_on;
-    extern int lto_isa_enabled;
+    extern THREAD_LOCAL int jlp_accel_on;
+    extern THREAD_LOCAL int lto_isa_enabled;
 }
 
 // ------------------------------------------------------------------------ //
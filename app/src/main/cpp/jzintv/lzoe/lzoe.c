@@ -6,12 +6,13 @@
 #include "minilzo/minilzo.h"
 #include "lzoe/lzoe.h"
 
-LZFILE            lzfile[MAX_LZOE_OPEN];
+/* Open files are per thread; the directory is registered once, up front. */
+LOCAL THREAD_LOCAL LZFILE lzfile[MAX_LZOE_OPEN];
 LOCAL lzoe_directory    *directory    = NULL;
 LOCAL int               directory_len = 0;
 
 #if LZO1X_MEM_DECOMPRESS > 0
-LOCAL uint8_t           lzo_wrk[ LZO1X_MEM_DECOMPRESS ];
+LOCAL THREAD_LOCAL uint8_t lzo_wrk[ LZO1X_MEM_DECOMPRESS ];
 #else
 #   define lzo_wrk NULL
 #endif
@@ -19,10 +19,22 @@
 #include "cp1600/cp1600.h"
 #include "serializer/serializer.h"
 
-extern int jlp_accel_on;    /* A bit of a hack */
+extern THREAD_LOCAL int jlp_accel_on;    /* A bit of a hack */
 
 LOCAL void mem_ser_init(periph_t *const p);     /* forward decl */
 
+/*
+ * ============================================================================
+ *  MEM_MARK_DIRTY -- Note a write to 'addr', if we're tracking writes.
+ * ============================================================================
+ */
+LOCAL INLINE void mem_mark_dirty(mem_t *const mem, const uint32_t addr)
+{
+    if (mem->dirty)
+        mem->dirty[addr >> (MEM_DIRTY_SHIFT + 5)] |=
+            1u << ((addr >> MEM_DIRTY_SHIFT) & 31);
+}
+
 /*
  * ============================================================================
  *  MEM_RD_8     -- Reads from an 8-bit memory.
@@ -98,6 +110,7 @@ LOCAL void mem_wr_8(periph_t *const per, periph_t *ign,
     UNUSED(ign);
     if ( mem->chk_jlp && jlp_accel_on ) return;
     mem->image[addr] = data & 0xFF;
+    mem_mark_dirty(mem, addr);
 }
 
 LOCAL void mem_wr_10(periph_t *const per, periph_t *ign,
@@ -107,6 +120,7 @@ LOCAL void mem_wr_10(periph_t *const per, periph_t *ign,
     UNUSED(ign);
     if ( mem->chk_jlp && jlp_accel_on ) return;
     mem->image[addr] = data & 0x3FF;
+    mem_mark_dirty(mem, addr);
 }
 
 LOCAL void mem_wr_16(periph_t *const per, periph_t *ign,
@@ -116,6 +130,7 @@ LOCAL void mem_wr_16(periph_t *const per, periph_t *ign,
     UNUSED(ign);
     if ( mem->chk_jlp && jlp_accel_on ) return;
     mem->image[addr] = data;
+    mem_mark_dirty(mem, addr);
 }
 
 LOCAL void mem_wr_g16(periph_t *const per, periph_t *ign,
@@ -126,6 +141,7 @@ LOCAL void mem_wr_g16(periph_t *const per, periph_t *ign,
     if ( mem->chk_jlp && jlp_accel_on ) return;
     if ((rand_jz() & 131071) == 3) data ^= 1u << (0xF & rand_jz());
     mem->image[addr] = data;
+    mem_mark_dirty(mem, addr);
 }
 
 LOCAL void mem_wr_gen(periph_t *const per, periph_t *ign,
@@ -135,6 +151,7 @@ LOCAL void mem_wr_gen(periph_t *const per, periph_t *ign,
     UNUSED(ign);
     if ( mem->chk_jlp && jlp_accel_on ) return;
     mem->image[addr] = data & mem->data_mask;
+    mem_mark_dirty(mem, addr);
 }
 
 /*
@@ -209,6 +226,7 @@ LOCAL void mem_wr_p16w(periph_t *const per, periph_t *ign,
     if ( mem->page == mem->page_sel )
     {
         mem->image[addr] = data & mem->data_mask;
+        mem_mark_dirty(mem, addr);
         if (mem->cpu)
         {
             const uint16_t full_addr = addr | mem->periph.addr_base;
@@ -229,6 +247,7 @@ LOCAL void mem_pk_p16(periph_t *const per, periph_t *ign,
     if ( mem->page == mem->page_sel )
     {
         mem->image[addr] = data & mem->data_mask;
+        mem_mark_dirty(mem, addr);
         if (mem->cpu)
         {
             const uint16_t full_addr = addr | mem->periph.addr_base;
@@ -250,6 +269,14 @@ LOCAL void mem_ram_dtor(periph_t *const per)
 {
     mem_t *const mem = PERIPH_AS(mem_t, per);
     CONDFREE(mem->image);
+    CONDFREE(mem->dirty);
+}
+
+/* For memories whose image someone else owns, such as paged RAM.           */
+LOCAL void mem_dirty_dtor(periph_t *const per)
+{
+    mem_t *const mem = PERIPH_AS(mem_t, per);
+    CONDFREE(mem->dirty);
 }
 
 /*
@@ -543,6 +570,92 @@ int mem_make_glitch_ram
 }
 
 
+/*
+ * ============================================================================
+ *  MEM_TRACK_DIRTY  -- Start or stop recording which pages get written.
+ * ============================================================================
+ */
+int mem_track_dirty
+(
+    mem_t          *mem,        /*  Memory to (stop) tracking.      */
+    int             enable      /*  Flag: Track writes?             */
+)
+{
+    const uint32_t words = (mem_dirty_pages(mem) + 31) >> 5;
+
+    if (!enable)
+    {
+        CONDFREE(mem->dirty);
+        return 0;
+    }
+
+    if (!mem->periph.write || !mem->image)
+        return -1;
+
+    if (!mem->dirty && !(mem->dirty = CALLOC(uint32_t, words)))
+        return -1;
+
+    memset(mem->dirty, 0xFF, words * sizeof(uint32_t));
+
+    if (!mem->periph.dtor)
+        mem->periph.dtor = mem_dirty_dtor;
+
+    return 0;
+}
+
+/*
+ * ============================================================================
+ *  MEM_DIRTY_PAGES  -- Number of pages (bits) in the memory's bitmap.
+ * ============================================================================
+ */
+uint32_t mem_dirty_pages
+(
+    const mem_t    *mem         /*  Memory to query.                */
+)
+{
+    return (mem->periph.addr_mask + MEM_DIRTY_WORDS) >> MEM_DIRTY_SHIFT;
+}
+
+/*
+ * ============================================================================
+ *  MEM_FETCH_DIRTY  -- Copy out the bitmap; optionally clear it.
+ * ============================================================================
+ */
+uint32_t mem_fetch_dirty
+(
+    mem_t          *mem,        /*  Memory to query.                */
+    uint32_t       *bits,       /*  Where to copy bitmap, or NULL.  */
+    int             clear       /*  Flag: Clear bitmap afterwards?  */
+)
+{
+    const uint32_t pages = mem_dirty_pages(mem);
+    const uint32_t words = (pages + 31) >> 5;
+    uint32_t i, count = 0;
+
+    if (!mem->dirty)
+        return 0;
+
+    /* Tracking starts all-ones, so mask off bits past the last page.       */
+    for (i = 0; i < words; i++)
+    {
+        uint32_t w = mem->dirty[i];
+
+        if (i == words - 1 && (pages & 31))
+            w &= ~((~0U) << (pages & 31));
+
+        if (bits)
+            bits[i] = w;
+
+        for (; w; w &= w - 1)
+            count++;
+    }
+
+    if (clear)
+        memset(mem->dirty, 0, words * sizeof(uint32_t));
+
+    return count;
+}
+
 /*
  * ============================================================================
  *  MEM_SER_INIT
@@ -571,6 +684,11 @@ LOCAL void mem_ser_init(periph_t *const p)
                      SER_MAND|SER_HEX);
         ser_register(hier, "page_sel", &mem->page_sel, ser_u8, 1,
                      SER_MAND|SER_HEX);
+
+        /* Paged RAM also needs its contents; paged ROM does not. */
+        if (p->write == mem_wr_p16w)
+            ser_register(hier, "image", mem->image, ser_u16,
+                         p->addr_mask + 1, SER_MAND|SER_HEX);
     } else
     {
         ser_register(hier, "image", mem->image, ser_u16, mem->img_length,
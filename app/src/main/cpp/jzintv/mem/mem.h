@@ -32,8 +32,16 @@ typedef struct mem_t
     uint8_t     chk_jlp;    /*  Flag: If set, need to check jlp_accel_on    */
     uint32_t    img_length; /*  Actual length of memory image.              */
     void       *cpu;        /*  CPU pointer for handling caching.           */
+    uint32_t   *dirty;      /*  Dirty page bitmap, if tracking writes.      */
 } mem_t;
 
+/* ------------------------------------------------------------------------ */
+/*  Dirty pages are 64 words.  Bit N of the bitmap covers words N*64 to     */
+/*  N*64+63 of the image, packed 32 to a uint32_t, LSB first.               */
+/* ------------------------------------------------------------------------ */
+#define MEM_DIRTY_SHIFT (6)
+#define MEM_DIRTY_WORDS (1u << MEM_DIRTY_SHIFT)
+
 
 /*
  * ============================================================================
@@ -103,6 +111,39 @@ int mem_make_glitch_ram
     int             randomize   /*  Flag: Randomize on init         */
 );
 
+/*
+ * ============================================================================
+ *  MEM_TRACK_DIRTY  -- Start or stop recording which pages get written.
+ *                      Tracking starts with every page dirty.  Only
+ *                      writable memories can be tracked.  Snapshot
+ *                      restores bypass the write path, so call this
+ *                      again after one to mark everything dirty.
+ *                      Returns 0 on success, -1 on failure.
+ *  MEM_DIRTY_PAGES  -- Number of pages (bits) in the memory's bitmap.
+ *  MEM_FETCH_DIRTY  -- Copy the bitmap into 'bits' (if not NULL), which
+ *                      must hold (pages + 31) / 32 words.  If 'clear',
+ *                      start over with every page clean.  Returns the
+ *                      number of dirty pages.
+ * ============================================================================
+ */
+int mem_track_dirty
+(
+    mem_t          *mem,        /*  Memory to (stop) tracking.      */
+    int             enable      /*  Flag: Track writes?             */
+);
+
+uint32_t mem_dirty_pages
+(
+    const mem_t    *mem         /*  Memory to query.                */
+);
+
+uint32_t mem_fetch_dirty
+(
+    mem_t          *mem,        /*  Memory to query.                */
+    uint32_t       *bits,       /*  Where to copy bitmap, or NULL.  */
+    int             clear       /*  Flag: Clear bitmap afterwards?  */
+);
+
 #endif
 
 /* ======================================================================== */
@@ -114,6 +114,328 @@ uint32_t crc32_upd32(uint32_t crc, uint32_t data)
     return crc;
 }
 
+/* ======================================================================== */
+/*  Hardware engines.  These are compiled with per-function target          */
+/*  attributes, so the rest of the program needn't be, and only used once   */
+/*  the CPU says it has the instructions.                                   */
+/* ======================================================================== */
+#if defined(__GNUC__) && !defined(__EMSCRIPTEN__) && \
+    (defined(__x86_64__) || defined(__i386__))
+# define CRC32_HAVE_PCLMUL
+# include <cpuid.h>
+# include <emmintrin.h>
+# include <wmmintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__)
+# define CRC32_HAVE_ARMV8
+# include <arm_acle.h>
+# if defined(__linux__)
+#  include <sys/auxv.h>
+# endif
+# ifdef __clang__
+#  define CRC32_TARGET_CRC __attribute__((target("crc")))
+# else
+#  define CRC32_TARGET_CRC __attribute__((target("+crc")))
+# endif
+#endif
+
+typedef uint32_t crc32_fn_t(uint32_t crc, const uint8_t *data, size_t len);
+
+/* ======================================================================== */
+/*  CRC32_SLICE  -- Slicing tables.  crc32_slice[k][n] is the CRC of byte   */
+/*                  n followed by k zero bytes, so [0] is crc32_tbl.        */
+/* ======================================================================== */
+static uint32_t crc32_slice[16][256];
+
+#define CRC32_LE32(p) ((uint32_t)(p)[0]       | (uint32_t)(p)[1] <<  8 | \
+                       (uint32_t)(p)[2] << 16 | (uint32_t)(p)[3] << 24)
+
+static uint32_t crc32_bytewise(uint32_t crc, const uint8_t *data, size_t len)
+{
+    while (len-- > 0)
+        crc = (crc >> 8) ^ crc32_tbl[(crc ^ *data++) & 0xFF];
+
+    return crc;
+}
+
+static uint32_t crc32_slice8(uint32_t crc, const uint8_t *data, size_t len)
+{
+    const uint32_t (*const t)[256] = (const uint32_t (*)[256])crc32_slice;
+
+    for (; len >= 8; len -= 8, data += 8)
+    {
+        const uint32_t a = crc ^ CRC32_LE32(data);
+        const uint32_t b = CRC32_LE32(data + 4);
+
+        crc = t[7][a       & 0xFF] ^ t[6][a >>  8 & 0xFF] ^
+              t[5][a >> 16 & 0xFF] ^ t[4][a >> 24       ] ^
+              t[3][b       & 0xFF] ^ t[2][b >>  8 & 0xFF] ^
+              t[1][b >> 16 & 0xFF] ^ t[0][b >> 24       ];
+    }
+
+    return crc32_bytewise(crc, data, len);
+}
+
+static uint32_t crc32_slice16(uint32_t crc, const uint8_t *data, size_t len)
+{
+    const uint32_t (*const t)[256] = (const uint32_t (*)[256])crc32_slice;
+
+    for (; len >= 16; len -= 16, data += 16)
+    {
+        const uint32_t a = crc ^ CRC32_LE32(data);
+        const uint32_t b = CRC32_LE32(data +  4);
+        const uint32_t c = CRC32_LE32(data +  8);
+        const uint32_t d = CRC32_LE32(data + 12);
+
+        crc = t[15][a       & 0xFF] ^ t[14][a >>  8 & 0xFF] ^
+              t[13][a >> 16 & 0xFF] ^ t[12][a >> 24       ] ^
+              t[11][b       & 0xFF] ^ t[10][b >>  8 & 0xFF] ^
+              t[ 9][b >> 16 & 0xFF] ^ t[ 8][b >> 24       ] ^
+              t[ 7][c       & 0xFF] ^ t[ 6][c >>  8 & 0xFF] ^
+              t[ 5][c >> 16 & 0xFF] ^ t[ 4][c >> 24       ] ^
+              t[ 3][d       & 0xFF] ^ t[ 2][d >>  8 & 0xFF] ^
+              t[ 1][d >> 16 & 0xFF] ^ t[ 0][d >> 24       ];
+    }
+
+    return crc32_bytewise(crc, data, len);
+}
+
+#ifdef CRC32_HAVE_PCLMUL
+/* ======================================================================== */
+/*  CRC32_PCLMUL -- Fold 64 bytes at a time with carry-less multiplies,     */
+/*                  then Barrett-reduce to 32 bits.  This is the method in  */
+/*  Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ"  */
+/*  paper, with its bit-reflected constants for the CRC-32 polynomial.      */
+/*  The fold wants at least 64 bytes and a multiple of 16; slicing does     */
+/*  whatever is left over.                                                  */
+/* ======================================================================== */
+__attribute__((target("sse2,pclmul")))
+static uint32_t crc32_pclmul(uint32_t crc, const uint8_t *data, size_t len)
+{
+    const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596LL, 0x0154442BD4LL);
+    const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009ELL, 0x01751997D0LL);
+    const __m128i k5k0 = _mm_set_epi64x(0,              0x0163CD6124LL);
+    const __m128i poly = _mm_set_epi64x(0x01F7011641LL, 0x01DB710641LL);
+    const __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+    __m128i x1, x2, x3, x4;
+    size_t tail;
+
+    if (len < 64)
+        return crc32_slice16(crc, data, len);
+
+    tail = len & 15;
+    len -= tail;
+
+    x1 = _mm_loadu_si128((const __m128i *)(data + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *)(data + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *)(data + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *)(data + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    data += 64;
+    len  -= 64;
+
+    /* -------------------------------------------------------------------- */
+    /*  Four independent folds per 64 bytes.                                */
+    /* -------------------------------------------------------------------- */
+#define CRC32_FOLD(x, k, y) \
+    _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128((x), (k), 0x00),   \
+                                _mm_clmulepi64_si128((x), (k), 0x11)),  \
+                  (y))
+    for (; len >= 64; len -= 64, data += 64)
+    {
+        x1 = CRC32_FOLD(x1, k1k2,
+                        _mm_loadu_si128((const __m128i *)(data + 0x00)));
+        x2 = CRC32_FOLD(x2, k1k2,
+                        _mm_loadu_si128((const __m128i *)(data + 0x10)));
+        x3 = CRC32_FOLD(x3, k1k2,
+                        _mm_loadu_si128((const __m128i *)(data + 0x20)));
+        x4 = CRC32_FOLD(x4, k1k2,
+                        _mm_loadu_si128((const __m128i *)(data + 0x30)));
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Down to 128 bits, then any remaining 16 byte blocks.                */
+    /* -------------------------------------------------------------------- */
+    x1 = CRC32_FOLD(x1, k3k4, x2);
+    x1 = CRC32_FOLD(x1, k3k4, x3);
+    x1 = CRC32_FOLD(x1, k3k4, x4);
+
+    for (; len >= 16; len -= 16, data += 16)
+        x1 = CRC32_FOLD(x1, k3k4, _mm_loadu_si128((const __m128i *)data));
+#undef CRC32_FOLD
+
+    /* -------------------------------------------------------------------- */
+    /*  128 bits to 64, then Barrett reduction to 32.                       */
+    /* -------------------------------------------------------------------- */
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask);
+    x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x2 = _mm_and_si128(x1, mask);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+    x2 = _mm_and_si128(x2, mask);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    crc = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+
+    return crc32_slice16(crc, data, tail);
+}
+
+static int crc32_pclmul_ok(void)
+{
+    unsigned eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    return (ecx & bit_PCLMUL) && (edx & bit_SSE2);
+}
+#endif
+
+#ifdef CRC32_HAVE_ARMV8
+/* ======================================================================== */
+/*  CRC32_ARMV8  -- The ARMv8 CRC32 instructions use the same polynomial    */
+/*                  and bit order as we do, so this is a straight loop.     */
+/* ======================================================================== */
+CRC32_TARGET_CRC
+static uint32_t crc32_armv8(uint32_t crc, const uint8_t *data, size_t len)
+{
+    for (; len > 0 && ((uintptr_t)data & 7); len--)
+        crc = __crc32b(crc, *data++);
+
+    for (; len >= 32; len -= 32, data += 32)
+    {
+        crc = __crc32d(crc, *(const uint64_t *)(data +  0));
+        crc = __crc32d(crc, *(const uint64_t *)(data +  8));
+        crc = __crc32d(crc, *(const uint64_t *)(data + 16));
+        crc = __crc32d(crc, *(const uint64_t *)(data + 24));
+    }
+
+    for (; len >= 8; len -= 8, data += 8)
+        crc = __crc32d(crc, *(const uint64_t *)data);
+
+    for (; len > 0; len--)
+        crc = __crc32b(crc, *data++);
+
+    return crc;
+}
+
+static int crc32_armv8_ok(void)
+{
+# if defined(__ARM_FEATURE_CRC32) || defined(__APPLE__)
+    return 1;
+# elif defined(__linux__) && defined(HWCAP_CRC32)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+# else
+    return 0;
+# endif
+}
+#endif
+
+/* ======================================================================== */
+/*  CRC32_ENGINES -- What we have, slowest to fastest.                      */
+/* ======================================================================== */
+static const struct
+{
+    const char *name;
+    crc32_fn_t *fn;
+} crc32_engines[CRC32_NUM_ENGINES] =
+{
+    { "bytewise", crc32_bytewise },
+    { "slice8",   crc32_slice8   },
+    { "slice16",  crc32_slice16  },
+#ifdef CRC32_HAVE_PCLMUL
+    { "pclmul",   crc32_pclmul   },
+#else
+    { "pclmul",   NULL           },
+#endif
+#ifdef CRC32_HAVE_ARMV8
+    { "armv8",    crc32_armv8    },
+#else
+    { "armv8",    NULL           },
+#endif
+};
+
+static crc32_fn_t *crc32_fn = NULL;
+static crc32_engine_t crc32_cur = CRC32_BYTEWISE;
+static int crc32_hw[CRC32_NUM_ENGINES];
+
+/* ======================================================================== */
+/*  CRC32_INIT   -- Build the slicing tables and pick the best engine.      */
+/*                  With GCC and friends this runs before main(), so the    */
+/*                  threads that hash ROMs never race to do it.             */
+/* ======================================================================== */
+#ifdef __GNUC__
+__attribute__((constructor))
+#endif
+static void crc32_init(void)
+{
+    int i, k;
+
+    for (i = 0; i < 256; i++)
+        crc32_slice[0][i] = crc32_tbl[i];
+
+    for (k = 1; k < 16; k++)
+        for (i = 0; i < 256; i++)
+        {
+            const uint32_t c = crc32_slice[k - 1][i];
+            crc32_slice[k][i] = (c >> 8) ^ crc32_tbl[c & 0xFF];
+        }
+
+    crc32_hw[CRC32_BYTEWISE] = 1;
+    crc32_hw[CRC32_SLICE8]   = 1;
+    crc32_hw[CRC32_SLICE16]  = 1;
+#ifdef CRC32_HAVE_PCLMUL
+    crc32_hw[CRC32_PCLMUL]   = crc32_pclmul_ok();
+#endif
+#ifdef CRC32_HAVE_ARMV8
+    crc32_hw[CRC32_ARMV8]    = crc32_armv8_ok();
+#endif
+
+    for (k = CRC32_NUM_ENGINES - 1; !crc32_hw[k]; k--)
+        ;
+    crc32_cur = (crc32_engine_t)k;
+    crc32_fn  = crc32_engines[k].fn;
+}
+
+/* ======================================================================== */
+/*  CRC32_SET_ENGINE  -- Use 'engine' for crc32_block from now on.          */
+/*  CRC32_GET_ENGINE  -- The engine crc32_block is using.                   */
+/*  CRC32_ENGINE_NAME -- A short name for 'engine'.                         */
+/* ======================================================================== */
+int crc32_set_engine(crc32_engine_t engine)
+{
+    if (!crc32_fn)
+        crc32_init();
+
+    if ((unsigned)engine >= CRC32_NUM_ENGINES || !crc32_hw[engine])
+        return -1;
+
+    crc32_cur = engine;
+    crc32_fn  = crc32_engines[engine].fn;
+    return 0;
+}
+
+crc32_engine_t crc32_get_engine(void)
+{
+    if (!crc32_fn)
+        crc32_init();
+
+    return crc32_cur;
+}
+
+const char *crc32_engine_name(crc32_engine_t engine)
+{
+    return (unsigned)engine < CRC32_NUM_ENGINES ? crc32_engines[engine].name
+                                                : "unknown";
+}
+
 /* ======================================================================== */
 /*  CRC32_BLOCK  -- Updates a 32-bit CRC on a block of 8-bit data.          */
 /*                  Note:  The 32-bit CRC is set up as a right-shifting     */
@@ -121,12 +443,13 @@ uint32_t crc32_upd32(uint32_t crc, uint32_t data)
 /* ======================================================================== */
 uint32_t crc32_block(uint32_t crc, const uint8_t *data, int len)
 {
-    int i;
+    if (len <= 0)
+        return crc;
 
-    for (i = 0; i < len; i++)
-        crc = (crc >> 8) ^ crc32_tbl[(crc ^ data[i]) & 0xFF];
+    if (!crc32_fn)
+        crc32_init();
 
-    return crc;
+    return crc32_fn(crc, data, (size_t)len);
 }
 
 /* ======================================================================== */
@@ -50,9 +50,39 @@ uint32_t crc32_upd32(uint32_t crc, uint32_t data);
 /*  CRC32_BLOCK  -- Updates a 32-bit CRC on a block of 8-bit data.          */
 /*                  Note:  The 32-bit CRC is set up as a right-shifting     */
 /*                  CRC with no inversions.                                 */
+/*                                                                          */
+/*                  Large blocks go through the fastest engine this CPU     */
+/*                  supports:  carry-less multiply folding on x86, the      */
+/*                  CRC32 instructions on ARMv8, slicing-by-16 elsewhere.   */
+/*                  Safe to call from several threads at once.              */
 /* ======================================================================== */
 uint32_t crc32_block(uint32_t crc, const uint8_t *data, int len);
 
+/* ======================================================================== */
+/*  CRC32_ENGINE_T -- The ways crc32_block can compute the CRC.  They all   */
+/*                    give the same result; only the speed differs.         */
+/* ======================================================================== */
+typedef enum crc32_engine_t
+{
+    CRC32_BYTEWISE,         /* One table lookup per byte.                   */
+    CRC32_SLICE8,           /* Eight tables, eight bytes per step.          */
+    CRC32_SLICE16,          /* Sixteen tables, sixteen bytes per step.      */
+    CRC32_PCLMUL,           /* x86 PCLMULQDQ folding, 64 bytes per step.    */
+    CRC32_ARMV8,            /* ARMv8 CRC32X, eight bytes per instruction.   */
+    CRC32_NUM_ENGINES
+} crc32_engine_t;
+
+/* ======================================================================== */
+/*  CRC32_SET_ENGINE  -- Use 'engine' for crc32_block from now on.  Returns */
+/*                       -1 if this build or CPU doesn't support it.  The   */
+/*                       best one is picked automatically at startup.       */
+/*  CRC32_GET_ENGINE  -- The engine crc32_block is using.                   */
+/*  CRC32_ENGINE_NAME -- A short name for 'engine'.                         */
+/* ======================================================================== */
+int            crc32_set_engine (crc32_engine_t engine);
+crc32_engine_t crc32_get_engine (void);
+const char    *crc32_engine_name(crc32_engine_t engine);
+
 #endif
 /* ======================================================================== */
 /*     This specific file is placed in the public domain by its author,     */
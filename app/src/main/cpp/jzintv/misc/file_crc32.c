@@ -3,24 +3,39 @@
 #include "misc/file_crc32.h"
 #include "lzoe/lzoe.h"
 
+#define FILE_CRC32_BUF (64 * 1024)
+
 /* ======================================================================== */
-/*  FILE_CRC32   -- Return the CRC-32 for a file.                           */
+/*  FILE_CRC32   -- Return the CRC-32 for a file.  Reads in large blocks,   */
+/*                  so crc32_block's fast engines get to do the work.       */
+/*                  Files are opened through lzoe, whose table of open      */
+/*                  files has no lock and is only per-thread where we have  */
+/*                  THREAD_LOCAL, so call this from one thread at a time.   */
 /* ======================================================================== */
 uint32_t file_crc32(const char *fname)
 {
-    LZFILE *f;
+    LZFILE *f = NULL;
     uint32_t crc = 0xFFFFFFFFU;
-    int c;
+    uint8_t spare[1024], *buf;
+    size_t buf_len = FILE_CRC32_BUF, len;
 
-    if (fname == NULL)
-        f = (LZFILE *)stdin;  // so hack, much wow.
-    else if (!(f = lzoe_fopen(fname, "rb")))
+    if (fname && !(f = lzoe_fopen(fname, "rb")))
         return crc;
 
-    while ((c = lzoe_fgetc(f)) != EOF)
-        crc = crc32_update(crc, c & 0xFF);
+    if (!(buf = (uint8_t *)malloc(buf_len)))
+    {
+        buf     = spare;
+        buf_len = sizeof(spare);
+    }
+
+    while ((len = f ? lzoe_fread(buf, 1, buf_len, f)
+                    : fread(buf, 1, buf_len, stdin)) > 0)
+        crc = crc32_block(crc, buf, (int)len);
+
+    if (buf != spare)
+        free(buf);
 
-    if (fname)
+    if (f)
         lzoe_fclose(f);
 
     return crc ^ 0xFFFFFFFFU;
@@ -467,8 +467,8 @@ static const char *must_quote =
 static const char *cfg_escquote_impl( const char *const str, 
                                       const int add_quotes )
 {
-    static unsigned char *buf = NULL;
-    static unsigned buf_sz = 0;
+    static THREAD_LOCAL unsigned char *buf = NULL;
+    static THREAD_LOCAL unsigned buf_sz = 0;
     const unsigned char *si;
     unsigned char *so;
     size_t req_sz = 3;
@@ -549,8 +549,8 @@ static const char *cfg_escquote_impl( const char *const str,
 static const char *cfg_unescquote_impl( const char *const str, 
                                         const int remove_quotes )
 {
-    static unsigned char *buf = NULL;
-    static unsigned buf_sz = 0;
+    static THREAD_LOCAL unsigned char *buf = NULL;
+    static THREAD_LOCAL unsigned buf_sz = 0;
     const unsigned char *si;
     unsigned char *so;
     const size_t len = strlen(str);
@@ -111,6 +111,33 @@
 /*  For uncompressed images, there's simply a x_dim * y_dim / 2 byte        */
 /*  record of packed pixels.  Pixels are packed into bytes with the         */
 /*  first pixel in bits 3..0, and the second pixel in bits 7..4.            */
+/*                                                                          */
+/*  KEYFRAME INDEX                                                          */
+/*                                                                          */
+/*  A movie may end with a keyframe index.  A keyframe is any frame that    */
+/*  is sent without a row-delta map, and so decodes without reference to    */
+/*  the previous frame.  The index is stored as one or more chunks that     */
+/*  look like frames to older decoders, but set flag bit 7.  Older          */
+/*  decoders therefore stop cleanly at the index.                           */
+/*                                                                          */
+/*      4 bytes     Total chunk length (incl. header)                       */
+/*      3 bytes     Frame number:  Always 0xFFFFFF                          */
+/*      1 byte      Flags:  Always 0x80                                     */
+/*      N*40 bytes  Index entries:                                          */
+/*                  4 bytes   Offset of frame from start of movie.  Frame   */
+/*                            0's offset points at the file header.         */
+/*                  3 bytes   Frame number                                  */
+/*                  1 byte    Reserved (0)                                  */
+/*                  32 bytes  Bounding boxes in effect at this frame        */
+/*                                                                          */
+/*  The last chunk ends with a 20 byte trailer, so that the index can be    */
+/*  found by reading the last 20 bytes of the file:                        */
+/*                                                                          */
+/*      4 bytes     Total length of all index chunks (incl. trailer)        */
+/*      4 bytes     Length of movie, not including the index                */
+/*      4 bytes     Number of index entries                                 */
+/*      4 bytes     Number of frames in movie                               */
+/*      4 bytes     Signature: 0x49 0x4D 0x56 0x58 ("IMVX")                 */
 /* ======================================================================== */
 
 
@@ -120,15 +147,35 @@
 #define FLG_RPTMAP ( 8)
 #define FLG_DLTMAP (16)
 #define FLG_LZOCMP (32)
+#define FLG_INDEX  (128)
+
+#define IDX_ENT_SZ (40)
+#define IDX_TRL_SZ (20)
+#define IDX_FR_NUM (0xFFFFFF)
 
-LOCAL uint8_t *enc_vid = NULL, *enc_buf = NULL, *enc_vid2;
+LOCAL THREAD_LOCAL uint8_t *enc_vid = NULL, *enc_buf = NULL, *enc_vid2;
 #ifndef NO_LZO
-LOCAL uint8_t *lzo_wrk = NULL, *lzo_tmp = NULL;
+LOCAL THREAD_LOCAL uint8_t *lzo_wrk = NULL, *lzo_tmp = NULL;
 #endif
-LOCAL uint32_t rowrpt[MVI_MAX_Y >> 5];
-LOCAL uint32_t rowdlt[MVI_MAX_Y >> 5];
+LOCAL THREAD_LOCAL uint32_t rowrpt[MVI_MAX_Y >> 5];
+LOCAL THREAD_LOCAL uint32_t rowdlt[MVI_MAX_Y >> 5];
 
 #define ENC_BUF_SZ (MVI_MAX_X * MVI_MAX_Y + 128)
+#define IDX_CHUNK  ((ENC_BUF_SZ - 8 - IDX_TRL_SZ) / IDX_ENT_SZ)
+
+LOCAL void put_32(uint8_t *p, uint32_t v)
+{
+    p[0] = (v >>  0) & 0xFF;
+    p[1] = (v >>  8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+LOCAL uint32_t get_32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] <<  0) | ((uint32_t)p[1] <<  8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
 
 
 /* ======================================================================== */
@@ -156,6 +203,12 @@ void mvi_init(mvi_t *movie, int x_dim, int y_dim)
     movie->fr  = 0;
     movie->f   = NULL;
 
+    movie->idx      = NULL;
+    movie->idx_cnt  = 0;
+    movie->idx_max  = 0;
+    movie->idx_base = 0;
+    movie->tot_fr   = 0;
+
     if (!enc_buf ) enc_buf  = CALLOC(uint8_t, ENC_BUF_SZ);
     if (!enc_vid ) enc_vid  = CALLOC(uint8_t, MVI_MAX_X * MVI_MAX_Y);
     if (!enc_vid2) enc_vid2 = CALLOC(uint8_t, MVI_MAX_X * MVI_MAX_Y);
@@ -172,6 +225,40 @@ void mvi_init(mvi_t *movie, int x_dim, int y_dim)
     }
 }
 
+/* ======================================================================== */
+/*  MVI_IDX_ADD:  Record a keyframe in the keyframe index.  If we run out   */
+/*                of memory, we just stop indexing.                         */
+/* ======================================================================== */
+LOCAL void mvi_idx_add(mvi_t *movie, uint32_t ofs, int fr,
+                       uint8_t bbox[8][4])
+{
+    mvi_idx_t *ent;
+
+    if (movie->idx_cnt < 0)
+        return;
+
+    if (movie->idx_cnt == movie->idx_max)
+    {
+        int new_max = movie->idx_max ? movie->idx_max * 2 : 256;
+        mvi_idx_t *new_idx = (mvi_idx_t *)realloc(movie->idx,
+                                                  new_max * sizeof(mvi_idx_t));
+        if (!new_idx)
+        {
+            fprintf(stderr, "MVI_WR: Out of memory; keyframe index "
+                            "disabled.\n");
+            movie->idx_cnt = -1;
+            return;
+        }
+        movie->idx     = new_idx;
+        movie->idx_max = new_max;
+    }
+
+    ent      = &movie->idx[movie->idx_cnt++];
+    ent->ofs = ofs;
+    ent->fr  = fr;
+    memcpy(ent->bbox, bbox, sizeof(ent->bbox));
+}
+
 /* ======================================================================== */
 /*  MVI_WR_FRAME:  Encode and write a movie frame to the movie file.        */
 /* ======================================================================== */
@@ -211,6 +298,7 @@ void mvi_wr_frame(mvi_t *movie, uint8_t *vid, uint8_t bbox[8][4])
 #ifndef NO_LZO
         movie->tot_lzosave= 0;
 #endif
+        movie->idx_cnt    = 0;
         memset(movie->vid, 0xFF, movie->x_dim * movie->y_dim); /* force 1st */
     }
 
@@ -583,6 +671,13 @@ no_rle:
     enc_hdr[6] = (movie->fr >> 16) & 0xFF;
     enc_hdr[7] = header_byte;
 
+    /* -------------------------------------------------------------------- */
+    /*  Frames sent w/out a row-delta map are keyframes.  Index them.  The  */
+    /*  bounding boxes passed in are the ones in effect after this frame.   */
+    /* -------------------------------------------------------------------- */
+    if (send_frame && !send_rowdlt)
+        mvi_idx_add(movie, movie->tot_bytes, movie->fr, bbox);
+
     /* -------------------------------------------------------------------- */
     /*  Send it all in one big fwrite.                                      */
     /* -------------------------------------------------------------------- */
@@ -680,6 +775,18 @@ again:
 
     flags = enc_buf[7];
 
+    /* -------------------------------------------------------------------- */
+    /*  Step over keyframe index chunks.  They only appear at the end of a  */
+    /*  movie, but a concatenated movie may continue after one.             */
+    /* -------------------------------------------------------------------- */
+    if (flags == FLG_INDEX && movie->fr == IDX_FR_NUM && fr_len >= 8)
+    {
+        movie->fr = movie->last_fr;
+        if (fseek(movie->f, fr_len - 8, SEEK_CUR) != 0)
+            return -1;
+        goto again;
+    }
+
 
     got_frame  = flags & FLG_FRSENT;
     got_bbox   = flags & FLG_BBSENT;
@@ -979,6 +1086,229 @@ again:
            (got_bbox  ? 0 : MVI_BB_SAME);
 }
 
+/* ======================================================================== */
+/*  MVI_WR_INDEX -- Append the keyframe index to the end of the movie.      */
+/* ======================================================================== */
+int mvi_wr_index(mvi_t *movie)
+{
+    uint32_t mov_len = movie->tot_bytes, idx_len;
+    int i, j, n, tot = 0;
+    uint8_t *enc_ptr;
+
+    if (!movie->f || movie->fr == 0 || movie->idx_cnt <= 0)
+        return 0;
+
+    idx_len = 8 * ((movie->idx_cnt + IDX_CHUNK - 1) / IDX_CHUNK)
+            + IDX_ENT_SZ * movie->idx_cnt + IDX_TRL_SZ;
+
+    for (i = 0; i < movie->idx_cnt; i += n)
+    {
+        int last;
+
+        n    = movie->idx_cnt - i > IDX_CHUNK ? IDX_CHUNK : movie->idx_cnt - i;
+        last = i + n == movie->idx_cnt;
+
+        /* ---------------------------------------------------------------- */
+        /*  Chunk header, followed by the entries themselves.               */
+        /* ---------------------------------------------------------------- */
+        enc_ptr = enc_buf + 8;
+        for (j = i; j < i + n; j++)
+        {
+            const mvi_idx_t *ent = &movie->idx[j];
+
+            put_32(enc_ptr, ent->ofs);
+            enc_ptr[4] = (ent->fr >>  0) & 0xFF;
+            enc_ptr[5] = (ent->fr >>  8) & 0xFF;
+            enc_ptr[6] = (ent->fr >> 16) & 0xFF;
+            enc_ptr[7] = 0;
+            memcpy(enc_ptr + 8, ent->bbox, 32);
+            enc_ptr += IDX_ENT_SZ;
+        }
+
+        if (last)
+        {
+            put_32(enc_ptr +  0, idx_len);
+            put_32(enc_ptr +  4, mov_len);
+            put_32(enc_ptr +  8, movie->idx_cnt);
+            put_32(enc_ptr + 12, movie->fr);
+            enc_ptr[16] = 0x49;
+            enc_ptr[17] = 0x4D;
+            enc_ptr[18] = 0x56;
+            enc_ptr[19] = 0x58;
+            enc_ptr += IDX_TRL_SZ;
+        }
+
+        put_32(enc_buf, enc_ptr - enc_buf);
+        enc_buf[4] = enc_buf[5] = enc_buf[6] = 0xFF;
+        enc_buf[7] = FLG_INDEX;
+
+        if (fwrite(enc_buf, 1, enc_ptr - enc_buf, movie->f) !=
+                (size_t)(enc_ptr - enc_buf))
+        {
+            fprintf(stderr, "MVI_WR: Error writing keyframe index\n");
+            return -1;
+        }
+        tot += enc_ptr - enc_buf;
+    }
+
+    fflush(movie->f);
+    movie->tot_bytes += tot;
+
+    return tot;
+}
+
+/* ======================================================================== */
+/*  MVI_RD_INDEX -- Load the keyframe index from the end of the movie.      */
+/* ======================================================================== */
+int mvi_rd_index(mvi_t *movie)
+{
+    uint8_t trl[IDX_TRL_SZ];
+    uint32_t idx_len, mov_len, idx_cnt, tot_fr;
+    long save_pos, end_pos, idx_pos;
+    mvi_idx_t *idx = NULL;
+    uint32_t i = 0;
+    int x_dim, y_dim;
+
+    movie->idx_cnt = 0;
+
+    if (!movie->f || (save_pos = ftell(movie->f)) < 0)
+        return -1;
+
+    /* -------------------------------------------------------------------- */
+    /*  Look for the trailer at the very end of the file.                   */
+    /* -------------------------------------------------------------------- */
+    if (fseek(movie->f, -IDX_TRL_SZ, SEEK_END) != 0 ||
+        (end_pos = ftell(movie->f)) < 0 ||
+        fread(trl, 1, IDX_TRL_SZ, movie->f) != IDX_TRL_SZ ||
+        trl[16] != 0x49 || trl[17] != 0x4D ||
+        trl[18] != 0x56 || trl[19] != 0x58)
+        goto fail;
+
+    end_pos += IDX_TRL_SZ;
+    idx_len  = get_32(trl +  0);
+    mov_len  = get_32(trl +  4);
+    idx_cnt  = get_32(trl +  8);
+    tot_fr   = get_32(trl + 12);
+    idx_pos  = end_pos - (long)idx_len;
+
+    if (idx_cnt == 0 || idx_len < 8 + IDX_TRL_SZ ||
+        idx_cnt > (idx_len - IDX_TRL_SZ) / IDX_ENT_SZ ||
+        idx_pos < (long)mov_len)
+        goto fail;
+
+    /* -------------------------------------------------------------------- */
+    /*  The movie must start with a file header.  Pick up the dimensions    */
+    /*  from it, so that we can seek before decoding any frames.            */
+    /* -------------------------------------------------------------------- */
+    if (fseek(movie->f, idx_pos - (long)mov_len, SEEK_SET) != 0 ||
+        fread(enc_buf, 1, 8, movie->f) != 8 ||
+        enc_buf[0] != 0x4A || enc_buf[1] != 0x5A ||
+        enc_buf[2] != 0x6A || enc_buf[3] != 0x7A ||
+        (enc_buf[5] << 8 | enc_buf[4]) > MVI_MAX_X ||
+        (enc_buf[7] << 8 | enc_buf[6]) > MVI_MAX_Y ||
+        fseek(movie->f, idx_pos, SEEK_SET) != 0)
+        goto fail;
+
+    x_dim = enc_buf[5] << 8 | enc_buf[4];
+    y_dim = enc_buf[7] << 8 | enc_buf[6];
+
+    if (!(idx = CALLOC(mvi_idx_t, idx_cnt)))
+        goto fail;
+
+    /* -------------------------------------------------------------------- */
+    /*  Read each chunk and unpack its entries.                             */
+    /* -------------------------------------------------------------------- */
+    while (i < idx_cnt)
+    {
+        uint32_t len, n;
+        const uint8_t *p;
+
+        if (fread(enc_buf, 1, 8, movie->f) != 8)
+            goto fail;
+
+        len = get_32(enc_buf);
+        if (enc_buf[4] != 0xFF || enc_buf[5] != 0xFF || enc_buf[6] != 0xFF ||
+            enc_buf[7] != FLG_INDEX || len < 8 || len > ENC_BUF_SZ ||
+            fread(enc_buf, 1, len - 8, movie->f) != len - 8)
+            goto fail;
+
+        n = (len - 8) / IDX_ENT_SZ;
+        if (n > idx_cnt - i)
+            n = idx_cnt - i;
+
+        for (p = enc_buf; n > 0; n--, i++, p += IDX_ENT_SZ)
+        {
+            idx[i].ofs = get_32(p);
+            idx[i].fr  = p[4] | (p[5] << 8) | (p[6] << 16);
+            memcpy(idx[i].bbox, p + 8, 32);
+
+            if (idx[i].ofs >= mov_len || (i > 0 && idx[i].fr <= idx[i-1].fr))
+                goto fail;
+        }
+    }
+
+    CONDFREE(movie->idx);
+    movie->idx      = idx;
+    movie->idx_cnt  = idx_cnt;
+    movie->idx_max  = idx_cnt;
+    movie->idx_base = idx_pos - mov_len;
+    movie->tot_fr   = tot_fr;
+    movie->x_dim    = x_dim;
+    movie->y_dim    = y_dim;
+
+    fseek(movie->f, save_pos, SEEK_SET);
+    return idx_cnt;
+
+fail:
+    CONDFREE(idx);
+    fseek(movie->f, save_pos, SEEK_SET);
+    return -1;
+}
+
+/* ======================================================================== */
+/*  MVI_SEEK -- Position the movie at the last keyframe at/before 'frame'.  */
+/* ======================================================================== */
+int mvi_seek(mvi_t *movie, int frame)
+{
+    int lo = 0, hi = movie->idx_cnt - 1;
+    const mvi_idx_t *ent;
+
+    if (!movie->f)
+        return -1;
+
+    /* -------------------------------------------------------------------- */
+    /*  No index, or asking for something before the first keyframe:        */
+    /*  start over from the top.                                            */
+    /* -------------------------------------------------------------------- */
+    if (movie->idx_cnt <= 0 || frame < movie->idx[0].fr)
+    {
+        if (fseek(movie->f, 0, SEEK_SET) != 0)
+            return -1;
+        memset(movie->bbox, 0, sizeof(movie->bbox));
+        return 0;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Binary search for the last keyframe whose number is <= frame.       */
+    /* -------------------------------------------------------------------- */
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) >> 1;
+
+        if (movie->idx[mid].fr <= frame) lo = mid;
+        else                             hi = mid - 1;
+    }
+
+    ent = &movie->idx[lo];
+    if (fseek(movie->f, movie->idx_base + (long)ent->ofs, SEEK_SET) != 0)
+        return -1;
+
+    memcpy(movie->bbox, ent->bbox, sizeof(movie->bbox));
+    movie->fr = ent->fr;
+
+    return ent->fr;
+}
+
 /* ======================================================================== */
 /*  This program is free software; you can redistribute it and/or modify    */
 /*  it under the terms of the GNU General Public License as published by    */
@@ -4,6 +4,13 @@
 #define MVI_MAX_X (256)
 #define MVI_MAX_Y (256)
 
+typedef struct mvi_idx_t        /*  Keyframe index entry.               */
+{
+    uint32_t ofs;               /*  File offset of frame (from start)   */
+    int      fr;                /*  Frame number.                       */
+    uint8_t  bbox[8][4];        /*  Bounding boxes in effect at frame.  */
+} mvi_idx_t;
+
 typedef struct mvi_t            /*  Movie-related stuff.                */
 {
     FILE    *f;                 /*  Current movie file.                 */
@@ -18,6 +25,10 @@ typedef struct mvi_t            /*  Movie-related stuff.                */
 #ifndef NO_LZO
     uint32_t tot_lzosave;       /*  Total bytes saved by LZO            */
 #endif
+    mvi_idx_t *idx;             /*  Keyframe index.                     */
+    int      idx_cnt, idx_max;  /*  # of index entries, # allocated     */
+    long     idx_base;          /*  File offset of movie start (decode) */
+    int      tot_fr;            /*  Frames in movie, from index (dec.)  */
 } mvi_t;
 
 
@@ -25,6 +36,22 @@ void mvi_init(mvi_t *movie, int x_dim, int y_dim);
 void mvi_wr_frame(mvi_t *movie, uint8_t *vid, uint8_t bbox[8][4]);
 int  mvi_rd_frame(mvi_t *movie, uint8_t *vid, uint8_t bbox[8][4]);
 
+/* ------------------------------------------------------------------------ */
+/*  MVI_WR_INDEX -- Append the keyframe index to a movie being written.     */
+/*                  Call just before closing the file.  Returns # of bytes  */
+/*                  written, or -1 on error.                                */
+/*  MVI_RD_INDEX -- Load the keyframe index from the end of a movie being   */
+/*                  read.  Leaves the file position unchanged.  Returns #   */
+/*                  of keyframes, or -1 if the movie has no index.          */
+/*  MVI_SEEK     -- Position the movie at the last keyframe at or before    */
+/*                  'frame'.  The next mvi_rd_frame decodes that keyframe.  */
+/*                  Returns its frame number.  Without an index, rewinds    */
+/*                  to the start of the file and returns 0.                 */
+/* ------------------------------------------------------------------------ */
+int  mvi_wr_index(mvi_t *movie);
+int  mvi_rd_index(mvi_t *movie);
+int  mvi_seek(mvi_t *movie, int frame);
+
 /* Flags returned by mvi_rd_frame */
 #define MVI_FR_SAME (1)     /* set if movie file skipped the frame  */
 #define MVI_BB_SAME (2)     /* set if movie file skipped the bbox   */
@@ -0,0 +1,927 @@
+/*
+ * ============================================================================
+ *  Title:    Rollback Netplay
+ * ============================================================================
+ *  Transport, input history, prediction and desync detection for two-
+ *  player rollback netplay.  See netplay.h for how the emulator drives it.
+ *
+ *  Every frame, each side sends all of its input the peer hasn't yet
+ *  acknowledged (up to NP_MAX_SEND frames), along with its latest final
+ *  state hash.  Lost packets are covered by the next one.  Remote input
+ *  is accepted in order only, so "remote_hi" is always a solid edge.
+ *
+ *  The shim delays, jitters and drops outgoing packets, so two copies on
+ *  one machine talking over 127.0.0.1 behave like they're far apart.
+ * ============================================================================
+ */
+
+#include "config.h"
+#include "plat/plat_lib.h"
+#include "netplay/netplay.h"
+
+#if (defined(PLAT_LINUX) || defined(PLAT_MACOS) || defined(__FreeBSD__)) \
+    && !defined(__EMSCRIPTEN__)
+# define NETPLAY_UDP
+# include <unistd.h>
+# include <fcntl.h>
+# include <errno.h>
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <netdb.h>
+#endif
+
+#define NP_RING         (128)           /* Frames of history.  Power of 2.  */
+#define NP_SLOT(f)      ((f) & (NP_RING - 1))
+#define NP_MAX_SEND     (64)            /* Most frames of input per packet. */
+#define NP_VERSION      (1)
+#define NP_PKT_MAX      (24 + NP_MAX_SEND * NP_WORDS)
+#define NP_NO_FRAME     (0xFFFFFFFFu)
+#define NP_TIMEOUT      (10.0)          /* Seconds before giving up.        */
+
+enum { NP_PKT_HELLO = 1, NP_PKT_INPUT, NP_PKT_BYE };
+
+typedef struct np_pkt_t
+{
+    double      due;                    /* When the shim lets it go.        */
+    int         len;
+    uint8_t     data[NP_PKT_MAX];
+} np_pkt_t;
+
+typedef struct netplay_pvt_t
+{
+    int         player;                 /* 1 or 2.                          */
+    int         window;                 /* Most frames we'll roll back.     */
+#ifdef NETPLAY_UDP
+    int         fd;
+    struct sockaddr_storage peer;
+    socklen_t   peer_len;
+#endif
+
+    /* Controller words:  left controller, then right. */
+    uint32_t   *word   [2 * NP_WORDS];
+    uint32_t    applied[2 * NP_WORDS];  /* What the game should see.        */
+    uint32_t    live   [2 * NP_WORDS];  /* What the keyboard etc. says.     */
+
+    /* Input history. */
+    uint8_t     local [NP_RING][NP_WORDS];
+    uint8_t     remote[NP_RING][NP_WORDS];
+    uint8_t     used  [NP_RING][NP_WORDS];  /* Remote input we ran with.    */
+    uint32_t    local_hi;               /* Local input known for < this.    */
+    uint32_t    remote_hi;              /* Remote input known for < this.   */
+    uint32_t    used_hi;                /* Frames simulated are < this.     */
+    uint32_t    peer_ack;               /* Peer has our input for < this.   */
+    int32_t     rollback;               /* Earliest misprediction, or -1.   */
+
+    /* Desync detection. */
+    uint32_t    my_hash  [NP_RING], my_tag  [NP_RING];
+    uint32_t    peer_hash[NP_RING], peer_tag[NP_RING];
+    uint32_t    last_hashed;            /* Latest frame we have a hash for. */
+    uint32_t    checked, desyncs, first_desync;
+
+    /* Connection. */
+    uint32_t    start_hash;
+    int         got_hello, peer_got_hello, peer_bye, lost, finished;
+    double      last_send;
+
+    /* Packet shim. */
+    double      sim_lat, sim_jit, sim_loss;
+    uint32_t    sim_rng;
+    np_pkt_t   *dq;
+    int         dq_cnt, dq_cap;
+
+    /* --netplay-test */
+    int         test;
+    uint32_t    test_frames, test_rng;
+    uint8_t     test_cur[NP_WORDS];
+    int         test_hold;
+
+    /* Statistics. */
+    uint32_t    sent, recvd, dropped;
+    uint64_t    sent_bytes;
+    uint32_t    rollbacks, resim_frames, resim_deep;
+    double      resim_time, resim_max;
+    uint32_t    stalls;
+    double      stall_time;
+    uint64_t    predicted;              /* Sum of frames run on prediction. */
+    uint32_t    sec_rollbacks, sec_frames;
+    double      sec_resim;
+} netplay_pvt_t;
+
+/* ======================================================================== */
+/*  NP_RAND      -- xorshift32, for the shim and the test input.            */
+/* ======================================================================== */
+LOCAL uint32_t np_rand(uint32_t *const s)
+{
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+#ifdef NETPLAY_UDP
+/* ======================================================================== */
+/*  NP_PUT_32 / NP_GET_32 -- Little-endian packet fields.                   */
+/* ======================================================================== */
+LOCAL void np_put_32(uint8_t *const p, const uint32_t v)
+{
+    p[0] = v;  p[1] = v >> 8;  p[2] = v >> 16;  p[3] = v >> 24;
+}
+
+LOCAL uint32_t np_get_32(const uint8_t *const p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* ======================================================================== */
+/*  NP_SENDTO    -- Put a packet on the wire.                               */
+/* ======================================================================== */
+LOCAL void np_sendto(netplay_pvt_t *const pvt, const uint8_t *const data,
+                     const int len)
+{
+    if (sendto(pvt->fd, data, len, 0, (struct sockaddr *)&pvt->peer,
+               pvt->peer_len) == len)
+    {
+        pvt->sent++;
+        pvt->sent_bytes += len;
+    }
+}
+
+/* ======================================================================== */
+/*  NP_SEND      -- Send a packet through the shim, if there is one.        */
+/*  NP_FLUSH     -- Let go of any packets the shim has held long enough.    */
+/* ======================================================================== */
+LOCAL void np_send(netplay_pvt_t *const pvt, const uint8_t *const data,
+                   const int len)
+{
+    np_pkt_t *pkt;
+    double delay;
+
+    pvt->last_send = get_time();
+
+    if (pvt->sim_lat <= 0 && pvt->sim_jit <= 0 && pvt->sim_loss <= 0)
+    {
+        np_sendto(pvt, data, len);
+        return;
+    }
+
+    if (np_rand(&pvt->sim_rng) % 10000 < pvt->sim_loss * 100)
+    {
+        pvt->dropped++;
+        return;
+    }
+
+    if (pvt->dq_cnt == pvt->dq_cap)
+    {
+        const int cap = pvt->dq_cap ? pvt->dq_cap * 2 : 64;
+        np_pkt_t *const dq = (np_pkt_t *)realloc(pvt->dq,
+                                                 cap * sizeof(np_pkt_t));
+        if (!dq)
+        {
+            pvt->dropped++;
+            return;
+        }
+        pvt->dq     = dq;
+        pvt->dq_cap = cap;
+    }
+
+    delay = pvt->sim_lat + pvt->sim_jit *
+            ((np_rand(&pvt->sim_rng) % 2001) / 1000.0 - 1.0);
+
+    pkt      = &pvt->dq[pvt->dq_cnt++];
+    pkt->due = pvt->last_send + (delay > 0 ? delay : 0) / 1000.0;
+    pkt->len = len;
+    memcpy(pkt->data, data, len);
+}
+
+LOCAL void np_flush(netplay_pvt_t *const pvt)
+{
+    const double now = get_time();
+    int i;
+
+    for (i = 0; i < pvt->dq_cnt; )
+    {
+        if (pvt->dq[i].due > now)
+        {
+            i++;
+            continue;
+        }
+        np_sendto(pvt, pvt->dq[i].data, pvt->dq[i].len);
+        pvt->dq[i] = pvt->dq[--pvt->dq_cnt];
+    }
+}
+
+/* ======================================================================== */
+/*  NP_SEND_HELLO / NP_SEND_INPUT / NP_SEND_BYE                             */
+/* ======================================================================== */
+LOCAL void np_send_hello(netplay_pvt_t *const pvt)
+{
+    uint8_t pkt[12];
+
+    pkt[0] = NP_PKT_HELLO;
+    pkt[1] = pvt->player;
+    memcpy(pkt + 2, "jzNP", 4);
+    pkt[6] = NP_VERSION;
+    pkt[7] = pvt->got_hello;
+    np_put_32(pkt + 8, pvt->start_hash);
+    np_send(pvt, pkt, sizeof(pkt));
+}
+
+LOCAL void np_send_input(netplay_pvt_t *const pvt)
+{
+    uint8_t pkt[NP_PKT_MAX];
+    uint32_t first = pvt->peer_ack, f;
+    int count;
+
+    if (pvt->local_hi - first > NP_MAX_SEND)
+        first = pvt->local_hi - NP_MAX_SEND;
+    count = pvt->local_hi - first;
+
+    pkt[0] = NP_PKT_INPUT;
+    pkt[1] = pvt->player;
+    np_put_32(pkt +  2, first);
+    pkt[6] = count;
+    np_put_32(pkt +  7, pvt->remote_hi);
+    np_put_32(pkt + 11, pvt->last_hashed);
+    np_put_32(pkt + 15, pvt->last_hashed == NP_NO_FRAME ? 0
+                        : pvt->my_hash[NP_SLOT(pvt->last_hashed)]);
+
+    for (f = first; f != pvt->local_hi; f++)
+        memcpy(pkt + 19 + (f - first) * NP_WORDS, pvt->local[NP_SLOT(f)],
+               NP_WORDS);
+
+    np_send(pvt, pkt, 19 + count * NP_WORDS);
+}
+
+LOCAL void np_send_bye(netplay_pvt_t *const pvt)
+{
+    uint8_t pkt[2];
+
+    pkt[0] = NP_PKT_BYE;
+    pkt[1] = pvt->player;
+    np_sendto(pvt, pkt, sizeof(pkt));
+}
+#endif
+
+/* ======================================================================== */
+/*  NP_CHECK     -- Compare our hash and the peer's for 'frame', if both    */
+/*                  are in.                                                 */
+/* ======================================================================== */
+LOCAL void np_check(netplay_pvt_t *const pvt, const uint32_t frame)
+{
+    const int s = NP_SLOT(frame);
+
+    if (pvt->my_tag[s] != frame || pvt->peer_tag[s] != frame)
+        return;
+
+    pvt->checked++;
+    pvt->my_tag[s] = NP_NO_FRAME;       /* Only check each frame once.      */
+
+    if (pvt->my_hash[s] == pvt->peer_hash[s])
+        return;
+
+    if (!pvt->desyncs++)
+        pvt->first_desync = frame;
+
+    if (pvt->desyncs <= 5)
+        fprintf(stderr, "\nNetplay: DESYNC at frame %u (local %.8X, "
+                        "peer %.8X)\n", frame, pvt->my_hash[s],
+                        pvt->peer_hash[s]);
+}
+
+#ifdef NETPLAY_UDP
+/* ======================================================================== */
+/*  NP_RECV_INPUT -- Take in remote input, noting any misprediction.        */
+/* ======================================================================== */
+LOCAL void np_recv_input(netplay_pvt_t *const pvt, const uint8_t *const pkt,
+                         const int len)
+{
+    const uint32_t first = np_get_32(pkt + 2);
+    const int      count = pkt[6];
+    const uint32_t ack   = np_get_32(pkt + 7);
+    const uint32_t hfrm  = np_get_32(pkt + 11);
+    uint32_t f;
+
+    if (len < 19 + count * NP_WORDS)
+        return;
+
+    pvt->peer_got_hello = 1;
+
+    if (ack > pvt->peer_ack && ack <= pvt->local_hi)
+        pvt->peer_ack = ack;
+
+    if (hfrm != NP_NO_FRAME)
+    {
+        pvt->peer_hash[NP_SLOT(hfrm)] = np_get_32(pkt + 15);
+        pvt->peer_tag [NP_SLOT(hfrm)] = hfrm;
+        np_check(pvt, hfrm);
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Accept only the next frame we're missing, and those after it.       */
+    /* -------------------------------------------------------------------- */
+    for (f = pvt->remote_hi; f - first < (uint32_t)count && f >= first; f++)
+    {
+        const int s = NP_SLOT(f);
+
+        memcpy(pvt->remote[s], pkt + 19 + (f - first) * NP_WORDS, NP_WORDS);
+        pvt->remote_hi = f + 1;
+
+        if (f < pvt->used_hi &&
+            memcmp(pvt->used[s], pvt->remote[s], NP_WORDS) &&
+            (pvt->rollback < 0 || (int32_t)f < pvt->rollback))
+            pvt->rollback = f;
+    }
+}
+
+/* ======================================================================== */
+/*  NP_POLL      -- Drain the socket, and let the shim send what's due.     */
+/* ======================================================================== */
+LOCAL void np_poll(netplay_pvt_t *const pvt)
+{
+    uint8_t pkt[NP_PKT_MAX];
+    ssize_t len;
+
+    np_flush(pvt);
+
+    while ((len = recv(pvt->fd, pkt, sizeof(pkt), 0)) >= 2)
+    {
+        if (pkt[1] == pvt->player)
+            continue;                   /* Talking to ourselves?            */
+
+        pvt->recvd++;
+
+        switch (pkt[0])
+        {
+            case NP_PKT_HELLO:
+            {
+                if (len < 12 || memcmp(pkt + 2, "jzNP", 4) ||
+                    pkt[6] != NP_VERSION)
+                    break;
+
+                if (!pvt->got_hello && np_get_32(pkt + 8) != pvt->start_hash)
+                    fprintf(stderr, "Netplay: WARNING:  The peer's machine "
+                                    "state differs.  Same game and "
+                                    "options on both sides?\n");
+                pvt->got_hello = 1;
+                pvt->peer_got_hello |= pkt[7];
+                break;
+            }
+
+            case NP_PKT_INPUT:
+            {
+                if (len >= 19)
+                    np_recv_input(pvt, pkt, len);
+                break;
+            }
+
+            case NP_PKT_BYE:
+            {
+                pvt->peer_bye = 1;
+                break;
+            }
+        }
+    }
+}
+#endif
+
+/* ======================================================================== */
+/*  NETPLAY_INIT     -- Parse the options and open the socket.              */
+/* ======================================================================== */
+int netplay_init
+(
+    netplay_t      *const np,
+    const char     *const spec,
+    const int             window,
+    const char     *const sim,
+    const char     *const test,
+    uint32_t      **const word
+)
+{
+#ifndef NETPLAY_UDP
+    UNUSED(spec); UNUSED(window); UNUSED(sim); UNUSED(test); UNUSED(word);
+    np->pvt = NULL;
+    fprintf(stderr, "Netplay is not supported on this platform.\n");
+    return -1;
+#else
+    netplay_pvt_t *pvt;
+    struct addrinfo hints, *res = NULL;
+    struct sockaddr_in local;
+    char host[256], port[16];
+    int player, lport, i, flags;
+
+    np->pvt = NULL;
+
+    if (sscanf(spec, "%d:%d:%255[^:]:%15s", &player, &lport, host, port)
+            != 4 || (player != 1 && player != 2) || lport <= 0)
+    {
+        fprintf(stderr, "Netplay: Expected player:local_port:host:port, "
+                        "got '%s'\n", spec);
+        return -1;
+    }
+
+    if (window < 1 || window > NP_MAX_WIN)
+    {
+        fprintf(stderr, "Netplay: Rollback window must be 1 to %d frames\n",
+                NP_MAX_WIN);
+        return -1;
+    }
+
+    if (!(pvt = CALLOC(netplay_pvt_t, 1)))
+        return -1;
+
+    pvt->player      = player;
+    pvt->window      = window;
+    pvt->rollback    = -1;
+    pvt->last_hashed = NP_NO_FRAME;
+    pvt->fd          = -1;
+    memcpy(pvt->word, word, sizeof(pvt->word));
+    for (i = 0; i < NP_RING; i++)
+        pvt->my_tag[i] = pvt->peer_tag[i] = NP_NO_FRAME;
+
+    /* -------------------------------------------------------------------- */
+    /*  Shim and test input settings.                                       */
+    /* -------------------------------------------------------------------- */
+    if (sim && sscanf(sim, "%lf,%lf,%lf", &pvt->sim_lat, &pvt->sim_jit,
+                      &pvt->sim_loss) < 1)
+    {
+        fprintf(stderr, "Netplay: Expected latency,jitter,loss, got '%s'\n",
+                sim);
+        goto fail;
+    }
+    pvt->sim_rng = 0x12345678u * player | 1;
+
+    if (test)
+    {
+        unsigned seed = 1, frames = 3600;
+
+        if (sscanf(test, "%u,%u", &seed, &frames) < 1)
+        {
+            fprintf(stderr, "Netplay: Expected seed,frames, got '%s'\n",
+                    test);
+            goto fail;
+        }
+        pvt->test        = 1;
+        pvt->test_frames = frames;
+        pvt->test_rng    = (seed ^ (0x9E3779B9u * player)) | 1;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Find the peer and open a non-blocking UDP socket.                   */
+    /* -------------------------------------------------------------------- */
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(host, port, &hints, &res) || !res)
+    {
+        fprintf(stderr, "Netplay: Can't find peer '%s:%s'\n", host, port);
+        goto fail;
+    }
+    memcpy(&pvt->peer, res->ai_addr, res->ai_addrlen);
+    pvt->peer_len = res->ai_addrlen;
+    freeaddrinfo(res);
+
+    memset(&local, 0, sizeof(local));
+    local.sin_family      = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port        = htons(lport);
+
+    if ((pvt->fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0 ||
+        bind(pvt->fd, (struct sockaddr *)&local, sizeof(local)) < 0 ||
+        (flags = fcntl(pvt->fd, F_GETFL, 0)) < 0 ||
+        fcntl(pvt->fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        perror("Netplay: socket");
+        goto fail;
+    }
+
+    np->pvt = pvt;
+    return 0;
+
+fail:
+    if (pvt->fd >= 0)
+        close(pvt->fd);
+    free(pvt);
+    return -1;
+#endif
+}
+
+/* ======================================================================== */
+/*  NETPLAY_CONNECT  -- Handshake with the peer.                            */
+/* ======================================================================== */
+int netplay_connect(netplay_t *const np, const uint32_t hash)
+{
+#ifndef NETPLAY_UDP
+    UNUSED(np); UNUSED(hash);
+    return -1;
+#else
+    netplay_pvt_t *const pvt = np->pvt;
+    const double start = get_time();
+    double last = 0;
+
+    if (!pvt)
+        return -1;
+
+    pvt->start_hash = hash;
+    jzp_printf("Netplay: Player %d waiting for the peer...\n", pvt->player);
+    jzp_flush();
+
+    while (!(pvt->got_hello && pvt->peer_got_hello))
+    {
+        const double now = get_time();
+
+        if (now - start > 30.0)
+        {
+            fprintf(stderr, "Netplay: No answer from the peer.\n");
+            return -1;
+        }
+
+        if (now - last > 0.1)
+        {
+            np_send_hello(pvt);
+            last = now;
+        }
+
+        np_poll(pvt);
+        plat_delay(1);
+    }
+
+    /* The peer may still need to hear that we heard it. */
+    np_send_hello(pvt);
+
+    jzp_printf("Netplay: Connected as player %d, rolling back up to %d "
+               "frames\n", pvt->player, pvt->window);
+    return 0;
+#endif
+}
+
+/* ======================================================================== */
+/*  NETPLAY_LIVE     -- Let the event subsystem see the live input.         */
+/*  NETPLAY_SYNC     -- Capture live input; show the game what we applied.  */
+/* ======================================================================== */
+void netplay_live(netplay_t *const np)
+{
+    netplay_pvt_t *const pvt = np->pvt;
+    int i;
+
+    if (!pvt)
+        return;
+
+    for (i = 0; i < 2 * NP_WORDS; i++)
+        *pvt->word[i] = pvt->live[i];
+}
+
+void netplay_sync(netplay_t *const np)
+{
+    netplay_pvt_t *const pvt = np->pvt;
+    int i;
+
+    if (!pvt)
+        return;
+
+    for (i = 0; i < 2 * NP_WORDS; i++)
+    {
+        pvt->live[i]  = *pvt->word[i];
+        *pvt->word[i] = pvt->applied[i];
+    }
+}
+
+/* ======================================================================== */
+/*  NP_TEST_INPUT -- Random but repeatable presses, held for a while.       */
+/* ======================================================================== */
+LOCAL void np_test_input(netplay_pvt_t *const pvt, uint8_t *const in)
+{
+    if (--pvt->test_hold <= 0)
+    {
+        const uint32_t r = np_rand(&pvt->test_rng);
+
+        if ((r & 3) == 0)
+            memset(pvt->test_cur, 0, NP_WORDS);
+        else
+            pvt->test_cur[(r >> 2) % NP_WORDS] = r >> 16;
+
+        pvt->test_hold = 1 + (r >> 24) % 30;
+    }
+
+    memcpy(in, pvt->test_cur, NP_WORDS);
+}
+
+/* ======================================================================== */
+/*  NETPLAY_LOCAL    -- Record and send local input for 'frame'.            */
+/* ======================================================================== */
+int netplay_local(netplay_t *const np, const uint32_t frame)
+{
+    netplay_pvt_t *const pvt = np->pvt;
+    uint8_t *const in = pvt->local[NP_SLOT(frame)];
+    int i;
+
+    if (pvt->test)
+        np_test_input(pvt, in);
+    else
+        for (i = 0; i < NP_WORDS; i++)
+            in[i] = pvt->live[i] | pvt->live[NP_WORDS + i];
+
+    pvt->local_hi = frame + 1;
+
+#ifdef NETPLAY_UDP
+    if (!pvt->lost)
+        np_send_input(pvt);
+#endif
+
+    return pvt->test && frame >= pvt->test_frames;
+}
+
+/* ======================================================================== */
+/*  NETPLAY_WAIT     -- Receive, and stall if we're too far ahead.          */
+/* ======================================================================== */
+int netplay_wait(netplay_t *const np, const uint32_t frame)
+{
+    netplay_pvt_t *const pvt = np->pvt;
+#ifdef NETPLAY_UDP
+    double start, resend;
+
+    if (pvt->lost)
+        return -1;
+
+    np_poll(pvt);
+
+    if (frame <= pvt->remote_hi + pvt->window)
+        return 0;
+
+    pvt->stalls++;
+    start = resend = get_time();
+
+    while (frame > pvt->remote_hi + pvt->window)
+    {
+        const double now = get_time();
+
+        if (pvt->peer_bye || now - start > NP_TIMEOUT)
+        {
+            fprintf(stderr, "\nNetplay: The peer %s.  Playing on alone.\n",
+                    pvt->peer_bye ? "left" : "stopped answering");
+            pvt->lost = 1;
+            break;
+        }
+
+        /* Our last packet may have been lost; say it again. */
+        if (now - resend > 0.02)
+        {
+            np_send_input(pvt);
+            resend = now;
+        }
+
+        plat_delay(1);
+        np_poll(pvt);
+    }
+
+    pvt->stall_time += get_time() - start;
+    return pvt->lost ? -1 : 0;
+#else
+    UNUSED(pvt); UNUSED(frame);
+    return -1;
+#endif
+}
+
+/* ======================================================================== */
+/*  NETPLAY_ROLLBACK -- Earliest mispredicted frame, or -1.                 */
+/* ======================================================================== */
+int32_t netplay_rollback(netplay_t *const np)
+{
+    netplay_pvt_t *const pvt = np->pvt;
+    const int32_t f = pvt->rollback;
+
+    pvt->rollback = -1;
+    return f;
+}
+
+/* ======================================================================== */
+/*  NETPLAY_APPLY    -- Set both controllers for 'frame'.  Remote input we  */
+/*                      don't have yet is predicted to be the last we got.  */
+/* ======================================================================== */
+void netplay_apply(netplay_t *const np, const uint32_t frame)
+{
+    netplay_pvt_t *const pvt = np->pvt;
+    const int s = NP_SLOT(frame);
+    const uint8_t *const mine = pvt->local[s];
+    uint8_t *const theirs = pvt->used[s];
+    const int me = pvt->player == 1 ? 0 : NP_WORDS;
+    const int it = NP_WORDS - me;
+    int i;
+
+    if (frame < pvt->remote_hi)
+        memcpy(theirs, pvt->remote[s], NP_WORDS);
+    else if (pvt->remote_hi)
+        memcpy(theirs, pvt->remote[NP_SLOT(pvt->remote_hi - 1)], NP_WORDS);
+    else
+        memset(theirs, 0, NP_WORDS);
+
+    if (frame >= pvt->used_hi)
+    {
+        pvt->used_hi    = frame + 1;
+        pvt->predicted += frame >= pvt->remote_hi
+                        ? frame - pvt->remote_hi + 1 : 0;
+    }
+
+    for (i = 0; i < NP_WORDS; i++)
+    {
+        pvt->applied[me + i] = mine[i];
+        pvt->applied[it + i] = theirs[i];
+    }
+
+    for (i = 0; i < 2 * NP_WORDS; i++)
+        *pvt->word[i] = pvt->applied[i];
+}
+
+/* ======================================================================== */
+/*  NETPLAY_CONFIRMED -- Frames with both players' input known.             */
+/* ======================================================================== */
+uint32_t netplay_confirmed(const netplay_t *const np)
+{
+    const netplay_pvt_t *const pvt = np->pvt;
+
+    return pvt->remote_hi < pvt->local_hi ? pvt->remote_hi : pvt->local_hi;
+}
+
+/* ======================================================================== */
+/*  NETPLAY_HASH     -- Record the final state hash for 'frame'.            */
+/* ======================================================================== */
+void netplay_hash(netplay_t *const np, const uint32_t frame,
+                  const uint32_t hash)
+{
+    netplay_pvt_t *const pvt = np->pvt;
+    const int s = NP_SLOT(frame);
+
+    pvt->my_hash[s]  = hash;
+    pvt->my_tag[s]   = frame;
+    pvt->last_hashed = frame;
+    np_check(pvt, frame);
+}
+
+/* ======================================================================== */
+/*  NETPLAY_DESYNC   -- Note a desync the emulator found on its own.        */
+/* ======================================================================== */
+void netplay_desync(netplay_t *const np, const uint32_t frame)
+{
+    netplay_pvt_t *const pvt = np->pvt;
+
+    if (!pvt->desyncs++)
+        pvt->first_desync = frame;
+}
+
+/* ======================================================================== */
+/*  NETPLAY_RESIM    -- Account for one rollback.                           */
+/* ======================================================================== */
+void netplay_resim(netplay_t *const np, const uint32_t frames,
+                   const double secs)
+{
+    netplay_pvt_t *const pvt = np->pvt;
+
+    if (!frames)
+        return;
+
+    pvt->rollbacks++;
+    pvt->resim_frames += frames;
+    pvt->resim_time   += secs;
+    if (pvt->resim_max < secs / frames)
+        pvt->resim_max = secs / frames;
+    if (pvt->resim_deep < frames)
+        pvt->resim_deep = frames;
+
+    pvt->sec_rollbacks++;
+    pvt->sec_frames += frames;
+    pvt->sec_resim  += secs;
+}
+
+/* ======================================================================== */
+/*  NETPLAY_STATUS   -- Rollbacks and re-sim cost over the last second.     */
+/* ======================================================================== */
+void netplay_status(netplay_t *const np)
+{
+    netplay_pvt_t *const pvt = np->pvt;
+
+    if (!pvt)
+        return;
+
+    jzp_printf(" NP:[%u rb %5.2fms/f%s]", pvt->sec_rollbacks,
+               pvt->sec_frames ? 1e3 * pvt->sec_resim / pvt->sec_frames : 0.,
+               pvt->desyncs ? " DESYNC" : "");
+
+    pvt->sec_rollbacks = 0;
+    pvt->sec_frames    = 0;
+    pvt->sec_resim     = 0;
+}
+
+/* ======================================================================== */
+/*  NP_FINISH    -- Make sure the peer has all our input, say goodbye, and  */
+/*                  report.                                                 */
+/* ======================================================================== */
+LOCAL void np_finish(netplay_pvt_t *const pvt)
+{
+#ifdef NETPLAY_UDP
+    if (!pvt->lost)
+    {
+        const double start = get_time();
+        double resend = 0;
+
+        while (pvt->peer_ack < pvt->local_hi && !pvt->peer_bye &&
+               get_time() - start < 2.0)
+        {
+            if (get_time() - resend > 0.01)
+            {
+                np_send_input(pvt);
+                resend = get_time();
+            }
+            plat_delay(1);
+            np_poll(pvt);
+        }
+    }
+
+    np_send_bye(pvt);
+    np_send_bye(pvt);
+    np_send_bye(pvt);
+    close(pvt->fd);
+#endif
+
+    jzp_printf("\nNetplay: player %d, %u frames, %.2f frames on prediction "
+               "on average\n", pvt->player, pvt->used_hi,
+               pvt->used_hi ? (double)pvt->predicted / pvt->used_hi : 0.);
+
+    if (pvt->resim_frames)
+    {
+        const double per = pvt->resim_time / pvt->resim_frames;
+
+        jzp_printf("  %u rollbacks, %u frames re-simulated (%.2f average, "
+                   "%u deepest)\n", pvt->rollbacks, pvt->resim_frames,
+                   (double)pvt->resim_frames / pvt->rollbacks,
+                   pvt->resim_deep);
+        jzp_printf("  Re-simulation: %.3f msec per frame average, %.3f "
+                   "worst; about %d frames fit in a 60Hz frame\n",
+                   1e3 * per, 1e3 * pvt->resim_max,
+                   (int)(1.0 / 60 / per));
+    } else
+        jzp_printf("  No rollbacks\n");
+
+    jzp_printf("  %u stalls (%.2f sec); packets: %u sent, %u received, "
+               "%u dropped by shim, %llu bytes sent\n", pvt->stalls,
+               pvt->stall_time, pvt->sent, pvt->recvd, pvt->dropped,
+               (unsigned long long)pvt->sent_bytes);
+
+    if (pvt->desyncs)
+        jzp_printf("  DESYNC:  %u of %u frames checked differ, first at "
+                   "frame %u\n", pvt->desyncs, pvt->checked,
+                   pvt->first_desync);
+    else
+        jzp_printf("  In sync:  %u frames checked\n", pvt->checked);
+}
+
+/* ======================================================================== */
+/*  NETPLAY_FINISH   -- Finish up, once.  Returns -1 if the two sides       */
+/*                      didn't stay in sync, or a test run didn't get to    */
+/*                      check anything.                                     */
+/* ======================================================================== */
+int netplay_finish(netplay_t *const np)
+{
+    netplay_pvt_t *const pvt = np->pvt;
+
+    if (!pvt)
+        return 0;
+
+    if (!pvt->finished)
+    {
+        pvt->finished = 1;
+        np_finish(pvt);
+    }
+
+    return pvt->desyncs || (pvt->test && !pvt->checked) ? -1 : 0;
+}
+
+/* ======================================================================== */
+/*  NETPLAY_DTOR     -- Finish, if nobody has, and free it all.             */
+/* ======================================================================== */
+void netplay_dtor(netplay_t *const np)
+{
+    netplay_pvt_t *const pvt = np->pvt;
+
+    if (!pvt)
+        return;
+
+    netplay_finish(np);
+    CONDFREE(pvt->dq);
+    CONDFREE(np->pvt);
+}
+
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
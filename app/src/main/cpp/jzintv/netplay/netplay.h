@@ -0,0 +1,129 @@
+/*
+ * ============================================================================
+ *  Title:    Rollback Netplay
+ * ============================================================================
+ *  Two players, one machine each, talking UDP.  Player 1 drives the left
+ *  hand controller and player 2 the right one.  Each side runs ahead on a
+ *  prediction of the other side's input (whatever it was last), and when
+ *  the real input turns out different, rolls the machine back to that
+ *  frame and quietly re-simulates up to the present.
+ *
+ *  This module owns the transport, the input history and prediction, the
+ *  desync detector and the statistics.  The emulator drives the snapshots
+ *  and the re-simulation, once per frame:
+ *
+ *      netplay_local    -- Hand over this frame's local input.
+ *      netplay_wait     -- Receive; stall if we're too far ahead.
+ *      netplay_rollback -- Earliest mispredicted frame, if any.  Restore
+ *                          it and netplay_apply + run each frame since.
+ *      netplay_hash     -- Report state hashes for frames now confirmed.
+ *      netplay_apply    -- Set both controllers for the next frame.
+ *
+ *  Input words are inputs to the pads code, which only looks at their low
+ *  8 bits, so each controller travels as 18 bytes per frame.
+ * ============================================================================
+ */
+#ifndef NETPLAY_NETPLAY_H_
+#define NETPLAY_NETPLAY_H_
+
+#define NP_WORDS    (18)        /* Event input words per hand controller.   */
+#define NP_MAX_WIN  (16)        /* Largest rollback window we allow.        */
+
+typedef struct netplay_t
+{
+    struct netplay_pvt_t *pvt;
+} netplay_t;
+
+/* ======================================================================== */
+/*  NETPLAY_INIT     -- Parse "player:local_port:peer_host:peer_port" and   */
+/*                      open the socket.  'window' is the most frames we'll */
+/*                      roll back.  'sim' is "latency,jitter,loss" in msec, */
+/*                      msec and percent for the outgoing packet shim, or   */
+/*                      NULL.  'test' is "seed,frames" to generate random   */
+/*                      local input and stop after that many frames, or     */
+/*                      NULL.  'word' points at the left controller's words */
+/*                      and then the right's.  Returns 0 or -1.             */
+/* ======================================================================== */
+int netplay_init
+(
+    netplay_t      *const np,
+    const char     *const spec,
+    const int             window,
+    const char     *const sim,
+    const char     *const test,
+    uint32_t      **const word
+);
+
+/* ======================================================================== */
+/*  NETPLAY_CONNECT  -- Handshake with the peer.  Blocks up to 30 seconds.  */
+/*                      'hash' is the starting state's hash; a mismatch     */
+/*                      means the two sides aren't running the same thing.  */
+/*                      Returns 0 once connected, -1 otherwise.             */
+/* ======================================================================== */
+int netplay_connect(netplay_t *const np, const uint32_t hash);
+
+/* ======================================================================== */
+/*  NETPLAY_LIVE     -- Call before the event subsystem updates the inputs. */
+/*                      Swaps the live input back in for it to work on.     */
+/*  NETPLAY_SYNC     -- Call after.  Captures the live input and puts back  */
+/*                      the controller words we applied, so the game only   */
+/*                      sees input change at frame boundaries.              */
+/* ======================================================================== */
+void netplay_live(netplay_t *const np);
+void netplay_sync(netplay_t *const np);
+
+/* ======================================================================== */
+/*  NETPLAY_LOCAL    -- Record and send local input for 'frame'.  Returns   */
+/*                      non-zero when a --netplay-test run is finished.     */
+/*  NETPLAY_WAIT     -- Receive, and stall while 'frame' is more than the   */
+/*                      window ahead of the peer.  Returns -1 if the peer   */
+/*                      has gone away.                                      */
+/*  NETPLAY_ROLLBACK -- Earliest frame simulated with the wrong remote      */
+/*                      input, or -1.  Clears it.                           */
+/*  NETPLAY_APPLY    -- Set both controllers' words for 'frame'.            */
+/*  NETPLAY_CONFIRMED-- Frames with both players' input known.  Machine     */
+/*                      state at the start of any frame up to this one is   */
+/*                      final.                                              */
+/*  NETPLAY_HASH     -- Report the final state hash for 'frame'.            */
+/*  NETPLAY_DESYNC   -- Note that we fell out of sync at 'frame' in a way   */
+/*                      the hashes won't show, such as a rollback deeper    */
+/*                      than the snapshots we kept.                         */
+/*  NETPLAY_RESIM    -- Account for re-simulating 'frames' in 'secs'.       */
+/* ======================================================================== */
+int      netplay_local    (netplay_t *const np, const uint32_t frame);
+int      netplay_wait     (netplay_t *const np, const uint32_t frame);
+int32_t  netplay_rollback (netplay_t *const np);
+void     netplay_apply    (netplay_t *const np, const uint32_t frame);
+uint32_t netplay_confirmed(const netplay_t *const np);
+void     netplay_hash     (netplay_t *const np, const uint32_t frame,
+                           const uint32_t hash);
+void     netplay_desync   (netplay_t *const np, const uint32_t frame);
+void     netplay_resim    (netplay_t *const np, const uint32_t frames,
+                           const double secs);
+
+/* ======================================================================== */
+/*  NETPLAY_STATUS   -- Append a short summary to the status line.          */
+/*  NETPLAY_FINISH   -- Say goodbye and report statistics.  Returns -1 if   */
+/*                      the two sides didn't stay in sync.                  */
+/*  NETPLAY_DTOR     -- Finish, if nobody has, and free it all.             */
+/* ======================================================================== */
+void netplay_status(netplay_t *const np);
+int  netplay_finish(netplay_t *const np);
+void netplay_dtor(netplay_t *const np);
+
+#endif
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
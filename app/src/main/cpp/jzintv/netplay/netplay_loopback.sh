@@ -0,0 +1,42 @@
+#!/bin/sh
+# Play two headless copies of jzIntv against each other over 127.0.0.1,
+# through the packet shim, on generated input.  Passes if both finish and
+# neither reports a desync.  Prints each side's netplay report, which
+# includes the rollback and re-simulation costs.
+#
+#   netplay_loopback.sh jzintv game.rom [frames [rollback [lat,jit,loss]]]
+
+JZINTV=${1:?usage: $0 jzintv game.rom [frames [rollback [lat,jit,loss]]]}
+GAME=${2:?usage: $0 jzintv game.rom [frames [rollback [lat,jit,loss]]]}
+FRAMES=${3:-1800}
+WINDOW=${4:-8}
+SIM=${5:-40,10,2}
+OUT=${TMPDIR:-/tmp}/netplay_loopback.$$
+
+SDL_VIDEODRIVER=dummy
+SDL_AUDIODRIVER=dummy
+export SDL_VIDEODRIVER SDL_AUDIODRIVER
+
+run() {
+    "$JZINTV" -a0 --netplay="$1" --netplay-rollback="$WINDOW" \
+        --netplay-sim="$SIM" --netplay-test="1,$FRAMES" "$GAME" \
+        > "$OUT.$2" 2>&1
+}
+
+run 1:47001:127.0.0.1:47002 p1 &
+P1=$!
+run 2:47002:127.0.0.1:47001 p2
+R2=$?
+wait $P1
+R1=$?
+
+STATUS=0
+for P in p1 p2 ; do
+    sed -n '/^Netplay: player/,/frames checked/p' "$OUT.$P"
+    grep -q 'In sync' "$OUT.$P" || STATUS=1
+done
+
+[ $R1 -eq 0 ] && [ $R2 -eq 0 ] || STATUS=1
+if [ $STATUS -eq 0 ] ; then echo "PASS" ; else echo "FAIL (see $OUT.*)" ; fi
+[ $STATUS -eq 0 ] && rm -f "$OUT.p1" "$OUT.p2"
+exit $STATUS
@@ -444,6 +444,31 @@ LOCAL void pad_write(periph_t *per, periph_t *req, uint32_t addr, uint32_t data)
     return;
 }
 
+/* ======================================================================== */
+/*  PAD_SER_INIT -- Registers the pads with the serializer.  The inputs     */
+/*                  come from outside the machine and aren't saved, but     */
+/*                  what the game last read or wrote on the ports is.       */
+/* ======================================================================== */
+LOCAL void pad_ser_init(periph_t *p)
+{
+#ifdef NO_SERIALIZER
+    UNUSED(p);
+#else
+    pad_t *const pad = PERIPH_AS(pad_t, p);
+    ser_hier_t *hier, *phier;
+
+    hier  = ser_new_hierarchy(NULL, p->name);
+    phier = ser_new_hierarchy(hier, "periph");
+
+    ser_register(hier, "side",   pad->side,    ser_u8,  2, SER_HEX|SER_MAND);
+    ser_register(hier, "io",     pad->io,      ser_u8,  2, SER_MAND);
+    ser_register(hier, "stale",  &pad->stale,  ser_u8,  1, SER_MAND);
+    ser_register(hier, "fake_shift", &pad->fake_shift, ser_u32, 1, SER_MAND);
+
+    periph_ser_register(p, phier);
+#endif
+}
+
 /* ======================================================================== */
 /*  PAD_RESET_INPUTS -- Reset the input bitvectors.  Used when switching    */
 /*                      keyboard input maps.                                */
@@ -472,6 +497,7 @@ int pad_init
     pad->periph.peek      = pad_read;
     pad->periph.poke      = pad_write;
     pad->periph.tick      = pad_tick;
+    pad->periph.ser_init  = pad_ser_init;
     pad->periph.min_tick  = 3579545 / (4*240);  /* 240Hz scanning rate. */
     pad->periph.max_tick  = 3579545 / (4*120);  /* 120Hz scanning rate. */
 
@@ -23,7 +23,7 @@ typedef struct pad_t
     uint8_t     side[2];    /*  Last read/written values on each port.      */
     uint8_t     io  [2];    /*  Flag bits:  Is this side set for output?    */
     uint8_t     io_cap;     /*  Flag: Can we change I/O modes?              */
-    bool        stale;      /*  Flag: We need to reevaluate controllers.    */
+    uint8_t     stale;      /*  Flag: We need to reevaluate controllers.    */
 
     /* The following must be uint32_t for the event subsystem.              */
     uint32_t    l[18];      /*  Event inputs to left controllers.           */
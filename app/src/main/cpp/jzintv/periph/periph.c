@@ -6,6 +6,8 @@
  *  PERIPH_NEW       -- Creates a new peripheral bus
  *  PERIPH_DELETE    -- Disposes a peripheral bus
  *  PERIPH_REGISTER  -- Registers a peripheral on the bus
+ *  PERIPH_MAP       -- Adds a peripheral to the address decode for a range
+ *  PERIPH_UNMAP     -- Removes a peripheral from the decode for a range
  *  PERIPH_READ      -- Perform a read on a peripheral bus
  *  PERIPH_WRITE     -- Perform a write on a peripheral bus
  *  PERIPH_TICK      -- Perform a tick on a peripheral bus
@@ -173,9 +175,7 @@ void periph_register
     const char      *name       /*  Name of peripheral.                 */
 )
 {
-    uint32_t bin, addr;
-    int i;
-    static int unnamed = 0;
+    static THREAD_LOCAL int unnamed = 0;
     char buf[32];
 
     /* -------------------------------------------------------------------- */
@@ -258,7 +258,35 @@ void periph_register
     /* -------------------------------------------------------------------- */
     /*  Poke the device into our address decode structures.                 */
     /* -------------------------------------------------------------------- */
-    if (periph->read)
+    periph_map(bus, periph, addr_lo, addr_hi, PERIPH_MAP_RD | PERIPH_MAP_WR);
+
+    jzp_printf("%-16s [0x%.4X...0x%.4X]\n", name,
+            addr_lo & bus->addr_mask, addr_hi & bus->addr_mask);
+}
+
+
+/*
+ * ============================================================================
+ *  PERIPH_MAP       -- Adds a registered peripheral to the address decode
+ *                      for a range.  Bins that already hold the peripheral
+ *                      are left alone, so overlapping calls are harmless.
+ *                      Only adds entries, so it's safe to call from inside
+ *                      a read or write handler.
+ * ============================================================================
+ */
+void periph_map
+(
+    periph_bus_t    *bus,       /*  Peripheral bus to decode on.        */
+    periph_t        *periph,    /*  Peripheral being mapped.            */
+    uint32_t        addr_lo,    /*  Low end of address range.           */
+    uint32_t        addr_hi,    /*  High end of address range.          */
+    int             which       /*  PERIPH_MAP_RD and/or PERIPH_MAP_WR  */
+)
+{
+    uint32_t bin, addr;
+    int i;
+
+    if (periph->read && (which & PERIPH_MAP_RD))
     for (addr = addr_lo & ( -(1u << bus->decode_shift) );
          addr <= addr_hi; addr += 1u << bus->decode_shift)
     {
@@ -281,7 +309,7 @@ void periph_register
         bus->rd[i][bin] = periph;
     }
 
-    if (periph->write)
+    if (periph->write && (which & PERIPH_MAP_WR))
     for (addr = addr_lo & ( -(1u << bus->decode_shift) );
          addr <= addr_hi; addr += 1u << bus->decode_shift)
     {
@@ -303,11 +331,51 @@ void periph_register
 
         bus->wr[i][bin] = periph;
     }
+}
 
-    jzp_printf("%-16s [0x%.4X...0x%.4X]\n", name,
-            addr_lo & bus->addr_mask, addr_hi & bus->addr_mask);
+/*
+ * ============================================================================
+ *  PERIPH_UNMAP     -- Removes a peripheral from the address decode for a
+ *                      range, keeping the remaining devices in each bin in
+ *                      their original order.  The peripheral stays on the
+ *                      bus (ticks, reset, serialization are unaffected).
+ *                      Must not be called from inside a read or write
+ *                      handler, since it reshuffles the bin being walked.
+ * ============================================================================
+ */
+LOCAL void periph_unmap_bin(periph_t **tbl[MAX_PERIPH_BIN], uint32_t bin,
+                            const periph_t *periph)
+{
+    int i, j;
+
+    for (i = j = 0; i < MAX_PERIPH_BIN && tbl[i][bin]; i++)
+        if (tbl[i][bin] != periph)
+            tbl[j++][bin] = tbl[i][bin];
+
+    for (; j < i; j++)
+        tbl[j][bin] = NULL;
 }
 
+void periph_unmap
+(
+    periph_bus_t    *bus,       /*  Peripheral bus to decode on.        */
+    periph_t        *periph,    /*  Peripheral being unmapped.          */
+    uint32_t        addr_lo,    /*  Low end of address range.           */
+    uint32_t        addr_hi,    /*  High end of address range.          */
+    int             which       /*  PERIPH_MAP_RD and/or PERIPH_MAP_WR  */
+)
+{
+    uint32_t bin, addr;
+
+    for (addr = addr_lo & ( -(1u << bus->decode_shift) );
+         addr <= addr_hi; addr += 1u << bus->decode_shift)
+    {
+        bin = (addr & bus->addr_mask) >> bus->decode_shift;
+
+        if (which & PERIPH_MAP_RD) periph_unmap_bin(bus->rd, bin, periph);
+        if (which & PERIPH_MAP_WR) periph_unmap_bin(bus->wr, bin, periph);
+    }
+}
 
 /*
  * ============================================================================
@@ -722,6 +790,44 @@ void periph_reset
     bus->pend_reset  = false;
 }
 
+/*
+ * ============================================================================
+ *  PERIPH_RESYNC    -- Realign tickables with the bus after a restore
+ *
+ *  Peripherals whose 'now' was restored along with the bus are left alone.
+ *  They can legitimately be a little ahead of the bus:  the CPU, for one,
+ *  finishes its last instruction past the end of its tick.  Pulling them
+ *  back would hand them extra cycles, and a restored machine would no
+ *  longer run the way the original did.
+ *
+ *  Everything else (graphics, sound, event handling, etc.) still has the
+ *  pre-restore 'now', which may be in the bus's future or far in its past.
+ *  Snap those to the bus's 'now' so they neither stall nor get one
+ *  enormous tick.  Without a snapshot, go by distance from the bus alone.
+ * ============================================================================
+ */
+void periph_resync
+(
+    periph_bus_t        *bus,
+    const ser_snap_t    *snap
+)
+{
+    const uint64_t now = bus->periph.now;
+    periph_t *p;
+
+    for (p = bus->tickable; p; p = p->tickable)
+    {
+#ifndef NO_SERIALIZER
+        if (snap && ser_snap_offset(snap, &p->now, sizeof(p->now)) >= 0)
+            continue;
+#else
+        UNUSED(snap);
+#endif
+        if (p->now > now || now - p->now > p->max_tick)
+            p->now = now;
+    }
+}
+
 
 /*
  * ============================================================================
@@ -6,6 +6,8 @@
  *  PERIPH_NEW       -- Creates a new peripheral bus
  *  PERIPH_DELETE    -- Disposes a peripheral bus
  *  PERIPH_REGISTER  -- Registers a peripheral on the bus
+ *  PERIPH_MAP       -- Adds a peripheral to the address decode for a range
+ *  PERIPH_UNMAP     -- Removes a peripheral from the decode for a range
  *  PERIPH_READ      -- Perform a read on a peripheral bus as a CPU
  *  PERIPH_PEEK      -- Perform a read on a peripheral bus via backdoor
  *  PERIPH_WRITE     -- Perform a write on a peripheral bus as a CPU
@@ -158,6 +160,35 @@ void periph_register
     const char      *name       /*  Name to give device.                */
 );
 
+/* ======================================================================== */
+/*  PERIPH_MAP       -- Adds a registered peripheral to the address decode  */
+/*                      for a range.  Safe to call from a read/write        */
+/*                      handler.                                            */
+/*  PERIPH_UNMAP     -- Removes a peripheral from the address decode for a  */
+/*                      range.  The peripheral stays on the bus otherwise.  */
+/*                      Not safe to call from a read/write handler.         */
+/* ======================================================================== */
+#define PERIPH_MAP_RD   (1)
+#define PERIPH_MAP_WR   (2)
+
+void periph_map
+(
+    periph_bus_t    *bus,       /*  Peripheral bus to decode on.        */
+    periph_t        *periph,    /*  Peripheral being mapped.            */
+    uint32_t        addr_lo,    /*  Low end of address range.           */
+    uint32_t        addr_hi,    /*  High end of address range.          */
+    int             which       /*  PERIPH_MAP_RD and/or PERIPH_MAP_WR  */
+);
+
+void periph_unmap
+(
+    periph_bus_t    *bus,       /*  Peripheral bus to decode on.        */
+    periph_t        *periph,    /*  Peripheral being unmapped.          */
+    uint32_t        addr_lo,    /*  Low end of address range.           */
+    uint32_t        addr_hi,    /*  High end of address range.          */
+    int             which       /*  PERIPH_MAP_RD and/or PERIPH_MAP_WR  */
+);
+
 /* ======================================================================== */
 /*  PERIPH_READ      -- Perform a read on a peripheral bus as a CPU.        */
 /*  PERIPH_PEEK      -- Perform a read on a peripheral bus via backdoor.    */
@@ -215,6 +246,17 @@ void periph_reset
     periph_bus_t    *bus
 );
 
+/* ======================================================================== */
+/*  PERIPH_RESYNC    -- Realign tickable peripherals with the bus's notion  */
+/*                      of 'now' after the bus's state has been restored.   */
+/*                      Those restored from 'snap' keep their own 'now'.    */
+/* ======================================================================== */
+void periph_resync
+(
+    periph_bus_t        *bus,
+    const ser_snap_t    *snap
+);
+
 /* ======================================================================== */
 /*  PERIPH_SER_REGISTER -- registers a peripheral for serialization         */
 /* ======================================================================== */
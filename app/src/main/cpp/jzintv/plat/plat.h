@@ -7,6 +7,8 @@
  *  The default supported platform is "SDL".
  * ============================================================================
  *  PLAT_INIT -- Platform-specific initialization. Returns non-zero on fail.
+ *  PLAT_THREAD_* / PLAT_MUTEX_* / PLAT_COND_* -- Minimal threading.
+ *  PLAT_GLOBAL_LOCK / PLAT_GLOBAL_UNLOCK      -- One process-wide lock.
  * ============================================================================
  */
 #ifndef PLAT_H_
@@ -16,6 +18,42 @@ int plat_init(void);
 
 bool plat_is_batch_mode(void);    /* Returns true if running in batch mode. */
 
+/* ======================================================================== */
+/*  Minimal threading support, for offloading slow work (such as movie      */
+/*  encoding) from the emulation thread.  The SDL platform provides real    */
+/*  threads, as does the headless one on Linux and macOS.  Elsewhere        */
+/*  plat_thread_create() returns NULL, and the caller must fall back to     */
+/*  doing the work inline.  All lock/cond calls accept NULL and do nothing  */
+/*  in that case.                                                           */
+/* ======================================================================== */
+typedef struct plat_thread_t plat_thread_t;
+typedef struct plat_mutex_t  plat_mutex_t;
+typedef struct plat_cond_t   plat_cond_t;
+
+plat_thread_t *plat_thread_create(int (*fn)(void *), const char *name,
+                                  void *opaque);
+int            plat_thread_join(plat_thread_t *const thread);
+
+plat_mutex_t  *plat_mutex_create(void);
+void           plat_mutex_destroy(plat_mutex_t *const mutex);
+void           plat_mutex_lock(plat_mutex_t *const mutex);
+void           plat_mutex_unlock(plat_mutex_t *const mutex);
+
+plat_cond_t   *plat_cond_create(void);
+void           plat_cond_destroy(plat_cond_t *const cond);
+void           plat_cond_wait(plat_cond_t *const cond,
+                              plat_mutex_t *const mutex);
+void           plat_cond_signal(plat_cond_t *const cond);
+void           plat_cond_broadcast(plat_cond_t *const cond);
+
+/* ======================================================================== */
+/*  One process-wide lock, usable without any setup, for the few things     */
+/*  that instances on separate threads can't do at the same time.  Not      */
+/*  recursive.  A no-op wherever there are no threads.                      */
+/* ======================================================================== */
+void           plat_global_lock(void);
+void           plat_global_unlock(void);
+
 #endif /*PLAT_H*/
 /* ======================================================================== */
 /*  This program is free software; you can redistribute it and/or modify    */
@@ -93,7 +93,7 @@ void snprintf(char * buf, int len, const char * fmt, ...)
 /*  prohibited or taxed by law.  Not part of this nutritious breakfast.     */
 /* ======================================================================== */
 
-LOCAL unsigned __rand_buf[128], __rand_ptr = 0;
+LOCAL THREAD_LOCAL unsigned __rand_buf[128], __rand_ptr = 0;
 
 /* ======================================================================== */
 /*  RAND_JZ      -- Return a random integer in the range  [0, 2^32)         */
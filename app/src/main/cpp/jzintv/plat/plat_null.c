@@ -62,6 +62,175 @@ void plat_delay(unsigned delay)
 }
 #endif
 
+#if defined(PLAT_LINUX) || defined(PLAT_MACOS)
+/* ======================================================================== */
+/*  PLAT_THREAD_* / PLAT_MUTEX_* / PLAT_COND_* -- POSIX threads, so that a  */
+/*  headless build can still run instances and workers side by side.       */
+/* ======================================================================== */
+#include <pthread.h>
+
+typedef struct plat_null_thread_t
+{
+    pthread_t   tid;
+    int       (*fn)(void *);
+    void       *opaque;
+    int         status;
+} plat_null_thread_t;
+
+LOCAL void *plat_null_thread(void *const arg)
+{
+    plat_null_thread_t *const thr = (plat_null_thread_t *)arg;
+
+    thr->status = thr->fn(thr->opaque);
+    return NULL;
+}
+
+plat_thread_t *plat_thread_create(int (*fn)(void *), const char *name,
+                                  void *opaque)
+{
+    plat_null_thread_t *const thr = CALLOC(plat_null_thread_t, 1);
+
+    UNUSED(name);
+
+    if (!thr)
+        return NULL;
+
+    thr->fn     = fn;
+    thr->opaque = opaque;
+
+    if (pthread_create(&thr->tid, NULL, plat_null_thread, thr))
+    {
+        free(thr);
+        return NULL;
+    }
+
+    return (plat_thread_t *)thr;
+}
+
+int plat_thread_join(plat_thread_t *const thread)
+{
+    plat_null_thread_t *const thr = (plat_null_thread_t *)thread;
+    int status;
+
+    if (!thr)
+        return 0;
+
+    pthread_join(thr->tid, NULL);
+    status = thr->status;
+    free(thr);
+    return status;
+}
+
+plat_mutex_t *plat_mutex_create(void)
+{
+    pthread_mutex_t *const mutex = CALLOC(pthread_mutex_t, 1);
+
+    if (mutex && pthread_mutex_init(mutex, NULL))
+    {
+        free(mutex);
+        return NULL;
+    }
+    return (plat_mutex_t *)mutex;
+}
+
+void plat_mutex_destroy(plat_mutex_t *const mutex)
+{
+    if (!mutex)
+        return;
+    pthread_mutex_destroy((pthread_mutex_t *)mutex);
+    free(mutex);
+}
+
+void plat_mutex_lock(plat_mutex_t *const mutex)
+{
+    if (mutex) pthread_mutex_lock((pthread_mutex_t *)mutex);
+}
+
+void plat_mutex_unlock(plat_mutex_t *const mutex)
+{
+    if (mutex) pthread_mutex_unlock((pthread_mutex_t *)mutex);
+}
+
+plat_cond_t *plat_cond_create(void)
+{
+    pthread_cond_t *const cond = CALLOC(pthread_cond_t, 1);
+
+    if (cond && pthread_cond_init(cond, NULL))
+    {
+        free(cond);
+        return NULL;
+    }
+    return (plat_cond_t *)cond;
+}
+
+void plat_cond_destroy(plat_cond_t *const cond)
+{
+    if (!cond)
+        return;
+    pthread_cond_destroy((pthread_cond_t *)cond);
+    free(cond);
+}
+
+void plat_cond_wait(plat_cond_t *const cond, plat_mutex_t *const mutex)
+{
+    if (cond && mutex)
+        pthread_cond_wait((pthread_cond_t *)cond, (pthread_mutex_t *)mutex);
+}
+
+void plat_cond_signal(plat_cond_t *const cond)
+{
+    if (cond) pthread_cond_signal((pthread_cond_t *)cond);
+}
+
+void plat_cond_broadcast(plat_cond_t *const cond)
+{
+    if (cond) pthread_cond_broadcast((pthread_cond_t *)cond);
+}
+
+/* ======================================================================== */
+/*  PLAT_GLOBAL_LOCK / PLAT_GLOBAL_UNLOCK                                   */
+/* ======================================================================== */
+LOCAL pthread_mutex_t plat_global_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void plat_global_lock(void)   { pthread_mutex_lock(&plat_global_mutex);   }
+void plat_global_unlock(void) { pthread_mutex_unlock(&plat_global_mutex); }
+
+#else
+/* ======================================================================== */
+/*  PLAT_THREAD_* / PLAT_MUTEX_* / PLAT_COND_* -- No threads without SDL.   */
+/*  plat_thread_create() fails, so callers do their work inline.           */
+/* ======================================================================== */
+plat_thread_t *plat_thread_create(int (*fn)(void *), const char *name,
+                                  void *opaque)
+{
+    UNUSED(fn); UNUSED(name); UNUSED(opaque);
+    return NULL;
+}
+
+int plat_thread_join(plat_thread_t *const thread)
+{
+    UNUSED(thread);
+    return 0;
+}
+
+plat_mutex_t *plat_mutex_create(void)               { return NULL;      }
+void plat_mutex_destroy(plat_mutex_t *const mutex)  { UNUSED(mutex);    }
+void plat_mutex_lock(plat_mutex_t *const mutex)     { UNUSED(mutex);    }
+void plat_mutex_unlock(plat_mutex_t *const mutex)   { UNUSED(mutex);    }
+plat_cond_t *plat_cond_create(void)                 { return NULL;      }
+void plat_cond_destroy(plat_cond_t *const cond)     { UNUSED(cond);     }
+void plat_cond_signal(plat_cond_t *const cond)      { UNUSED(cond);     }
+void plat_cond_broadcast(plat_cond_t *const cond)   { UNUSED(cond);     }
+void plat_cond_wait(plat_cond_t *const cond, plat_mutex_t *const mutex)
+{
+    UNUSED(cond);
+    UNUSED(mutex);
+}
+
+void plat_global_lock(void)   { }
+void plat_global_unlock(void) { }
+#endif
+
 int plat_init(void)
 {
     /* -------------------------------------------------------------------- */
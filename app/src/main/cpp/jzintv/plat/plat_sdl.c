@@ -49,6 +49,100 @@ void plat_delay(unsigned delay)
 }
 #endif
 
+/* ======================================================================== */
+/*  PLAT_THREAD_* / PLAT_MUTEX_* / PLAT_COND_* -- Thin wrappers on SDL.     */
+/* ======================================================================== */
+plat_thread_t *plat_thread_create(int (*fn)(void *), const char *name,
+                                  void *opaque)
+{
+#ifndef USE_SDL2
+    UNUSED(name);
+    return (plat_thread_t *)SDL_CreateThread(fn, opaque);
+#else
+    return (plat_thread_t *)SDL_CreateThread(fn, name, opaque);
+#endif
+}
+
+int plat_thread_join(plat_thread_t *const thread)
+{
+    int status = 0;
+    if (thread)
+        SDL_WaitThread((SDL_Thread *)thread, &status);
+    return status;
+}
+
+plat_mutex_t *plat_mutex_create(void)
+{
+    return (plat_mutex_t *)SDL_CreateMutex();
+}
+
+void plat_mutex_destroy(plat_mutex_t *const mutex)
+{
+    if (mutex) SDL_DestroyMutex((SDL_mutex *)mutex);
+}
+
+void plat_mutex_lock(plat_mutex_t *const mutex)
+{
+    if (mutex) SDL_LockMutex((SDL_mutex *)mutex);
+}
+
+void plat_mutex_unlock(plat_mutex_t *const mutex)
+{
+    if (mutex) SDL_UnlockMutex((SDL_mutex *)mutex);
+}
+
+plat_cond_t *plat_cond_create(void)
+{
+    return (plat_cond_t *)SDL_CreateCond();
+}
+
+void plat_cond_destroy(plat_cond_t *const cond)
+{
+    if (cond) SDL_DestroyCond((SDL_cond *)cond);
+}
+
+void plat_cond_wait(plat_cond_t *const cond, plat_mutex_t *const mutex)
+{
+    if (cond && mutex) SDL_CondWait((SDL_cond *)cond, (SDL_mutex *)mutex);
+}
+
+void plat_cond_signal(plat_cond_t *const cond)
+{
+    if (cond) SDL_CondSignal((SDL_cond *)cond);
+}
+
+void plat_cond_broadcast(plat_cond_t *const cond)
+{
+    if (cond) SDL_CondBroadcast((SDL_cond *)cond);
+}
+
+/* ======================================================================== */
+/*  PLAT_GLOBAL_LOCK / PLAT_GLOBAL_UNLOCK -- The mutex is made on first     */
+/*  use.  SDL2's spinlock needs no setup, so it guards that; SDL1 has no    */
+/*  such thing, but then SDL1 builds only ever run the one instance.        */
+/* ======================================================================== */
+#ifdef USE_SDL2
+LOCAL SDL_SpinLock plat_global_spin = 0;
+#endif
+LOCAL SDL_mutex   *plat_global_mutex = NULL;
+
+void plat_global_lock(void)
+{
+#ifdef USE_SDL2
+    SDL_AtomicLock(&plat_global_spin);
+#endif
+    if (!plat_global_mutex)
+        plat_global_mutex = SDL_CreateMutex();
+#ifdef USE_SDL2
+    SDL_AtomicUnlock(&plat_global_spin);
+#endif
+    if (plat_global_mutex) SDL_LockMutex(plat_global_mutex);
+}
+
+void plat_global_unlock(void)
+{
+    if (plat_global_mutex) SDL_UnlockMutex(plat_global_mutex);
+}
 
 int plat_init(void)
 {
@@ -0,0 +1,620 @@
+/*
+ * ============================================================================
+ *  Title:    Sampling Profiler
+ * ============================================================================
+ *  See prof.h for an overview.
+ *
+ *  The shadow call stack:  JSRs push a frame holding the return address.
+ *  An instruction that writes R7 and isn't a branch or jump is probably a
+ *  return, so after it runs we look down the stack for the frame it went
+ *  back to.  Routines that read arguments from after their JSR return a
+ *  few words past it, so we allow for that.  A "return" that matches no
+ *  frame (a jump table, say) leaves the stack alone.  Entering the ISR
+ *  pushes a frame for the interrupted PC, which the ISR's return pops.
+ *
+ *  Samples go into a call tree keyed by the JSR targets on the stack, with
+ *  the sampled PC at the leaves.  Functions are only resolved from symbols
+ *  when the reports are written, so it doesn't matter when they're loaded.
+ * ============================================================================
+ */
+
+#include "config.h"
+#include "periph/periph.h"
+#include "cp1600/cp1600.h"
+#include "cp1600/op_decode.h"
+#include "lzoe/lzoe.h"
+#include "debug/debug_.h"
+#include "prof/prof.h"
+
+#define PROF_CALL       (1)     /* JSR:  push a frame.                      */
+#define PROF_RET        (2)     /* Writes R7:  maybe pop some frames.       */
+#define PROF_ISR        (4)     /* Interrupt vector:  push a frame.         */
+
+#define PROF_RET_WINDOW (3)     /* Words of arguments after a JSR.          */
+#define PROF_RET_TOP    (32)    /* ...or for the innermost frame.           */
+#define PROF_LEAF       (0x10000)
+#define PROF_NONE       (0x10000)
+#define PROF_MAX_NODES  (1 << 20)
+#define PROF_MIN_NODES  (4096)
+
+/* ======================================================================== */
+/*  PROF_CLASSIFY -- Decide if an instruction is a call, a likely return,   */
+/*                   or neither, from its first two words.                  */
+/* ======================================================================== */
+LOCAL uint32_t prof_classify(const uint32_t w0, const uint32_t w1)
+{
+    const uint32_t op = w0 & 0x3FF;
+
+    /* J/JSR:  It's a call if it saves a return address. */
+    if (op == 0x004)
+        return (w1 & 0x300) != 0x300 ? PROF_CALL : 0;
+
+    /* Everything else must have R7 as its destination. */
+    if ((op & 7) != 7)
+        return 0;
+
+    /* 1ooo mmm 111:  Not a branch (1000) or an MVO (1001). */
+    if (op & 0x200)
+        return (op & 0x3C0) >= 0x280 ? PROF_RET : 0;
+
+    /* 0ooo sss 111:  Reg-to-reg 2-ops, such as JR (MOVR R5,R7). */
+    if (op >= 0x080)
+        return PROF_RET;
+
+    /* 0000 ooo 111:  INCR through ADCR. */
+    return op >= 0x008 && op < 0x030 ? PROF_RET : 0;
+}
+
+/* ======================================================================== */
+/*  PROF_PUSH    -- Push a frame on the shadow stack.  If it's full, we've  */
+/*                  probably missed some returns; forget the oldest frame.  */
+/* ======================================================================== */
+LOCAL void prof_push(prof_t *const prof, const uint32_t ret,
+                     const uint32_t target)
+{
+    prof_frame_t *f;
+
+    prof->calls[target & 0xFFFF]++;
+
+    if (prof->depth == PROF_MAX_DEPTH)
+    {
+        int i;
+
+        memmove(&prof->stack[0], &prof->stack[1],
+                (PROF_MAX_DEPTH - 1) * sizeof(prof_frame_t));
+        prof->depth--;
+        prof->dropped++;
+
+        /* Every frame now has a different path to the root. */
+        for (i = 0; i < prof->depth; i++)
+            prof->stack[i].node = -1;
+    }
+
+    f = &prof->stack[prof->depth++];
+    f->ret    = ret;
+    f->target = target;
+    f->node   = -1;
+}
+
+/* ======================================================================== */
+/*  PROF_RETURN  -- Pop back to the frame that returns to 'pc', if any.     */
+/* ======================================================================== */
+LOCAL void prof_return(prof_t *const prof, const uint32_t pc)
+{
+    int i;
+
+    for (i = prof->depth - 1; i >= 0; i--)
+    {
+        const uint32_t past = (pc - prof->stack[i].ret) & 0xFFFF;
+
+        if (past <= (i == prof->depth - 1 ? PROF_RET_TOP : PROF_RET_WINDOW))
+        {
+            prof->depth = i;
+            return;
+        }
+    }
+}
+
+/* ======================================================================== */
+/*  PROF_EXEC    -- Stands in for the execute function of calls, returns    */
+/*                  and the ISR entry point.  Runs the real one, then       */
+/*                  updates the shadow stack.                               */
+/* ======================================================================== */
+LOCAL int prof_exec(const instr_t *instr, cp1600_t *cp1600)
+{
+    prof_t *const prof = (prof_t *)cp1600->decode_hook_opaque;
+    const uint32_t pc   = instr->address;
+    const uint32_t kind = prof->kind[pc];
+    int cycles;
+
+    if (kind & PROF_ISR)
+        prof_push(prof, CP1600_PK(cp1600, (cp1600->r[6] - 1) & 0xFFFF), pc);
+
+    cycles = prof->exec[pc](instr, cp1600);
+
+    if (kind & PROF_CALL)
+        prof_push(prof, pc + 3, cp1600->r[7]);
+    else if (kind & PROF_RET)
+        prof_return(prof, cp1600->r[7]);
+
+    return cycles;
+}
+
+/* ======================================================================== */
+/*  PROF_DECODE_HOOK -- Called by the CPU as it decodes each instruction.   */
+/*                      Wraps the ones that affect the call stack.          */
+/* ======================================================================== */
+LOCAL cp1600_ins_t *prof_decode_hook(void *opaque, uint32_t addr,
+                                     uint32_t w0, uint32_t w1,
+                                     cp1600_ins_t *execute)
+{
+    prof_t *const prof = (prof_t *)opaque;
+    uint32_t kind = prof_classify(w0, w1);
+
+    if (addr == prof->cpu->int_vec)
+        kind |= PROF_ISR;
+
+    prof->kind[addr] = kind;
+    if (!kind)
+        return execute;
+
+    prof->exec[addr] = execute;
+    return prof_exec;
+}
+
+/* ======================================================================== */
+/*  PROF_GROW    -- Double the call tree's capacity and rehash.             */
+/* ======================================================================== */
+LOCAL int prof_grow(prof_t *const prof)
+{
+    const int32_t max_nodes = prof->max_nodes ? prof->max_nodes * 2
+                                              : PROF_MIN_NODES;
+    const uint32_t hash_size = 2 * max_nodes;
+    prof_node_t *node = REALLOC(prof->node, prof_node_t, max_nodes);
+    int32_t *hash;
+    int32_t n;
+
+    if (!node)
+        return -1;
+    prof->node = node;
+
+    if (!(hash = CALLOC(int32_t, hash_size)))
+        return -1;
+
+    CONDFREE(prof->hash);
+    memset(hash, 0xFF, hash_size * sizeof(int32_t));
+    prof->hash      = hash;
+    prof->hash_mask = hash_size - 1;
+    prof->max_nodes = max_nodes;
+
+    for (n = 0; n < prof->num_nodes; n++)
+    {
+        uint32_t h = ((uint32_t)node[n].parent * 0x9E3779B1u) ^
+                     (node[n].key * 0x85EBCA77u);
+
+        for (h &= prof->hash_mask; hash[h] >= 0; h = (h + 1) & prof->hash_mask)
+            ;
+        hash[h] = n;
+    }
+
+    return 0;
+}
+
+/* ======================================================================== */
+/*  PROF_NODE    -- Find or add the call tree node for 'key' under          */
+/*                  'parent'.  If the tree is full, returns 'parent'.       */
+/* ======================================================================== */
+LOCAL int32_t prof_node(prof_t *const prof, const int32_t parent,
+                        const uint32_t key)
+{
+    const uint32_t hkey = ((uint32_t)parent * 0x9E3779B1u) ^
+                          (key * 0x85EBCA77u);
+    uint32_t h;
+    int32_t n;
+
+    for (h = hkey & prof->hash_mask; (n = prof->hash[h]) >= 0;
+         h = (h + 1) & prof->hash_mask)
+        if (prof->node[n].parent == parent && prof->node[n].key == key)
+            return n;
+
+    if (prof->num_nodes == prof->max_nodes)
+    {
+        if (prof->max_nodes == PROF_MAX_NODES || prof_grow(prof))
+            return parent;
+
+        for (h = hkey & prof->hash_mask; prof->hash[h] >= 0;
+             h = (h + 1) & prof->hash_mask)
+            ;
+    }
+
+    n = prof->num_nodes++;
+    prof->node[n].parent = parent;
+    prof->node[n].key    = key;
+    prof->node[n].cycles = 0;
+    prof->hash[h] = n;
+
+    return n;
+}
+
+/* ======================================================================== */
+/*  PROF_TICK    -- Take a sample, charging it with the cycles since the    */
+/*                  last one.  Jitter the interval so we don't beat against */
+/*                  the frame rate.                                         */
+/* ======================================================================== */
+LOCAL uint32_t prof_tick(periph_t *const periph, const uint32_t len)
+{
+    prof_t *const prof = PERIPH_AS(prof_t, periph);
+    int32_t parent = -1, leaf;
+    uint32_t next;
+    int i;
+
+    for (i = 0; i < prof->depth; i++)
+    {
+        prof_frame_t *const f = &prof->stack[i];
+
+        if (f->node < 0)
+            f->node = prof_node(prof, parent, f->target);
+        parent = f->node;
+    }
+
+    leaf = prof_node(prof, parent, PROF_LEAF | prof->cpu->r[7]);
+    if (leaf >= 0)
+        prof->node[leaf].cycles += len;
+
+    prof->samples++;
+    prof->cycles += len;
+
+    prof->rand = prof->rand * 1103515245u + 12345u;
+    next = prof->interval / 2 + (prof->rand >> 8) % prof->interval;
+    prof->periph.min_tick = next;
+    prof->periph.max_tick = next;
+
+    return len;
+}
+
+/* ======================================================================== */
+/*  Helpers for writing the reports.                                        */
+/* ======================================================================== */
+typedef struct prof_line_t
+{
+    char       *stack;
+    uint64_t    cycles;
+} prof_line_t;
+
+typedef struct prof_func_t
+{
+    uint32_t    func;
+    uint64_t    self, total, calls;
+} prof_func_t;
+
+LOCAL int prof_cmp_line(const void *a, const void *b)
+{
+    return strcmp(((const prof_line_t *)a)->stack,
+                  ((const prof_line_t *)b)->stack);
+}
+
+LOCAL int prof_cmp_func(const void *a, const void *b)
+{
+    const prof_func_t *const fa = (const prof_func_t *)a;
+    const prof_func_t *const fb = (const prof_func_t *)b;
+
+    if (fa->self  != fb->self ) return fa->self  > fb->self  ? -1 : 1;
+    if (fa->total != fb->total) return fa->total > fb->total ? -1 : 1;
+    return fa->func < fb->func ? -1 : fa->func > fb->func;
+}
+
+/* ------------------------------------------------------------------------ */
+/*  Local labels (ones with a '.') don't start functions.                   */
+/* ------------------------------------------------------------------------ */
+LOCAL int prof_is_func(const char *const symb)
+{
+    return symb && !strchr(symb, '.');
+}
+
+LOCAL const char *prof_name(const uint32_t func, char *const buf)
+{
+    const char *symb;
+
+    if (func == PROF_NONE)
+        return "[toplevel]";
+
+    if ((symb = debug_symb_for_addr(func)) != NULL)
+        return symb;
+
+    sprintf(buf, "$%.4X", func);
+    return buf;
+}
+
+LOCAL char *prof_fname(const char *const base, const char *const ext)
+{
+    char *const fname = CALLOC(char, strlen(base) + strlen(ext) + 1);
+
+    if (fname)
+    {
+        strcpy(fname, base);
+        strcat(fname, ext);
+    }
+    return fname;
+}
+
+/* ======================================================================== */
+/*  PROF_STACK   -- Join a list of function names, innermost first, into    */
+/*                  a collapsed stack, outermost first.                     */
+/* ======================================================================== */
+LOCAL char *prof_stack(const char *const *const path, int depth)
+{
+    size_t len = 0;
+    char *stack, *s;
+    int i;
+
+    for (i = 0; i < depth; i++)
+        len += strlen(path[i]) + 1;
+
+    if (!(s = stack = CALLOC(char, len)))
+        return NULL;
+
+    while (depth-- > 0)
+    {
+        strcpy(s, path[depth]);
+        s += strlen(s);
+        *s++ = depth ? ';' : 0;
+    }
+
+    return stack;
+}
+
+/* ======================================================================== */
+/*  PROF_WRITE   -- Write the collapsed stacks and the function report.     */
+/* ======================================================================== */
+LOCAL void prof_write(prof_t *const prof)
+{
+    uint32_t    *owner = CALLOC(uint32_t,    0x10000);
+    uint32_t    *func  = CALLOC(uint32_t,    prof->num_nodes + 1);
+    uint32_t    *stamp = CALLOC(uint32_t,    PROF_NONE + 1);
+    prof_func_t *fn    = CALLOC(prof_func_t, PROF_NONE + 1);
+    prof_line_t *line  = CALLOC(prof_line_t, prof->num_nodes + 1);
+    char *fn_folded    = prof_fname(prof->fname, ".folded");
+    char *fn_report    = prof_fname(prof->fname, ".txt");
+    const char *path[PROF_MAX_DEPTH + 2];
+    char bufs[PROF_MAX_DEPTH + 2][8];
+    FILE *f;
+    uint32_t cur = PROF_NONE, a;
+    int32_t n, num_lines = 0, num_fn = 0, i, j;
+
+    if (!owner || !func || !stamp || !fn || !line || !fn_folded || !fn_report)
+    {
+        fprintf(stderr, "prof:  Out of memory writing profile\n");
+        goto done;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Each address belongs to the closest function symbol at or below.    */
+    /* -------------------------------------------------------------------- */
+    for (a = 0; a < 0x10000; a++)
+    {
+        if (prof_is_func(debug_symb_for_addr(a)))
+            cur = a;
+        owner[a] = cur;
+    }
+
+    for (a = 0; a <= PROF_NONE; a++)
+        fn[a].func = a;
+
+    /* -------------------------------------------------------------------- */
+    /*  Resolve each node to a function.  A frame is the function its JSR   */
+    /*  went to.  A sample is the function its PC lies in, or else the one */
+    /*  its frame says we're in.  Parents come before their children.       */
+    /*                                                                      */
+    /*  Then for each node with samples, build its stack, and tally self    */
+    /*  and total cycles.  A function counts once per stack in its total.   */
+    /*  (A frame only has samples if the tree filled up below it.)          */
+    /* -------------------------------------------------------------------- */
+    for (n = 0; n < prof->num_nodes; n++)
+    {
+        const prof_node_t *const nd = &prof->node[n];
+        const uint32_t addr  = nd->key & 0xFFFF;
+        const uint32_t above = nd->parent >= 0 ? func[nd->parent] : PROF_NONE;
+        const uint64_t cyc   = nd->cycles;
+        int32_t p;
+        int depth = 0;
+
+        if (!(nd->key & PROF_LEAF))
+            func[n] = owner[addr] != PROF_NONE ? owner[addr] : addr;
+        else
+            func[n] = owner[addr] != PROF_NONE ? owner[addr] : above;
+
+        if (!cyc)
+            continue;
+
+        fn[func[n]].self += cyc;
+
+        /* A leaf in the function its frame called doesn't add a level. */
+        p = (nd->key & PROF_LEAF) && func[n] == above ? nd->parent : n;
+
+        if (p < 0)
+        {
+            path[depth++] = prof_name(PROF_NONE, bufs[0]);
+            fn[PROF_NONE].total += cyc;
+        }
+
+        for (; p >= 0; p = prof->node[p].parent)
+        {
+            if (stamp[func[p]] != (uint32_t)n + 1)
+            {
+                stamp[func[p]] = n + 1;
+                fn[func[p]].total += cyc;
+            }
+            path[depth] = prof_name(func[p], bufs[depth]);
+            depth++;
+        }
+
+        if (!(line[num_lines].stack = prof_stack(path, depth)))
+            continue;
+        line[num_lines++].cycles = cyc;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Collapsed stacks.  Different call sites and PCs in the same         */
+    /*  functions make the same stack, so merge those.                      */
+    /* -------------------------------------------------------------------- */
+    qsort(line, num_lines, sizeof(prof_line_t), prof_cmp_line);
+    for (i = 0, j = 0; i < num_lines; i++)
+    {
+        if (j > 0 && !prof_cmp_line(&line[j - 1], &line[i]))
+        {
+            line[j - 1].cycles += line[i].cycles;
+            free(line[i].stack);
+        } else
+            line[j++] = line[i];
+    }
+    num_lines = j;
+
+    if (!(f = fopen(fn_folded, "w")))
+    {
+        fprintf(stderr, "prof:  Could not open '%s' for writing\n",
+                fn_folded);
+        goto done;
+    }
+
+    for (i = 0; i < num_lines; i++)
+        fprintf(f, "%s %" U64_FMT "\n", line[i].stack, line[i].cycles);
+    fclose(f);
+
+    /* -------------------------------------------------------------------- */
+    /*  Per-function report, hottest first.                                 */
+    /* -------------------------------------------------------------------- */
+    for (a = 0; a < 0x10000; a++)
+        if (prof->calls[a])
+            fn[owner[a] != PROF_NONE ? owner[a] : a].calls += prof->calls[a];
+
+    for (a = 0; a <= PROF_NONE; a++)
+        if (fn[a].self || fn[a].total || fn[a].calls)
+            fn[num_fn++] = fn[a];
+
+    qsort(fn, num_fn, sizeof(prof_func_t), prof_cmp_func);
+
+    if (!(f = fopen(fn_report, "w")))
+    {
+        fprintf(stderr, "prof:  Could not open '%s' for writing\n",
+                fn_report);
+        goto done;
+    }
+
+    fprintf(f, "%" U64_FMT " samples over %" U64_FMT " cycles, one every "
+               "%u cycles on average\n",
+            prof->samples, prof->cycles, prof->interval);
+    if (prof->dropped)
+        fprintf(f, "%" U64_FMT " frames dropped; the call stack got deeper "
+                   "than %d\n", prof->dropped, PROF_MAX_DEPTH);
+    fprintf(f, "\n      Self cycles         Total cycles       Calls  "
+               "Function\n"
+               "-------------------  -------------------  ----------  "
+               "--------------------\n");
+
+    for (i = 0; i < num_fn; i++)
+    {
+        const double scale = prof->cycles ? 100.0 / prof->cycles : 0.0;
+
+        fprintf(f, "%11" U64_FMT " %6.2f%%  %11" U64_FMT " %6.2f%%  "
+                   "%10" U64_FMT "  %s\n",
+                fn[i].self,  fn[i].self  * scale,
+                fn[i].total, fn[i].total * scale,
+                fn[i].calls, prof_name(fn[i].func, bufs[0]));
+    }
+    fclose(f);
+
+    jzp_printf("prof:  Wrote %" U64_FMT " samples to '%s' and '%s'\n",
+               prof->samples, fn_folded, fn_report);
+
+done:
+    if (line)
+        for (i = 0; i < num_lines; i++)
+            free(line[i].stack);
+
+    CONDFREE(owner);
+    CONDFREE(func);
+    CONDFREE(stamp);
+    CONDFREE(fn);
+    CONDFREE(line);
+    CONDFREE(fn_folded);
+    CONDFREE(fn_report);
+}
+
+/* ======================================================================== */
+/*  PROF_DTOR    -- Write the reports, unhook from the CPU, and clean up.   */
+/* ======================================================================== */
+LOCAL void prof_dtor(periph_t *const periph)
+{
+    prof_t *const prof = PERIPH_AS(prof_t, periph);
+
+    if (prof->cpu && prof->cpu->decode_hook_opaque == prof)
+        cp1600_decode_hook(prof->cpu, NULL, NULL);
+
+    if (prof->samples)
+        prof_write(prof);
+
+    CONDFREE(prof->fname);
+    CONDFREE(prof->kind);
+    CONDFREE(prof->exec);
+    CONDFREE(prof->calls);
+    CONDFREE(prof->node);
+    CONDFREE(prof->hash);
+
+    memset(prof, 0, sizeof(prof_t));
+}
+
+/* ======================================================================== */
+/*  PROF_INIT    -- Sets up the profiler.                                   */
+/* ======================================================================== */
+int prof_init(prof_t *const prof, cp1600_t *const cpu,
+              const uint32_t interval, const char *const fname)
+{
+    memset(prof, 0, sizeof(prof_t));
+
+    /* -------------------------------------------------------------------- */
+    /*  prof_tick jitters the gap over [interval/2, 3*interval/2).  Below   */
+    /*  2 cycles that range starts at 0, and a 0-cycle tick never advances. */
+    /* -------------------------------------------------------------------- */
+    prof->cpu      = cpu;
+    prof->interval = interval > 2 ? interval : 2;
+    prof->rand     = 1;
+    prof->fname    = strdup(fname);
+    prof->kind     = CALLOC(uint8_t,        0x10000);
+    prof->exec     = CALLOC(cp1600_ins_t *, 0x10000);
+    prof->calls    = CALLOC(uint32_t,       0x10000);
+
+    if (!prof->fname || !prof->kind || !prof->exec || !prof->calls ||
+        prof_grow(prof))
+    {
+        prof_dtor(&prof->periph);
+        return -1;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  The profiler only needs to be ticked.  It has no address space.     */
+    /* -------------------------------------------------------------------- */
+    prof->periph.tick      = prof_tick;
+    prof->periph.min_tick  = prof->interval;
+    prof->periph.max_tick  = prof->interval;
+    prof->periph.dtor      = prof_dtor;
+
+    cp1600_decode_hook(cpu, prof_decode_hook, prof);
+
+    return 0;
+}
+
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
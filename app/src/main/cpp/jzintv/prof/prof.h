@@ -0,0 +1,89 @@
+/*
+ * ============================================================================
+ *  Title:    Sampling Profiler
+ * ============================================================================
+ *  Samples the program counter every so many cycles, along with a shadow
+ *  call stack built from the JSRs and returns the CPU executes.  Unlike
+ *  the debugger's profile, this runs at full speed:  the stack is kept by
+ *  wrapping only JSRs and instructions that write R7, via the CPU's
+ *  decode hook, and the samples come from an ordinary peripheral tick.
+ *
+ *  At exit, writes two files:
+ *
+ *      <base>.folded   Collapsed stacks ("main;FOO;BAR cycles"), one per
+ *                      line, for flamegraph.pl, speedscope and friends.
+ *      <base>.txt      Per-function report:  self and total cycles, and
+ *                      the number of times each function was called.
+ *
+ *  Functions are named from the debugger's symbol table, if one was
+ *  loaded with --sym-file.  Otherwise they're named by address.
+ * ============================================================================
+ */
+#ifndef PROF_H_
+#define PROF_H_
+
+#define PROF_MAX_DEPTH (64)
+
+typedef struct prof_frame_t
+{
+    uint16_t    ret;        /* Return address.                              */
+    uint16_t    target;     /* Address called.                              */
+    int32_t     node;       /* Call tree node, or -1 if not looked up yet.  */
+} prof_frame_t;
+
+typedef struct prof_node_t
+{
+    int32_t     parent;     /* Parent node, or -1 for the root.             */
+    uint32_t    key;        /* Bit 16 set for a sample PC; else a frame.    */
+    uint64_t    cycles;     /* Cycles sampled with exactly this stack.      */
+} prof_node_t;
+
+typedef struct prof_t
+{
+    periph_t        periph;
+    cp1600_t       *cpu;
+    char           *fname;          /* Base name for output files.          */
+    uint32_t        interval;       /* Average cycles between samples.      */
+    uint32_t        rand;           /* Jitters the sample interval.         */
+
+    prof_frame_t    stack[PROF_MAX_DEPTH];
+    int             depth;
+
+    uint8_t        *kind;           /* Per address:  call/return/ISR entry. */
+    cp1600_ins_t  **exec;           /* Per address:  wrapped execute fn.    */
+    uint32_t       *calls;          /* Per address:  times called.          */
+
+    prof_node_t    *node;           /* Call tree, parents before children.  */
+    int32_t         num_nodes, max_nodes;
+    int32_t        *hash;           /* Open-addressed (parent,key) -> node. */
+    uint32_t        hash_mask;
+
+    uint64_t        samples;
+    uint64_t        cycles;
+    uint64_t        dropped;        /* Frames lost to stack overflow.       */
+} prof_t;
+
+/* ======================================================================== */
+/*  PROF_INIT    -- Sets up the profiler to sample every 'interval' cycles  */
+/*                  on average, and write <fname>.folded and <fname>.txt    */
+/*                  when it's destroyed.  Register it on the bus after.     */
+/* ======================================================================== */
+int prof_init(prof_t *const prof, cp1600_t *const cpu,
+              const uint32_t interval, const char *const fname);
+
+#endif
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
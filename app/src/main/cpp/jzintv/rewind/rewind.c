@@ -0,0 +1,572 @@
+/*
+ * ============================================================================
+ *  Title:    Rewind Buffer
+ * ============================================================================
+ *  The history is a chain of backward deltas hanging off 'head', the most
+ *  recent snapshot:
+ *
+ *      head                    newest capture, uncompressed
+ *      ent[count - 1]          head ^ (capture before head)
+ *      ent[count - 2]          (capture before head) ^ (one before that)
+ *      ...
+ *      ent[0]                  oldest delta we still have
+ *
+ *  Stepping back XORs the newest delta into 'head' and pops it.  When the
+ *  history outgrows its memory cap, the oldest deltas fall off the end.
+ *
+ *  Captures are staged in a small pool of slots.  rewind_frame() copies
+ *  the machine into a free slot on the emulator thread, which is just a
+ *  handful of memcpy()s.  The worker picks staged slots up in order,
+ *  builds the delta against 'head', compresses it, and files it.  If the
+ *  worker falls behind and every slot is full, the capture is dropped.
+ *  That only leaves a gap in the history; the chain stays intact.
+ *
+ *  Only the worker touches 'head' and the history while it's running.
+ *  rewind_step() waits for the worker to go idle before touching either.
+ * ============================================================================
+ */
+
+#include "config.h"
+#include "serializer/serializer.h"
+#include "plat/plat.h"
+#include "plat/plat_lib.h"
+#include "rewind/rewind.h"
+
+#ifndef NO_LZO
+# include "minilzo/minilzo.h"
+#endif
+
+#ifndef NO_SERIALIZER
+
+#define RW_SLOTS        (4)         /* Captures that may wait on worker.    */
+
+typedef struct rw_ent_t
+{
+    uint8_t        *data;           /* Delta, compressed unless 'raw'.      */
+    uint32_t        len;
+    int             raw;            /* Stored as-is; didn't compress.       */
+} rw_ent_t;
+
+typedef struct rewind_pvt_t
+{
+    const ser_snap_t *snap;
+    uint32_t        size;           /* Bytes per snapshot.                  */
+    int             interval;       /* Frames between captures.             */
+    int             countdown;      /* Frames until the next capture.       */
+    int             since;          /* Frames run since last capture/step.  */
+    size_t          mem_cap;        /* Limit on stored delta bytes.         */
+
+    /* -------------------------------------------------------------------- */
+    /*  Staging.  Slots go free -> queued -> (worker) -> free.              */
+    /* -------------------------------------------------------------------- */
+    uint8_t        *slot[RW_SLOTS];
+    int             queue[RW_SLOTS];/* Queued slot numbers, oldest first.   */
+    int             q_cnt;
+    int             busy;           /* Worker is processing a slot.         */
+    int             slot_free[RW_SLOTS];
+    int             quit;
+
+    /* -------------------------------------------------------------------- */
+    /*  History.  Owned by the worker while it's running.                   */
+    /* -------------------------------------------------------------------- */
+    uint8_t        *head;
+    int             have_head;
+    uint8_t        *xbuf;           /* Delta before compression.            */
+    uint8_t        *cbuf;           /* Compressor output.                   */
+    uint8_t        *wrk;            /* Compressor work memory.              */
+    rw_ent_t       *ent;            /* Circular; 'first' is the oldest.     */
+    int             ent_cap, first, count;
+    size_t          mem_used;
+
+    plat_thread_t  *worker;
+    plat_mutex_t   *lock;
+    plat_cond_t    *work, *idle;
+
+    /* -------------------------------------------------------------------- */
+    /*  Statistics.                                                         */
+    /* -------------------------------------------------------------------- */
+    uint32_t        captures, drops, steps, evicted;
+    double          capture_time;   /* Emulator thread, staging copies.     */
+    double          pack_time;      /* Worker, delta + compression.         */
+    uint64_t        raw_bytes, packed_bytes;
+    size_t          high_water;
+} rewind_pvt_t;
+
+/* ======================================================================== */
+/*  RW_EVICT     -- Drop the oldest delta.                                  */
+/* ======================================================================== */
+LOCAL void rw_evict(rewind_pvt_t *const pvt)
+{
+    rw_ent_t *const e = &pvt->ent[pvt->first];
+
+    pvt->mem_used -= e->len;
+    free(e->data);
+    e->data = NULL;
+    pvt->first = (pvt->first + 1) % pvt->ent_cap;
+    pvt->count--;
+    pvt->evicted++;
+}
+
+/* ======================================================================== */
+/*  RW_PUSH      -- File a new delta as the newest entry.  Returns -1 if    */
+/*                  we're out of memory, in which case the delta is lost.   */
+/* ======================================================================== */
+LOCAL int rw_push(rewind_pvt_t *const pvt, const uint8_t *const data,
+                  const uint32_t len, const int raw)
+{
+    uint8_t *copy;
+
+    if (pvt->count == pvt->ent_cap)
+    {
+        const int new_cap = pvt->ent_cap ? pvt->ent_cap * 2 : 64;
+        rw_ent_t *new_ent = CALLOC(rw_ent_t, new_cap);
+        int i;
+
+        if (!new_ent)
+            return -1;
+
+        for (i = 0; i < pvt->count; i++)
+            new_ent[i] = pvt->ent[(pvt->first + i) % pvt->ent_cap];
+
+        free(pvt->ent);
+        pvt->ent     = new_ent;
+        pvt->ent_cap = new_cap;
+        pvt->first   = 0;
+    }
+
+    if (!(copy = (uint8_t *)malloc(len ? len : 1)))
+        return -1;
+
+    memcpy(copy, data, len);
+    {
+        rw_ent_t *const e =
+            &pvt->ent[(pvt->first + pvt->count) % pvt->ent_cap];
+        e->data = copy;
+        e->len  = len;
+        e->raw  = raw;
+    }
+    pvt->count++;
+    pvt->mem_used += len;
+
+    while (pvt->mem_used > pvt->mem_cap && pvt->count > 1)
+        rw_evict(pvt);
+
+    if (pvt->mem_used > pvt->high_water)
+        pvt->high_water = pvt->mem_used;
+
+    return 0;
+}
+
+/* ======================================================================== */
+/*  RW_PACK      -- Fold a staged capture into the history.                 */
+/* ======================================================================== */
+LOCAL void rw_pack(rewind_pvt_t *const pvt, const uint8_t *const cap)
+{
+    const double start = get_time();
+    const uint8_t *data = pvt->xbuf;
+    uint32_t len = pvt->size, i;
+    int raw = 1;
+
+    if (!pvt->have_head)
+    {
+        memcpy(pvt->head, cap, pvt->size);
+        pvt->have_head = 1;
+        pvt->pack_time += get_time() - start;
+        return;
+    }
+
+    for (i = 0; i < pvt->size; i++)
+        pvt->xbuf[i] = pvt->head[i] ^ cap[i];
+
+#ifndef NO_LZO
+    {
+        lzo_uint lzo_len = 0;
+        const int r = lzo1x_1_compress(pvt->xbuf, pvt->size, pvt->cbuf,
+                                       &lzo_len, (lzo_voidp)pvt->wrk);
+
+        if (r == LZO_E_OK && lzo_len < pvt->size)
+        {
+            data = pvt->cbuf;
+            len  = lzo_len;
+            raw  = 0;
+        }
+    }
+#endif
+
+    if (rw_push(pvt, data, len, raw) == 0)
+    {
+        pvt->raw_bytes    += pvt->size;
+        pvt->packed_bytes += len;
+    } else
+    {
+        /* Without this delta, the older ones no longer lead anywhere.      */
+        while (pvt->count > 0)
+            rw_evict(pvt);
+    }
+
+    memcpy(pvt->head, cap, pvt->size);
+    pvt->pack_time += get_time() - start;
+}
+
+/* ======================================================================== */
+/*  RW_WORKER    -- Pack staged captures as they arrive.                    */
+/* ======================================================================== */
+LOCAL int rw_worker(void *opaque)
+{
+    rewind_pvt_t *const pvt = (rewind_pvt_t *)opaque;
+
+    plat_mutex_lock(pvt->lock);
+    for (;;)
+    {
+        int s;
+
+        while (pvt->q_cnt == 0 && !pvt->quit)
+            plat_cond_wait(pvt->work, pvt->lock);
+
+        if (pvt->q_cnt == 0)
+            break;
+
+        s = pvt->queue[0];
+        memmove(&pvt->queue[0], &pvt->queue[1],
+                (RW_SLOTS - 1) * sizeof(pvt->queue[0]));
+        pvt->q_cnt--;
+        pvt->busy = 1;
+        plat_mutex_unlock(pvt->lock);
+
+        rw_pack(pvt, pvt->slot[s]);
+
+        plat_mutex_lock(pvt->lock);
+        pvt->busy = 0;
+        pvt->slot_free[s] = 1;
+        if (pvt->q_cnt == 0)
+            plat_cond_broadcast(pvt->idle);
+    }
+    plat_mutex_unlock(pvt->lock);
+
+    return 0;
+}
+
+/* ======================================================================== */
+/*  RW_WAIT_IDLE -- Wait for the worker to catch up.                        */
+/* ======================================================================== */
+LOCAL void rw_wait_idle(rewind_pvt_t *const pvt)
+{
+    if (!pvt->worker)
+        return;
+
+    plat_mutex_lock(pvt->lock);
+    while (pvt->q_cnt != 0 || pvt->busy)
+        plat_cond_wait(pvt->idle, pvt->lock);
+    plat_mutex_unlock(pvt->lock);
+}
+
+/* ======================================================================== */
+/*  REWIND_INIT  -- Start capturing every 'interval' frames, keeping no     */
+/*                  more than 'mem_cap' bytes of compressed history.        */
+/* ======================================================================== */
+int rewind_init
+(
+    rewind_t                *const rw,
+    const struct ser_snap_t *const snap,
+    const int                      interval,
+    const size_t                   mem_cap
+)
+{
+    rewind_pvt_t *pvt;
+    int i;
+
+    rw->pvt = NULL;
+
+    if (!snap || interval < 1 || mem_cap == 0)
+        return -1;
+
+    if (!(pvt = CALLOC(rewind_pvt_t, 1)))
+        goto fail;
+
+    pvt->snap      = snap;
+    pvt->size      = snap->size;
+    pvt->interval  = interval;
+    pvt->countdown = 1;
+    pvt->mem_cap   = mem_cap;
+
+    for (i = 0; i < RW_SLOTS; i++)
+    {
+        if (!(pvt->slot[i] = CALLOC(uint8_t, pvt->size)))
+            goto fail;
+        pvt->slot_free[i] = 1;
+    }
+
+    /* LZO can expand incompressible data by up to 1/16th plus a bit.       */
+    if (!(pvt->head = CALLOC(uint8_t, pvt->size))                         ||
+        !(pvt->xbuf = CALLOC(uint8_t, pvt->size))                         ||
+        !(pvt->cbuf = CALLOC(uint8_t, pvt->size + pvt->size / 16 + 67)))
+        goto fail;
+
+#ifndef NO_LZO
+    if (!(pvt->wrk = CALLOC(uint8_t, LZO1X_MEM_COMPRESS)))
+        goto fail;
+#endif
+
+    /* -------------------------------------------------------------------- */
+    /*  Without threads, rewind_frame() packs inline.                       */
+    /* -------------------------------------------------------------------- */
+    pvt->lock = plat_mutex_create();
+    pvt->work = plat_cond_create();
+    pvt->idle = plat_cond_create();
+
+    if (pvt->lock && pvt->work && pvt->idle)
+        pvt->worker = plat_thread_create(rw_worker, "jzintv rewind",
+                                         (void *)pvt);
+
+    rw->pvt = pvt;
+
+    jzp_printf("Rewind: Capturing every %d frame%s, %u bytes each, "
+               "history capped at %.1fMB%s\n",
+               interval, interval == 1 ? "" : "s", pvt->size,
+               mem_cap / 1048576.0, pvt->worker ? "" : " (no worker thread)");
+    return 0;
+
+fail:
+    fprintf(stderr, "rewind: Out of memory\n");
+    if (pvt)
+    {
+        for (i = 0; i < RW_SLOTS; i++)
+            CONDFREE(pvt->slot[i]);
+        CONDFREE(pvt->head);
+        CONDFREE(pvt->xbuf);
+        CONDFREE(pvt->cbuf);
+        CONDFREE(pvt->wrk);
+        free(pvt);
+    }
+    return -1;
+}
+
+/* ======================================================================== */
+/*  REWIND_FRAME -- Call once per displayed frame.  Takes a snapshot when   */
+/*                  one is due and hands it to the worker.                  */
+/* ======================================================================== */
+void rewind_frame(rewind_t *const rw)
+{
+    rewind_pvt_t *const pvt = rw->pvt;
+    double start;
+    int s;
+
+    if (!pvt)
+        return;
+
+    pvt->since++;
+    if (--pvt->countdown > 0)
+        return;
+
+    pvt->countdown = pvt->interval;
+
+    if (pvt->worker)
+        plat_mutex_lock(pvt->lock);
+
+    for (s = 0; s < RW_SLOTS && !pvt->slot_free[s]; s++)
+        ;
+
+    if (s < RW_SLOTS)
+        pvt->slot_free[s] = 0;
+
+    if (pvt->worker)
+        plat_mutex_unlock(pvt->lock);
+
+    if (s == RW_SLOTS)
+    {
+        pvt->drops++;
+        return;
+    }
+
+    start = get_time();
+    ser_snap_save(pvt->snap, pvt->slot[s]);
+    pvt->capture_time += get_time() - start;
+    pvt->captures++;
+    pvt->since = 0;
+
+    if (!pvt->worker)
+    {
+        rw_pack(pvt, pvt->slot[s]);
+        pvt->slot_free[s] = 1;
+        return;
+    }
+
+    plat_mutex_lock(pvt->lock);
+    pvt->queue[pvt->q_cnt++] = s;
+    plat_cond_signal(pvt->work);
+    plat_mutex_unlock(pvt->lock);
+}
+
+/* ======================================================================== */
+/*  REWIND_STEP  -- Step back one entry and restore it into the machine.    */
+/* ======================================================================== */
+int rewind_step(rewind_t *const rw)
+{
+    rewind_pvt_t *const pvt = rw->pvt;
+    rw_ent_t *e;
+
+    if (!pvt)
+        return -1;
+
+    rw_wait_idle(pvt);
+
+    if (!pvt->have_head)
+        return -1;
+
+    pvt->countdown = pvt->interval;
+
+    /* -------------------------------------------------------------------- */
+    /*  If we've run on since the newest capture, go back to it first.      */
+    /* -------------------------------------------------------------------- */
+    if (pvt->since > 0 || pvt->count == 0)
+    {
+        const int ret = pvt->since > 0 ? 0 : -1;
+        pvt->since = 0;
+        ser_snap_restore(pvt->snap, pvt->head);
+        return ret;
+    }
+
+    e = &pvt->ent[(pvt->first + pvt->count - 1) % pvt->ent_cap];
+
+    if (e->raw)
+        memcpy(pvt->xbuf, e->data, e->len);
+#ifndef NO_LZO
+    else
+    {
+        lzo_uint lzo_len = pvt->size;
+        const int r = lzo1x_decompress_safe(e->data, e->len, pvt->xbuf,
+                                            &lzo_len, NULL);
+        if (r != LZO_E_OK || lzo_len != pvt->size)
+        {
+            /* Shouldn't happen.  Drop the history rather than trust it.   */
+            fprintf(stderr, "rewind: History is corrupt; discarding it.\n");
+            while (pvt->count > 0)
+                rw_evict(pvt);
+            ser_snap_restore(pvt->snap, pvt->head);
+            return -1;
+        }
+    }
+#endif
+
+    {
+        uint32_t i;
+        for (i = 0; i < pvt->size; i++)
+            pvt->head[i] ^= pvt->xbuf[i];
+    }
+
+    pvt->mem_used -= e->len;
+    free(e->data);
+    e->data = NULL;
+    pvt->count--;
+    pvt->steps++;
+
+    ser_snap_restore(pvt->snap, pvt->head);
+    return 0;
+}
+
+/* ======================================================================== */
+/*  REWIND_IS_ACTIVE -- Returns non-zero if rewind has been started.        */
+/* ======================================================================== */
+int rewind_is_active(const rewind_t *const rw)
+{
+    return rw->pvt != NULL;
+}
+
+/* ======================================================================== */
+/*  REWIND_DTOR  -- Stop the worker, report statistics, free it all.        */
+/* ======================================================================== */
+void rewind_dtor(rewind_t *const rw)
+{
+    rewind_pvt_t *const pvt = rw->pvt;
+    int i;
+
+    if (!pvt)
+        return;
+
+    if (pvt->worker)
+    {
+        plat_mutex_lock(pvt->lock);
+        pvt->quit = 1;
+        plat_cond_signal(pvt->work);
+        plat_mutex_unlock(pvt->lock);
+        plat_thread_join(pvt->worker);
+    }
+
+    if (pvt->captures)
+    {
+        const uint32_t packed = pvt->captures - (pvt->have_head ? 1 : 0);
+
+        jzp_printf("Rewind: %u captures, %.1f usec each on the emulator "
+                   "thread, %.1f usec to pack\n",
+                   pvt->captures, 1e6 * pvt->capture_time / pvt->captures,
+                   packed ? 1e6 * pvt->pack_time / packed : 0.0);
+        jzp_printf("Rewind: %.1f:1 compression, %u entries (%u frames) "
+                   "held in %.1fKB, %.1fKB peak\n",
+                   pvt->packed_bytes ? (double)pvt->raw_bytes /
+                                       pvt->packed_bytes : 0.0,
+                   pvt->count, pvt->count * pvt->interval,
+                   pvt->mem_used / 1024.0, pvt->high_water / 1024.0);
+        jzp_printf("Rewind: %u steps back, %u evicted, %u dropped\n",
+                   pvt->steps, pvt->evicted, pvt->drops);
+    }
+
+    while (pvt->count > 0)
+        rw_evict(pvt);
+
+    for (i = 0; i < RW_SLOTS; i++)
+        CONDFREE(pvt->slot[i]);
+    CONDFREE(pvt->head);
+    CONDFREE(pvt->xbuf);
+    CONDFREE(pvt->cbuf);
+    CONDFREE(pvt->wrk);
+    CONDFREE(pvt->ent);
+    if (pvt->idle) plat_cond_destroy(pvt->idle);
+    if (pvt->work) plat_cond_destroy(pvt->work);
+    if (pvt->lock) plat_mutex_destroy(pvt->lock);
+    free(pvt);
+    rw->pvt = NULL;
+}
+
+#else /* NO_SERIALIZER */
+
+/* ======================================================================== */
+/*  Without the serializer, there's nothing to capture.                     */
+/* ======================================================================== */
+int rewind_init
+(
+    rewind_t                *const rw,
+    const struct ser_snap_t *const snap,
+    const int                      interval,
+    const size_t                   mem_cap
+)
+{
+    UNUSED(snap);
+    UNUSED(interval);
+    UNUSED(mem_cap);
+    rw->pvt = NULL;
+    fprintf(stderr, "Rewind is not supported in this build.\n");
+    return -1;
+}
+
+void rewind_frame(rewind_t *const rw)             { UNUSED(rw); }
+int  rewind_step(rewind_t *const rw)              { UNUSED(rw); return -1; }
+int  rewind_is_active(const rewind_t *const rw)   { UNUSED(rw); return 0; }
+void rewind_dtor(rewind_t *const rw)              { UNUSED(rw); }
+
+#endif /* NO_SERIALIZER */
+
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
@@ -0,0 +1,73 @@
+/*
+ * ============================================================================
+ *  Title:    Rewind Buffer
+ * ============================================================================
+ *  Captures a machine snapshot every few frames into a bounded history.
+ *  Each entry is the XOR of two consecutive snapshots, compressed with
+ *  minilzo.  Most of the machine doesn't change from one frame to the
+ *  next, so the deltas are mostly zeros and compress to very little.
+ *
+ *  The emulator thread only copies the snapshot into a staging slot.  A
+ *  worker thread does the XOR and compression work, and owns the history.
+ * ============================================================================
+ */
+#ifndef REWIND_REWIND_H_
+#define REWIND_REWIND_H_
+
+struct ser_snap_t;      /* forward decl */
+
+typedef struct rewind_t
+{
+    struct rewind_pvt_t *pvt;
+} rewind_t;
+
+/* ======================================================================== */
+/*  REWIND_INIT  -- Start capturing every 'interval' frames, keeping no     */
+/*                  more than 'mem_cap' bytes of compressed history.        */
+/*                  Returns 0 on success, -1 on failure.                    */
+/* ======================================================================== */
+int rewind_init
+(
+    rewind_t                *const rw,
+    const struct ser_snap_t *const snap,
+    const int                      interval,
+    const size_t                   mem_cap
+);
+
+/* ======================================================================== */
+/*  REWIND_FRAME -- Call once per displayed frame.  Takes a snapshot when   */
+/*                  one is due and hands it to the worker.                  */
+/* ======================================================================== */
+void rewind_frame(rewind_t *const rw);
+
+/* ======================================================================== */
+/*  REWIND_STEP  -- Step back one entry and restore it into the machine.    */
+/*                  The caller must resync whatever is derived from the     */
+/*                  machine state.  Returns -1 if no history is left.       */
+/*                  The oldest state stays put and is returned each time.   */
+/* ======================================================================== */
+int rewind_step(rewind_t *const rw);
+
+/* ======================================================================== */
+/*  REWIND_IS_ACTIVE -- Returns non-zero if rewind has been started.        */
+/*  REWIND_DTOR      -- Stop the worker, report statistics, free it all.    */
+/* ======================================================================== */
+int  rewind_is_active(const rewind_t *const rw);
+void rewind_dtor(rewind_t *const rw);
+
+#endif
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
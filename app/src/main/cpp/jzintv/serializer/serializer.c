@@ -17,7 +17,7 @@ int no_serializer;
 
 #include "serializer/serializer.h"
 
-static ser_hier_t *ser_hier = NULL;
+static THREAD_LOCAL ser_hier_t *ser_hier = NULL;
 
 /* ======================================================================== */
 /*  SER_REGISTER:  Register key/value pair that will be serialized.         */
@@ -134,16 +134,16 @@ ser_hier_t *ser_new_hierarchy
 /* ======================================================================== */
 /*  SER_GET_INT                                                             */
 /* ======================================================================== */
-uint64_t ser_get_int(void *object, ser_type_t type, void **next)
+uint64_t ser_get_int(const void *object, ser_type_t type, const void **next)
 {
     uint64_t value;
     union
     {
-        uint8_t  *pu8;   int8_t  *ps8;
-        uint16_t *pu16;  int16_t *ps16;
-        uint32_t *pu32;  int32_t *ps32;
-        uint64_t *pu64;  int64_t *ps64;
-        void    *v;
+        const uint8_t  *pu8;   const int8_t  *ps8;
+        const uint16_t *pu16;  const int16_t *ps16;
+        const uint32_t *pu32;  const int32_t *ps32;
+        const uint64_t *pu64;  const int64_t *ps64;
+        const void     *v;
     } ptr;
 
     ptr.v = object;
@@ -168,7 +168,7 @@ uint64_t ser_get_int(void *object, ser_type_t type, void **next)
     return value;
 }
 
-static char ser_int_buf[20];
+static THREAD_LOCAL char ser_int_buf[20];
 
 /* ======================================================================== */
 /*  SER_INT_TO_STR                                                          */
@@ -176,7 +176,7 @@ static char ser_int_buf[20];
 char *ser_int_to_str(uint64_t value, ser_type_t type, uint32_t flags, int fix)
 {
     const char *format;
-    static char ffmt[10];
+    static THREAD_LOCAL char ffmt[10];
 
     if (flags & SER_HEX)
     {
@@ -236,10 +236,10 @@ void ser_print_array
     int         indent
 )
 {
-    int      i, l, col;
-    void    *p;
-    uint64_t v;
-    char    *s;
+    int         i, l, col;
+    const void *p;
+    uint64_t    v;
+    char       *s;
 
     fprintf(f, "%*s%s =\n%*s{\n%*s",
             indent, "", obj->name, indent, "", indent + 4, "");
@@ -383,6 +383,377 @@ void ser_print_hierarchy(FILE *f, ser_hier_t *node, int init, int indent)
     return;
 }
 
+/* ======================================================================== */
+/*  SER_DTOR:  Discard the entire hierarchy.                                */
+/* ======================================================================== */
+LOCAL void ser_dtor_hier(ser_hier_t *node)
+{
+    while (node)
+    {
+        ser_hier_t *next = node->next;
+        ser_list_t *obj  = node->obj_list;
+
+        ser_dtor_hier(node->hier_list);
+
+        while (obj)
+        {
+            ser_list_t *next_obj = obj->next;
+            free(obj->name);
+            free(obj);
+            obj = next_obj;
+        }
+
+        free(node->name);
+        free(node);
+        node = next;
+    }
+}
+
+void ser_dtor(void)
+{
+    ser_dtor_hier(ser_hier);
+    ser_hier = NULL;
+}
+
+/* ======================================================================== */
+/*  Binary snapshots.                                                       */
+/*                                                                          */
+/*  The hierarchy is walked once to produce a flat list of (object, offset, */
+/*  length) steps.  Saving and restoring are then just a loop of memcpy's   */
+/*  into and out of an arena, with no per-object interpretation.  The data  */
+/*  is kept in host byte order; the file format records which that is.     */
+/*                                                                          */
+/*  File layout:                                                            */
+/*      "jzIntvSS"      8 byte magic                                        */
+/*      version         uint32_t, SER_SNAP_VERSION                          */
+/*      byte order      uint32_t, 0x01020304 as written by the host         */
+/*      signature       uint32_t, hash of the planned names/types/lengths   */
+/*      init_size       uint32_t, bytes of SER_INIT data that follow        */
+/*      size            uint32_t, bytes of state that follow that           */
+/* ======================================================================== */
+LOCAL const char ser_snap_magic[8] = { 'j','z','I','n','t','v','S','S' };
+#define SER_SNAP_BOM (0x01020304u)
+
+LOCAL const uint32_t ser_type_size[] = { 1, 1, 2, 2, 4, 4, 8, 8, 0 };
+
+/* ------------------------------------------------------------------------ */
+/*  SER_SNAP_HASH -- FNV-1a, folded over everything that defines the plan.  */
+/* ------------------------------------------------------------------------ */
+LOCAL uint32_t ser_snap_hash(uint32_t h, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    while (len-- > 0)
+        h = (h ^ *p++) * 0x01000193u;
+
+    return h;
+}
+
+/* ------------------------------------------------------------------------ */
+/*  SER_SNAP_WALK -- Visit every snapshot-worthy object in hierarchy order. */
+/*                   With 'snap->copy' NULL, just counts.                   */
+/* ------------------------------------------------------------------------ */
+LOCAL void ser_snap_walk(ser_snap_t *snap, ser_hier_t *node)
+{
+    for (; node; node = node->next)
+    {
+        ser_list_t *obj;
+
+        snap->sig = ser_snap_hash(snap->sig, node->name, strlen(node->name));
+        ser_snap_walk(snap, node->hier_list);
+
+        for (obj = node->obj_list; obj; obj = obj->next)
+        {
+            const uint32_t length = ser_type_size[obj->type] * obj->length;
+            const uint32_t desc[3] =
+                { (uint32_t)obj->type, (uint32_t)obj->length,
+                  obj->flags & SER_INIT };
+            ser_copy_t *step;
+
+            if (obj->type == ser_string || (obj->flags & SER_INFO) ||
+                length == 0)
+                continue;
+
+            snap->sig = ser_snap_hash(snap->sig, obj->name, strlen(obj->name));
+            snap->sig = ser_snap_hash(snap->sig, desc, sizeof(desc));
+
+            /* ------------------------------------------------------------ */
+            /*  SER_INIT objects are verified individually, so that we can  */
+            /*  name the culprit.  Everything else is merged when it's      */
+            /*  contiguous with the previous step.                          */
+            /* ------------------------------------------------------------ */
+            if (obj->flags & SER_INIT)
+            {
+                if (snap->init)
+                {
+                    step = &snap->init[snap->init_cnt];
+                    step->object = obj->object;
+                    step->offset = snap->init_size;
+                    step->length = length;
+                    step->hier   = node;
+                    step->obj    = obj;
+                }
+                snap->init_cnt++;
+                snap->init_size += length;
+                continue;
+            }
+
+            if (snap->copy && snap->copy_cnt > 0)
+            {
+                step = &snap->copy[snap->copy_cnt - 1];
+                if ((uint8_t *)step->object + step->length ==
+                    (uint8_t *)obj->object)
+                {
+                    step->length += length;
+                    snap->size   += length;
+                    continue;
+                }
+            }
+
+            if (snap->copy)
+            {
+                step = &snap->copy[snap->copy_cnt];
+                step->object = obj->object;
+                step->offset = snap->size;
+                step->length = length;
+                step->hier   = node;
+                step->obj    = obj;
+            }
+            snap->copy_cnt++;
+            snap->size += length;
+        }
+    }
+}
+
+/* ======================================================================== */
+/*  SER_SNAP_PLAN    -- Walk the hierarchy once and build a copy plan.      */
+/* ======================================================================== */
+ser_snap_t *ser_snap_plan(void)
+{
+    ser_snap_t *snap = CALLOC(ser_snap_t, 1);
+
+    if (!snap)
+        return NULL;
+
+    /* -------------------------------------------------------------------- */
+    /*  Count first, then fill in.  The count is an upper bound on the      */
+    /*  number of steps, since the fill pass merges adjacent objects.       */
+    /* -------------------------------------------------------------------- */
+    ser_snap_walk(snap, ser_hier);
+
+    if (snap->copy_cnt == 0)
+        goto fail;
+
+    snap->copy  = CALLOC(ser_copy_t, snap->copy_cnt);
+    snap->init  = CALLOC(ser_copy_t, snap->init_cnt + 1);
+    snap->arena = CALLOC(uint8_t,    snap->size);
+
+    if (!snap->copy || !snap->init || !snap->arena)
+        goto fail;
+
+    snap->copy_cnt  = snap->init_cnt  = 0;
+    snap->size      = snap->init_size = 0;
+    snap->sig       = 0;
+    ser_snap_walk(snap, ser_hier);
+
+    return snap;
+
+fail:
+    ser_snap_dtor(snap);
+    return NULL;
+}
+
+/* ======================================================================== */
+/*  SER_SNAP_DTOR    -- Free a copy plan and its arena.                     */
+/* ======================================================================== */
+void ser_snap_dtor(ser_snap_t *snap)
+{
+    if (!snap)
+        return;
+
+    CONDFREE(snap->copy);
+    CONDFREE(snap->init);
+    CONDFREE(snap->arena);
+    free(snap);
+}
+
+/* ======================================================================== */
+/*  SER_SNAP_SAVE    -- Copy the machine state into 'arena'.                */
+/* ======================================================================== */
+void ser_snap_save(const ser_snap_t *snap, uint8_t *arena)
+{
+    const ser_copy_t *step = snap->copy;
+    const ser_copy_t *end  = step + snap->copy_cnt;
+
+    for (; step != end; step++)
+        memcpy(arena + step->offset, step->object, step->length);
+}
+
+/* ======================================================================== */
+/*  SER_SNAP_RESTORE -- Copy 'arena' back into the machine.                 */
+/* ======================================================================== */
+void ser_snap_restore(const ser_snap_t *snap, const uint8_t *arena)
+{
+    const ser_copy_t *step = snap->copy;
+    const ser_copy_t *end  = step + snap->copy_cnt;
+
+    for (; step != end; step++)
+        memcpy(step->object, arena + step->offset, step->length);
+}
+
+/* ======================================================================== */
+/*  SER_SNAP_OFFSET  -- Find where 'length' bytes at 'object' live in the   */
+/*                      arena.  Returns -1 if they aren't all captured.     */
+/* ======================================================================== */
+int32_t ser_snap_offset(const ser_snap_t *snap, const void *object,
+                        uint32_t length)
+{
+    const uint8_t *const obj = (const uint8_t *)object;
+    int i;
+
+    for (i = 0; i < snap->copy_cnt; i++)
+    {
+        const ser_copy_t *step = &snap->copy[i];
+        const uint8_t    *base = (const uint8_t *)step->object;
+
+        if (obj >= base && obj + length <= base + step->length)
+            return (int32_t)(step->offset + (obj - base));
+    }
+
+    return -1;
+}
+
+/* ======================================================================== */
+/*  SER_SNAP_VERIFY_INIT -- Compare SER_INIT objects against an image.      */
+/* ======================================================================== */
+int ser_snap_verify_init(const ser_snap_t *snap, const uint8_t *init_img)
+{
+    int i, bad = 0;
+
+    for (i = 0; i < snap->init_cnt; i++)
+    {
+        const ser_copy_t *step = &snap->init[i];
+        const uint8_t    *img  = init_img + step->offset;
+
+        if (!memcmp(step->object, img, step->length))
+            continue;
+
+        bad++;
+        fprintf(stderr, "Snapshot: %s.%s differs from the current setup",
+                step->hier->name, step->obj->name);
+
+        if (step->obj->length == 1)
+        {
+            fprintf(stderr, " (saved %s,", ser_int_to_str(
+                    ser_get_int(img, step->obj->type, NULL),
+                    step->obj->type, step->obj->flags, 0));
+            fprintf(stderr, " current %s)", ser_int_to_str(
+                    ser_get_int(step->object, step->obj->type, NULL),
+                    step->obj->type, step->obj->flags, 0));
+        }
+        fputc('\n', stderr);
+    }
+
+    return bad;
+}
+
+/* ======================================================================== */
+/*  SER_SNAP_WRITE   -- Write 'arena' to a file in the versioned format.    */
+/* ======================================================================== */
+int ser_snap_write(const ser_snap_t *snap, const uint8_t *arena, FILE *f)
+{
+    uint32_t hdr[5];
+    int i;
+
+    hdr[0] = SER_SNAP_VERSION;
+    hdr[1] = SER_SNAP_BOM;
+    hdr[2] = snap->sig;
+    hdr[3] = snap->init_size;
+    hdr[4] = snap->size;
+
+    if (fwrite(ser_snap_magic, sizeof(ser_snap_magic), 1, f) != 1 ||
+        fwrite(hdr, sizeof(hdr), 1, f) != 1)
+        return -1;
+
+    for (i = 0; i < snap->init_cnt; i++)
+        if (fwrite(snap->init[i].object, snap->init[i].length, 1, f) != 1)
+            return -1;
+
+    if (fwrite(arena, snap->size, 1, f) != 1)
+        return -1;
+
+    return 0;
+}
+
+/* ======================================================================== */
+/*  SER_SNAP_READ    -- Read a file into 'arena', checking compatibility.   */
+/* ======================================================================== */
+int ser_snap_read(const ser_snap_t *snap, uint8_t *arena, FILE *f)
+{
+    char magic[sizeof(ser_snap_magic)];
+    uint32_t hdr[5];
+    uint8_t *init_img = NULL;
+
+    if (fread(magic, sizeof(magic), 1, f) != 1 ||
+        fread(hdr, sizeof(hdr), 1, f) != 1 ||
+        memcmp(magic, ser_snap_magic, sizeof(magic)))
+    {
+        fprintf(stderr, "Snapshot: not a jzIntv snapshot\n");
+        return -1;
+    }
+
+    if (hdr[0] != SER_SNAP_VERSION)
+    {
+        fprintf(stderr, "Snapshot: unsupported version %u (expected %d)\n",
+                hdr[0], SER_SNAP_VERSION);
+        return -1;
+    }
+
+    if (hdr[1] != SER_SNAP_BOM)
+    {
+        fprintf(stderr, "Snapshot: written on a host with another "
+                        "byte order\n");
+        return -1;
+    }
+
+    if (hdr[2] != snap->sig || hdr[3] != snap->init_size ||
+        hdr[4] != snap->size)
+    {
+        fprintf(stderr, "Snapshot: saved from a different machine "
+                        "configuration\n");
+        return -1;
+    }
+
+    if (snap->init_size)
+    {
+        if (!(init_img = CALLOC(uint8_t, snap->init_size)))
+            goto fail;
+
+        if (fread(init_img, snap->init_size, 1, f) != 1)
+        {
+            fprintf(stderr, "Snapshot: file is truncated\n");
+            goto fail;
+        }
+
+        if (ser_snap_verify_init(snap, init_img))
+            goto fail;
+
+        CONDFREE(init_img);
+    }
+
+    if (fread(arena, snap->size, 1, f) != 1)
+    {
+        fprintf(stderr, "Snapshot: file is truncated\n");
+        return -1;
+    }
+
+    return 0;
+
+fail:
+    CONDFREE(init_img);
+    return -1;
+}
+
 #endif
 
 /* ======================================================================== */
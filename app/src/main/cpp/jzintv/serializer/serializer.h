@@ -14,6 +14,7 @@
 #ifdef NO_SERIALIZER
 
 typedef void ser_hier_t;
+typedef void ser_snap_t;
 
 #else
 
@@ -30,7 +31,7 @@ typedef struct ser_hier_t ser_hier_t;
 struct ser_list_t
 {
     struct ser_list_t *next;
-    const char *name;
+    char       *name;
     void       *object;
     ser_type_t  type;
     int         length;
@@ -43,7 +44,7 @@ struct ser_hier_t
     ser_hier_t  *next;
     ser_hier_t  *parent;
     ser_hier_t  *hier_list;
-    const char  *name;
+    char        *name;
     ser_list_t  *obj_list;
     uint32_t     flags;
 };
@@ -55,6 +56,38 @@ struct ser_hier_t
 #define SER_MAND    (0x0010)
 #define SER_SEEN    (0x0020)
 
+/* ======================================================================== */
+/*  SER_COPY_T   -- One step of a snapshot copy plan:  'length' bytes at    */
+/*                  'object' live at 'offset' in the snapshot arena.        */
+/*                  Adjacent objects get merged into a single step.         */
+/*  SER_SNAP_T   -- A flattened view of the hierarchy for binary snapshots. */
+/*                  SER_INFO objects and strings are not captured.          */
+/*                  SER_INIT objects are kept apart and are only verified,  */
+/*                  never restored.                                         */
+/* ======================================================================== */
+typedef struct ser_copy_t
+{
+    void             *object;   /*  Where the bytes live in the emulator.   */
+    uint32_t          offset;   /*  Where they live in the arena.           */
+    uint32_t          length;   /*  Number of bytes.                        */
+    const ser_hier_t *hier;     /*  First object in this step, for errors.  */
+    const ser_list_t *obj;
+} ser_copy_t;
+
+typedef struct ser_snap_t
+{
+    ser_copy_t  *copy;          /*  Copy plan for the emulator state.       */
+    int          copy_cnt;
+    ser_copy_t  *init;          /*  SER_INIT objects, verified on load.     */
+    int          init_cnt;
+    uint32_t     size;          /*  Bytes in one snapshot.                  */
+    uint32_t     init_size;     /*  Bytes of SER_INIT data in a file.       */
+    uint32_t     sig;           /*  Hash of the names/types/sizes planned.  */
+    uint8_t     *arena;         /*  One preallocated snapshot of 'size'.    */
+} ser_snap_t;
+
+#define SER_SNAP_VERSION (1)
+
 
 /* ======================================================================== */
 /*  SER_REGISTER:  Register key/value pair that will be serialized.         */
@@ -81,7 +114,8 @@ ser_hier_t *ser_new_hierarchy
 /* ======================================================================== */
 /*  SER_GET_INT                                                             */
 /* ======================================================================== */
-uint64_t ser_get_int(void *object, ser_type_t type, void **next);
+uint64_t ser_get_int(const void *object, ser_type_t type,
+                     const void **next);
 
 /* ======================================================================== */
 /*  SER_INT_TO_STR                                                          */
@@ -124,6 +158,53 @@ void ser_print_string
 /* ======================================================================== */
 void ser_print_hierarchy(FILE *f, ser_hier_t *node, int init, int indent);
 
+/* ======================================================================== */
+/*  SER_DTOR:  Discard the entire hierarchy.  Any ser_snap_t built from it  */
+/*             must be freed first.                                         */
+/* ======================================================================== */
+void ser_dtor(void);
+
+/* ======================================================================== */
+/*  SER_SNAP_PLAN    -- Walk the hierarchy once and build a copy plan.      */
+/*                      Returns NULL if nothing is registered.              */
+/*  SER_SNAP_DTOR    -- Free a copy plan and its arena.                     */
+/* ======================================================================== */
+ser_snap_t *ser_snap_plan(void);
+void ser_snap_dtor(ser_snap_t *snap);
+
+/* ======================================================================== */
+/*  SER_SNAP_SAVE    -- Copy the machine state into 'arena' (snap->size).   */
+/*  SER_SNAP_RESTORE -- Copy 'arena' back into the machine.                 */
+/*                                                                          */
+/*  These are straight memcpy loops, safe to call once per frame.  The      */
+/*  caller is responsible for resyncing anything derived from the state.    */
+/* ======================================================================== */
+void ser_snap_save   (const ser_snap_t *snap, uint8_t *arena);
+void ser_snap_restore(const ser_snap_t *snap, const uint8_t *arena);
+
+/* ======================================================================== */
+/*  SER_SNAP_OFFSET  -- Where do 'length' bytes at 'object' live in the     */
+/*                      arena?  Lets callers pick out parts of a snapshot.  */
+/*                      Returns -1 if they aren't all captured.             */
+/* ======================================================================== */
+int32_t ser_snap_offset(const ser_snap_t *snap, const void *object,
+                        uint32_t length);
+
+/* ======================================================================== */
+/*  SER_SNAP_VERIFY_INIT -- Compare SER_INIT objects against an image       */
+/*                          captured earlier.  Returns # of mismatches.     */
+/* ======================================================================== */
+int ser_snap_verify_init(const ser_snap_t *snap, const uint8_t *init_img);
+
+/* ======================================================================== */
+/*  SER_SNAP_WRITE   -- Write 'arena' to a file in the versioned format.    */
+/*  SER_SNAP_READ    -- Read a file into 'arena', checking the version,     */
+/*                      the plan signature and the SER_INIT objects.        */
+/*                      'arena' is only meaningful if this returns 0.       */
+/* ======================================================================== */
+int ser_snap_write(const ser_snap_t *snap, const uint8_t *arena, FILE *f);
+int ser_snap_read (const ser_snap_t *snap, uint8_t *arena, FILE *f);
+
 
 #endif
 #endif
@@ -23,6 +23,7 @@
  */
 
 struct avi_writer_t;    /* forward decl */
+struct strm_t;          /* forward decl */
 typedef struct snd_pvt_t *snd_pvt_p;
 typedef struct snd_t     *snd_p;
 
@@ -68,12 +69,42 @@ typedef struct snd_t
     int         raw_start;      /* FLAG: To suppress silence @ start    */
 
     int         buf_size;
-    int         buf_cnt;
+    int         buf_cnt;        /* Buffers allocated per pool.          */
+    int         active_cnt;     /* Mix buffers allowed in flight.       */
+
+    int         auto_thresh;    /* --snd-auto: Underruns per 1000 audio */
+                                /*  callbacks tolerated.  0 == off.     */
+    uint64_t    tot_underrun;   /* Callbacks that found no mixed audio. */
+
+    struct strm_t *strm;        /* Raw stream output, if any.           */
+    bool        hash_on;        /* FLAG: Add mixed audio to 'hash'.     */
+    uint32_t    hash;           /* CRC32 of the audio hashed so far.    */
 
     snd_pvt_p   pvt;            /* Private stuff (API specific)         */
 } snd_t;
 
 
+/*
+ * ============================================================================
+ *  SND_LAT_STATS_T -- Snapshot of the audio output latency statistics.
+ *                     Latency is measured from when snd_tick places a mixed
+ *                     buffer on the dirty list to when the audio callback
+ *                     consumes it, plus the one buffer the device is
+ *                     playing.  Jitter is each callback period's deviation
+ *                     from the nominal buf_size / rate.  All in msec.
+ * ============================================================================
+ */
+typedef struct snd_lat_stats_t
+{
+    double      lat_p50, lat_p95, lat_p99;  /* Output latency percentiles.  */
+    double      jit_p50, jit_p99;           /* Callback jitter percentiles. */
+    uint64_t    underruns;                  /* Total underruns so far.      */
+    int         num_samples;                /* # of samples in percentiles. */
+    int         buf_size;                   /* Current buffer size.         */
+    int         buf_cnt;                    /* Current in-flight buffers.   */
+    int         auto_tune;                  /* Non-zero if --snd-auto.      */
+} snd_lat_stats_t;
+
 /*
  * ============================================================================
  *  SND_REGISTER -- Registers a sound input buffer with the sound object
@@ -89,7 +120,15 @@ int snd_register(periph_t *const snd, snd_buf_t *const src);
 int snd_init(snd_t *snd, int rate, char *raw_file,
              int user_snd_buf_size, int user_snd_buf_cnt,
              struct avi_writer_t *const avi, int pal_mode,
-             double time_scale);
+             double time_scale, int snd_auto);
+
+/*
+ * ============================================================================
+ *  SND_GET_LAT_STATS -- Compute latency/jitter percentiles over the most
+ *                       recent audio callbacks.
+ * ============================================================================
+ */
+void snd_get_lat_stats(snd_t *const snd, snd_lat_stats_t *const stats);
 
 /*
  * ============================================================================
@@ -105,6 +144,15 @@ void snd_play_silence(snd_t *const snd);
  */
 void snd_play_static(snd_t *const snd);
 
+/*
+ * ============================================================================
+ *  SND_WARM     -- While enabled, tearing down a snd_t pauses the audio
+ *                  device instead of closing it, and the next snd_init that
+ *                  asks for the same format picks it up.  0 closes it.
+ * ============================================================================
+ */
+void snd_warm(int enable);
+
 
 #endif
 /* ======================================================================== */
@@ -16,8 +16,10 @@
 #include "periph/periph.h"
 #include "snd.h"
 #include "avi/avi.h"
+#include "strm/strm.h"
+#include "misc/crc32.h"
 
-LOCAL int32_t *mixbuf = NULL;
+LOCAL THREAD_LOCAL int32_t *mixbuf = NULL;
 LOCAL uint32_t snd_tick(periph_t *const periph, uint32_t len);
 
 /* ======================================================================== */
@@ -154,11 +156,11 @@ LOCAL uint32_t snd_tick(periph_t *const periph, uint32_t len)
 
     /* -------------------------------------------------------------------- */
     /*  Try to drop everything coming to us.  However, if we're dumping     */
-    /*  sound to a raw audio file or AVI, don't actually drop anything      */
-    /*  until after we've written the audio out to file.                    */
+    /*  sound to a raw audio file, AVI or stream, or hashing it, don't      */
+    /*  actually drop anything until after we've written the audio out.     */
     /* -------------------------------------------------------------------- */
     try_drop = min_num_dirty;
-    if (snd->raw_file || avi_active)
+    if (snd->raw_file || avi_active || snd->strm || snd->hash_on)
     {
         dly_drop = try_drop;
         try_drop = 0;
@@ -251,6 +253,25 @@ one_source:
             avi_record_audio(snd->pvt->avi, clean, snd->buf_size,
                              !not_silent);
 
+        /* ---------------------------------------------------------------- */
+        /*  Likewise for the raw stream output.                             */
+        /* ---------------------------------------------------------------- */
+        if (snd->strm)
+            strm_audio(snd->strm, clean, snd->buf_size, snd->periph.now);
+
+        /* ---------------------------------------------------------------- */
+        /*  And to the audio hash, on a bounded run (--max-frames).  The    */
+        /*  samples are hashed little-endian, whatever the host.            */
+        /* ---------------------------------------------------------------- */
+        if (snd->hash_on)
+#ifdef BYTE_LE
+            snd->hash = crc32_block(snd->hash, (const uint8_t *)clean,
+                                    snd->buf_size * 2);
+#else
+            for (j = 0; j < snd->buf_size; j++)
+                snd->hash = crc32_upd16(snd->hash, clean[j]);
+#endif
+
         /* ---------------------------------------------------------------- */
         /*  If we're also writing this out to an audio file, do that last.  */
         /* ---------------------------------------------------------------- */
@@ -402,7 +423,8 @@ LOCAL void snd_dtor(periph_t *const p);
  */
 int snd_init(snd_t *snd, int rate, char *raw_file,
              int user_snd_buf_size, int user_snd_buf_cnt,
-             struct avi_writer_t *const avi, int pal_mode, double time_scale)
+             struct avi_writer_t *const avi, int pal_mode, double time_scale,
+             int snd_auto)
 {
     int i;
 
@@ -422,6 +444,10 @@ int snd_init(snd_t *snd, int rate, char *raw_file,
     snd->buf_cnt  = user_snd_buf_cnt  > 0 ? user_snd_buf_cnt
                   :                         SND_BUF_CNT_DEFAULT;
 
+    /* No audio device, so nothing to tune. */
+    snd->active_cnt = snd->buf_cnt;
+    UNUSED(snd_auto);
+
 
     /* -------------------------------------------------------------------- */
     /*  Hook in AVI writer.                                                 */
@@ -531,10 +557,22 @@ LOCAL void snd_dtor(periph_t *const p)
  * ============================================================================
  *  SND_PLAY_SILENCE -- Pump silent audio frame. (Used during reset.) 
  *  SND_PLAY_STATIC  -- A silly bit of fun.
+ *  SND_WARM         -- No device to keep open.
  * ============================================================================
  */
 void snd_play_silence(snd_t *const snd) { UNUSED(snd); }
 void snd_play_static (snd_t *const snd) { UNUSED(snd); }
+void snd_warm(int enable)               { UNUSED(enable); }
+
+/* ======================================================================== */
+/*  SND_GET_LAT_STATS -- No audio device, so no latency to speak of.        */
+/* ======================================================================== */
+void snd_get_lat_stats(snd_t *const snd, snd_lat_stats_t *const stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->buf_size = snd->buf_size;
+    stats->buf_cnt  = snd->active_cnt;
+}
 
 /* ======================================================================== */
 /*  This program is free software; you can redistribute it and/or modify    */
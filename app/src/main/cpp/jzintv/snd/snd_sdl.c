@@ -10,6 +10,7 @@
  *  SND_FILL     -- Audio callback used by SDL for filling SDL's buffers.
  *  SND_REGISTER -- Registers a PSG with the SND module.
  *  SND_INIT     -- Initialize a SND_T
+ *  SND_GET_LAT_STATS -- Report output latency and callback jitter.
  * ============================================================================
  */
 
@@ -19,20 +20,65 @@
 #include "periph/periph.h"
 #include "snd.h"
 #include "avi/avi.h"
+#include "strm/strm.h"
+#include "misc/crc32.h"
 #include "plat/plat_lib.h"
 
 LOCAL int32_t *mixbuf = NULL;
 LOCAL uint32_t snd_tick(periph_t *const periph, uint32_t len);
 
+/* ======================================================================== */
+/*  Between warm launches the audio device stays open, paused.  Remember    */
+/*  what it was opened with and what we got, to reuse it when that holds.   */
+/*  Each launch has its own snd_t, so the device is opened with the address */
+/*  of snd_dev_snd as its userdata, and snd_fill looks the snd_t up there.  */
+/* ======================================================================== */
+LOCAL bool          snd_keep   = false;
+LOCAL bool          snd_parked = false;
+LOCAL SDL_AudioSpec snd_dev_wanted, snd_dev_actual;
+LOCAL snd_t        *snd_dev_snd = NULL;
+
+/* ======================================================================== */
+/*  SND_WARM     -- Park the audio device on teardown from now on, or not.  */
+/* ======================================================================== */
+void snd_warm(int enable)
+{
+    snd_keep = enable;
+    if (!enable && snd_parked)
+    {
+        SDL_CloseAudio();
+        snd_parked = false;
+    }
+}
+
 /* ======================================================================== */
 /*  SND Private structure                                                   */
 /*  All sound API specific stuff (SDL in this case) goes here.              */
 /* ======================================================================== */
+#define SND_LAT_HIST      (1024)    /* Callbacks of history to keep.     */
+#define SND_AUTO_WINDOW   (256)     /* Callbacks per --snd-auto verdict. */
+#define SND_AUTO_HOLD_MAX (64)      /* Most clean windows to tighten.    */
+
 typedef struct snd_pvt_t
 {
     SDL_AudioSpec   *audio_fmt;
     SDL_AudioCVT    *audio_cvt;
     avi_writer_t    *avi;
+
+    /* Latency instrumentation.  Everything here is under SDL_LockAudio. */
+    double          *dirty_time;    /* When each dirty mixbuf was queued.   */
+    double           last_fill;     /* When snd_fill last ran.              */
+    float            lat_hist[SND_LAT_HIST];    /* Output latency, msec.    */
+    float            jit_hist[SND_LAT_HIST];    /* Callback jitter, msec.   */
+    int              lat_idx, lat_cnt;
+    int              jit_idx, jit_cnt;
+
+    /* --snd-auto tuning state. */
+    uint64_t         win_frame;     /* tot_frame at start of window.        */
+    uint64_t         win_underrun;  /* tot_underrun at start of window.     */
+    int              clean_win;     /* Consecutive windows w/out trouble.   */
+    int              hold_win;      /* Clean windows needed to tighten.     */
+    bool             warned_max;    /* Already complained we're maxed out.  */
 } snd_pvt_t;
 
 
@@ -111,6 +157,88 @@ LOCAL void snd_update_wav_hdr(FILE *f, int rate)
     }
 }
 
+/* ======================================================================== */
+/*  SND_NUM_AVAIL -- How many clean mix buffers we may fill without going   */
+/*                   over the active in-flight count.  Audio must be locked.*/
+/* ======================================================================== */
+LOCAL int snd_num_avail(const snd_t *const snd)
+{
+    const int reserved = snd->mixbuf.tot_buf - snd->active_cnt;
+    const int avail    = snd->mixbuf.num_clean - reserved;
+
+    return avail > 0 ? avail : 0;
+}
+
+/* ======================================================================== */
+/*  SND_QUEUE_DIRTY -- Put a mix buffer on the dirty list for snd_fill, and */
+/*                     timestamp it.  Audio must be locked.                 */
+/* ======================================================================== */
+LOCAL void snd_queue_dirty(snd_t *const snd, int16_t *const buf)
+{
+    if (snd->mixbuf.num_dirty == 0)
+        snd->mixbuf.top_dirty_ptr = 0;
+
+    snd->pvt->dirty_time[snd->mixbuf.num_dirty] = get_time();
+    snd->mixbuf.dirty[snd->mixbuf.num_dirty++]  = buf;
+}
+
+/* ======================================================================== */
+/*  SND_HIST_ADD -- Add a sample (in seconds) to a msec history ring.       */
+/* ======================================================================== */
+LOCAL void snd_hist_add(float *const hist, int *const idx, int *const cnt,
+                        const double sec)
+{
+    hist[*idx] = (float)(sec * 1000.0);
+    *idx = (*idx + 1) % SND_LAT_HIST;
+    if (*cnt < SND_LAT_HIST)
+        (*cnt)++;
+}
+
+/* ======================================================================== */
+/*  SND_AUTO_TUNE -- Once per window of callbacks, grow the number of mix   */
+/*                   buffers in flight if we're underrunning too often, or  */
+/*                   shrink it after a run of clean windows.  Each time we  */
+/*                   have to back off, we wait longer before tightening     */
+/*                   again so we don't oscillate.  Audio must be locked.    */
+/*                                                                          */
+/*  The buffer size itself is chosen once in snd_init, as the PSG and       */
+/*  Intellivoice size their own buffers from it.                            */
+/* ======================================================================== */
+LOCAL void snd_auto_tune(snd_t *const snd)
+{
+    snd_pvt_t *const pvt = snd->pvt;
+    const uint64_t frames    = snd->tot_frame    - pvt->win_frame;
+    const uint64_t underruns = snd->tot_underrun - pvt->win_underrun;
+
+    if (frames < SND_AUTO_WINDOW)
+        return;
+
+    pvt->win_frame    = snd->tot_frame;
+    pvt->win_underrun = snd->tot_underrun;
+
+    if (underruns * 1000 > (uint64_t)snd->auto_thresh * frames)
+    {
+        if (snd->active_cnt < snd->mixbuf.tot_buf)
+            snd->active_cnt++;
+        else if (!pvt->warned_max)
+        {
+            jzp_printf("\nsnd:  Still underrunning with %d buffers of %d; "
+                       "try a larger --audiobufsize\n",
+                       snd->active_cnt, snd->buf_size);
+            pvt->warned_max = true;
+        }
+
+        pvt->clean_win = 0;
+        if (pvt->hold_win < SND_AUTO_HOLD_MAX)
+            pvt->hold_win *= 2;
+    } else if (underruns == 0 && ++pvt->clean_win >= pvt->hold_win)
+    {
+        if (snd->active_cnt > SND_AUTO_MIN_CNT)
+            snd->active_cnt--;
+        pvt->clean_win = 0;
+    }
+}
+
 int force_sound_atten = 0;
 int old_sound_atten;
 /*
@@ -162,7 +290,10 @@ LOCAL uint32_t snd_tick(periph_t *const periph, uint32_t len)
     /*  progress.  If we're uncontrolled, try to drop incoming audio.       */
     /* -------------------------------------------------------------------- */
     SDL_LockAudio();
-    if (snd->mixbuf.num_clean == 0)
+    if (snd->auto_thresh > 0)
+        snd_auto_tune(snd);
+
+    if (snd_num_avail(snd) == 0)
     {
         if (snd->time_scale > 0)
         {
@@ -211,7 +342,7 @@ LOCAL uint32_t snd_tick(periph_t *const periph, uint32_t len)
     /*  the number of clean buffers we have available, also taking into     */
     /*  account the room we'll have since we're dropping buffers.           */
     /* -------------------------------------------------------------------- */
-    min_num_dirty = snd->mixbuf.num_clean + try_drop;
+    min_num_dirty = snd_num_avail(snd) + try_drop;
     for (i = 0; i < snd->src_cnt; i++)
     {
         if (min_num_dirty > snd->src[i]->num_dirty)
@@ -308,10 +439,7 @@ one_source:
         if (dly_drop == 0)
         {
             SDL_LockAudio();
-            if (snd->mixbuf.num_dirty == 0)
-                snd->mixbuf.top_dirty_ptr = 0;
-
-            snd->mixbuf.dirty[snd->mixbuf.num_dirty++] = clean;
+            snd_queue_dirty(snd, clean);
             SDL_UnlockAudio();
         }
 
@@ -322,6 +450,25 @@ one_source:
             avi_record_audio(snd->pvt->avi, clean, snd->buf_size,
                              !not_silent);
 
+        /* ---------------------------------------------------------------- */
+        /*  Likewise for the raw stream output.                             */
+        /* ---------------------------------------------------------------- */
+        if (snd->strm)
+            strm_audio(snd->strm, clean, snd->buf_size, snd->periph.now);
+
+        /* ---------------------------------------------------------------- */
+        /*  And to the audio hash, on a bounded run (--max-frames).  The    */
+        /*  samples are hashed little-endian, whatever the host.            */
+        /* ---------------------------------------------------------------- */
+        if (snd->hash_on)
+#ifdef BYTE_LE
+            snd->hash = crc32_block(snd->hash, (const uint8_t *)clean,
+                                    snd->buf_size * 2);
+#else
+            for (j = 0; j < snd->buf_size; j++)
+                snd->hash = crc32_upd16(snd->hash, clean[j]);
+#endif
+
         /* ---------------------------------------------------------------- */
         /*  If we're also writing this out to an audio file, do that last.  */
         /* ---------------------------------------------------------------- */
@@ -389,7 +536,7 @@ one_source:
     /*  Unpause the audio driver if we're sufficiently piped up.            */
     /* -------------------------------------------------------------------- */
     SDL_LockAudio();
-    if (snd->mixbuf.num_dirty > snd->mixbuf.num_clean)
+    if (snd->mixbuf.num_dirty > snd_num_avail(snd))
         SDL_PauseAudio(0);
     SDL_UnlockAudio();
 
@@ -421,22 +568,51 @@ one_source:
  */
 LOCAL void snd_fill(void *udata, uint8_t *stream, int len)
 {
-    snd_t *snd = (snd_t*)udata;
+    snd_t *const snd = *(snd_t **)udata;
+
+    if (!snd)
+    {
+        memset(stream, 0, len);
+        return;
+    }
+
+    snd_pvt_t *const pvt = snd->pvt;
+    const double now    = get_time();
+    const double period = (double)snd->buf_size / snd->rate;
 
     snd->tot_dirty += snd->mixbuf.num_dirty;
     snd->tot_frame++;
 
+    /* -------------------------------------------------------------------- */
+    /*  Track how far each callback lands from its nominal period.          */
+    /* -------------------------------------------------------------------- */
+    if (pvt->last_fill > 0.0)
+        snd_hist_add(pvt->jit_hist, &pvt->jit_idx, &pvt->jit_cnt,
+                     fabs(now - pvt->last_fill - period));
+    pvt->last_fill = now;
+
     /* -------------------------------------------------------------------- */
     /*  Sad case:  We're slipping behind.                                   */
     /* -------------------------------------------------------------------- */
     if (snd->mixbuf.num_dirty == 0)
     {
         /* Grab a clean buffer and zero it.  Ugly. */
+        snd->tot_underrun++;
+        pvt->dirty_time[0] = -1.0;
         snd->mixbuf.dirty[snd->mixbuf.num_dirty++] =
             snd->mixbuf.clean[--snd->mixbuf.num_clean];
         memset(snd->mixbuf.dirty[0], 0,
                snd->buf_size * sizeof(snd->mixbuf.dirty[0][0]));
     }
+    /* -------------------------------------------------------------------- */
+    /*  Otherwise, note how long this buffer sat waiting for us, plus the   */
+    /*  buffer's worth of time the device takes to play it out.             */
+    /* -------------------------------------------------------------------- */
+    else if (pvt->dirty_time[0] >= 0.0)
+    {
+        snd_hist_add(pvt->lat_hist, &pvt->lat_idx, &pvt->lat_cnt,
+                     now - pvt->dirty_time[0] + period);
+    }
 
     /* -------------------------------------------------------------------- */
     /*  Do it if we can.                                                    */
@@ -490,7 +666,10 @@ LOCAL void snd_fill(void *udata, uint8_t *stream, int len)
         /* ---------------------------------------------------------------- */
         snd->mixbuf.num_dirty--;
         for (i = 0; i < snd->mixbuf.num_dirty; i++)
+        {
             snd->mixbuf.dirty[i] = snd->mixbuf.dirty[i + 1];
+            pvt->dirty_time[i]   = pvt->dirty_time[i + 1];
+        }
 
         return;
     }
@@ -585,7 +764,8 @@ LOCAL void snd_dtor(periph_t *const p);
  */
 int snd_init(snd_t *snd, int rate, char *raw_file,
              int user_snd_buf_size, int user_snd_buf_cnt,
-             struct avi_writer_t *const avi, int pal_mode, double time_scale)
+             struct avi_writer_t *const avi, int pal_mode, double time_scale,
+             int snd_auto)
 {
     int i;
     SDL_AudioSpec *wanted = NULL, *actual = NULL;
@@ -603,11 +783,14 @@ int snd_init(snd_t *snd, int rate, char *raw_file,
     }
 
     snd->buf_size = user_snd_buf_size > 0 ? user_snd_buf_size
+                  : snd_auto > 0          ? SND_AUTO_BUF_SIZE
                   :                         SND_BUF_SIZE_DEFAULT;
 
     snd->buf_cnt  = user_snd_buf_cnt  > 0 ? user_snd_buf_cnt
                   :                         SND_BUF_CNT_DEFAULT;
 
+    snd->auto_thresh = snd_auto > 0 ? snd_auto : 0;
+
     /* -------------------------------------------------------------------- */
     /*  Open the audio device asking for our preferred format, but be       */
     /*  prepared for it to be different than what we asked for.             */
@@ -624,12 +807,38 @@ int snd_init(snd_t *snd, int rate, char *raw_file,
     wanted->channels = 1;
     wanted->samples  = snd->buf_size;
     wanted->callback = snd_fill;
-    wanted->userdata = (void*)snd;
+    wanted->userdata = (void*)&snd_dev_snd;
 
-    if ( SDL_OpenAudio(wanted, actual) < 0 )
+    if (snd_parked &&
+        snd_dev_wanted.freq     == wanted->freq     &&
+        snd_dev_wanted.format   == wanted->format   &&
+        snd_dev_wanted.channels == wanted->channels &&
+        snd_dev_wanted.samples  == wanted->samples)
     {
-        fprintf(stderr, "snd:  Couldn't open audio: %s\n", SDL_GetError());
-        goto fail;
+        SDL_LockAudio();
+        snd_dev_snd = snd;
+        SDL_UnlockAudio();
+        *actual    = snd_dev_actual;
+        snd_parked = false;
+        jzp_printf("snd:  Reusing the audio device from the last game\n");
+    } else
+    {
+        if (snd_parked)
+        {
+            SDL_CloseAudio();
+            snd_parked = false;
+        }
+
+        snd_dev_snd = snd;
+        if ( SDL_OpenAudio(wanted, actual) < 0 )
+        {
+            fprintf(stderr, "snd:  Couldn't open audio: %s\n",
+                    SDL_GetError());
+            goto fail;
+        }
+
+        snd_dev_wanted = *wanted;
+        snd_dev_actual = *actual;
     }
 
     /* -------------------------------------------------------------------- */
@@ -759,6 +968,24 @@ int snd_init(snd_t *snd, int rate, char *raw_file,
     snd->periph.addr_mask = ~0U;
     snd->periph.dtor      = snd_dtor;
 
+    /* -------------------------------------------------------------------- */
+    /*  With --snd-auto, start from the requested count but allocate a      */
+    /*  larger pool, so snd_auto_tune can let more buffers into flight.     */
+    /* -------------------------------------------------------------------- */
+    snd->active_cnt = snd->buf_cnt;
+    if (snd->auto_thresh > 0)
+    {
+        if (snd->buf_cnt < SND_AUTO_MAX_CNT)
+            snd->buf_cnt = SND_AUTO_MAX_CNT;
+
+        snd->pvt->hold_win = 4;
+
+        jzp_printf("snd:  Auto-tuning bufcnt %d..%d, bufsize %d, "
+                   "threshold %d underruns per 1000\n",
+                   SND_AUTO_MIN_CNT, snd->buf_cnt, snd->buf_size,
+                   snd->auto_thresh);
+    }
+
     /* -------------------------------------------------------------------- */
     /*  Set up our mix buffers as 'clean'.                                  */
     /* -------------------------------------------------------------------- */
@@ -768,11 +995,13 @@ int snd_init(snd_t *snd, int rate, char *raw_file,
     snd->mixbuf.buf   = CALLOC(int16_t, snd->buf_size * snd->mixbuf.num_clean);
     snd->mixbuf.clean = CALLOC(int16_t *, snd->mixbuf.num_clean);
     snd->mixbuf.dirty = CALLOC(int16_t *, snd->mixbuf.num_clean);
+    snd->pvt->dirty_time = CALLOC(double, snd->mixbuf.num_clean);
 
     if (mixbuf) free(mixbuf);
     mixbuf            = CALLOC(int32_t,   snd->buf_size);
 
-    if (!snd->mixbuf.buf || !snd->mixbuf.clean || !snd->mixbuf.dirty || !mixbuf)
+    if (!snd->mixbuf.buf || !snd->mixbuf.clean || !snd->mixbuf.dirty ||
+        !snd->pvt->dirty_time || !mixbuf)
     {
         fprintf(stderr, "snd_init: Out of memory allocating mixbuf.\n");
         goto fail;
@@ -809,6 +1038,8 @@ fail:
     CONDFREE(actual);
     CONDFREE(audio_cvt);
     CONDFREE(cvt_buf);
+    if (snd->pvt)
+        CONDFREE(snd->pvt->dirty_time);
     CONDFREE(snd->pvt);
     CONDFREE(snd->mixbuf.buf);
     CONDFREE(snd->mixbuf.clean);
@@ -827,7 +1058,18 @@ LOCAL void snd_dtor(periph_t *const p)
     snd_pvt_t *const pvt = (snd_pvt_t *)snd->pvt;
     int i;
 
-    SDL_CloseAudio();
+    if (snd_keep && pvt && pvt->audio_fmt)
+    {
+        SDL_LockAudio();
+        SDL_PauseAudio(1);
+        snd_dev_snd = NULL;
+        SDL_UnlockAudio();
+        snd_parked = true;
+    } else
+    {
+        SDL_CloseAudio();
+        snd_dev_snd = NULL;
+    }
     CONDFREE(mixbuf);
     CONDFREE(snd->mixbuf.buf);
     CONDFREE(snd->mixbuf.clean);
@@ -841,6 +1083,7 @@ LOCAL void snd_dtor(periph_t *const p)
             CONDFREE(pvt->audio_cvt);
         }
         CONDFREE(pvt->audio_fmt);
+        CONDFREE(pvt->dirty_time);
     }
 
     CONDFREE(snd->pvt);
@@ -863,18 +1106,14 @@ void snd_play_silence(snd_t *const snd)
 {
     SDL_LockAudio();
 
-    while (snd->mixbuf.num_clean > 0)
+    while (snd_num_avail(snd) > 0)
     {
         const int clean_idx = --snd->mixbuf.num_clean;
         int16_t *const clean = snd->mixbuf.clean[clean_idx];
         snd->mixbuf.clean[clean_idx] = NULL;    /*  spot bugs!    */
 
         memset(clean, 0, snd->buf_size * sizeof(*clean));
-
-        if (snd->mixbuf.num_dirty == 0)
-            snd->mixbuf.top_dirty_ptr = 0;
-
-        snd->mixbuf.dirty[snd->mixbuf.num_dirty++] = clean;
+        snd_queue_dirty(snd, clean);
     }
 
     SDL_PauseAudio(0);
@@ -900,7 +1139,7 @@ void snd_play_static(snd_t *const snd)
 {
     SDL_LockAudio();
 
-    while (snd->mixbuf.num_clean > 0)
+    while (snd_num_avail(snd) > 0)
     {
         const int clean_idx = --snd->mixbuf.num_clean;
         int16_t *const clean = snd->mixbuf.clean[clean_idx];
@@ -909,16 +1148,68 @@ void snd_play_static(snd_t *const snd)
         for (int i = 0; i < snd->buf_size; ++i) 
             clean[i] = (rand_jz() & 0x3FFF) - 0x2000;
 
-        if (snd->mixbuf.num_dirty == 0)
-            snd->mixbuf.top_dirty_ptr = 0;
-
-        snd->mixbuf.dirty[snd->mixbuf.num_dirty++] = clean;
+        snd_queue_dirty(snd, clean);
     }
 
     SDL_PauseAudio(0);
     SDL_UnlockAudio();
 }
 
+/* ======================================================================== */
+/*  SND_FLOAT_CMP -- qsort() comparison for the latency histories.          */
+/* ======================================================================== */
+LOCAL int snd_float_cmp(const void *a, const void *b)
+{
+    const float fa = *(const float *)a, fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+/* ======================================================================== */
+/*  SND_PCTILE -- Pick the p'th percentile out of a sorted history.         */
+/* ======================================================================== */
+LOCAL double snd_pctile(const float *const sorted, const int cnt, const int p)
+{
+    return cnt > 0 ? sorted[(cnt - 1) * p / 100] : 0.0;
+}
+
+/* ======================================================================== */
+/*  SND_GET_LAT_STATS -- Compute latency/jitter percentiles over the most   */
+/*                       recent audio callbacks.                            */
+/* ======================================================================== */
+void snd_get_lat_stats(snd_t *const snd, snd_lat_stats_t *const stats)
+{
+    float lat[SND_LAT_HIST], jit[SND_LAT_HIST];
+    int lat_cnt, jit_cnt;
+
+    memset(stats, 0, sizeof(*stats));
+    if (!snd->pvt)
+        return;
+
+    /* -------------------------------------------------------------------- */
+    /*  Snapshot under lock, then sort at our leisure.                      */
+    /* -------------------------------------------------------------------- */
+    SDL_LockAudio();
+    lat_cnt = snd->pvt->lat_cnt;
+    jit_cnt = snd->pvt->jit_cnt;
+    memcpy(lat, snd->pvt->lat_hist, lat_cnt * sizeof(float));
+    memcpy(jit, snd->pvt->jit_hist, jit_cnt * sizeof(float));
+    stats->underruns   = snd->tot_underrun;
+    stats->buf_cnt     = snd->active_cnt;
+    SDL_UnlockAudio();
+
+    qsort(lat, lat_cnt, sizeof(float), snd_float_cmp);
+    qsort(jit, jit_cnt, sizeof(float), snd_float_cmp);
+
+    stats->lat_p50     = snd_pctile(lat, lat_cnt, 50);
+    stats->lat_p95     = snd_pctile(lat, lat_cnt, 95);
+    stats->lat_p99     = snd_pctile(lat, lat_cnt, 99);
+    stats->jit_p50     = snd_pctile(jit, jit_cnt, 50);
+    stats->jit_p99     = snd_pctile(jit, jit_cnt, 99);
+    stats->num_samples = lat_cnt;
+    stats->buf_size    = snd->buf_size;
+    stats->auto_tune   = snd->auto_thresh > 0;
+}
+
 /* ======================================================================== */
 /*  This program is free software; you can redistribute it and/or modify    */
 /*  it under the terms of the GNU General Public License as published by    */
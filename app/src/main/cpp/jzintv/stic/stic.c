@@ -777,59 +777,66 @@ LOCAL void stic_dtor(periph_t *const p)
 }
 
 /* ======================================================================== */
-/*  STIC_INIT    -- Initialize this ugly ass peripheral.  Booyah!           */
+/*  STIC_SER_INIT -- Register the STIC's state with the serializer.  The    */
+/*                   rendered bitmaps are left out; STIC_RESYNC marks them  */
+/*                   dirty so the next frame rebuilds them.                 */
 /* ======================================================================== */
-int stic_init
-(
-    stic_t              *const stic,
-    uint16_t            *const grom_img,
-    req_q_t             *const req_q,
-    gfx_t               *const gfx,
-    demo_t              *const demo,
-    const int            rand_mem,
-    const int            pal_mode,
-    const int            gram_size,
-    const enum stic_type stic_type
-)
+LOCAL void stic_ser_init(periph_t *const p)
 {
-    /* -------------------------------------------------------------------- */
-    /*  First, zero out the STIC structure to get rid of anything that      */
-    /*  might be dangling.                                                  */
-    /* -------------------------------------------------------------------- */
-    memset((void*)stic, 0, sizeof(stic_t));
-
-    /* -------------------------------------------------------------------- */
-    /*  PAL or NTSC?  8900 or STIC1A?                                       */
-    /* -------------------------------------------------------------------- */
-    stic->pal  = pal_mode;
-    stic->type = stic_type;
-
-    /* -------------------------------------------------------------------- */
-    /*  Set our graphics subsystem pointers.                                */
-    /* -------------------------------------------------------------------- */
-    stic->gfx  = gfx;
-    stic->disp = gfx->vid;
-
-    /* -------------------------------------------------------------------- */
-    /*  Register the demo recorder, if there is one.                        */
-    /* -------------------------------------------------------------------- */
-    stic->demo = demo;
+#ifdef NO_SERIALIZER
+    UNUSED(p);
+#else
+    stic_t *const stic = PERIPH_AS(stic_t, p);
+    ser_hier_t *hier, *phier;
+
+    hier  = ser_new_hierarchy(NULL, p->name);
+    phier = ser_new_hierarchy(hier, "periph");
+
+    periph_ser_register(p, phier);
+
+#define SER_REG(x,t,l,f)\
+    ser_register(hier, #x, &stic->x, t, l, f)
+
+    SER_REG(pal,               ser_u8,  1,      SER_INIT|SER_MAND);
+    SER_REG(type,              ser_u8,  1,      SER_INIT|SER_MAND);
+    SER_REG(gram_size,         ser_u8,  1,      SER_INIT|SER_MAND);
+
+    SER_REG(eff_cycle,         ser_u64, 1,      SER_MAND);
+    SER_REG(gmem_accessible,   ser_u64, 1,      SER_MAND);
+    SER_REG(stic_accessible,   ser_u64, 1,      SER_MAND);
+    SER_REG(vid_enable_cutoff, ser_u64, 1,      SER_MAND);
+    SER_REG(next_frame_render, ser_u64, 1,      SER_MAND);
+    SER_REG(last_frame_intrq,  ser_u64, 1,      SER_MAND);
+    SER_REG(next_frame_intrq,  ser_u64, 1,      SER_MAND);
+    SER_REG(raw,               ser_u32, 0x40,   SER_MAND|SER_HEX);
+    SER_REG(gmem,              ser_u8,  0x1000, SER_MAND|SER_HEX);
+    SER_REG(fifo_rd_ptr,       ser_s32, 1,      SER_MAND);
+    SER_REG(fifo_wr_ptr,       ser_s32, 1,      SER_MAND);
+    SER_REG(busrq_count,       ser_s32, 1,      SER_MAND);
+    SER_REG(btab_sr,           ser_u16, 240,    SER_MAND|SER_HEX);
+    SER_REG(btab,              ser_u16, 240,    SER_MAND|SER_HEX);
+    SER_REG(btab_pr,           ser_u16, 240,    SER_MAND|SER_HEX);
+    SER_REG(last_bg,           ser_u32, 12,     SER_MAND|SER_HEX);
+    SER_REG(prev_vid_enable,   ser_u8,  1,      SER_MAND);
+    SER_REG(vid_enable,        ser_u8,  1,      SER_MAND);
+    SER_REG(mode,              ser_u8,  1,      SER_MAND);
+    SER_REG(p_mode,            ser_u8,  1,      SER_MAND);
+#undef SER_REG
+#endif
+}
 
-    /* -------------------------------------------------------------------- */
-    /*  Set the total GRAM size:                                            */
-    /*      64 cards standard, 256 cards for INTV88 / TutorVision.          */
-    /*      Or 128 cards if you're just having some fun.                    */
-    /* -------------------------------------------------------------------- */
-    stic->gram_size = gram_size > 2 ? 2
-                    : gram_size < 0 ? 0
-                    :                 gram_size;
-    stic->gram_mask = stic->gram_size == 2 ? 0x0FF8
-                    : stic->gram_size == 1 ? 0x0BF8
-                    :                        0x09F8;
+/* ======================================================================== */
+/*  STIC_INIT_TABLES -- Fill in the lookup tables above.  They're the same  */
+/*                      for every instance, so this happens just once.      */
+/*                      stic_init runs under plat_global_lock(), which      */
+/*                      keeps instances on other threads out meanwhile.     */
+/* ======================================================================== */
+LOCAL void stic_init_tables(void)
+{
+    static bool ready = false;
 
-    /* -------------------------------------------------------------------- */
-    /*  Initialize the bit/nibble expansion tables.                         */
-    /* -------------------------------------------------------------------- */
+    if (ready)
+        return;
 
     /*  Calculate bit-to-nibble masks b2n, b2n_r */
     for (int i = 0; i < 256; i++)
@@ -897,6 +904,65 @@ int stic_init
         stic_bit_rd[i] = 3 * bit_rd;
     }
 
+    ready = true;
+}
+
+/* ======================================================================== */
+/*  STIC_INIT    -- Initialize this ugly ass peripheral.  Booyah!           */
+/* ======================================================================== */
+int stic_init
+(
+    stic_t              *const stic,
+    uint16_t            *const grom_img,
+    req_q_t             *const req_q,
+    gfx_t               *const gfx,
+    demo_t              *const demo,
+    const int            rand_mem,
+    const int            pal_mode,
+    const int            gram_size,
+    const enum stic_type stic_type
+)
+{
+    /* -------------------------------------------------------------------- */
+    /*  First, zero out the STIC structure to get rid of anything that      */
+    /*  might be dangling.                                                  */
+    /* -------------------------------------------------------------------- */
+    memset((void*)stic, 0, sizeof(stic_t));
+
+    /* -------------------------------------------------------------------- */
+    /*  PAL or NTSC?  8900 or STIC1A?                                       */
+    /* -------------------------------------------------------------------- */
+    stic->pal  = pal_mode;
+    stic->type = stic_type;
+
+    /* -------------------------------------------------------------------- */
+    /*  Set our graphics subsystem pointers.                                */
+    /* -------------------------------------------------------------------- */
+    stic->gfx  = gfx;
+    stic->disp = gfx->vid;
+
+    /* -------------------------------------------------------------------- */
+    /*  Register the demo recorder, if there is one.                        */
+    /* -------------------------------------------------------------------- */
+    stic->demo = demo;
+
+    /* -------------------------------------------------------------------- */
+    /*  Set the total GRAM size:                                            */
+    /*      64 cards standard, 256 cards for INTV88 / TutorVision.          */
+    /*      Or 128 cards if you're just having some fun.                    */
+    /* -------------------------------------------------------------------- */
+    stic->gram_size = gram_size > 2 ? 2
+                    : gram_size < 0 ? 0
+                    :                 gram_size;
+    stic->gram_mask = stic->gram_size == 2 ? 0x0FF8
+                    : stic->gram_size == 1 ? 0x0BF8
+                    :                        0x09F8;
+
+    /* -------------------------------------------------------------------- */
+    /*  Initialize the bit/nibble expansion tables.                         */
+    /* -------------------------------------------------------------------- */
+    stic_init_tables();
+
     /* -------------------------------------------------------------------- */
     /*  Initialize graphics memory.                                         */
     /* -------------------------------------------------------------------- */
@@ -939,6 +1005,7 @@ int stic_init
     stic->stic_cr.tick      = stic_tick;
     stic->stic_cr.reset     = stic_reset;
     stic->stic_cr.dtor      = stic_dtor;
+    stic->stic_cr.ser_init  = stic_ser_init;
     stic->stic_cr.min_tick  = 1;
     stic->stic_cr.max_tick  = STIC_FRAMCLKS;
     stic->stic_cr.addr_base = 0x00000000;
@@ -2738,9 +2805,9 @@ static const uint8_t stic_gram_gif_palette[5][3] =
 /* ======================================================================== */
 void stic_gram_to_gif(const stic_t *const stic)
 {
-    static uint8_t *gram_bitmap = NULL;
-    static int gram_size = -1;
-    static unique_filename_t gram_shot_tmpl =
+    static THREAD_LOCAL uint8_t *gram_bitmap = NULL;
+    static THREAD_LOCAL int gram_size = -1;
+    static THREAD_LOCAL unique_filename_t gram_shot_tmpl =
     {
         "gram", ".gif", NULL, 0, 4, 0
     };
@@ -0,0 +1,728 @@
+/*
+ * ============================================================================
+ *  Title:    Raw Video / Audio Stream Output
+ * ============================================================================
+ *  RAW STREAM FORMAT
+ *
+ *  All multibyte fields are little endian.  The stream starts with a
+ *  32 byte header:
+ *
+ *      4 bytes     Signature: "JZST"
+ *      2 bytes     Version (1)
+ *      2 bytes     Header length (32)
+ *      2 bytes     Frame width  (160)
+ *      2 bytes     Frame height (200)
+ *      4 bytes     Frame rate numerator   (CPU cycles per second)
+ *      4 bytes     Frame rate denominator (CPU cycles per frame)
+ *      4 bytes     Audio rate in Hz, or 0 if there's no audio in this stream
+ *      4 bytes     Audio format:  1 == signed 16-bit mono
+ *      4 bytes     Reserved (0)
+ *
+ *  A series of packets follows.  Each has a 16 byte header:
+ *
+ *      1 byte      Type:  'P' palette, 'V' video frame, 'A' audio
+ *      3 bytes     Reserved (0)
+ *      4 bytes     Payload length in bytes
+ *      8 bytes     Emulated CPU cycle at which the packet was generated
+ *
+ *  'P' carries 32 RGB triples:  The STIC colors, then jzIntv's utility
+ *  colors (used for on-screen messages).  'V' carries one byte per pixel,
+ *  indexing that palette, in raster order.  'A' carries audio samples.
+ *
+ *  Y4M STREAM FORMAT
+ *
+ *  A standard YUV4MPEG2 stream, 4:4:4 chroma, BT.601 limited range.
+ *  Audio, if requested, goes to its own sink as bare 16-bit samples.
+ *
+ *  Internally, every sink has a ring buffer that holds packets exactly as
+ *  they appear in the raw format.  The emulator thread copies frames and
+ *  audio into the ring.  The sink's writer thread writes raw streams
+ *  straight out of the ring, and converts on the way out otherwise.  If
+ *  the ring fills, the emulator waits for the consumer.  If the consumer
+ *  goes away, the sink discards everything from then on.
+ * ============================================================================
+ */
+
+#include "config.h"
+#include "gfx/palette.h"
+#include "plat/plat.h"
+#include "plat/plat_lib.h"
+#include "stic/stic_timings.h"
+#include "strm/strm.h"
+
+#if defined(PLAT_LINUX) || defined(PLAT_MACOS) || defined(__FreeBSD__)
+# define STRM_UNIX_SOCKET
+# include <unistd.h>
+# include <signal.h>
+# include <sys/socket.h>
+# include <sys/un.h>
+#endif
+
+#define STRM_RING_SZ    (1u << 22)          /* 4MB per sink, ~2 seconds.   */
+#define STRM_RING_MSK   (STRM_RING_SZ - 1)
+#define STRM_HDR_SZ     (32)
+#define STRM_PKT_SZ     (16)
+#define STRM_X_DIM      (160)
+#define STRM_Y_DIM      (200)
+#define STRM_PAL_SZ     (32)
+
+enum { STRM_SINK_RAW, STRM_SINK_Y4M, STRM_SINK_PCM };
+
+typedef struct strm_sink_t
+{
+    char           *path;           /* Where we're writing.                 */
+    FILE           *f;              /* Open output, once we have it.        */
+    int             type;           /* STRM_SINK_xxx                        */
+    int             dead;           /* Output failed; discard everything.   */
+    int             quit;           /* Writer thread should exit.           */
+
+    uint8_t        *ring;           /* Packets waiting to go out.           */
+    uint32_t        wr, rd;         /* Free-running ring byte counters.     */
+
+    char            hdr[64];        /* Stream header, sent after opening.   */
+    int             hdr_len;
+
+    uint8_t         yuv[STRM_PAL_SZ][3];    /* Palette as Y'CbCr (Y4M)      */
+    uint8_t        *conv;                   /* Y4M conversion buffer        */
+
+    plat_thread_t  *worker;
+    plat_mutex_t   *lock;
+    plat_cond_t    *not_empty, *not_full;
+
+    uint64_t        bytes;          /* Bytes written to the output.         */
+    uint32_t        frames;         /* Video frames written.                */
+    uint32_t        stalls;         /* Times the emulator waited on us.     */
+    uint32_t        high_water;     /* Most bytes ever queued.              */
+} strm_sink_t;
+
+typedef struct strm_pvt_t
+{
+    strm_sink_t    *vid;            /* Video, and audio in raw streams.     */
+    strm_sink_t    *aud;            /* Separate audio sink, if any.         */
+    double          start;          /* Wall time at start, for stats.       */
+} strm_pvt_t;
+
+/* ======================================================================== */
+/*  STRM_PUT_32  -- Little-endian helpers for headers.                      */
+/* ======================================================================== */
+LOCAL void strm_put_16(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+LOCAL void strm_put_32(uint8_t *p, uint32_t v)
+{
+    strm_put_16(p, v);
+    strm_put_16(p + 2, v >> 16);
+}
+
+/* ======================================================================== */
+/*  STRM_OPEN    -- Open the output.  This may block (for example, opening  */
+/*                  a FIFO waits for the reader), so it runs on the writer  */
+/*                  thread when there is one.                               */
+/* ======================================================================== */
+LOCAL FILE *strm_open(const char *const path)
+{
+#ifdef STRM_UNIX_SOCKET
+    if (!strncmp(path, "unix:", 5))
+    {
+        struct sockaddr_un addr;
+        int fd;
+        FILE *f;
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path + 5, sizeof(addr.sun_path) - 1);
+
+        if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+            return NULL;
+
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+            !(f = fdopen(fd, "wb")))
+        {
+            close(fd);
+            return NULL;
+        }
+        return f;
+    }
+#endif
+    return fopen(path, "wb");
+}
+
+/* ======================================================================== */
+/*  STRM_SINK_WRITE -- Write to the output, killing the sink on failure.    */
+/* ======================================================================== */
+LOCAL void strm_sink_write(strm_sink_t *const sink, const void *const data,
+                           const size_t len)
+{
+    if (sink->dead || len == 0)
+        return;
+
+    if (fwrite(data, 1, len, sink->f) != len)
+    {
+        fprintf(stderr, "\nstream: Error writing to '%s'; "
+                        "no longer streaming to it.\n", sink->path);
+        sink->dead = 1;
+        return;
+    }
+
+    sink->bytes += len;
+}
+
+/* ======================================================================== */
+/*  STRM_RING_READ -- Copy bytes out of the ring, handling wraparound.      */
+/* ======================================================================== */
+LOCAL void strm_ring_read(const strm_sink_t *const sink, const uint32_t pos,
+                          void *const dst, const uint32_t len)
+{
+    const uint32_t ofs   = pos & STRM_RING_MSK;
+    const uint32_t first = len < STRM_RING_SZ - ofs ? len : STRM_RING_SZ - ofs;
+
+    memcpy(dst, sink->ring + ofs, first);
+    memcpy((uint8_t *)dst + first, sink->ring, len - first);
+}
+
+/* ======================================================================== */
+/*  STRM_SINK_DRAIN -- Send 'avail' bytes worth of whole packets starting   */
+/*                     at the ring's read pointer.                          */
+/* ======================================================================== */
+LOCAL void strm_sink_drain(strm_sink_t *const sink, const uint32_t avail)
+{
+    uint32_t pos = sink->rd, end = sink->rd + avail;
+
+    if (sink->dead)
+        return;
+
+    /* -------------------------------------------------------------------- */
+    /*  Raw streams go out exactly as queued.  No copies.                   */
+    /* -------------------------------------------------------------------- */
+    if (sink->type == STRM_SINK_RAW)
+    {
+        const uint32_t ofs   = pos & STRM_RING_MSK;
+        const uint32_t first = avail < STRM_RING_SZ - ofs ? avail
+                                                          : STRM_RING_SZ - ofs;
+
+        strm_sink_write(sink, sink->ring + ofs, first);
+        strm_sink_write(sink, sink->ring, avail - first);
+
+        /* Count frames for the stats. */
+        while (pos != end)
+        {
+            uint8_t pkt[STRM_PKT_SZ];
+
+            strm_ring_read(sink, pos, pkt, STRM_PKT_SZ);
+            sink->frames += pkt[0] == 'V';
+            pos += STRM_PKT_SZ + (pkt[4] | pkt[5] << 8 | pkt[6] << 16 |
+                                  (uint32_t)pkt[7] << 24);
+        }
+        return;
+    }
+
+    /* -------------------------------------------------------------------- */
+    /*  Otherwise, pick out the packets this sink cares about.              */
+    /* -------------------------------------------------------------------- */
+    while (pos != end && !sink->dead)
+    {
+        uint8_t pkt[STRM_PKT_SZ];
+        uint32_t len;
+
+        strm_ring_read(sink, pos, pkt, STRM_PKT_SZ);
+        len  = pkt[4] | pkt[5] << 8 | pkt[6] << 16 | (uint32_t)pkt[7] << 24;
+        pos += STRM_PKT_SZ;
+
+        if (sink->type == STRM_SINK_PCM && pkt[0] == 'A')
+        {
+            const uint32_t ofs   = pos & STRM_RING_MSK;
+            const uint32_t room  = STRM_RING_SZ - ofs;
+            const uint32_t first = len < room ? len : room;
+
+            strm_sink_write(sink, sink->ring + ofs, first);
+            strm_sink_write(sink, sink->ring, len - first);
+        }
+        else if (sink->type == STRM_SINK_Y4M && pkt[0] == 'V')
+        {
+            const int npix = STRM_X_DIM * STRM_Y_DIM;
+            uint8_t *const y = sink->conv + 6;
+            uint8_t *const u = y + npix;
+            uint8_t *const v = u + npix;
+            int i;
+
+            for (i = 0; i < npix; i++)
+            {
+                const uint8_t *const c =
+                    sink->yuv[sink->ring[(pos + i) & STRM_RING_MSK] & 31];
+                y[i] = c[0];
+                u[i] = c[1];
+                v[i] = c[2];
+            }
+
+            strm_sink_write(sink, sink->conv, 6 + 3 * npix);
+            sink->frames++;
+        }
+
+        pos += len;
+    }
+}
+
+/* ======================================================================== */
+/*  STRM_SINK_START -- Open the output if we haven't yet, and send the      */
+/*                     stream header.                                       */
+/* ======================================================================== */
+LOCAL int strm_sink_start(strm_sink_t *const sink)
+{
+    if (sink->f)
+        return 0;
+
+    if (!(sink->f = strm_open(sink->path)))
+    {
+        fprintf(stderr, "stream: Could not open '%s' for writing: %s\n",
+                sink->path, strerror(errno));
+        sink->dead = 1;
+        return -1;
+    }
+
+    strm_sink_write(sink, sink->hdr, sink->hdr_len);
+    return 0;
+}
+
+/* ======================================================================== */
+/*  STRM_WRITER_THREAD -- Drain the ring until told to quit.                */
+/* ======================================================================== */
+LOCAL int strm_writer_thread(void *opaque)
+{
+    strm_sink_t *const sink = (strm_sink_t *)opaque;
+
+    strm_sink_start(sink);
+
+    for (;;)
+    {
+        uint32_t avail;
+
+        plat_mutex_lock(sink->lock);
+        while (sink->wr == sink->rd && !sink->quit)
+            plat_cond_wait(sink->not_empty, sink->lock);
+        avail = sink->wr - sink->rd;
+        plat_mutex_unlock(sink->lock);
+
+        if (avail == 0)
+            break;
+
+        strm_sink_drain(sink, avail);
+        if (!sink->dead)
+            fflush(sink->f);
+
+        plat_mutex_lock(sink->lock);
+        sink->rd += avail;
+        plat_cond_signal(sink->not_full);
+        plat_mutex_unlock(sink->lock);
+    }
+
+    return 0;
+}
+
+/* ======================================================================== */
+/*  STRM_SINK_PUT -- Queue a packet, waiting for room if we must.           */
+/* ======================================================================== */
+LOCAL void strm_sink_put(strm_sink_t *const sink, const int type,
+                         const uint64_t now, const void *const data,
+                         const uint32_t len)
+{
+    const uint32_t tot = STRM_PKT_SZ + len;
+    uint8_t pkt[STRM_PKT_SZ];
+    uint32_t wr, ofs, first;
+
+    if (sink->dead)
+        return;
+
+    pkt[0] = type;
+    pkt[1] = pkt[2] = pkt[3] = 0;
+    strm_put_32(pkt + 4, len);
+    strm_put_32(pkt + 8, (uint32_t)now);
+    strm_put_32(pkt + 12, (uint32_t)(now >> 32));
+
+    /* -------------------------------------------------------------------- */
+    /*  Wait for room.  Only the writer thread ever moves 'rd'.             */
+    /* -------------------------------------------------------------------- */
+    plat_mutex_lock(sink->lock);
+    if (STRM_RING_SZ - (sink->wr - sink->rd) < tot)
+    {
+        sink->stalls++;
+        while (STRM_RING_SZ - (sink->wr - sink->rd) < tot && !sink->dead)
+            plat_cond_wait(sink->not_full, sink->lock);
+    }
+    wr = sink->wr;
+    plat_mutex_unlock(sink->lock);
+
+    /* -------------------------------------------------------------------- */
+    /*  Copy in the header and payload, then publish them.                  */
+    /* -------------------------------------------------------------------- */
+    ofs   = wr & STRM_RING_MSK;
+    first = tot < STRM_RING_SZ - ofs ? tot : STRM_RING_SZ - ofs;
+
+    if (first >= STRM_PKT_SZ)
+    {
+        memcpy(sink->ring + ofs, pkt, STRM_PKT_SZ);
+        memcpy(sink->ring + ofs + STRM_PKT_SZ, data, first - STRM_PKT_SZ);
+        memcpy(sink->ring, (const uint8_t *)data + first - STRM_PKT_SZ,
+               tot - first);
+    } else
+    {
+        memcpy(sink->ring + ofs, pkt, first);
+        memcpy(sink->ring, pkt + first, STRM_PKT_SZ - first);
+        memcpy(sink->ring + STRM_PKT_SZ - first, data, len);
+    }
+
+    plat_mutex_lock(sink->lock);
+    sink->wr += tot;
+    if (sink->high_water < sink->wr - sink->rd)
+        sink->high_water = sink->wr - sink->rd;
+    plat_cond_signal(sink->not_empty);
+    plat_mutex_unlock(sink->lock);
+
+    /* -------------------------------------------------------------------- */
+    /*  No writer thread?  Then write it ourselves.                         */
+    /* -------------------------------------------------------------------- */
+    if (!sink->worker)
+    {
+        strm_sink_drain(sink, tot);
+        sink->rd += tot;
+    }
+}
+
+/* ======================================================================== */
+/*  STRM_SINK_NEW -- Allocate a sink and start its writer thread.           */
+/* ======================================================================== */
+LOCAL strm_sink_t *strm_sink_new(const char *const path, const int type)
+{
+    strm_sink_t *sink = CALLOC(strm_sink_t, 1);
+
+    if (!sink)
+        return NULL;
+
+    sink->type = type;
+    sink->path = strdup(path);
+    sink->ring = CALLOC(uint8_t, STRM_RING_SZ);
+    sink->lock = plat_mutex_create();
+    sink->not_empty = plat_cond_create();
+    sink->not_full  = plat_cond_create();
+
+    if (type == STRM_SINK_Y4M)
+    {
+        sink->conv = CALLOC(uint8_t, 6 + 3 * STRM_X_DIM * STRM_Y_DIM);
+        if (sink->conv)
+            memcpy(sink->conv, "FRAME\n", 6);
+    }
+
+    if (!sink->path || !sink->ring || (type == STRM_SINK_Y4M && !sink->conv))
+    {
+        CONDFREE(sink->path);
+        CONDFREE(sink->ring);
+        CONDFREE(sink->conv);
+        plat_cond_destroy(sink->not_full);
+        plat_cond_destroy(sink->not_empty);
+        plat_mutex_destroy(sink->lock);
+        free(sink);
+        return NULL;
+    }
+
+    return sink;
+}
+
+/* ======================================================================== */
+/*  STRM_SINK_GO  -- Start the writer thread.  If we can't, open the        */
+/*                   output right here and write inline.                    */
+/* ======================================================================== */
+LOCAL int strm_sink_go(strm_sink_t *const sink)
+{
+    if (sink->lock && sink->not_empty && sink->not_full)
+        sink->worker = plat_thread_create(strm_writer_thread, "jzintv stream",
+                                          (void *)sink);
+
+    if (!sink->worker)
+        return strm_sink_start(sink);
+
+    return 0;
+}
+
+/* ======================================================================== */
+/*  STRM_SINK_STOP -- Drain, stop the thread, and close the output.         */
+/* ======================================================================== */
+LOCAL void strm_sink_stop(strm_sink_t *const sink)
+{
+    if (!sink)
+        return;
+
+    if (sink->worker)
+    {
+        plat_mutex_lock(sink->lock);
+        sink->quit = 1;
+        plat_cond_signal(sink->not_empty);
+        plat_mutex_unlock(sink->lock);
+        plat_thread_join(sink->worker);
+        sink->worker = NULL;
+    }
+
+    if (sink->f)
+        fclose(sink->f);
+    sink->f = NULL;
+}
+
+/* ======================================================================== */
+/*  STRM_SINK_FREE -- Stop the sink, and free it.                           */
+/* ======================================================================== */
+LOCAL void strm_sink_free(strm_sink_t *const sink)
+{
+    if (!sink)
+        return;
+
+    strm_sink_stop(sink);
+
+    plat_cond_destroy(sink->not_full);
+    plat_cond_destroy(sink->not_empty);
+    plat_mutex_destroy(sink->lock);
+    CONDFREE(sink->path);
+    CONDFREE(sink->ring);
+    CONDFREE(sink->conv);
+    free(sink);
+}
+
+/* ======================================================================== */
+/*  STRM_PARSE_FMT -- Convert a format name to a STRM_FMT_xxx value.        */
+/* ======================================================================== */
+int strm_parse_fmt(const char *const name)
+{
+    if (!stricmp(name, "raw")) return STRM_FMT_RAW;
+    if (!stricmp(name, "y4m")) return STRM_FMT_Y4M;
+    return -1;
+}
+
+/* ======================================================================== */
+/*  STRM_INIT    -- Start streaming.                                        */
+/* ======================================================================== */
+int strm_init
+(
+    strm_t                 *const strm,
+    const char             *const path,
+    const char             *const pcm_path,
+    const int                     fmt,
+    const int                     pal_mode,
+    const int                     audio_rate,
+    const struct palette_t *const palette
+)
+{
+    const uint32_t fr_num = pal_mode ? 1000000 : 894886;
+    const uint32_t fr_den = pal_mode ? PAL_FRAMCLKS : NTSC_FRAMCLKS;
+    strm_pvt_t *pvt;
+    strm_sink_t *vid;
+    int i;
+
+    if (!(pvt = CALLOC(strm_pvt_t, 1)))
+        return -1;
+
+    vid = pvt->vid = strm_sink_new(path, fmt == STRM_FMT_Y4M ? STRM_SINK_Y4M
+                                                             : STRM_SINK_RAW);
+    if (!vid)
+        goto fail;
+
+    if (pcm_path && audio_rate > 0 &&
+        !(pvt->aud = strm_sink_new(pcm_path, STRM_SINK_PCM)))
+        goto fail;
+
+#ifdef STRM_UNIX_SOCKET
+    /* -------------------------------------------------------------------- */
+    /*  A consumer that exits early must not take us down with SIGPIPE.    */
+    /*  We notice the failed write instead.                                 */
+    /* -------------------------------------------------------------------- */
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    /* -------------------------------------------------------------------- */
+    /*  Build the stream header.                                            */
+    /* -------------------------------------------------------------------- */
+    if (fmt == STRM_FMT_Y4M)
+    {
+        vid->hdr_len = snprintf(vid->hdr, sizeof(vid->hdr),
+                                "YUV4MPEG2 W%d H%d F%u:%u Ip A0:0 C444\n",
+                                STRM_X_DIM, STRM_Y_DIM, fr_num, fr_den);
+
+        /* ---------------------------------------------------------------- */
+        /*  BT.601, limited range.                                          */
+        /* ---------------------------------------------------------------- */
+        for (i = 0; i < STRM_PAL_SZ; i++)
+        {
+            const uint8_t *const rgb = i < 16 ? palette->color[i]
+                                              : util_palette.color[i - 16];
+            const double r = rgb[0], g = rgb[1], b = rgb[2];
+
+            vid->yuv[i][0] = (uint8_t)( 16.5 + ( 65.481*r + 128.553*g
+                                                + 24.966*b) / 255.);
+            vid->yuv[i][1] = (uint8_t)(128.5 + (-37.797*r -  74.203*g
+                                                + 112.0 *b) / 255.);
+            vid->yuv[i][2] = (uint8_t)(128.5 + (112.0  *r -  93.786*g
+                                                - 18.214*b) / 255.);
+        }
+    } else
+    {
+        uint8_t *const hdr = (uint8_t *)vid->hdr;
+
+        memset(hdr, 0, STRM_HDR_SZ);
+        memcpy(hdr, "JZST", 4);
+        strm_put_16(hdr +  4, 1);
+        strm_put_16(hdr +  6, STRM_HDR_SZ);
+        strm_put_16(hdr +  8, STRM_X_DIM);
+        strm_put_16(hdr + 10, STRM_Y_DIM);
+        strm_put_32(hdr + 12, fr_num);
+        strm_put_32(hdr + 16, fr_den);
+        strm_put_32(hdr + 20, pvt->aud ? 0 : audio_rate);
+        strm_put_32(hdr + 24, 1);
+        vid->hdr_len = STRM_HDR_SZ;
+    }
+
+    if (strm_sink_go(vid) || (pvt->aud && strm_sink_go(pvt->aud)))
+        goto fail;
+
+    /* -------------------------------------------------------------------- */
+    /*  Raw streams lead with the palette.                                  */
+    /* -------------------------------------------------------------------- */
+    if (fmt == STRM_FMT_RAW)
+    {
+        uint8_t pal[STRM_PAL_SZ][3];
+
+        memcpy(pal[0],  palette->color,     sizeof(palette->color));
+        memcpy(pal[16], util_palette.color, sizeof(util_palette.color));
+        strm_sink_put(vid, 'P', 0, pal, sizeof(pal));
+    }
+
+    pvt->start = get_time();
+    strm->pvt  = pvt;
+
+    jzp_printf("Streaming %s video to '%s'",
+               fmt == STRM_FMT_Y4M ? "Y4M" : "raw", path);
+    if (pvt->aud)
+        jzp_printf(", audio to '%s'", pcm_path);
+    jzp_printf("\n");
+    return 0;
+
+fail:
+    fprintf(stderr, "stream: Could not start streaming to '%s'\n", path);
+    strm_sink_free(pvt->aud);
+    strm_sink_free(pvt->vid);
+    free(pvt);
+    return -1;
+}
+
+/* ======================================================================== */
+/*  STRM_VIDEO   -- Queue a frame.                                          */
+/* ======================================================================== */
+void strm_video(const strm_t *const strm, const uint8_t *const vid,
+                const uint64_t now)
+{
+    if (!strm || !strm->pvt)
+        return;
+
+    strm_sink_put(strm->pvt->vid, 'V', now, vid, STRM_X_DIM * STRM_Y_DIM);
+}
+
+/* ======================================================================== */
+/*  STRM_AUDIO   -- Queue audio.  Y4M streams have no room for audio, so    */
+/*                  without a separate PCM sink, we drop it.                */
+/* ======================================================================== */
+void strm_audio(const strm_t *const strm, const int16_t *const pcm,
+                const int num_samples, const uint64_t now)
+{
+    strm_sink_t *sink;
+
+    if (!strm || !strm->pvt)
+        return;
+
+    sink = strm->pvt->aud ? strm->pvt->aud : strm->pvt->vid;
+    if (sink->type == STRM_SINK_Y4M)
+        return;
+
+#ifdef BYTE_BE
+    {
+        int16_t swab[4096];
+        int done = 0;
+
+        while (done < num_samples)
+        {
+            const int n = num_samples - done < 4096 ? num_samples - done
+                                                    : 4096;
+            int i;
+
+            for (i = 0; i < n; i++)
+                swab[i] = (int16_t)(((uint16_t)pcm[done + i] << 8) |
+                                    ((uint16_t)pcm[done + i] >> 8));
+
+            strm_sink_put(sink, 'A', now, swab, n * sizeof(int16_t));
+            done += n;
+        }
+    }
+#else
+    strm_sink_put(sink, 'A', now, pcm, num_samples * sizeof(int16_t));
+#endif
+}
+
+/* ======================================================================== */
+/*  STRM_IS_ACTIVE -- Returns non-zero if streaming has been started.       */
+/* ======================================================================== */
+int strm_is_active(const strm_t *const strm)
+{
+    return strm && strm->pvt;
+}
+
+/* ======================================================================== */
+/*  STRM_DTOR    -- Flush, close, and report.                               */
+/* ======================================================================== */
+void strm_dtor(strm_t *const strm)
+{
+    strm_pvt_t *const pvt = strm->pvt;
+    double elapsed;
+
+    if (!pvt)
+        return;
+
+    strm->pvt = NULL;
+    strm_sink_stop(pvt->vid);
+    strm_sink_stop(pvt->aud);
+    elapsed   = get_time() - pvt->start;
+
+    jzp_printf("\nDone streaming:\n"
+               "    Frames:              %10u\n"
+               "    Bytes:               %10" U64_FMT "\n"
+               "    Queue peak (bytes):  %10u\n"
+               "    Emulator stalls:     %10u\n",
+               pvt->vid->frames, pvt->vid->bytes,
+               pvt->vid->high_water, pvt->vid->stalls);
+
+    if (pvt->aud)
+        jzp_printf("    Audio bytes:         %10" U64_FMT "\n"
+                   "    Audio stalls:        %10u\n",
+                   pvt->aud->bytes, pvt->aud->stalls);
+
+    if (elapsed > 0.)
+        jzp_printf("    Average rate:        %10.1f fps\n",
+                   pvt->vid->frames / elapsed);
+    jzp_flush();
+
+    strm_sink_free(pvt->aud);
+    strm_sink_free(pvt->vid);
+    free(pvt);
+}
+
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
@@ -0,0 +1,92 @@
+/*
+ * ============================================================================
+ *  Title:    Raw Video / Audio Stream Output
+ * ============================================================================
+ *  Streams uncompressed frames and PCM audio to a file, named pipe, or
+ *  UNIX domain socket, so that an external encoder (such as ffmpeg) can
+ *  do the compression work on other cores.  The emulator thread only
+ *  copies each frame and audio buffer into a ring buffer.  A writer
+ *  thread per output drains the ring.
+ *
+ *  See strm.c for a description of the stream formats.
+ * ============================================================================
+ */
+#ifndef STRM_STRM_H_
+#define STRM_STRM_H_
+
+#ifndef GFX_PALETTE_H_
+struct palette_t;  /* forward decl to reduce deps */
+#endif
+
+/* ======================================================================== */
+/*  Stream formats.                                                         */
+/* ======================================================================== */
+enum
+{
+    STRM_FMT_RAW = 0,   /* Palette-indexed frames + PCM, tiny packet headers */
+    STRM_FMT_Y4M = 1    /* YUV4MPEG2 4:4:4 video.  Audio to separate sink.   */
+};
+
+typedef struct strm_t
+{
+    struct strm_pvt_t *pvt;
+} strm_t;
+
+/* ======================================================================== */
+/*  STRM_INIT    -- Start streaming to 'path'.  If 'pcm_path' is non-NULL,  */
+/*                  audio goes there as raw signed 16-bit LE mono instead   */
+/*                  of being interleaved with the video.  Y4M streams can   */
+/*                  only carry audio this way.  Paths of the form           */
+/*                  "unix:/path" connect to a UNIX domain socket.           */
+/*                  Returns 0 on success, -1 on failure.                    */
+/* ======================================================================== */
+int strm_init
+(
+    strm_t                 *const strm,
+    const char             *const path,
+    const char             *const pcm_path,
+    const int                     fmt,
+    const int                     pal_mode,
+    const int                     audio_rate,
+    const struct palette_t *const palette
+);
+
+/* ======================================================================== */
+/*  STRM_PARSE_FMT -- Convert "raw" or "y4m" to a STRM_FMT_xxx value.       */
+/*                    Returns -1 if the name isn't recognized.              */
+/* ======================================================================== */
+int strm_parse_fmt(const char *const name);
+
+/* ======================================================================== */
+/*  STRM_VIDEO   -- Queue a 160x200 palette-indexed frame.                  */
+/*  STRM_AUDIO   -- Queue a buffer of mono 16-bit audio.                    */
+/* ======================================================================== */
+void strm_video(const strm_t *const strm, const uint8_t *const vid,
+                const uint64_t now);
+void strm_audio(const strm_t *const strm, const int16_t *const pcm,
+                const int num_samples, const uint64_t now);
+
+/* ======================================================================== */
+/*  STRM_IS_ACTIVE -- Returns non-zero if streaming has been started.       */
+/*  STRM_DTOR      -- Flush everything queued, close the outputs, and       */
+/*                    report statistics.                                    */
+/* ======================================================================== */
+int  strm_is_active(const strm_t *const strm);
+void strm_dtor(strm_t *const strm);
+
+#endif
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
@@ -84,6 +84,59 @@ uint8_t map_palette[16][3];
 
 const char *prog;
 
+/* ------------------------------------------------------------------------ */
+/*  Frame range selected with -r.  Decoding starts at the nearest keyframe  */
+/*  at or before the first frame, if the movie has a keyframe index.        */
+/* ------------------------------------------------------------------------ */
+int first_fr = 0, last_fr = INT_MAX;
+int in_range = 0;
+
+static int parse_range(const char *s)
+{
+    char *end;
+
+    first_fr = strtol(s, &end, 10);
+    if (end == s || first_fr < 0)
+        return -1;
+
+    if (*end == ':' || *end == '-')
+    {
+        s = end + 1;
+        last_fr = strtol(s, &end, 10);
+        if (end == s || last_fr < first_fr)
+            return -1;
+    }
+
+    return *end == '\0' ? 0 : -1;
+}
+
+static int seek_range(void)
+{
+    in_range = 0;
+    return mvi_seek(&movie, first_fr);
+}
+
+static int rd_range_frame(uint8_t *vid, uint8_t bbox[8][4])
+{
+    int flag;
+
+    while ((flag = mvi_rd_frame(&movie, vid, bbox)) >= 0)
+    {
+        if (movie.fr < first_fr)
+            continue;
+        if (movie.fr > last_fr)
+            return -1;
+
+        /* The first frame in range is never a repeat, as far as we care. */
+        if (!in_range)
+            flag &= ~MVI_FR_SAME;
+        in_range = 1;
+        break;
+    }
+
+    return flag;
+}
+
 static void usage( void )
 {
     fprintf(stderr, "%s [flags] input.imv output.gif\n", prog);
@@ -91,6 +144,8 @@ static void usage( void )
             "    -d##   Set minimum delay to ##ms, default 50ms.\n"
             "    -D##   Assume GIF decode delay of ##ms, default 3.33ms.\n"
             "    -s     Stretch horizontallly 2x.\n"
+            "    -r#:#  Only convert frames # through #.\n"
+            "    -j#    Compress frames on # worker threads.\n"
             "    -f     Flat images (no transparency or optimization).\n");
     exit(1);
 }
@@ -110,6 +165,8 @@ int main(int argc, char *argv[])
     int n_cols = 16;
     int mode = 0;
     int min_delay = 15, stretch = 0, dec_delay = 1;
+    int threads = 0;
+    double start_time, elapsed;
 
     prog = argv[0];
 
@@ -120,6 +177,15 @@ int main(int argc, char *argv[])
         else if ( argv[1][1] == 'd'  ) min_delay = atof(&argv[1][2])*3/10;
         else if ( argv[1][1] == 'D'  ) dec_delay = atof(&argv[1][2])*3/10;
         else if ( argv[1][1] == 's'  ) stretch = 1;
+        else if ( argv[1][1] == 'j'  ) threads = atoi(&argv[1][2]);
+        else if ( argv[1][1] == 'r'  )
+        {
+            if (parse_range(&argv[1][2]) < 0)
+            {
+                fprintf(stderr, "%s: bad frame range %s\n", prog, argv[1]);
+                usage();
+            }
+        }
         else
         {
             fprintf(stderr, "%s: unexpected flag %s\n", prog, argv[1] );
@@ -156,8 +222,16 @@ int main(int argc, char *argv[])
     fr = 0;
     prev_gif_time = curr_gif_time = 0;
 
+    if (first_fr > 0 || last_fr < INT_MAX)
+    {
+        if (mvi_rd_index(&movie) < 0)
+            fprintf(stderr, "No keyframe index in %s; "
+                            "decoding from the start\n", argv[1]);
+        seek_range();
+    }
+
     printf("Pass 1:  Color optimization...\n"); fflush(stdout);
-    while ((flag = mvi_rd_frame(&movie, curr, bbox)) >= 0)
+    while ((flag = rd_range_frame(curr, bbox)) >= 0)
     {
         int mask = 0;
         if ((flag & MVI_FR_SAME) != 0)
@@ -249,11 +323,11 @@ int main(int argc, char *argv[])
 
 
     /* reset the movie */
-    fseek(movie.f, 0, SEEK_SET);
+    seek_range();
     memset(movie.vid, 0xFF, movie.x_dim * movie.y_dim);
 
     /* get to the first frame of the movie */
-    while ((flag = mvi_rd_frame(&movie, prev, bbox)) >= 0)
+    while ((flag = rd_range_frame(prev, bbox)) >= 0)
     {
         if ((flag & MVI_FR_SAME) == 0)
             break;
@@ -268,9 +342,12 @@ int main(int argc, char *argv[])
     }
     wrote += ret;
 
+    if (threads > 0 && (threads = gif_set_threads(&gif, threads)) == 0)
+        fprintf(stderr, "No threads available; compressing inline\n");
 
     printf("Pass 2:  Image compression...\n"); fflush(stdout);
-    while ((flag = mvi_rd_frame(&movie, curr, bbox)) >= 0)
+    start_time = get_time();
+    while ((flag = rd_range_frame(curr, bbox)) >= 0)
     {
         curr_gif_time += 5;
         fr++;
@@ -356,7 +433,10 @@ int main(int argc, char *argv[])
         fprintf(stderr, "Error terminating GIF file %s\n", argv[2]);
         exit(1);
     }
-    wrote += ret;
+    elapsed = get_time() - start_time;
+
+    /* With worker threads, gif_wr_frame_m doesn't know the frame sizes. */
+    wrote = ftell(fo);
     fclose(fo);
 
     printf("Decoded %d source frames (%d dupes, %d dropped)\n",
@@ -367,6 +447,11 @@ int main(int argc, char *argv[])
     printf("GIF frame type breakdown:\n");
     for (i = 0; i < 6; i++)
         printf("%-65s%10d\n", typedesc[i], gif_best_stat[i]);
+    printf("Pass 2 took %.3f sec:  %.1f source frames/sec, "
+           "%.1f unique frames/sec (%d worker thread%s)\n",
+           elapsed, fr / (elapsed > 0 ? elapsed : 1e-9),
+           out_fr / (elapsed > 0 ? elapsed : 1e-9),
+           threads, threads == 1 ? "" : "s");
 
     return 0;
 }
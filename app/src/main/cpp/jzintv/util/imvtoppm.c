@@ -51,6 +51,59 @@ uint8_t curr[MVI_MAX_X * MVI_MAX_Y];
 uint8_t lbuf[MVI_MAX_X * 2][3];
 uint8_t bbox[8][4];
 
+/* ------------------------------------------------------------------------ */
+/*  Frame range selected with -r.  Decoding starts at the nearest keyframe  */
+/*  at or before the first frame, if the movie has a keyframe index.        */
+/* ------------------------------------------------------------------------ */
+int first_fr = 0, last_fr = INT_MAX;
+int in_range = 0;
+
+static int parse_range(const char *s)
+{
+    char *end;
+
+    first_fr = strtol(s, &end, 10);
+    if (end == s || first_fr < 0)
+        return -1;
+
+    if (*end == ':' || *end == '-')
+    {
+        s = end + 1;
+        last_fr = strtol(s, &end, 10);
+        if (end == s || last_fr < first_fr)
+            return -1;
+    }
+
+    return *end == '\0' ? 0 : -1;
+}
+
+static int seek_range(void)
+{
+    in_range = 0;
+    return mvi_seek(&movie, first_fr);
+}
+
+static int rd_range_frame(uint8_t *vid, uint8_t fr_bbox[8][4])
+{
+    int flag;
+
+    while ((flag = mvi_rd_frame(&movie, vid, fr_bbox)) >= 0)
+    {
+        if (movie.fr < first_fr)
+            continue;
+        if (movie.fr > last_fr)
+            return -1;
+
+        /* The first frame in range is never a repeat, as far as we care. */
+        if (!in_range)
+            flag &= ~MVI_FR_SAME;
+        in_range = 1;
+        break;
+    }
+
+    return flag;
+}
+
 
 int main(int argc, char *argv[])
 {
@@ -60,16 +113,21 @@ int main(int argc, char *argv[])
     char *fname, *fprev;
     int mode = 0;
 
-    if (argc == 4 && argv[1][0] == '-' && argv[1][1] == '\0')
+    while (argc >= 4 && argv[1][0] == '-')
     {
-        mode = 1;
+        if      (argv[1][1] == '\0') mode = 1;
+        else if (argv[1][1] == 'r' && parse_range(&argv[1][2]) == 0) ;
+        else break;
+
         argc--;
         argv++;
     }
 
     if (argc != 3)
     {
-        fprintf(stderr, "%s [-] input.imv output.gif\n", argv[0]);
+        fprintf(stderr, "%s [-] [-r#[:#]] input.imv output\n"
+                        "    -r#[:#]  Only expand frames # through #\n",
+                argv[0]);
         exit(1);
     }
 
@@ -90,10 +148,18 @@ int main(int argc, char *argv[])
 
     memset(movie.vid, 16, MVI_MAX_X * MVI_MAX_Y);
     movie.f = fi;
-    fr = 0;
+    fr = first_fr;
+
+    if (first_fr > 0 || last_fr < INT_MAX)
+    {
+        if (mvi_rd_index(&movie) < 0)
+            fprintf(stderr, "No keyframe index in %s; "
+                            "decoding from the start\n", argv[1]);
+        seek_range();
+    }
 
     printf("Expanding IMV to PPM files...\n"); fflush(stdout);
-    while ((flag = mvi_rd_frame(&movie, curr, bbox)) >= 0)
+    while ((flag = rd_range_frame(curr, bbox)) >= 0)
     {
         char *ftmp;
 
@@ -39,7 +39,7 @@ t_locutus_wrap      locutus;
 game_metadata_t*    metadata;
 bc_cfgfile_t*       bincfg;
 
-int jlp_accel_on, lto_isa_enabled;
+THREAD_LOCAL int jlp_accel_on, lto_isa_enabled;
 int debug = 0;
 
 #define GET_BIT(bv,i,b) do {                                    \
@@ -0,0 +1,308 @@
+/* ======================================================================== */
+/*  ITRACE2TXT -- Convert a compact instruction trace written by the        */
+/*                debugger's "ht" command into the same text format as      */
+/*                the register history in "dump.hst".                       */
+/*                                                                          */
+/*  Usage:  itrace2txt [-a#[:#]] [-w#] input.trc [output.txt]               */
+/*      -a#[:#]  Only show instructions at addresses # through # (hex).     */
+/*      -w#      Line width, as the debugger's display width.  Default 80.  */
+/* ======================================================================== */
+
+#include "config.h"
+#include "periph/periph.h"
+#include "cp1600/cp1600.h"
+#include "debug/debug_dasm1600.h"
+#include "debug/itrace.h"
+#include "minilzo/minilzo.h"
+
+/* ------------------------------------------------------------------------ */
+/*  The disassembler asks for symbols.  We don't have any.                  */
+/* ------------------------------------------------------------------------ */
+const char *debug_symb_for_addr(const uint32_t addr);
+
+const char *debug_symb_for_addr(const uint32_t addr)
+{
+    UNUSED(addr);
+    return NULL;
+}
+
+static const char req_ack_char[16] =
+{
+    '-', 'q', '2', 'Q', 'b', '5', '6', '7',
+    '8', '9', 'a', 'x', 'B', 'd', 'e', 'f'
+};
+
+typedef struct rec_t
+{
+    uint16_t r[8];
+    uint16_t w[3];
+    uint32_t flags;             /* S C O Z I D intr in bits 0-6 */
+    uint32_t req_ack;
+    uint64_t now;
+} rec_t;
+
+static uint32_t addr_lo = 0x0000, addr_hi = 0xFFFF;
+static int      width = 80;
+
+static uint16_t seen[0x10000][3];
+static uint8_t  raw[ITRACE_CHUNK];
+static uint8_t  packed[ITRACE_CHUNK + ITRACE_CHUNK / 16 + 67];
+
+static int parse_range(const char *s)
+{
+    char *end;
+
+    addr_lo = addr_hi = strtoul(s, &end, 16);
+    if (end == s || addr_lo > 0xFFFF)
+        return -1;
+
+    if (*end == ':' || *end == '-')
+    {
+        s = end + 1;
+        addr_hi = strtoul(s, &end, 16);
+        if (end == s || addr_hi > 0xFFFF || addr_hi < addr_lo)
+            return -1;
+    }
+
+    return *end == '\0' ? 0 : -1;
+}
+
+static uint32_t get32(const uint8_t *const p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* ======================================================================== */
+/*  PRINT_REC -- Same layout as debug_render_reghist(), with indent 0 and   */
+/*               no symbols or source.  'nreq_ack' is the req/ack state of  */
+/*               the following instruction.                                 */
+/* ======================================================================== */
+static void print_rec(FILE *const fo, const rec_t *const rec,
+                      const uint32_t nreq_ack)
+{
+    static char buf[1024];
+    const uint32_t f = rec->flags;
+    int disasm_width = width - 60;
+    char *dis;
+
+    if (disasm_width > 500) disasm_width = 500;
+    if (disasm_width < 0)   disasm_width = 0;
+
+    dasm1600(buf, rec->r[7], (f >> 5) & 1, rec->w[0], rec->w[1], rec->w[2]);
+    dis = buf + 39;
+
+    if ((nreq_ack & (CP1600_INTAK|CP1600_BUSAK)) != 0)
+    {
+        dis = buf + 37;
+        dis[0] = '>';
+        dis[1] = '>';
+    }
+
+    memmove(buf, dis, disasm_width);
+    buf[disasm_width] = 0;
+
+    fprintf(fo, "%.4X %.4X %.4X %.4X %.4X %.4X %.4X %.4X %c%c%c%c%c%c%c%c"
+            "%-*.*s %8" U64_FMT "\n",
+            rec->r[0], rec->r[1], rec->r[2], rec->r[3],
+            rec->r[4], rec->r[5], rec->r[6], rec->r[7],
+            (f >> 0) & 1 ? 'S' : '-', (f >> 3) & 1 ? 'Z' : '-',
+            (f >> 2) & 1 ? 'O' : '-', (f >> 1) & 1 ? 'C' : '-',
+            (f >> 4) & 1 ? 'I' : '-', (f >> 5) & 1 ? 'D' : '-',
+            (f >> 6) & 1 ? 'i' : '-',
+            req_ack_char[rec->req_ack & 15],
+            disasm_width, disasm_width, buf, rec->now);
+}
+
+/* ======================================================================== */
+/*  DECODE_CHUNK -- Decode the records in one chunk.  'cur' carries the     */
+/*                  delta state and holds the last record decoded, which    */
+/*                  isn't printed until we've seen the one after it.        */
+/* ======================================================================== */
+static int decode_chunk(FILE *const fo, const uint8_t *p,
+                        const uint8_t *const end, rec_t *const cur,
+                        int *const have_cur, uint64_t *const count)
+{
+    while (p < end)
+    {
+        rec_t next = *cur;
+        uint32_t mask, flg, zz = 0, shift;
+        uint64_t dt = 0;
+        int i, n;
+
+        if (end - p < 4)
+            return -1;
+
+        mask = *p++;
+        flg  = *p++;
+        next.flags = flg & 0x7F;
+        if (flg & ITRACE_FLAG_REQACK)
+            next.req_ack = *p++;
+
+        for (shift = 0; p < end && shift < 21; shift += 7)
+        {
+            zz |= (uint32_t)(*p & 0x7F) << shift;
+            if (!(*p++ & 0x80))
+                break;
+        }
+        next.r[7] += (zz >> 1) ^ -(zz & 1);
+
+        for (shift = 0; p < end && shift < 64; shift += 7)
+        {
+            dt |= (uint64_t)(*p & 0x7F) << shift;
+            if (!(*p++ & 0x80))
+                break;
+        }
+        next.now += dt;
+
+        for (i = 0; i < 7; i++)
+            if (mask & (1 << i))
+            {
+                if (end - p < 2)
+                    return -1;
+                next.r[i] = p[0] | (p[1] << 8);
+                p += 2;
+            }
+
+        if (mask & ITRACE_MASK_WORDS)
+        {
+            if (end - p < 2)
+                return -1;
+
+            n = itrace_num_words(p[0] | (p[1] << 8), (next.flags >> 5) & 1);
+            if (end - p < 2 * n)
+                return -1;
+
+            for (i = 0; i < n; i++, p += 2)
+                seen[next.r[7]][i] = p[0] | (p[1] << 8);
+        }
+
+        for (i = 0; i < 3; i++)
+            next.w[i] = seen[next.r[7]][i];
+
+        if (*have_cur && cur->r[7] >= addr_lo && cur->r[7] <= addr_hi)
+            print_rec(fo, cur, next.req_ack);
+
+        *cur = next;
+        *have_cur = 1;
+        ++*count;
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *fi, *fo = stdout;
+    uint8_t hdr[8];
+    rec_t cur;
+    int have_cur = 0, err = 0;
+    uint64_t count = 0;
+
+    while (argc >= 2 && argv[1][0] == '-' && argv[1][1])
+    {
+        if      (argv[1][1] == 'a' && parse_range(&argv[1][2]) == 0) ;
+        else if (argv[1][1] == 'w' && (width = atoi(&argv[1][2])) > 0) ;
+        else { argc = 0; break; }
+
+        argc--;
+        argv++;
+    }
+
+    if (argc != 2 && argc != 3)
+    {
+        fprintf(stderr, "%s [-a#[:#]] [-w#] input.trc [output.txt]\n"
+                        "    -a#[:#]  Only show addresses # through # (hex)\n"
+                        "    -w#      Line width.  Default is 80\n",
+                argc ? argv[0] : "itrace2txt");
+        exit(1);
+    }
+
+    if (!(fi = fopen(argv[1], "rb")))
+    {
+        fprintf(stderr, "Could not open %s for reading\n", argv[1]);
+        exit(1);
+    }
+
+    if (argc == 3 && !(fo = fopen(argv[2], "w")))
+    {
+        fprintf(stderr, "Could not open %s for writing\n", argv[2]);
+        exit(1);
+    }
+
+    if (fread(hdr, 1, 8, fi) != 8 || memcmp(hdr, ITRACE_MAGIC, 4) ||
+        hdr[4] != ITRACE_VERSION)
+    {
+        fprintf(stderr, "%s is not a version %d instruction trace\n",
+                argv[1], ITRACE_VERSION);
+        exit(1);
+    }
+
+    if (lzo_init() != LZO_E_OK)
+    {
+        fprintf(stderr, "lzo_init() failed\n");
+        exit(1);
+    }
+
+    memset(&cur, 0, sizeof(cur));
+
+    while (fread(hdr, 1, 8, fi) == 8)
+    {
+        const uint32_t raw_len = get32(hdr + 0);
+        const uint32_t len     = get32(hdr + 4);
+        const uint8_t *data    = packed;
+
+        if (raw_len > ITRACE_CHUNK || len > raw_len ||
+            fread(packed, 1, len, fi) != len)
+        {
+            err = 1;
+            break;
+        }
+
+        if (len < raw_len)
+        {
+            lzo_uint out_len = raw_len;
+            if (lzo1x_decompress_safe(packed, len, raw, &out_len, NULL)
+                    != LZO_E_OK || out_len != raw_len)
+            {
+                err = 1;
+                break;
+            }
+            data = raw;
+        }
+
+        if (decode_chunk(fo, data, data + raw_len, &cur, &have_cur, &count))
+        {
+            err = 1;
+            break;
+        }
+    }
+
+    if (have_cur && cur.r[7] >= addr_lo && cur.r[7] <= addr_hi)
+        print_rec(fo, &cur, 0);
+
+    if (err)
+        fprintf(stderr, "%s: Trace is truncated or corrupt after %" U64_FMT
+                        " instructions\n", argv[1], count);
+
+    fclose(fi);
+    if (fo != stdout)
+        fclose(fo);
+
+    return err;
+}
+
+/* ======================================================================== */
+/*  This program is free software; you can redistribute it and/or modify    */
+/*  it under the terms of the GNU General Public License as published by    */
+/*  the Free Software Foundation; either version 2 of the License, or       */
+/*  (at your option) any later version.                                     */
+/*                                                                          */
+/*  This program is distributed in the hope that it will be useful,         */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of          */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU       */
+/*  General Public License for more details.                                */
+/*                                                                          */
+/*  You should have received a copy of the GNU General Public License along */
+/*  with this program; if not, write to the Free Software Foundation, Inc., */
+/*  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.             */
+/* ======================================================================== */
@@ -25,7 +25,7 @@ t_locutus locutus;
 extern "C"
 {
     // These are here just to satisfy the linker.
-    int jlp_accel_on, lto_isa_enabled;
+    THREAD_LOCAL int jlp_accel_on, lto_isa_enabled;
 }
 
 LOCAL void show_messages(const t_loc_to_bin& loc_to_bin)
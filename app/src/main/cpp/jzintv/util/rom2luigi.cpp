@@ -27,7 +27,7 @@ icartrom_t  icart;
 extern "C"
 {
     // These are here just to satisfy the linker.
-    int jlp_accel_on, lto_isa_enabled;
+    THREAD_LOCAL int jlp_accel_on, lto_isa_enabled;
 }
 
 LOCAL void show_messages(const t_rom_to_loc& rom_to_loc)
@@ -507,6 +507,31 @@ void symtab_grep_for_symbol(symtab_t *symtab, symtab_grep_callback_t callback,
     AVL_Traverse(&symtab->by_symbol, InOrder, match_string);
 }
 
+/* ------------------------------------------------------------------------ */
+/*  SYMTAB_FOR_EACH          -- Call 'callback' for every symbol, with its  */
+/*                              address and sequence number at that address */
+/*                              and the caller's 'opaque' pointer.          */
+/* ------------------------------------------------------------------------ */
+static symtab_each_callback_t each_callback = NULL;
+static void *each_opaque;
+
+static int each_symbol(void *p)
+{
+    symtab_ent_t *ent = (symtab_ent_t *)p;
+    each_callback(each_opaque, ent->symbol, ent->address, ent->addrseq);
+
+    return 0;
+}
+
+void symtab_for_each(symtab_t *symtab, symtab_each_callback_t callback,
+                     void *opaque)
+{
+    each_callback = callback;
+    each_opaque   = opaque;
+
+    AVL_Traverse(&symtab->by_symbol, InOrder, each_symbol);
+}
+
 
 /* ======================================================================== */
 /*  This program is free software; you can redistribute it and/or modify    */
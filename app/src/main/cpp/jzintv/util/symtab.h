@@ -43,6 +43,7 @@ typedef struct symtab_t
 /*  SYMTAB_DUMP_BY_ADDR     -- Write symbol table dump, sorted by address.  */
 /*  SYMTAB_DUMP_XREFS       -- Write cross-reference table.                 */
 /*  SYMTAB_GREP_FOR_SYMBOL  -- Search for symbols containing 'string'       */
+/*  SYMTAB_FOR_EACH         -- Call 'callback' for every symbol.            */
 /* ------------------------------------------------------------------------ */
 symtab_t *symtab_create      (void);
 void      symtab_destroy     (symtab_t *symtab);
@@ -58,6 +59,9 @@ void      symtab_dump_xrefs  (symtab_t *symtab, FILE *f);
 typedef void (*symtab_grep_callback_t)(const char *, uint32_t, int);
 
 void symtab_grep_for_symbol(symtab_t*, symtab_grep_callback_t, const char*);
+typedef void (*symtab_each_callback_t)(void *, const char *, uint32_t, int);
+
+void symtab_for_each(symtab_t*, symtab_each_callback_t, void *opaque);
 
 #endif
 
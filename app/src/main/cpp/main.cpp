@@ -103,15 +103,6 @@ void free_rom_config_struct(rom_config_struct_t *rom_config) {
     }
     rom_config->custom_commands = nullptr;
 
-    if (rom_config->texture_screenshot > 0) {
-        glDeleteTextures(1, &(rom_config->texture_screenshot));
-    }
-    rom_config->texture_screenshot = 0;
-
-    if (rom_config->texture_box > 0) {
-        glDeleteTextures(1, &(rom_config->texture_box));
-    }
-    rom_config->texture_box = 0;
     clear_controls(&(rom_config->controls[0]));
     clear_controls(&(rom_config->controls[1]));
     clear_controls(&(rom_config->controls_delta[0]));
@@ -180,6 +171,7 @@ static void apply_default_settings() {
     app_conf->image_height_percentage = 45;
 
     app_conf->num_roms_jump = 20;
+    app_conf->idle_max_fps = 5;
     app_conf->hide_unavailable_roms = true;
     app_conf->last_crc32 = 0;
 
@@ -209,6 +201,7 @@ static void apply_default_settings() {
     app_conf->mobile_default_landscape_controls_size = 2;
     app_conf->jzintv_fullscreen = false;
     app_conf->use_external_jzintv = false;
+    app_conf->jzintv_warm_core = true;
     app_conf->mobile_use_inverted_controls = false;
     app_conf->act_player = 0;
 
@@ -259,8 +252,6 @@ static void free_roms_list(struct roms_list_struct_t *str) {
         free(str->folder);
     }
 
-    clear_roms_textures(str);
-
     for (int i = 0; i < str->total_roms_num; i++) {
         free_rom_config_struct(&(str->list[i]));
     }
@@ -337,27 +328,15 @@ static void copy_config(rom_config_struct_t *original_config, rom_config_struct_
     act_config->crc32 = original_config->crc32;
     act_config->double_row = original_config->double_row;
     act_config->available_status = original_config->available_status;
-    act_config->original_texture_screenshot_width = original_config->original_texture_screenshot_width;
-    act_config->original_texture_screenshot_height = original_config->original_texture_screenshot_height;
-    act_config->original_texture_box_width = original_config->original_texture_box_width;
-    act_config->original_texture_box_height = original_config->original_texture_box_height;
-    act_config->texture_screenshot = original_config->texture_screenshot;
-    act_config->texture_box = original_config->texture_box;
 }
 
 void reset_rom_config(rom_config_struct_t *act_rom_config, uint32_t crc32) {
     act_rom_config->description = nullptr;
     act_rom_config->file_name = nullptr;
-    act_rom_config->original_texture_box_height = 0;
-    act_rom_config->original_texture_box_width = 0;
-    act_rom_config->original_texture_screenshot_height = 0;
-    act_rom_config->original_texture_screenshot_width = 0;
     act_rom_config->crc32 = 0;
     act_rom_config->double_row = false;
     act_rom_config->available_status = 0;
     act_rom_config->image_file_name = nullptr;
-    act_rom_config->texture_screenshot = 0;
-    act_rom_config->texture_box = 0;
     act_rom_config->box_file_name = nullptr;
     act_rom_config->crc32 = crc32;
     act_rom_config->game_name = nullptr;
@@ -401,6 +380,32 @@ static void manage_new_frame() {
     }
 }
 
+static int loading_w = 0;
+static int loading_h = 0;
+
+// Crc32 -> index in roms_configuration
+static std::unordered_map<uint32_t, int> roms_configuration_by_crc32;
+
+static void rebuild_roms_configuration_index() {
+    roms_configuration_by_crc32.clear();
+    for (int i = 0; i < app_config_struct.num_valid_crc32s; i++) {
+        // First wins, as the linear scan did
+        roms_configuration_by_crc32.insert(std::make_pair(roms_configuration[i].crc32, i));
+    }
+}
+
+static int lookup_roms_configuration(uint32_t crc32) {
+    auto it = roms_configuration_by_crc32.find(crc32);
+    if (it != roms_configuration_by_crc32.end() && it->second < app_config_struct.num_valid_crc32s &&
+        roms_configuration[it->second].crc32 == crc32) {
+        return it->second;
+    }
+    // roms_configuration changed under us (games added, removed or sorted): rebuild and retry
+    rebuild_roms_configuration_index();
+    it = roms_configuration_by_crc32.find(crc32);
+    return it != roms_configuration_by_crc32.end() ? it->second : -1;
+}
+
 static void step_loading(int w, int h) {
     static int count = 0;
     if (!gui_util_str.show_loading) {
@@ -415,6 +420,10 @@ static void step_loading(int w, int h) {
     }
 }
 
+static void step_loading_index() {
+    step_loading(loading_w, loading_h);
+}
+
 static void load_roms(struct app_config_struct_t *app_conf, struct roms_list_struct_t *roms_list_struct_ptr, vector<rom_config_struct_t> roms_config, bool hide_unavailable) {
 
     // Non troppo corretto funzionalmente...
@@ -423,11 +432,8 @@ static void load_roms(struct app_config_struct_t *app_conf, struct roms_list_str
     }
 
     vector<rom_config_struct_t> found_roms;
-    struct dirent *Dirent;
-    DIR *dir;
-    char *p;
+    vector<rom_index_entry_t> entries;
 
-    dir = opendir(roms_list_struct_ptr->folder);
     Log(LOG_INFO) << "Reloading roms list from " << roms_list_struct_ptr->folder;
 
     roms_list_struct_ptr->execBinStatus = 0;
@@ -437,174 +443,159 @@ static void load_roms(struct app_config_struct_t *app_conf, struct roms_list_str
     roms_list_struct_ptr->tutorvisionGromBinStatus = 0;
     roms_list_struct_ptr->ecsBinStatus = 0;
 
-    if (dir != nullptr) {
-        int w;
-        int h;
-        if (!gui_util_str.show_loading) {
-            if (loading_millis == -1) {
-                loading_millis = get_act_millis();
-            }
-            get_window_size(&w, &h);
-            if (app_config_struct.custom_font_loaded) {
-                ImGui::PopFont();
-            }
-            app_config_struct.custom_font_loaded = false;
+    if (!gui_util_str.show_loading) {
+        if (loading_millis == -1) {
+            loading_millis = get_act_millis();
         }
-
-        while ((Dirent = readdir(dir)) != nullptr) {
-            step_loading(w, h);
-            if (Dirent->d_type == DT_DIR && strcmp(Dirent->d_name, ".")) {
-            } else {
-                if (strlen(Dirent->d_name) < 4) continue;
-                p = Dirent->d_name + (strlen(Dirent->d_name) - 4);
-                if ((*p) != '.')continue;
-
-                char complete_filename[FILENAME_MAX];
-                sprintf(complete_filename, "%s/%s", roms_list_struct_ptr->folder, Dirent->d_name);
-                uint32_t crc32 = file_crc32(complete_filename);
-
-                if (crc32 == app_conf->execBinCrc32) {
-                    roms_list_struct_ptr->exec_bin_crc32 = crc32;
-                    bool save_name = false;
-                    if (!strcmp(Dirent->d_name, "exec.bin")) {
-                        roms_list_struct_ptr->execBinStatus = 1;
-                        save_name = true;
-                    } else if (roms_list_struct_ptr->execBinStatus != 1) {
-                        roms_list_struct_ptr->execBinStatus = 2;
-                        save_name = true;
-                    }
-                    if (save_name) {
-                        sprintf(roms_list_struct_ptr->exec_bin_file_name, "%s", Dirent->d_name);
-                    }
-                    continue;
-                } else if (crc32 == app_conf->gromBinCrc32) {
-                    roms_list_struct_ptr->grom_bin_crc32 = crc32;
-                    bool save_name = false;
-                    if (!strcmp(Dirent->d_name, "grom.bin")) {
-                        roms_list_struct_ptr->gromBinStatus = 1;
-                        save_name = true;
-                    } else if (roms_list_struct_ptr->gromBinStatus != 1) {
-                        roms_list_struct_ptr->gromBinStatus = 2;
-                        save_name = true;
-                    }
-                    if (save_name) {
-                        sprintf(roms_list_struct_ptr->grom_bin_file_name, "%s", Dirent->d_name);
-                    }
-                    continue;
-                } else if (crc32 == app_conf->tutorvisionExecBinCrc32) {
-                    roms_list_struct_ptr->tutorvision_exec_bin_crc32 = crc32;
-                    bool save_name = false;
-                    if (!strcmp(Dirent->d_name, "wbexec.bin")) {
-                        roms_list_struct_ptr->tutorvisionExecBinStatus = 1;
-                        save_name = true;
-                    } else if (roms_list_struct_ptr->tutorvisionExecBinStatus != 1) {
-                        roms_list_struct_ptr->tutorvisionExecBinStatus = 2;
-                        save_name = true;
-                    }
-                    if (save_name) {
-                        sprintf(roms_list_struct_ptr->tutorvision_exec_bin_file_name, "%s", Dirent->d_name);
-                    }
-                    continue;
-                } else if (crc32 == app_conf->tutorvisionGromBinCrc32) {
-                    roms_list_struct_ptr->tutorvision_grom_bin_crc32 = crc32;
-                    bool save_name = false;
-                    if (!strcmp(Dirent->d_name, "gromintv.bin")) {
-                        roms_list_struct_ptr->tutorvisionGromBinStatus = 1;
-                        save_name = true;
-                    } else if (roms_list_struct_ptr->tutorvisionGromBinStatus != 1) {
-                        roms_list_struct_ptr->tutorvisionGromBinStatus = 2;
-                        save_name = true;
-                    }
-                    if (save_name) {
-                        sprintf(roms_list_struct_ptr->tutorvision_grom_bin_file_name, "%s", Dirent->d_name);
-                    }
-                    continue;
-                } else if (crc32 == app_conf->ecsBinCrc32) {
-                    roms_list_struct_ptr->ecs_bin_crc32 = crc32;
-                    bool save_name = false;
-                    if (!strcmp(Dirent->d_name, "ecs.bin")) {
-                        roms_list_struct_ptr->ecsBinStatus = 1;
-                        save_name = true;
-                    } else if (roms_list_struct_ptr->ecsBinStatus != 1) {
-                        roms_list_struct_ptr->ecsBinStatus = 2;
-                        save_name = true;
-                    }
-                    if (save_name) {
-                        sprintf(roms_list_struct_ptr->ecs_bin_file_name, "%s", Dirent->d_name);
-                    }
-                    continue;
+        get_window_size(&loading_w, &loading_h);
+        if (app_config_struct.custom_font_loaded) {
+            ImGui::PopFont();
+        }
+        app_config_struct.custom_font_loaded = false;
+    }
+
+    // Only new or changed files are read, see rom_index.cpp
+    const uint32_t bios_crc32[ROM_TYPE_BIOS_NUM] = {app_conf->execBinCrc32, app_conf->gromBinCrc32,
+                                                    app_conf->tutorvisionExecBinCrc32, app_conf->tutorvisionGromBinCrc32,
+                                                    app_conf->ecsBinCrc32};
+    const char *folder = roms_list_struct_ptr->folder;
+    char index_file[FILENAME_MAX];
+    sprintf(index_file, "%s%s%08x.dat", app_conf->root_folder_for_configuration, ROM_INDEX_FILE_PREFIX,
+            crc32_block(0xFFFFFFFFU, (const unsigned char *) folder, strlen(folder)));
+
+    if (rom_index_scan(folder, index_file, bios_crc32, &entries, step_loading_index)) {
+        for (int i = 0; i < entries.size(); i++) {
+            const char *d_name = entries[i].file_name.c_str();
+            uint32_t crc32 = entries[i].crc32;
+            int type = entries[i].type;
+
+            if (type == ROM_TYPE_EXEC) {
+                roms_list_struct_ptr->exec_bin_crc32 = crc32;
+                bool save_name = false;
+                if (!strcmp(d_name, "exec.bin")) {
+                    roms_list_struct_ptr->execBinStatus = 1;
+                    save_name = true;
+                } else if (roms_list_struct_ptr->execBinStatus != 1) {
+                    roms_list_struct_ptr->execBinStatus = 2;
+                    save_name = true;
                 }
-
-                if (!strcmp(Dirent->d_name, "ecs.bin")) {
-                    roms_list_struct_ptr->ecsBinStatus = 3;
-                    roms_list_struct_ptr->ecs_bin_crc32 = crc32;
-                } else if (!strcmp(Dirent->d_name, "grom.bin")) {
-                    roms_list_struct_ptr->gromBinStatus = 3;
-                    roms_list_struct_ptr->grom_bin_crc32 = crc32;
-                } else if (!strcmp(Dirent->d_name, "exec.bin")) {
-                    roms_list_struct_ptr->execBinStatus = 3;
-                    roms_list_struct_ptr->exec_bin_crc32 = crc32;
-                } else if (!strcmp(Dirent->d_name, "wbexec.bin")) {
-                    roms_list_struct_ptr->tutorvisionExecBinStatus = 3;
-                    roms_list_struct_ptr->tutorvision_exec_bin_crc32 = crc32;
-                } else if (!strcmp(Dirent->d_name, "gromintv.bin")) {
-                    roms_list_struct_ptr->tutorvisionGromBinStatus = 3;
-                    roms_list_struct_ptr->tutorvision_grom_bin_crc32 = crc32;
+                if (save_name) {
+                    sprintf(roms_list_struct_ptr->exec_bin_file_name, "%s", d_name);
                 }
-
-                if (((strcasecmp(p, ".bin")) &&
-                     (strcasecmp(p, ".rom")) &&
-                     (strcasecmp(p, ".int")) &&
-                     (strcasecmp(p, ".cc3")) &&
-                     (strcasecmp(p, ".luigi")) &&
-                     (strcasecmp(p, ".itv"))) || (
-                            (!strcasecmp(Dirent->d_name, "exec.bin")) ||
-                            (!strcasecmp(Dirent->d_name, "grom.bin")) ||
-                            (!strcasecmp(Dirent->d_name, "wbexec.bin")) ||
-                            (!strcasecmp(Dirent->d_name, "gromintv.bin")) ||
-                            (!strcasecmp(Dirent->d_name, "ecs.bin"))) || crc32 == 0)
-                    continue;
-
-                rom_config_struct_t config;
-                reset_rom_config(&config, crc32);
-                config.file_name = strdup(Dirent->d_name);
-                config.available_status = ROM_AVAILABLE_STATUS_UNKNOWN;
-                clear_sdl_frect(&config.mobile_landscape_rect);
-                clear_sdl_frect(&config.mobile_portrait_rect);
-                found_roms.push_back(config);
+                continue;
+            } else if (type == ROM_TYPE_GROM) {
+                roms_list_struct_ptr->grom_bin_crc32 = crc32;
+                bool save_name = false;
+                if (!strcmp(d_name, "grom.bin")) {
+                    roms_list_struct_ptr->gromBinStatus = 1;
+                    save_name = true;
+                } else if (roms_list_struct_ptr->gromBinStatus != 1) {
+                    roms_list_struct_ptr->gromBinStatus = 2;
+                    save_name = true;
+                }
+                if (save_name) {
+                    sprintf(roms_list_struct_ptr->grom_bin_file_name, "%s", d_name);
+                }
+                continue;
+            } else if (type == ROM_TYPE_TUTORVISION_EXEC) {
+                roms_list_struct_ptr->tutorvision_exec_bin_crc32 = crc32;
+                bool save_name = false;
+                if (!strcmp(d_name, "wbexec.bin")) {
+                    roms_list_struct_ptr->tutorvisionExecBinStatus = 1;
+                    save_name = true;
+                } else if (roms_list_struct_ptr->tutorvisionExecBinStatus != 1) {
+                    roms_list_struct_ptr->tutorvisionExecBinStatus = 2;
+                    save_name = true;
+                }
+                if (save_name) {
+                    sprintf(roms_list_struct_ptr->tutorvision_exec_bin_file_name, "%s", d_name);
+                }
+                continue;
+            } else if (type == ROM_TYPE_TUTORVISION_GROM) {
+                roms_list_struct_ptr->tutorvision_grom_bin_crc32 = crc32;
+                bool save_name = false;
+                if (!strcmp(d_name, "gromintv.bin")) {
+                    roms_list_struct_ptr->tutorvisionGromBinStatus = 1;
+                    save_name = true;
+                } else if (roms_list_struct_ptr->tutorvisionGromBinStatus != 1) {
+                    roms_list_struct_ptr->tutorvisionGromBinStatus = 2;
+                    save_name = true;
+                }
+                if (save_name) {
+                    sprintf(roms_list_struct_ptr->tutorvision_grom_bin_file_name, "%s", d_name);
+                }
+                continue;
+            } else if (type == ROM_TYPE_ECS) {
+                roms_list_struct_ptr->ecs_bin_crc32 = crc32;
+                bool save_name = false;
+                if (!strcmp(d_name, "ecs.bin")) {
+                    roms_list_struct_ptr->ecsBinStatus = 1;
+                    save_name = true;
+                } else if (roms_list_struct_ptr->ecsBinStatus != 1) {
+                    roms_list_struct_ptr->ecsBinStatus = 2;
+                    save_name = true;
+                }
+                if (save_name) {
+                    sprintf(roms_list_struct_ptr->ecs_bin_file_name, "%s", d_name);
+                }
+                continue;
             }
-        }
-        if (!gui_util_str.show_loading) {
-            if (custom_font != nullptr) {
-                ImGui::PushFont(custom_font);
-                app_config_struct.custom_font_loaded = true;
+
+            if (!strcmp(d_name, "ecs.bin")) {
+                roms_list_struct_ptr->ecsBinStatus = 3;
+                roms_list_struct_ptr->ecs_bin_crc32 = crc32;
+            } else if (!strcmp(d_name, "grom.bin")) {
+                roms_list_struct_ptr->gromBinStatus = 3;
+                roms_list_struct_ptr->grom_bin_crc32 = crc32;
+            } else if (!strcmp(d_name, "exec.bin")) {
+                roms_list_struct_ptr->execBinStatus = 3;
+                roms_list_struct_ptr->exec_bin_crc32 = crc32;
+            } else if (!strcmp(d_name, "wbexec.bin")) {
+                roms_list_struct_ptr->tutorvisionExecBinStatus = 3;
+                roms_list_struct_ptr->tutorvision_exec_bin_crc32 = crc32;
+            } else if (!strcmp(d_name, "gromintv.bin")) {
+                roms_list_struct_ptr->tutorvisionGromBinStatus = 3;
+                roms_list_struct_ptr->tutorvision_grom_bin_crc32 = crc32;
             }
+
+            if (type != ROM_TYPE_GAME)
+                continue;
+
+            rom_config_struct_t config;
+            reset_rom_config(&config, crc32);
+            config.file_name = strdup(d_name);
+            config.available_status = ROM_AVAILABLE_STATUS_UNKNOWN;
+            clear_sdl_frect(&config.mobile_landscape_rect);
+            clear_sdl_frect(&config.mobile_portrait_rect);
+            found_roms.push_back(config);
         }
+        rom_index_watch(folder);
     } else {
+        rom_index_unwatch();
         ADD_POPUP("Path invalid", "Roms path invalid:" << roms_list_struct_ptr->folder);
     }
 
-    closedir(dir);
+    if (!gui_util_str.show_loading) {
+        if (custom_font != nullptr) {
+            ImGui::PushFont(custom_font);
+            app_config_struct.custom_font_loaded = true;
+        }
+    }
+
     sort_config_by_crc_32(&found_roms);
     remove_duplicates(&found_roms, false);
 
     // Check cross infos
-    int q = 0;
+    int q;
     int unknown = 0;
     uint32_t prev_crc32 = 0;
     char prev_name[100];
+    rebuild_roms_configuration_index();
     for (int i = 0; i < found_roms.size(); i++) {
         uint32_t crc32 = found_roms[i].crc32;
-        if (app_config_struct.num_valid_crc32s > 0) {
-            while (roms_config[q].crc32 < crc32) {
-                if (q >= app_config_struct.num_valid_crc32s - 1) {
-                    break;
-                }
-                q++;
-            }
-        }
+        q = lookup_roms_configuration(crc32);
 
-        if (app_config_struct.num_valid_crc32s > 0 && roms_config[q].crc32 == crc32) {
+        if (q >= 0) {
             // Trovato in config file
             roms_config[q].available_status = ROM_AVAILABLE_STATUS_FOUND;
             found_roms[i].available_status = ROM_AVAILABLE_STATUS_FOUND;
@@ -799,6 +790,11 @@ static void add_jzintv_command(vector<string> *commands_list, const char* option
     commands_list->push_back(final_command.c_str());
 }
 
+// What follows 'option' in the command just added: the launch descriptor takes the same (formatted) value
+static string last_command_argument(vector<string> *commands, const char *option) {
+    return commands->back().substr(strlen(option));
+}
+
 static bool check_file_presence(const char *main_message, char *fileName) {
     std::stringstream file;
     file << app_config_struct.roms_folder_absolute_path << fileName;
@@ -1003,13 +999,25 @@ bool start_emulation(int index) {
         return false;
     }
 
+    // The built-in jzIntv gets the usual options as a launch descriptor, and only the others as command line
+    jzintv_launch_t launch_desc;
+    memset(&launch_desc, 0, sizeof(launch_desc));
+    launch_desc.gram_size = -1;
+    string rom_path, exec_path, grom_path, game_path, disp_res, ecs_tape, jlp_savegame, kbdhackfile, palette;
+    vector<string> other_commands;
+    other_commands.push_back("jzintv");
+
     ADD_JZINTV_COMMAND(&commands, "jzintv", false, "", false);
     if (roms_list_struct.list[index].use_tutorvision_gram) {
         ADD_JZINTV_COMMAND(&commands, "-G2", false, "", false);
+        launch_desc.gram_size = 2;
     }
     ADD_JZINTV_COMMAND(&commands, "-p", app_config_struct.use_external_jzintv, app_config_struct.roms_folder_absolute_path, true);
+    rom_path = last_command_argument(&commands, "-p");
     ADD_JZINTV_COMMAND(&commands, "-e", app_config_struct.use_external_jzintv, app_config_struct.roms_folder_absolute_path << execBinFileName, true);
+    exec_path = last_command_argument(&commands, "-e");
     ADD_JZINTV_COMMAND(&commands, "-g", app_config_struct.use_external_jzintv, app_config_struct.roms_folder_absolute_path << gromBinFileName, true);
+    grom_path = last_command_argument(&commands, "-g");
 
     ostringstream resolutionOss;
     resolutionOss << "-z" << app_config_struct.jzintv_resolution_index;
@@ -1017,6 +1025,7 @@ bool start_emulation(int index) {
 
     if (app_config_struct.jzintv_fullscreen) {
         ADD_JZINTV_COMMAND(&commands, "--fullscreen", false, "", false);
+        launch_desc.fullscreen = 1;
     }
 
     if (app_config_struct.use_external_jzintv) {
@@ -1027,6 +1036,7 @@ bool start_emulation(int index) {
 #endif
     } else {
         ADD_JZINTV_COMMAND(&commands, "", false, app_config_struct.roms_folder_absolute_path << roms_list_struct.list[index].file_name, true);
+        game_path = last_command_argument(&commands, "");
     }
 
     bool ecs_tape_auto = roms_list_struct.list[index].ecs_tape_name_auto;
@@ -1068,6 +1078,7 @@ bool start_emulation(int index) {
                         msg << "\nEcs tape file: " << vec[1] << "\n";
                         Log(LOG_INFO) << "Ecs tape command:" << oss_command.str();
                         ADD_JZINTV_COMMAND(&commands, oss_command.str().c_str(), false, "" , false);
+                        ecs_tape = last_command_argument(&commands, "--ecs-tape=");
                     } else {
                         Log(LOG_INFO) << "Skipped custom Ecs tape command:" << cc;
                     }
@@ -1088,11 +1099,13 @@ bool start_emulation(int index) {
                         msg << "\nJlp save file:" << vec[1] << "\n";
                         Log(LOG_INFO) << "Jlp save command:" << oss_command.str();
                         ADD_JZINTV_COMMAND(&commands, oss_command.str().c_str(), false, "" , false);
+                        jlp_savegame = last_command_argument(&commands, "--jlp-savegame=");
                     } else {
                         Log(LOG_INFO) << "Skipped custom Jlp save command:" << cc;
                     }
                 } else {
                     ADD_JZINTV_COMMAND(&commands, cc.c_str(), false, "" , false);
+                    other_commands.push_back(cc);
                 }
             }
         }
@@ -1139,6 +1152,7 @@ bool start_emulation(int index) {
             msg << "\nEcs tape file: " << oss_file.str() << "\n";
             Log(LOG_INFO) << "Automatic Ecs tape command:" << oss_command.str();
             ADD_JZINTV_COMMAND(&commands, oss_command.str().c_str(), false, "" , false);
+            ecs_tape = last_command_argument(&commands, "--ecs-tape=");
         }
         if (jlp_save_file_auto) {
             ostringstream oss_command;
@@ -1153,6 +1167,7 @@ bool start_emulation(int index) {
             msg << "\nJlp save file: " << oss_file.str() << "\n";
             Log(LOG_INFO) << "Automatic Jlp save command:" << oss_command.str();
             ADD_JZINTV_COMMAND(&commands, oss_command.str().c_str(), false, "" , false);
+            jlp_savegame = last_command_argument(&commands, "--jlp-savegame=");
         }
         if (msg.str().length() > 0) {
             string trimmed = msg.str().c_str();
@@ -1170,10 +1185,12 @@ bool start_emulation(int index) {
         }
 
         ADD_JZINTV_COMMAND(&commands, resolutionOss.str().c_str(), false, "" , false);
+        disp_res = last_command_argument(&commands, "-z");
 
         if (app_config_struct.mobile_mode && app_config_struct.mobile_show_controls && !found_mouse_command) {
             app_config_struct.consume_mouse_events_only_for_simulate_controls = true;
             ADD_JZINTV_COMMAND(&commands, JZINTV_MOUSE_COMMAND, false, "", false);
+            launch_desc.enable_mouse = 1;
         }
 
         // Keyboard hack file
@@ -1186,6 +1203,7 @@ bool start_emulation(int index) {
                 return false;
             }
             ADD_JZINTV_COMMAND(&commands, "--kbdhackfile=", false, file_hack, true);
+            kbdhackfile = last_command_argument(&commands, "--kbdhackfile=");
         }
         free(data);
 
@@ -1199,6 +1217,7 @@ bool start_emulation(int index) {
                 return false;
             }
             ADD_JZINTV_COMMAND(&commands, "--gfx-palette=", false, file_palette, true);
+            palette = last_command_argument(&commands, "--gfx-palette=");
         }
         free(data);
     }
@@ -1206,7 +1225,7 @@ bool start_emulation(int index) {
     if (launch) {
         std::cout << "Starting...\n" << std::endl;
         int argc;
-        char **argv = convert_to_argv_argc(&commands, &argc);
+        char **argv = convert_to_argv_argc(app_config_struct.use_external_jzintv ? &commands : &other_commands, &argc);
 
         if (app_config_struct.use_external_jzintv) {
             string external_jzintv_complete_filename = app_config_struct.root_folder_for_configuration;
@@ -1228,8 +1247,25 @@ bool start_emulation(int index) {
             system(external_jzintv_command.c_str());
 
         } else {
-            if (-10 == jzintv_entry_point(argc, argv)) {
+            launch_desc.fn_exec = exec_path.c_str();
+            launch_desc.fn_grom = grom_path.c_str();
+            launch_desc.fn_game = game_path.c_str();
+            launch_desc.rom_path = rom_path.c_str();
+            launch_desc.disp_res = disp_res.c_str();
+            launch_desc.ecs_tape = ecs_tape.empty() ? nullptr : ecs_tape.c_str();
+            launch_desc.jlp_savegame = jlp_savegame.empty() ? nullptr : jlp_savegame.c_str();
+            launch_desc.kbdhackfile = kbdhackfile.empty() ? nullptr : kbdhackfile.c_str();
+            launch_desc.gfx_palette = palette.empty() ? nullptr : palette.c_str();
+            launch_desc.warm = app_config_struct.jzintv_warm_core;
+            launch_desc.argc = argc;
+            launch_desc.argv = argv;
+            launch_desc.request_time = gui_util_str.launch_request_time;
+            bool warm_start = launch_desc.warm && jzintv_is_warm();
+            if (-10 == jzintv_launch(&launch_desc)) {
                 ADD_POPUP("Emulation error", "Emulation error. Check console window for details");
+            } else if (jzintv_launch_ms() > 0) {
+                Log(LOG_INFO) << "Launch latency: " << jzintv_launch_ms() << " ms from request to first frame ("
+                              << (warm_start ? "warm" : "cold") << " core)";
             }
         }
         for (int i = 0; i < argc; i++) {
@@ -1257,12 +1293,11 @@ static int init_gui() {
 static void reset_all_millis() {
     gui_util_str.last_key_released_millis = 0;
     gui_util_str.last_rom_index_millis = 0;
-    gui_util_str.last_roms_checked_millis = 0;
 }
 
 void suspend_gui() {
     clear_general_textures();
-    clear_roms_textures(&roms_list_struct);
+    clear_roms_textures();
     reset_all_millis();
     gui_util_str.roms_list_scrollable.window = nullptr;
     gui_util_str.description_scrollable.window = nullptr;
@@ -1312,14 +1347,7 @@ void free_popup() {
 }
 
 int find_roms_config_index(int index) {
-    uint32_t crc32 = roms_list_struct.list[index].crc32;
-    for (int i = 0; i < app_config_struct.num_valid_crc32s; i++) {
-        uint32_t act_crc32 = roms_configuration[i].crc32;
-        if (crc32 == act_crc32) {
-            return i;
-        }
-    }
-    return -1;
+    return lookup_roms_configuration(roms_list_struct.list[index].crc32);
 }
 
 void update_roms_list() {
@@ -1442,6 +1470,63 @@ void get_gap_pixels(int *l, int *r, int *t, int *b) {
 }
 
 extern long start_millis;
+// Idle rendering: once nothing has moved for IDLE_AFTER_ACTIVITY_MILLIS, frames are only drawn when input
+// arrives, or idle_max_fps times per second to pick up background changes. 0 always renders.
+#define IDLE_AFTER_ACTIVITY_MILLIS 500
+#define IDLE_STATS_MILLIS 60000
+
+static long last_activity_millis = 0;
+static long idle_stats_millis = 0;
+static int idle_stats_frames = 0;
+static int idle_stats_busy_frames = 0;
+
+static bool is_scrollable_moving(ImguiScrollable *scrollable) {
+    return scrollable->is_dragging || scrollable->is_auto_scrolling;
+}
+
+static bool is_gui_animating() {
+    return loading_millis != -1 ||
+           !gui_events.empty() ||
+           images_loading() ||
+           ImGui::GetIO().WantTextInput ||
+           is_scrollable_moving(&gui_util_str.roms_list_scrollable) ||
+           is_scrollable_moving(&gui_util_str.description_scrollable) ||
+           is_scrollable_moving(&gui_util_str.options_scrollable) ||
+           is_scrollable_moving(&gui_util_str.options_sub_scrollable);
+}
+
+// Blocks until the next frame is due
+static void wait_for_next_frame() {
+    long millis = get_act_millis();
+    if (idle_stats_millis == 0) {
+        idle_stats_millis = millis;
+    }
+    if (millis - idle_stats_millis >= IDLE_STATS_MILLIS) {
+        if (idle_stats_frames > 0) {
+            Log(LOG_INFO) << "Idle rendering: " << idle_stats_frames << " idle frames, " << idle_stats_busy_frames
+                          << " busy frames in the last " << (millis - idle_stats_millis) / 1000 << " s";
+        }
+        idle_stats_millis = millis;
+        idle_stats_frames = 0;
+        idle_stats_busy_frames = 0;
+    }
+
+    if (app_config_struct.idle_max_fps == 0 || is_gui_animating()) {
+        last_activity_millis = millis;
+    }
+    if (millis - last_activity_millis < IDLE_AFTER_ACTIVITY_MILLIS) {
+        idle_stats_busy_frames++;
+        return;
+    }
+
+    if (wait_for_event(1000 / app_config_struct.idle_max_fps)) {
+        last_activity_millis = get_act_millis();
+        idle_stats_busy_frames++;
+    } else {
+        idle_stats_frames++;
+    }
+}
+
 static int start_gui() {
     if (-1 == init_gui()) {
         return -1;
@@ -1453,9 +1538,11 @@ static int start_gui() {
     memset(&roms_list_struct, 0, sizeof(roms_list_struct_t));
 
     // Main loop
+    last_activity_millis = get_act_millis();
     while (true) {
         bool refresh_for_text = false;
         bool exit;
+        wait_for_next_frame();
         check_for_special_event(&exit, &app_config_struct);
         if (exit) {
             save_config_file();
@@ -1605,6 +1692,7 @@ void free_all() {
         free(app_config_struct.external_sd_path);
     }
 
+    rom_index_unwatch();
     free_message(INFOS_INDEX);
     free_message(WARNINGS_INDEX);
     free_message(ERRORS_INDEX);
@@ -1625,6 +1713,7 @@ void free_all() {
     }
 
     clear_general_textures();
+    stop_images_loader();
     clear_all_default_game_controls();
 //    check_textures_freed();
     clear_events();
@@ -17,6 +17,7 @@
 #include <fstream>
 #include <dirent.h>
 #include <set>
+#include <unordered_map>
 #include "imgui_scrollable.h"
 #include "popup.h"
 #include "utils/gui_events.h"
@@ -24,6 +25,7 @@
 #include "utils/messages.h"
 #include "utils/ini.h"
 #include "utils/exceptions.h"
+#include "utils/rom_index.h"
 #include "SDL.h"
 #include "logger.h"
 
@@ -124,6 +126,7 @@ struct app_config_struct_t {
     uint64_t mobile_default_landscape_controls_size;
     uint64_t mobile_ecs_portrait_alpha;
     uint64_t mobile_ecs_landscape_alpha;
+    uint64_t idle_max_fps;
     bool hide_unavailable_roms;
     bool window_maximized;
     bool jzintv_fullscreen;
@@ -131,8 +134,7 @@ struct app_config_struct_t {
     bool mobile_show_configuration_controls;
     bool mobile_use_inverted_controls;
     bool use_external_jzintv;
-    // To align memory pointer for saving ini (really sad)
-    bool dummy2;
+    bool jzintv_warm_core;
     double roms_list_width_percentage;
     double image_height_percentage;
     double mobile_portrait_top_gap_percentage;
@@ -195,12 +197,6 @@ struct rom_config_struct_t {
     bool double_row;
     int available_status;
     char *file_name;
-    int original_texture_screenshot_width;
-    int original_texture_screenshot_height;
-    int original_texture_box_width;
-    int original_texture_box_height;
-    uint32_t texture_screenshot;
-    uint32_t texture_box;
     vector<Control *> controls[2];
 };
 
@@ -302,13 +298,12 @@ struct gui_util_struct_t {
     int act_tab_index = 0;
     bool configuration_change_tab_index = false;
     int configuration_act_tab_index = 0;
-    int last_rom_index_checked;
     ImVec2 title_bar_size;
 
     // Millis
     long last_rom_index_millis = 0; // For double click management in mobile mode
     long last_key_released_millis = 0; // Avoid multiple key released
-    long last_roms_checked_millis = 0; // Used to load image in mobile mode landscape
+    double launch_request_time = 0; // jzIntv's get_time() when the game was chosen, for the launch latency
     bool show_config_window;
 
     backup_config_struct_t backup;
@@ -355,8 +350,11 @@ extern "C" {
 #include "jzintv/event/event_plat.h"
 extern int force_sound_atten;
 extern unsigned int file_crc32(char *fname);
+extern unsigned int crc32_block(unsigned int crc, const unsigned char *data, int len);
 extern int jzintv_entry_point(int argc, char *argv[]);
 extern void event_enqueue_custom(int press_status, const char *ev_name);
+extern double get_time(void);
+#include "jzintv/launch.h"
 }
 
 // Main
@@ -403,6 +401,7 @@ extern void get_window_size(int *w, int *h);
 extern void render();
 extern void clean(int mode);
 extern void check_for_special_event(bool *exit, app_config_struct_t *config);
+extern bool wait_for_event(int timeout_millis);
 extern bool is_ok_permission();
 extern long get_act_millis();
 extern bool get_mobile_mode();
@@ -477,18 +476,16 @@ extern std::string get_formatted_path(const char* path, bool keep_final_slash =
 // Images
 extern void load_images(struct app_config_struct_t *app_conf);
 extern void clear_general_textures();
-extern void clear_roms_textures(struct roms_list_struct_t *roms_list_struct);
+extern void clear_roms_textures();
+extern void stop_images_loader();
 extern void draw_background(ImVec2 vec);
 extern void draw_loading(ImVec2 vec);
+extern bool images_loading();
 extern void manage_image_window(ImVec2 size,
                                 struct roms_list_struct_t *roms_list_struct,
                                 struct app_config_struct_t *app_config_struct,
                                 int tab_selected,
-                                int rom_index_selected,
-                                uint32_t last_landscape_scrollbar_pos,
-                                ImguiScrollable *roms_list_scrollable,
-                                long *last_millis_checked,
-                                int *last_rom_index_checked);
+                                int rom_index_selected);
 
 // Gui events
 extern std::vector<GuiEvent *> gui_events;
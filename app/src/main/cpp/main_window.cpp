@@ -933,12 +933,7 @@ static void draw_right_up_child() {
                             &roms_list_struct,
                             &app_config_struct,
                             tab_selected,
-                            gui_util_str.rom_index_selected,
-                            gui_util_str.roms_list_scrollable.window->Scroll.y,
-                            &(gui_util_str.roms_list_scrollable),
-                            &(gui_util_str.last_roms_checked_millis),
-                            &(gui_util_str.last_rom_index_checked)
-        );
+                            gui_util_str.rom_index_selected);
     }
     ImGui::End();
     ImGui::EndChild();
@@ -1134,6 +1129,7 @@ static bool manage_next_gui_event() {
                 }
                 break;
             case PREPARE_FOR_LAUNCH_GAME_EVENT:
+                gui_util_str.launch_request_time = get_time();
                 app_config_struct.starting_game = true;
                 get_center_rom_index(&gui_util_str.par_int, &gui_util_str.par_float);
                 submit_gui_event(START_GAME_EVENT, par_int, par_float);
@@ -1157,6 +1153,10 @@ static bool need_center_rom_index() {
 }
 
 void check_for_update_list() {
+    // Roms folder changed on disk
+    if (rom_index_changed() && !gui_util_str.reload_roms_on_refresh) {
+        request_for_scroll(RELOAD_ROMS_AND_RECOMPILE_MODE);
+    }
     if (!list_is_dirty()) {
         bool sent_request = manage_window_size_changes();
         if (!app_config_struct.mobile_mode || !gui_util_str.portrait) {
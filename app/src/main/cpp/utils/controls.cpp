@@ -24,7 +24,6 @@ Uint32 saved_start_ticks;
 int act_configuration_control_index;
 int first_valid_configuration_control_index;
 int last_control_index;
-bool last_screen_is_portrait;
 static vector<string> controls_keys;
 static vector<string> device_default_keys;
 
@@ -43,38 +42,32 @@ static void update_configuration_mode_controls() {
                 brightness_less_control->alpha_portrait = CONTROLS_ALPHA_DISABLED;
                 brightness_less_control->alpha_landscape = CONTROLS_ALPHA_DISABLED;
                 brightness_less_control->is_pressable = false;
-                brightness_less_control->update_textures_alpha();
             }
             if (brightness_more_control != nullptr) {
                 brightness_more_control->alpha_portrait = CONTROLS_ALPHA_DISABLED;
                 brightness_more_control->alpha_landscape = CONTROLS_ALPHA_DISABLED;
                 brightness_more_control->is_pressable = false;
-                brightness_more_control->update_textures_alpha();
             }
             if (eye_control != nullptr) {
                 eye_control->alpha_portrait = CONTROLS_ALPHA_DISABLED;
                 eye_control->alpha_landscape = CONTROLS_ALPHA_DISABLED;
                 eye_control->is_pressable = false;
-                eye_control->update_textures_alpha();
             }
         } else {
             if (brightness_less_control != nullptr) {
                 brightness_less_control->alpha_portrait = CONTROLS_ALPHA_ENABLED;
                 brightness_less_control->alpha_landscape = CONTROLS_ALPHA_ENABLED;
                 brightness_less_control->is_pressable = true;
-                brightness_less_control->update_textures_alpha();
             }
             if (brightness_more_control != nullptr) {
                 brightness_more_control->alpha_portrait = CONTROLS_ALPHA_ENABLED;
                 brightness_more_control->alpha_landscape = CONTROLS_ALPHA_ENABLED;
                 brightness_more_control->is_pressable = true;
-                brightness_more_control->update_textures_alpha();
             }
             if (eye_control != nullptr) {
                 eye_control->alpha_portrait = CONTROLS_ALPHA_ENABLED;
                 eye_control->alpha_landscape = CONTROLS_ALPHA_ENABLED;
                 eye_control->is_pressable = true;
-                eye_control->update_textures_alpha();
             }
         }
 
@@ -255,7 +248,6 @@ static bool manage_configuration_mode_change(bool next_mode_is_configuration_mod
                     Control *c = effective_game_controls[hand_index][i];
                     c->is_pressable = true;
                     c->was_pressable = true;
-                    c->update_textures_alpha();
                 }
             }
             Control *switch_mode_control = get_control_by_event(CONFIGURATION_SWITCH_MODE, &configuration_controls);
@@ -382,7 +374,80 @@ static int get_direction_position(const char *key) {
     return -1;
 }
 
+// Touch points are resolved through a uniform grid over the screen (in percent): each cell lists the controls
+// whose rectangle overlaps it, configuration controls first, in the order they are hit-tested. Only the layout
+// is indexed, visibility and pressability are still checked per event. Rebuilt when the layout changes.
+#define CONTROLS_GRID_SIZE 16
+
+struct grid_control_t {
+    Control *control;
+    bool is_configuration;
+};
+
+static vector<grid_control_t> controls_grid[CONTROLS_GRID_SIZE * CONTROLS_GRID_SIZE];
+static bool controls_grid_dirty = true;
+static bool controls_grid_portrait;
+static int controls_grid_hand_index;
+static size_t controls_grid_num_controls[2];
+
+static void controls_layout_changed() {
+    controls_grid_dirty = true;
+}
+
+static int get_controls_grid_cell(float perc) {
+    int res = (int) (perc * CONTROLS_GRID_SIZE / 100);
+    if (res < 0) {
+        res = 0;
+    } else if (res >= CONTROLS_GRID_SIZE) {
+        res = CONTROLS_GRID_SIZE - 1;
+    }
+    return res;
+}
+
+static void add_to_controls_grid(vector<Control *> *container, bool is_configuration) {
+    grid_control_t entry;
+    entry.is_configuration = is_configuration;
+    for (int i = 0; i < container->size(); i++) {
+        entry.control = (*container)[i];
+        if (entry.control == nullptr) {
+            continue;
+        }
+        SDL_FRect *frect = entry.control->get_control_frect();
+        if (frect->w < 0 || frect->h < 0) {
+            continue;
+        }
+        int last_x = get_controls_grid_cell(frect->x + frect->w);
+        int last_y = get_controls_grid_cell(frect->y + frect->h);
+        for (int y = get_controls_grid_cell(frect->y); y <= last_y; y++) {
+            for (int x = get_controls_grid_cell(frect->x); x <= last_x; x++) {
+                controls_grid[y * CONTROLS_GRID_SIZE + x].push_back(entry);
+            }
+        }
+    }
+}
+
+static void check_controls_grid() {
+    int hand_index = app_config_struct.mobile_use_inverted_controls ? 1 : 0;
+    // Orientation, hand and container changes are caught here as well, whoever made them
+    if (controls_grid_dirty || controls_grid_portrait != screen_is_portrait ||
+        controls_grid_hand_index != hand_index ||
+        controls_grid_num_controls[0] != configuration_controls.size() ||
+        controls_grid_num_controls[1] != effective_game_controls[hand_index].size()) {
+        for (int i = 0; i < CONTROLS_GRID_SIZE * CONTROLS_GRID_SIZE; i++) {
+            controls_grid[i].clear();
+        }
+        add_to_controls_grid(&configuration_controls, true);
+        add_to_controls_grid(&effective_game_controls[hand_index], false);
+        controls_grid_portrait = screen_is_portrait;
+        controls_grid_hand_index = hand_index;
+        controls_grid_num_controls[0] = configuration_controls.size();
+        controls_grid_num_controls[1] = effective_game_controls[hand_index].size();
+        controls_grid_dirty = false;
+    }
+}
+
 void refresh_rect_on_screen_size_change() {
+    controls_layout_changed();
     SDL_FRect *frect = *get_act_jzintv_rendering_frect_ref(screen_is_portrait);
     if (frect != nullptr) {
         SDL_Rect *rect_ref = *get_act_jzintv_rendering_rect_ref(screen_is_portrait);
@@ -465,6 +530,8 @@ static void change_size_and_position_callback(void *val) {
     if (act_configuration_control_index == -3) {
         SDL_Rect *rect_ref = *get_act_jzintv_rendering_rect_ref(screen_is_portrait);
         *rect_ref = transform_to_sdl_rect(frect);
+    } else {
+        controls_layout_changed();
     }
 }
 
@@ -485,10 +552,6 @@ static void change_visibility_callback(void *val) {
     all_controls_hierarchy.clear();
 }
 
-void deallocate_control_texture(SDL_Texture *ptr) {
-    SDL_DestroyTexture(ptr);
-}
-
 static void copy_control(Control *source, Control *destination);
 
 static void reset_to_default_callback(void *val) {
@@ -500,15 +563,8 @@ static void reset_to_default_callback(void *val) {
         for (it = all_controls_hierarchy.begin(); it != all_controls_hierarchy.end(); it++) {
             Control *c = *it;
             int old_position = c->jzintv_event_index;
-            if (c->tx_released != nullptr) {
-                deallocate_control_texture(c->tx_released);
-            }
-            c->tx_released = nullptr;
-
-            if (c->tx_pressed != nullptr) {
-                deallocate_control_texture(c->tx_pressed);
-            }
-            c->tx_pressed = nullptr;
+            // The file names may change: look the images up again
+            c->atlas_generation = 0;
 
             int hand_index = app_config_struct.mobile_use_inverted_controls ? 1 : 0;
             Control *delta_ref = get_control_by_event(c->original_event, &(delta_default_controls[hand_index]));
@@ -517,9 +573,9 @@ static void reset_to_default_callback(void *val) {
             if (c->jzintv_event_index == -1) {
                 c->jzintv_event_index = old_position;
             }
-            c->update_textures_alpha();
         }
         all_controls_hierarchy.clear();
+        controls_layout_changed();
     } else {
         // Screen
         init_jzintv_rendering_rect(false);
@@ -551,7 +607,6 @@ static void change_brightness_callback(void *val) {
         } else if (*ptr < 0) {
             *ptr = 0;
         }
-        c->update_textures_alpha();
     }
     all_controls_hierarchy.clear();
 }
@@ -805,9 +860,10 @@ Control::Control() {
     is_visible = 1;
     is_drawn = false;
     file_name_released = "";
-    tx_released = nullptr;
+    img_released = -1;
     file_name_pressed = "";
-    tx_pressed = nullptr;
+    img_pressed = -1;
+    atlas_generation = 0;
     alpha_portrait = DEFAULT_ALPHA_CONFIG;
     alpha_landscape = DEFAULT_ALPHA_CONFIG;
     is_pressable = true;
@@ -826,31 +882,14 @@ Control::Control() {
 Control::~Control() {
     file_name_pressed = "";
     file_name_released = "";
-    if (tx_released != nullptr) {
-        // Already deallocated by LIBSDL?
-//        deallocate_control_texture(tx_released);
-    }
-    tx_released = nullptr;
-
-    if (tx_pressed != nullptr) {
-        // Already deallocated by LIBSDL?
-//        deallocate_control_texture(tx_pressed);
-    }
-    tx_pressed = nullptr;
+    // Images belong to the controls atlas
+    img_released = -1;
+    img_pressed = -1;
     original_event = "";
     override_event = "";
     children.clear();
 }
 
-void Control::update_textures_alpha() {
-    if (tx_released != nullptr && tx_released != (SDL_Texture *) -1) {
-        SDL_SetTextureAlphaMod(tx_released, screen_is_portrait ? alpha_portrait : alpha_landscape);
-    }
-    if (tx_pressed != nullptr && tx_pressed != (SDL_Texture *) -1) {
-        SDL_SetTextureAlphaMod(tx_pressed, screen_is_portrait ? alpha_portrait : alpha_landscape);
-    }
-}
-
 SDL_FRect *Control::get_control_frect() {
     return screen_is_portrait ? &portrait_frect : &landscape_frect;
 }
@@ -1570,33 +1609,318 @@ bool Control::normalize_from_delta(Control *parent_control) {
     return res;
 }
 
-static SDL_Texture *IMG_LoadTexture_custom(SDL_Renderer *renderer, const char *file) {
-    SDL_Texture *texture = nullptr;
-    SDL_Surface *surface = IMG_Load(file);
-    if (surface) {
+// Control images are packed into atlas pages as they are first needed, so the whole overlay is drawn from one
+// texture (two at most, in practice) in a single batch, instead of one texture per control and state.
+// Alpha is a vertex colour, so it needs no per-texture state. Pages are filled shelf by shelf, tallest first.
+#define CONTROLS_ATLAS_PAGE_SIZE 2048
+#define CONTROLS_ATLAS_PADDING 1
+
+struct control_image_t {
+    int page; // -1 if the file is missing or can't be loaded
+    SDL_Rect rect;
+};
+
+struct controls_atlas_page_t {
+    SDL_Texture *texture;
+    int size;
+    int shelf_x;
+    int shelf_y;
+    int shelf_h;
+};
+
+static SDL_Renderer *atlas_renderer = nullptr;
+static vector<controls_atlas_page_t> atlas_pages;
+static vector<control_image_t> atlas_images;
+static map<string, int> atlas_images_by_file;
+static int atlas_generation = 1;
+
+static int batch_page = -1;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+static vector<SDL_Vertex> batch_vertices;
+static vector<int> batch_indices;
+#else
+// No geometry API: copies are queued and drawn grouped by alpha, so the alpha mod is set once per group
+struct control_copy_t {
+    SDL_Rect src;
+    SDL_FRect dest;
+    Uint8 alpha;
+};
+
+static vector<control_copy_t> batch_copies;
+#endif
+
+static void release_controls_atlas() {
+    for (int i = 0; i < atlas_pages.size(); i++) {
+        SDL_DestroyTexture(atlas_pages[i].texture);
+    }
+    atlas_pages.clear();
+    atlas_images.clear();
+    atlas_images_by_file.clear();
+    atlas_renderer = nullptr;
+    batch_page = -1;
+    // Controls holding indices into the old atlas look their images up again
+    atlas_generation++;
+}
+
+// Called before 'renderer' is destroyed, as the atlas pages go with it
+extern "C" void release_onscreen_controls(SDL_Renderer *renderer) {
+    if (renderer != nullptr && renderer == atlas_renderer) {
+        release_controls_atlas();
+    }
+}
+
+static int get_atlas_page_size(SDL_Renderer *renderer) {
+    SDL_RendererInfo info;
+    int res = CONTROLS_ATLAS_PAGE_SIZE;
+    if (SDL_GetRendererInfo(renderer, &info) == 0) {
+        if (info.max_texture_width > 0 && info.max_texture_width < res) {
+            res = info.max_texture_width;
+        }
+        if (info.max_texture_height > 0 && info.max_texture_height < res) {
+            res = info.max_texture_height;
+        }
+    }
+    return res;
+}
+
+static bool reserve_atlas_rect(SDL_Renderer *renderer, int w, int h, int *page_index, SDL_Rect *rect) {
+    controls_atlas_page_t *page = atlas_pages.empty() ? nullptr : &atlas_pages.back();
+    if (page != nullptr && page->shelf_x + w > page->size) {
+        // New shelf, below the tallest image of this one
+        page->shelf_y += page->shelf_h;
+        page->shelf_x = 0;
+        page->shelf_h = 0;
+    }
+    if (page == nullptr || page->shelf_y + h > page->size) {
+        controls_atlas_page_t new_page;
+        new_page.size = get_atlas_page_size(renderer);
+        if (w > new_page.size || h > new_page.size) {
+            return false;
+        }
+        new_page.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC,
+                                             new_page.size, new_page.size);
+        if (new_page.texture == nullptr) {
+            return false;
+        }
+        SDL_SetTextureBlendMode(new_page.texture, SDL_BLENDMODE_BLEND);
+        new_page.shelf_x = 0;
+        new_page.shelf_y = 0;
+        new_page.shelf_h = 0;
+        atlas_pages.push_back(new_page);
+        page = &atlas_pages.back();
+    }
+    rect->x = page->shelf_x;
+    rect->y = page->shelf_y;
+    rect->w = w;
+    rect->h = h;
+    page->shelf_x += w;
+    page->shelf_h = std::max(page->shelf_h, h);
+    *page_index = atlas_pages.size() - 1;
+    return true;
+}
+
+// Copies 'surface' into the atlas, with a transparent border so that filtering doesn't bleed between images.
+// Pure white is transparent, as the control images have always been loaded with it as colour key.
+static bool add_surface_to_atlas(SDL_Renderer *renderer, SDL_Surface *surface, control_image_t *image) {
+    bool res = false;
+    int page_size = get_atlas_page_size(renderer) - 2 * CONTROLS_ATLAS_PADDING;
+    int max_side = std::max(surface->w, surface->h);
+    SDL_Rect dest_rect;
+    dest_rect.x = CONTROLS_ATLAS_PADDING;
+    dest_rect.y = CONTROLS_ATLAS_PADDING;
+    dest_rect.w = surface->w;
+    dest_rect.h = surface->h;
+    if (max_side > page_size) {
+        // Only if the renderer's textures are smaller than the image
+        dest_rect.w = std::max(1, surface->w * page_size / max_side);
+        dest_rect.h = std::max(1, surface->h * page_size / max_side);
+    }
+    SDL_Surface *padded = SDL_CreateRGBSurfaceWithFormat(0, dest_rect.w + 2 * CONTROLS_ATLAS_PADDING,
+                                                         dest_rect.h + 2 * CONTROLS_ATLAS_PADDING, 32,
+                                                         SDL_PIXELFORMAT_ARGB8888);
+    if (padded != nullptr) {
         SDL_SetColorKey(surface, SDL_TRUE, SDL_MapRGB(surface->format, 0xFF, 0xFF, 0xFF));
-        texture = SDL_CreateTextureFromSurface(renderer, surface);
-        SDL_FreeSurface(surface);
+        SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+        SDL_Rect slot;
+        if (SDL_BlitScaled(surface, nullptr, padded, &dest_rect) == 0 &&
+            reserve_atlas_rect(renderer, padded->w, padded->h, &image->page, &slot) &&
+            SDL_UpdateTexture(atlas_pages[image->page].texture, &slot, padded->pixels, padded->pitch) == 0) {
+            image->rect.x = slot.x + CONTROLS_ATLAS_PADDING;
+            image->rect.y = slot.y + CONTROLS_ATLAS_PADDING;
+            image->rect.w = dest_rect.w;
+            image->rect.h = dest_rect.h;
+            res = true;
+        }
+        SDL_FreeSurface(padded);
+    }
+    if (!res) {
+        image->page = -1;
     }
-    return texture;
+    return res;
 }
 
-static SDL_Texture *get_texture(const char *file, SDL_Renderer *renderer, int alpha) {
-    char buf[FILENAME_MAX];
-    SDL_Texture *res = nullptr;
-    sprintf(buf, "%s%s/%s", app_config_struct.resource_folder_absolute_path, "Images/Controls", file);
-    if (!exist_file(buf)) {
-        ADD_POPUP("File not found", "File not found:'" << file << "'");
-    } else {
-        res = IMG_LoadTexture_custom(renderer, buf);
-        if (res == nullptr) {
-            ADD_POPUP("File not loaded", "Unable to load file:'" << file << "'\nError:" << SDL_GetError());
+static bool compare_surfaces_by_height(const pair<string, SDL_Surface *> &a, const pair<string, SDL_Surface *> &b) {
+    return a.second->h > b.second->h;
+}
+
+// Loads the images of 'files' not in the atlas yet, and packs them tallest first
+static void load_control_images(SDL_Renderer *renderer, const vector<string> &files) {
+    if (renderer != atlas_renderer) {
+        release_controls_atlas();
+        atlas_renderer = renderer;
+    }
+
+    vector<pair<string, SDL_Surface *>> surfaces;
+    for (int i = 0; i < files.size(); i++) {
+        const char *file = files[i].c_str();
+        if (atlas_images_by_file.count(files[i]) > 0) {
+            continue;
+        }
+        control_image_t image;
+        memset(&image, 0, sizeof(image));
+        image.page = -1;
+        atlas_images_by_file[files[i]] = atlas_images.size();
+        atlas_images.push_back(image);
+
+        char buf[FILENAME_MAX];
+        sprintf(buf, "%s%s/%s", app_config_struct.resource_folder_absolute_path, "Images/Controls", file);
+        if (!exist_file(buf)) {
+            ADD_POPUP("File not found", "File not found:'" << file << "'");
         } else {
-            SDL_SetTextureBlendMode(res, SDL_BLENDMODE_BLEND);
-            SDL_SetTextureAlphaMod(res, alpha);
+            SDL_Surface *surface = IMG_Load(buf);
+            if (surface == nullptr) {
+                ADD_POPUP("File not loaded", "Unable to load file:'" << file << "'\nError:" << SDL_GetError());
+            } else {
+                surfaces.emplace_back(files[i], surface);
+            }
         }
     }
-    return res;
+
+    std::stable_sort(surfaces.begin(), surfaces.end(), compare_surfaces_by_height);
+    for (int i = 0; i < surfaces.size(); i++) {
+        control_image_t *image = &atlas_images[atlas_images_by_file[surfaces[i].first]];
+        if (!add_surface_to_atlas(renderer, surfaces[i].second, image)) {
+            ADD_POPUP("File not loaded", "Unable to load file:'" << surfaces[i].first << "'\nError:" << SDL_GetError());
+        }
+        SDL_FreeSurface(surfaces[i].second);
+    }
+}
+
+static int get_control_image(const string &file) {
+    map<string, int>::iterator it = atlas_images_by_file.find(file);
+    if (it == atlas_images_by_file.end() || atlas_images[it->second].page < 0) {
+        return -1;
+    }
+    return it->second;
+}
+
+static bool needs_control_images(Control *c, bool atlas_changed) {
+    return c != nullptr && (atlas_changed || c->atlas_generation != atlas_generation) && c->is_visible == 1 &&
+           is_compatible_with_act_configuration(c);
+}
+
+// Points the drawable controls of 'container' to their images, loading the missing ones in a single pass
+static void load_controls_images(vector<Control *> *container, SDL_Renderer *renderer) {
+    vector<string> files;
+    bool atlas_changed = renderer != atlas_renderer;
+    for (int i = 0; i < container->size(); i++) {
+        Control *c = (*container)[i];
+        if (needs_control_images(c, atlas_changed)) {
+            if (!c->file_name_released.empty()) {
+                files.push_back(c->file_name_released);
+            }
+            if (!c->file_name_pressed.empty()) {
+                files.push_back(c->file_name_pressed);
+            }
+        }
+    }
+    if (!files.empty() || atlas_changed) {
+        load_control_images(renderer, files);
+    }
+    for (int i = 0; i < container->size(); i++) {
+        Control *c = (*container)[i];
+        if (needs_control_images(c, false)) {
+            c->img_released = get_control_image(c->file_name_released);
+            c->img_pressed = get_control_image(c->file_name_pressed);
+            c->atlas_generation = atlas_generation;
+        }
+    }
+}
+
+#if !SDL_VERSION_ATLEAST(2, 0, 18)
+static bool compare_copies_by_alpha(const control_copy_t &a, const control_copy_t &b) {
+    return a.alpha < b.alpha;
+}
+
+// Sorting by alpha only keeps the drawing order of copies that don't overlap
+static bool overlaps_copy_of_other_alpha(const SDL_FRect *dest, Uint8 alpha) {
+    for (int i = 0; i < batch_copies.size(); i++) {
+        const SDL_FRect *r = &batch_copies[i].dest;
+        if (batch_copies[i].alpha != alpha && dest->x < r->x + r->w && r->x < dest->x + dest->w &&
+            dest->y < r->y + r->h && r->y < dest->y + dest->h) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+static void flush_controls_batch(SDL_Renderer *renderer) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (batch_page >= 0 && !batch_vertices.empty()) {
+        SDL_RenderGeometry(renderer, atlas_pages[batch_page].texture, batch_vertices.data(), batch_vertices.size(),
+                           batch_indices.data(), batch_indices.size());
+    }
+    batch_vertices.clear();
+    batch_indices.clear();
+#else
+    if (batch_page >= 0 && !batch_copies.empty()) {
+        SDL_Texture *texture = atlas_pages[batch_page].texture;
+        std::stable_sort(batch_copies.begin(), batch_copies.end(), compare_copies_by_alpha);
+        for (int i = 0; i < batch_copies.size(); i++) {
+            if (i == 0 || batch_copies[i].alpha != batch_copies[i - 1].alpha) {
+                SDL_SetTextureAlphaMod(texture, batch_copies[i].alpha);
+            }
+            SDL_RenderCopyF(renderer, texture, &batch_copies[i].src, &batch_copies[i].dest);
+        }
+    }
+    batch_copies.clear();
+#endif
+    batch_page = -1;
+}
+
+static void add_to_controls_batch(SDL_Renderer *renderer, const control_image_t *image, const SDL_FRect *dest,
+                                  Uint8 alpha) {
+    bool flush = image->page != batch_page;
+#if !SDL_VERSION_ATLEAST(2, 0, 18)
+    flush = flush || overlaps_copy_of_other_alpha(dest, alpha);
+#endif
+    if (flush) {
+        // Keep the drawing order: controls can overlap
+        flush_controls_batch(renderer);
+        batch_page = image->page;
+    }
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    float size = atlas_pages[image->page].size;
+    float u0 = image->rect.x / size;
+    float v0 = image->rect.y / size;
+    float u1 = (image->rect.x + image->rect.w) / size;
+    float v1 = (image->rect.y + image->rect.h) / size;
+    SDL_Color color = {255, 255, 255, alpha};
+    int base = batch_vertices.size();
+    SDL_Vertex vertices[4] = {
+            {{dest->x,           dest->y},           color, {u0, v0}},
+            {{dest->x + dest->w, dest->y},           color, {u1, v0}},
+            {{dest->x + dest->w, dest->y + dest->h}, color, {u1, v1}},
+            {{dest->x,           dest->y + dest->h}, color, {u0, v1}}
+    };
+    batch_vertices.insert(batch_vertices.end(), vertices, vertices + 4);
+    int indices[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+    batch_indices.insert(batch_indices.end(), indices, indices + 6);
+#else
+    control_copy_t copy = {image->rect, *dest, alpha};
+    batch_copies.push_back(copy);
+#endif
 }
 
 Control *add_new_control(string event, vector<Control *> *container, bool set_position_and_size = true) {
@@ -2240,6 +2564,7 @@ void sort_effective_game_controls(vector<Control *> *vec) {
 }
 
 static void populate_effective_game_controls(vector<Control *> container[2]) {
+    controls_layout_changed();
     duplicate_controls(&container[0], &effective_game_controls[LEFT_HAND_INDEX]);
     sort_effective_game_controls(&effective_game_controls[LEFT_HAND_INDEX]);
     duplicate_controls(&container[1], &effective_game_controls[RIGHT_HAND_INDEX]);
@@ -2342,6 +2667,7 @@ void manage_on_release_controls_queue() {
 };
 
 static void populate_configuration_controls() {
+    controls_layout_changed();
     if (configuration_controls.size() > 0) {
         configuration_controls.clear();
     }
@@ -2587,6 +2913,8 @@ void clear_controls(vector<Control *> container[2]) {
             c = nullptr;
         }
         container->clear();
+        // The hit-test grid may point to them
+        controls_layout_changed();
     }
 }
 
@@ -2731,21 +3059,17 @@ void clear_all_default_game_controls() {
 Control *get_control_by_touch_point(float x_perc, float y_perc, SDL_FRect *real_pos) {
     float x = x_perc * (float) 100;
     float y = y_perc * (float) 100;
-    for (int i = 0; i < configuration_controls.size(); i++) {
-        Control *c = configuration_controls[i];
-        if (c != nullptr && c->is_visible == 1 && is_compatible_with_act_configuration(c) && c->is_drawn && (c->is_pressable || c->is_pressed) && c->is_in_control(x, y, real_pos)) {
-            // To avoid repeated click
-            if (manage_pause && !c->get_effective_event().compare(CONFIGURATION_SWITCH_MODE)) {
-                return nullptr;
-            }
-            return c;
-        }
-    }
-    for (int i = 0; i < effective_game_controls[app_config_struct.mobile_use_inverted_controls ? 1 : 0].size(); i++) {
-        Control *c = effective_game_controls[app_config_struct.mobile_use_inverted_controls ? 1 : 0][i];
-        if (c != nullptr && c->is_visible == 1 && is_compatible_with_act_configuration(c) && c->is_drawn && (c->is_pressable || c->is_pressed) && c->is_in_control(x, y, real_pos)) {
+    check_controls_grid();
+    vector<grid_control_t> *cell = &controls_grid[get_controls_grid_cell(y) * CONTROLS_GRID_SIZE + get_controls_grid_cell(x)];
+    for (int i = 0; i < cell->size(); i++) {
+        Control *c = (*cell)[i].control;
+        if (c->is_visible == 1 && is_compatible_with_act_configuration(c) && c->is_drawn && (c->is_pressable || c->is_pressed) && c->is_in_control(x, y, real_pos)) {
             // To avoid repeated click
-            if (manage_pause && !c->is_pressed && !c->get_effective_event().compare(PAUSE)) {
+            if ((*cell)[i].is_configuration) {
+                if (manage_pause && !c->get_effective_event().compare(CONFIGURATION_SWITCH_MODE)) {
+                    return nullptr;
+                }
+            } else if (manage_pause && !c->is_pressed && !c->get_effective_event().compare(PAUSE)) {
                 return nullptr;
             }
             return c;
@@ -3048,11 +3372,6 @@ void init_controls() {
     init_files_default_map();
 }
 
-SDL_Texture *allocate_control_texture(const char *name, SDL_Renderer *renderer, int64_t ptr) {
-    SDL_Texture *tx = get_texture(name, renderer, ptr);
-    return tx;
-}
-
 bool manage_override_control_for_game(char *key, char *value, struct rom_config_struct_t *act_rom_config) {
     // Esempio: "control_alpha_landscape_PD0L_KP1__L"
     // ref_control_property: control_alpha_landscape
@@ -3187,31 +3506,18 @@ bool is_compatible_with_act_configuration(Control *c) {
 
 void draw_control(Control *c, SDL_Renderer *renderer) {
     if (c != nullptr && (c->is_visible == 1 && is_compatible_with_act_configuration(c))) {
-        SDL_FRect *frect = c->get_control_frect();
-        SDL_Rect pixels_rect = transform_to_sdl_rect(frect);
-        int64_t *ptr = screen_is_portrait ? &c->alpha_portrait : &c->alpha_landscape;
-        if (c->tx_released == nullptr && !c->file_name_released.empty()) {
-            c->tx_released = allocate_control_texture(c->file_name_released.c_str(), renderer, *ptr);
-            if (c->tx_released == nullptr) {
-                c->tx_released = (SDL_Texture *) -1;
-            }
-        }
-        if (c->tx_pressed == nullptr && !c->file_name_pressed.empty() && c->tx_released != nullptr &&
-            c->tx_released != (SDL_Texture *) -1) {
-            c->tx_pressed = allocate_control_texture(c->file_name_pressed.c_str(), renderer, *ptr);
-            if (c->tx_pressed == nullptr) {
-                c->tx_pressed = (SDL_Texture *) -1;
-            }
-        }
-        if (c->tx_released == nullptr || c->tx_released == (SDL_Texture *) -1 || c->tx_pressed == nullptr ||
-            c->tx_pressed == (SDL_Texture *) -1) {
+        if (c->img_released < 0 || c->img_pressed < 0) {
             c->is_visible = 0;
         } else {
-            if (c->is_pressed) {
-                SDL_RenderCopy(renderer, c->tx_pressed, nullptr, &pixels_rect);
-            } else {
-                SDL_RenderCopy(renderer, c->tx_released, nullptr, &pixels_rect);
-            }
+            SDL_FRect *frect = c->get_control_frect();
+            SDL_FRect pixels_frect;
+            pixels_frect.x = (frect->x / 100) * (float) window_x;
+            pixels_frect.y = (frect->y / 100) * (float) window_y;
+            pixels_frect.w = (frect->w / 100) * (float) window_x;
+            pixels_frect.h = (frect->h / 100) * (float) window_y;
+            int64_t alpha = screen_is_portrait ? c->alpha_portrait : c->alpha_landscape;
+            control_image_t *image = &atlas_images[c->is_pressed ? c->img_pressed : c->img_released];
+            add_to_controls_batch(renderer, image, &pixels_frect, (Uint8) alpha);
             c->is_drawn = true;
             if (c->continuous_click && c->is_pressed) {
                 manage_button_press_or_release(c, true);
@@ -3220,7 +3526,7 @@ void draw_control(Control *c, SDL_Renderer *renderer) {
     }
 }
 
-void draw_controls(vector<Control *> container[2], SDL_Renderer *renderer, bool update_alpha) {
+void draw_controls(vector<Control *> container[2], SDL_Renderer *renderer) {
     if (manage_show_saved) {
         Control *save_control;
         if (manage_show_saved_global) {
@@ -3235,7 +3541,6 @@ void draw_controls(vector<Control *> container[2], SDL_Renderer *renderer, bool
                 if (*ptr > 1) {
                     save_control->is_visible = 1;
                     *ptr -= 3;
-                    save_control->update_textures_alpha();
                     saved_start_ticks = act_ticks;
                 } else {
                     save_control->is_visible = 0;
@@ -3245,12 +3550,9 @@ void draw_controls(vector<Control *> container[2], SDL_Renderer *renderer, bool
             }
         }
     }
+    load_controls_images(container, renderer);
     for (int i = 0; i < container->size(); i++) {
-        Control *c = (*container)[i];
-        if (update_alpha) {
-            c->update_textures_alpha();
-        }
-        draw_control(c, renderer);
+        draw_control((*container)[i], renderer);
     }
 }
 
@@ -3302,7 +3604,9 @@ extern "C" void manage_onscreen_controls(SDL_Renderer *renderer) {
             pause_control->is_visible = 0;
         }
         if (custom_emulation_paused) {
+            vector<Control *> pause_container(1, pause_control);
             update_pause_control_position();
+            load_controls_images(&pause_container, renderer);
             draw_control(pause_control, renderer);
         }
     }
@@ -3322,14 +3626,14 @@ extern "C" void manage_onscreen_controls(SDL_Renderer *renderer) {
 
         fix_player_selected_visible_status(&(effective_game_controls[app_config_struct.mobile_use_inverted_controls ? 1 : 0]));
         fix_disc_direction_visible_status(&(effective_game_controls[app_config_struct.mobile_use_inverted_controls ? 1 : 0]), DISC_KEY, DISC_DIRECTION_KEY);
-        draw_controls(&(effective_game_controls[app_config_struct.mobile_use_inverted_controls ? 1 : 0]), renderer, last_screen_is_portrait != screen_is_portrait);
+        draw_controls(&(effective_game_controls[app_config_struct.mobile_use_inverted_controls ? 1 : 0]), renderer);
         if (app_config_struct.mobile_show_configuration_controls) {
             fix_disc_direction_visible_status(&configuration_controls, CONFIGURATION_DISC_KEY, CONFIGURATION_DISC_DIRECTION_KEY);
-            draw_controls(&configuration_controls, renderer, last_screen_is_portrait != screen_is_portrait);
+            draw_controls(&configuration_controls, renderer);
             if (configuration_mode) {
                 update_configuration_mode_controls();
             }
         }
-        last_screen_is_portrait = screen_is_portrait;
     }
+    flush_controls_batch(renderer);
 }
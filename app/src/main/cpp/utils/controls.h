@@ -171,7 +171,6 @@ public:
     void set_default_position_and_size(int hand_index);
     string get_effective_event();
     SDL_FRect *get_control_frect();
-    void update_textures_alpha();
     bool check_and_fix_size();
     bool normalize_to_delta(Control* parent_control, bool keep_univisible);
     bool normalize_from_delta(Control* parent_control);
@@ -190,8 +189,9 @@ public:
     // Technical members
     string original_event;
     int last_direction;
-    SDL_Texture *tx_released;
-    SDL_Texture *tx_pressed;
+    int img_released;
+    int img_pressed;
+    int atlas_generation;
     int jzintv_event_index;
     bool last_pressed;
     bool is_pressed;
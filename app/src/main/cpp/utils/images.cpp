@@ -1,10 +1,45 @@
 #include "main.h"
 #include "includes_specific.h"
 #include "stb_image.h"
+#include <deque>
 
-static GLuint game_image_texture;
-static int game_image_width;
-static int game_image_height;
+// Rom artwork is decoded by a small pool of threads and uploaded on this thread, within a time budget per
+// frame. Textures are cached by rom crc32, and the least recently shown are deleted past ARTWORK_CACHE_SIZE.
+#define ARTWORK_CACHE_SIZE 48
+#define ARTWORK_PREFETCH 2
+#define ARTWORK_MAX_THREADS 2
+#define ARTWORK_UPLOAD_BUDGET_MILLIS 4
+
+enum artwork_state_t {
+    ARTWORK_QUEUED,
+    ARTWORK_DECODING,
+    ARTWORK_DECODED,
+    ARTWORK_READY,
+    ARTWORK_MISSING,
+    ARTWORK_BROKEN
+};
+
+struct artwork_t {
+    string file_name;
+    artwork_state_t state;
+    unsigned char *pixels;
+    int width;
+    int height;
+    GLuint texture;
+    uint64_t last_used;
+    bool warned;
+};
+
+// Guarded by artwork_mutex, as is artwork_jobs
+static std::unordered_map<uint64_t, artwork_t> artworks;
+static std::deque<uint64_t> artwork_jobs;
+static SDL_mutex *artwork_mutex = nullptr;
+static SDL_cond *artwork_cond = nullptr;
+static SDL_Thread *artwork_threads[ARTWORK_MAX_THREADS];
+static int artwork_threads_num = 0;
+static bool artwork_quit = false;
+static uint64_t artwork_frame = 0;
+static uint64_t artwork_selected_key = 0;
 
 static GLuint empty_game_image_texture = 0;
 static int empty_game_image_width;
@@ -25,15 +60,8 @@ static int black_image_height;
 long loading_millis = -1;
 
 // OpenGL, direttamente da Dear ImGui https://github.com/ocornut/imgui/wiki/Image-Loading-and-Displaying-Examples
-// Simple helper function to load an image into a OpenGL texture with common settings
-static bool LoadTextureFromFile(const char *filename, GLuint *out_texture, int *out_width, int *out_height) {
-    // Load from file
-    int image_width = 0;
-    int image_height = 0;
-    unsigned char *image_data = stbi_load(filename, &image_width, &image_height, NULL, 4);
-    if (image_data == NULL)
-        return false;
-
+// Simple helper function to upload RGBA pixels into a OpenGL texture with common settings
+static GLuint CreateTexture(const unsigned char *image_data, int image_width, int image_height) {
     // Create a OpenGL texture identifier
     GLuint image_texture;
     glGenTextures(1, &image_texture);
@@ -50,6 +78,18 @@ static bool LoadTextureFromFile(const char *filename, GLuint *out_texture, int *
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 #endif
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image_width, image_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data);
+    return image_texture;
+}
+
+static bool LoadTextureFromFile(const char *filename, GLuint *out_texture, int *out_width, int *out_height) {
+    // Load from file
+    int image_width = 0;
+    int image_height = 0;
+    unsigned char *image_data = stbi_load(filename, &image_width, &image_height, NULL, 4);
+    if (image_data == NULL)
+        return false;
+
+    GLuint image_texture = CreateTexture(image_data, image_width, image_height);
     stbi_image_free(image_data);
 
     *out_texture = image_texture;
@@ -111,117 +151,313 @@ void clear_general_textures() {
     }
 }
 
-void clear_roms_textures(struct roms_list_struct_t *roms_list_struct) {
-    for (int i = 0; i < roms_list_struct->total_roms_num; i++) {
-        rom_config_struct_t *rom_config = &(roms_list_struct->list[i]);
-        if (rom_config->texture_screenshot > 0) {
-            glDeleteTextures(1, &(rom_config->texture_screenshot));
+// Called with artwork_mutex locked, which is released while decoding
+static void decode_next_artwork() {
+    uint64_t key = artwork_jobs.front();
+    artwork_jobs.pop_front();
+    auto it = artworks.find(key);
+    if (it == artworks.end() || it->second.state != ARTWORK_QUEUED) {
+        return;
+    }
+    // Decoding entries are never evicted, and map nodes don't move
+    artwork_t *artwork = &it->second;
+    artwork->state = ARTWORK_DECODING;
+    string file_name = artwork->file_name;
+    SDL_UnlockMutex(artwork_mutex);
+
+    int width = 0;
+    int height = 0;
+    unsigned char *pixels = nullptr;
+    bool exists = exist_file(file_name.c_str());
+    if (exists) {
+        pixels = stbi_load(file_name.c_str(), &width, &height, NULL, 4);
+    }
+
+    SDL_LockMutex(artwork_mutex);
+    artwork->pixels = pixels;
+    artwork->width = width;
+    artwork->height = height;
+    artwork->state = pixels != nullptr ? ARTWORK_DECODED : exists ? ARTWORK_BROKEN : ARTWORK_MISSING;
+}
+
+static int artwork_worker(void *data) {
+    SDL_LockMutex(artwork_mutex);
+    while (!artwork_quit) {
+        if (artwork_jobs.empty()) {
+            SDL_CondWait(artwork_cond, artwork_mutex);
+        } else {
+            decode_next_artwork();
+        }
+    }
+    SDL_UnlockMutex(artwork_mutex);
+    return 0;
+}
+
+static void start_artwork_workers() {
+    if (artwork_mutex != nullptr) {
+        return;
+    }
+    artwork_mutex = SDL_CreateMutex();
+    artwork_cond = SDL_CreateCond();
+    artwork_quit = false;
+    int max_threads = std::min(std::max(SDL_GetCPUCount() - 1, 1), ARTWORK_MAX_THREADS);
+    for (int i = 0; i < max_threads; i++) {
+        artwork_threads[artwork_threads_num] = SDL_CreateThread(artwork_worker, "artwork", nullptr);
+        if (artwork_threads[artwork_threads_num] != nullptr) {
+            artwork_threads_num++;
+        }
+    }
+    // Without threads, upload_artworks decodes one image per frame
+    Log(LOG_INFO) << "Artwork: " << artwork_threads_num << " decoding threads";
+}
+
+static void free_artwork(artwork_t *artwork) {
+    if (artwork->pixels != nullptr) {
+        stbi_image_free(artwork->pixels);
+        artwork->pixels = nullptr;
+    }
+    if (artwork->texture != 0) {
+        glDeleteTextures(1, &artwork->texture);
+        artwork->texture = 0;
+    }
+}
+
+static uint64_t get_artwork_key(rom_config_struct_t *rom_config, bool is_screenshot) {
+    return ((uint64_t) rom_config->crc32 << 1) | (is_screenshot ? 0 : 1);
+}
+
+static bool get_artwork_file_name(struct app_config_struct_t *app_conf, rom_config_struct_t *rom_config, bool is_screenshot, string *file_name) {
+    char *act_image_ptr = is_screenshot ? rom_config->image_file_name : rom_config->box_file_name;
+    if (act_image_ptr == nullptr) {
+        return false;
+    }
+    char complete_filename[FILENAME_MAX];
+    sprintf(complete_filename, "%s%s/%s", app_conf->resource_folder_absolute_path,
+            is_screenshot ? "Images/Screenshots" : "Images/Boxes", act_image_ptr);
+    *file_name = complete_filename;
+    return true;
+}
+
+// Queues the artwork if it isn't cached yet; 'urgent' ones go before prefetches. Returns a copy of the entry.
+static artwork_t request_artwork(struct app_config_struct_t *app_conf, rom_config_struct_t *rom_config, bool is_screenshot, bool urgent) {
+    artwork_t result = {"", ARTWORK_MISSING, nullptr, 0, 0, 0, 0, true};
+    string file_name;
+    if (!get_artwork_file_name(app_conf, rom_config, is_screenshot, &file_name)) {
+        return result;
+    }
+
+    uint64_t key = get_artwork_key(rom_config, is_screenshot);
+    SDL_LockMutex(artwork_mutex);
+    auto it = artworks.find(key);
+    if (it != artworks.end() && it->second.file_name != file_name) {
+        // Image changed in configuration
+        if (it->second.state == ARTWORK_QUEUED) {
+            it->second.file_name = file_name;
+        } else if (it->second.state != ARTWORK_DECODING) {
+            free_artwork(&it->second);
+            artworks.erase(it);
+            it = artworks.end();
+        }
+    }
+    if (it == artworks.end()) {
+        artwork_t artwork = {file_name, ARTWORK_QUEUED, nullptr, 0, 0, 0, 0, false};
+        it = artworks.insert(std::make_pair(key, artwork)).first;
+        if (urgent) {
+            artwork_jobs.push_front(key);
+        } else {
+            artwork_jobs.push_back(key);
+        }
+        SDL_CondSignal(artwork_cond);
+    } else if (it->second.state == ARTWORK_QUEUED && urgent && artwork_jobs.front() != key) {
+        artwork_jobs.erase(std::find(artwork_jobs.begin(), artwork_jobs.end(), key));
+        artwork_jobs.push_front(key);
+    }
+    it->second.last_used = artwork_frame;
+    if (urgent && (it->second.state == ARTWORK_MISSING || it->second.state == ARTWORK_BROKEN)) {
+        result.warned = it->second.warned;
+        it->second.warned = true;
+    }
+    result.file_name = it->second.file_name;
+    result.state = it->second.state;
+    result.width = it->second.width;
+    result.height = it->second.height;
+    result.texture = it->second.texture;
+    SDL_UnlockMutex(artwork_mutex);
+    return result;
+}
+
+// Selection moved on: whatever is still waiting in the queue isn't wanted anymore
+static void cancel_artwork_jobs() {
+    SDL_LockMutex(artwork_mutex);
+    for (uint64_t key : artwork_jobs) {
+        auto it = artworks.find(key);
+        if (it != artworks.end() && it->second.state == ARTWORK_QUEUED) {
+            artworks.erase(it);
+        }
+    }
+    artwork_jobs.clear();
+    SDL_UnlockMutex(artwork_mutex);
+}
+
+static void evict_artworks() {
+    while (artworks.size() > ARTWORK_CACHE_SIZE) {
+        auto oldest = artworks.end();
+        for (auto it = artworks.begin(); it != artworks.end(); ++it) {
+            artwork_state_t state = it->second.state;
+            if ((state == ARTWORK_READY || state == ARTWORK_MISSING || state == ARTWORK_BROKEN) &&
+                it->second.last_used != artwork_frame &&
+                (oldest == artworks.end() || it->second.last_used < oldest->second.last_used)) {
+                oldest = it;
+            }
+        }
+        if (oldest == artworks.end()) {
+            break;
+        }
+        free_artwork(&oldest->second);
+        artworks.erase(oldest);
+    }
+}
+
+// Turns decoded images into textures, at least one per frame and then until the budget is spent
+static void upload_artworks() {
+    long start_millis = get_act_millis();
+    artwork_frame++;
+    SDL_LockMutex(artwork_mutex);
+    if (artwork_threads_num == 0 && !artwork_jobs.empty()) {
+        decode_next_artwork();
+    }
+    do {
+        auto it = artworks.begin();
+        while (it != artworks.end() && it->second.state != ARTWORK_DECODED) {
+            ++it;
         }
-        rom_config->texture_screenshot = 0;
+        if (it == artworks.end()) {
+            break;
+        }
+        // Only this thread touches decoded entries, so the upload can run unlocked
+        artwork_t *artwork = &it->second;
+        SDL_UnlockMutex(artwork_mutex);
+        GLuint texture = CreateTexture(artwork->pixels, artwork->width, artwork->height);
+        SDL_LockMutex(artwork_mutex);
+        stbi_image_free(artwork->pixels);
+        artwork->pixels = nullptr;
+        artwork->texture = texture;
+        artwork->state = ARTWORK_READY;
+    } while (get_act_millis() - start_millis < ARTWORK_UPLOAD_BUDGET_MILLIS);
+    evict_artworks();
+    SDL_UnlockMutex(artwork_mutex);
+}
+
+// Frames are needed until queued artwork is on screen
+bool images_loading() {
+    if (artwork_mutex == nullptr) {
+        return false;
+    }
+    SDL_LockMutex(artwork_mutex);
+    bool loading = !artwork_jobs.empty();
+    for (auto it = artworks.begin(); !loading && it != artworks.end(); ++it) {
+        loading = it->second.state == ARTWORK_DECODING || it->second.state == ARTWORK_DECODED;
+    }
+    SDL_UnlockMutex(artwork_mutex);
+    return loading;
+}
 
-        if (rom_config->texture_box > 0) {
-            glDeleteTextures(1, &(rom_config->texture_box));
+// The GL context is going away: textures go, images not uploaded yet stay
+void clear_roms_textures() {
+    if (artwork_mutex == nullptr) {
+        return;
+    }
+    SDL_LockMutex(artwork_mutex);
+    for (auto it = artworks.begin(); it != artworks.end();) {
+        if (it->second.state == ARTWORK_READY) {
+            free_artwork(&it->second);
+            it = artworks.erase(it);
+        } else {
+            ++it;
         }
-        rom_config->texture_box = 0;
     }
+    artwork_selected_key = 0;
+    SDL_UnlockMutex(artwork_mutex);
+}
+
+void stop_images_loader() {
+    if (artwork_mutex == nullptr) {
+        return;
+    }
+    SDL_LockMutex(artwork_mutex);
+    artwork_quit = true;
+    artwork_jobs.clear();
+    SDL_CondBroadcast(artwork_cond);
+    SDL_UnlockMutex(artwork_mutex);
+    for (int i = 0; i < artwork_threads_num; i++) {
+        SDL_WaitThread(artwork_threads[i], nullptr);
+    }
+    artwork_threads_num = 0;
+    for (auto &it : artworks) {
+        free_artwork(&it.second);
+    }
+    artworks.clear();
+    SDL_DestroyCond(artwork_cond);
+    SDL_DestroyMutex(artwork_mutex);
+    artwork_cond = nullptr;
+    artwork_mutex = nullptr;
 }
 
 void manage_image_window(ImVec2 size,
                          struct roms_list_struct_t *roms_list_struct,
                          struct app_config_struct_t *app_config_struct,
                          int tab_selected,
-                         int rom_index_selected,
-                         uint32_t mobile_last_landscape_scrollbar_pos,
-                         ImguiScrollable *roms_list_scrollable,
-                         long *last_millis_checked,
-                         int *last_rom_index_checked) {
+                         int rom_index_selected) {
+
+    start_artwork_workers();
+    upload_artworks();
 
-    char sub_folder[100];
     bool is_screenshot = tab_selected == 0;
-    uint32_t *txtr;
-    int *orig_width;
-    int *orig_height;
-    if (is_screenshot) {
-        sprintf(sub_folder, "%s", "Images/Screenshots");
-        game_image_texture = roms_list_struct->list[rom_index_selected].texture_screenshot;
-        txtr = &roms_list_struct->list[rom_index_selected].texture_screenshot;
-        orig_width = &roms_list_struct->list[rom_index_selected].original_texture_screenshot_width;
-        orig_height = &roms_list_struct->list[rom_index_selected].original_texture_screenshot_height;
-    } else {
-        sprintf(sub_folder, "%s", "Images/Boxes");
-        game_image_texture = roms_list_struct->list[rom_index_selected].texture_box;
-        txtr = &roms_list_struct->list[rom_index_selected].texture_box;
-        orig_width = &roms_list_struct->list[rom_index_selected].original_texture_box_width;
-        orig_height = &roms_list_struct->list[rom_index_selected].original_texture_box_height;
+    rom_config_struct_t *rom_config = &roms_list_struct->list[rom_index_selected];
+    uint64_t key = get_artwork_key(rom_config, is_screenshot);
+    if (key != artwork_selected_key) {
+        cancel_artwork_jobs();
+        artwork_selected_key = key;
     }
 
-    if (game_image_texture == 0) {
-        bool loadImage = false;
-        if (!app_config_struct->mobile_mode) {
-            loadImage = true;
-        } else {
-            // In mobile mode we wait for list stopped, before loading an image (only landscape)
-            long millis = get_act_millis();
-            if (*last_millis_checked == 0) {
-                *last_millis_checked = millis;
-            }
-            if (roms_list_scrollable->window->Scroll.y == mobile_last_landscape_scrollbar_pos &&
-                *last_rom_index_checked == rom_index_selected) {
-                if (millis - *last_millis_checked > 150 && !roms_list_scrollable->is_dragging &&
-                    !roms_list_scrollable->is_auto_scrolling) {
-                    loadImage = true;
-                }
-            } else {
-                *last_millis_checked = millis;
-            }
-            *last_rom_index_checked = rom_index_selected;
+    artwork_t artwork = request_artwork(app_config_struct, rom_config, is_screenshot, true);
+
+    // Neighbours, then the other tab, so they're ready when the selection gets there
+    for (int i = 1; i <= ARTWORK_PREFETCH; i++) {
+        if (rom_index_selected + i < roms_list_struct->total_roms_num) {
+            request_artwork(app_config_struct, &roms_list_struct->list[rom_index_selected + i], is_screenshot, false);
         }
-        if (loadImage) {
-            char *act_image_ptr = is_screenshot ? roms_list_struct->list[rom_index_selected].image_file_name : roms_list_struct->list[rom_index_selected].box_file_name;
-            if (act_image_ptr != NULL) {
-                char complete_filename[FILENAME_MAX];
-                sprintf(complete_filename, "%s%s/%s", app_config_struct->resource_folder_absolute_path, sub_folder,
-                        (is_screenshot ? roms_list_struct->list[rom_index_selected].image_file_name : roms_list_struct->list[rom_index_selected].box_file_name));
-                if (exist_file(complete_filename)) {
-                    bool res = LoadTextureFromFile(complete_filename, &game_image_texture, &game_image_width, &game_image_height);
-                    if (res) {
-                        *txtr = game_image_texture;
-                        *orig_width = game_image_width;
-                        *orig_height = game_image_height;
-                    } else {
-                        ADD_CONFIG_WARNING("Unable to load image: " << complete_filename);
-                        *txtr = -1;
-                    }
-                } else {
-                    ADD_CONFIG_WARNING("Unable to find image: " << complete_filename);
-                    *txtr = -1;
-                }
+        if (rom_index_selected - i >= 0) {
+            request_artwork(app_config_struct, &roms_list_struct->list[rom_index_selected - i], is_screenshot, false);
+        }
+    }
+    request_artwork(app_config_struct, rom_config, !is_screenshot, false);
+
+    GLuint game_image_texture;
+    int orig_width = NO_GAME_IMAGE_X;
+    int orig_height = NO_GAME_IMAGE_Y;
+    if (artwork.state == ARTWORK_READY) {
+        game_image_texture = artwork.texture;
+        orig_width = artwork.width;
+        orig_height = artwork.height;
+    } else if (artwork.state == ARTWORK_MISSING || artwork.state == ARTWORK_BROKEN) {
+        if (!artwork.warned) {
+            if (artwork.state == ARTWORK_MISSING) {
+                ADD_CONFIG_WARNING("Unable to find image: " << artwork.file_name);
             } else {
-                *txtr = -1;
+                ADD_CONFIG_WARNING("Unable to load image: " << artwork.file_name);
             }
-            game_image_texture = *txtr;
-        } else {
-            *orig_width = NO_GAME_IMAGE_X;
-            *orig_height = NO_GAME_IMAGE_Y;
         }
+        game_image_texture = -1;
+    } else {
+        game_image_texture = 0;
     }
+
     int act_image_height = size.y;
-    int act_image_width = (act_image_height *
-                           ((game_image_texture != (GLuint) -1)
-                            ? *orig_width
-                            : NO_GAME_IMAGE_X) /
-                           ((game_image_texture != (GLuint) -1)
-                            ? *orig_height
-                            : NO_GAME_IMAGE_Y));
+    int act_image_width = act_image_height * orig_width / orig_height;
     if (act_image_width > size.x) {
         act_image_width = size.x;
-        act_image_height = (act_image_width *
-                            ((game_image_texture != (GLuint) -1)
-                             ? *orig_height
-                             : NO_GAME_IMAGE_Y) /
-                            ((game_image_texture != (GLuint) -1)
-                             ? *orig_width
-                             : NO_GAME_IMAGE_X));
+        act_image_height = act_image_width * orig_height / orig_width;
     }
     ImVec2 pos = ImGui::GetCursorPos();
     ImGui::SetCursorPos(ImVec2(pos.x + (float) ((size.x - act_image_width) / 2), pos.y + (float) ((size.y - act_image_height) / 2)));
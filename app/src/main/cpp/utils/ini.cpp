@@ -304,6 +304,7 @@ static ini_option_t ini_options_general[] =
                 {MOBILE_DEFAULT_LANDSCAPE_CONTROLS_SIZE_OPTION, UINT_64_T,        NULL, NULL},
                 {MOBILE_ECS_PORTRAIT_ALPHA_OPTION,              UINT_64_T,        NULL, NULL},
                 {MOBILE_ECS_LANDSCAPE_ALPHA_OPTION,             UINT_64_T,        NULL, NULL},
+                {IDLE_MAX_FPS_OPTION,                           UINT_64_T,        NULL, NULL},
                 {HIDE_UNAVAILABLE_ROMS_OPTION,                  BOOL_T,           NULL, NULL},
                 {WINDOW_MAXIMIZED_OPTION,                       BOOL_T,           NULL, NULL},
                 {JZINTV_FULLSCREEN_OPTION,                      BOOL_T,           NULL, NULL},
@@ -311,7 +312,7 @@ static ini_option_t ini_options_general[] =
                 {MOBILE_SHOW_CONFIGURATION_CONTROLS_OPTION,     BOOL_T,           NULL, NULL},
                 {MOBILE_USE_INVERTED_CONTROLS_OPTION,           BOOL_T,           NULL, NULL},
                 {USE_EXTERNAL_JZINTV_OPTION,                    BOOL_T,           NULL, NULL},
-                {"DUMMY",                                       BOOL_T,           condition_bool_dummy, NULL},
+                {JZINTV_WARM_CORE_OPTION,                       BOOL_T,           NULL, NULL},
                 {ROMS_LIST_WIDTH_PERCENTAGE_OPTION,             DOUBLE_T,         NULL, NULL},
                 {IMAGE_HEIGHT_PERCENTAGE_OPTION,                DOUBLE_T,         NULL, NULL},
                 {MOBILE_PORTRAIT_TOP_GAP_PERCENTAGE_OPTION,     DOUBLE_T,         NULL, NULL},
@@ -647,6 +648,8 @@ static bool set_general_value(char *key, char *value, struct app_config_struct_t
         app_conf->image_height_percentage = string_to_float(value);
     } else if (!strcmp(key, NUM_ROMS_JUMP_OPTION)) {
         app_conf->num_roms_jump = string_to_int(value);
+    } else if (!strcmp(key, IDLE_MAX_FPS_OPTION)) {
+        app_conf->idle_max_fps = string_to_int(value);
     } else if (!strcmp(key, HIDE_UNAVAILABLE_ROMS_OPTION)) {
         app_conf->hide_unavailable_roms = string_to_bool(value);
     } else if (!strcmp(key, LAST_CRC_32_OPTION)) {
@@ -699,6 +702,8 @@ static bool set_general_value(char *key, char *value, struct app_config_struct_t
         app_conf->jzintv_fullscreen = string_to_bool(value);
     } else if (!strcmp(key, USE_EXTERNAL_JZINTV_OPTION)) {
         app_conf->use_external_jzintv = string_to_bool(value);
+    } else if (!strcmp(key, JZINTV_WARM_CORE_OPTION)) {
+        app_conf->jzintv_warm_core = string_to_bool(value);
     } else if (!strcmp(key, MOBILE_USE_INVERTED_CONTROLS_OPTION)) {
         app_conf->mobile_use_inverted_controls = string_to_bool(value);
     } else if (!strcmp(key, MOBILE_DEFAULT_PORTRAIT_CONTROLS_SIZE_OPTION)) {
@@ -922,6 +927,11 @@ static void fix_incompatible_options() {
         ADD_POPUP("Wrong configuration", "Fixed wrong configuration for flag 'mobile_ecs_landscape_alpha' (must be < 255)");
     }
 
+    if (app_config_struct.idle_max_fps > 60) {
+        app_config_struct.idle_max_fps = 60;
+        ADD_POPUP("Wrong configuration", "Fixed wrong configuration for flag 'idle_max_fps' (must be <= 60)");
+    }
+
     int max_size = app_config_struct.mobile_mode ? 90 : 48;
     int min_font_size = app_config_struct.mobile_mode ? 30 : 15;
     int min_scrollbar_size = app_config_struct.mobile_mode ? 40 : 15;
@@ -22,6 +22,7 @@
 #define JZINTV_RESOLUTION_INDEX_OPTION "jzintv_resolution_index"
 
 #define NUM_ROMS_JUMP_OPTION "num_roms_jump"
+#define IDLE_MAX_FPS_OPTION "idle_max_fps"
 
 #define WINDOW_WIDTH_OPTION "window_width"
 #define WINDOW_HEIGHT_OPTION "window_height"
@@ -88,6 +89,7 @@
 
 #define JZINTV_FULLSCREEN_OPTION "jzintv_fullscreen"
 #define USE_EXTERNAL_JZINTV_OPTION "external_jzintv"
+#define JZINTV_WARM_CORE_OPTION "jzintv_warm_core"
 #define CONTROL_PORTRAIT_S_PERC_OPTION "control_portrait_s_perc"
 #define CONTROL_LANDSCAPE_S_PERC_OPTION "control_landscape_s_perc"
 
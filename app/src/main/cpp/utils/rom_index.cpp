@@ -0,0 +1,318 @@
+#include "main.h"
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#define ROM_INDEX_INOTIFY
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Persistent index of the roms folder: file name -> (size, mtime, crc32, type).
+// Stored in native byte order, since it never leaves the device.
+#define ROM_INDEX_MAGIC "jzRI"
+#define ROM_INDEX_VERSION 1
+#define ROM_INDEX_MAX_THREADS 8
+#define ROM_INDEX_SETTLE_MILLIS 500
+
+static std::unordered_map<string, rom_index_entry_t> index_map;
+static string index_map_file;
+static uint32_t index_map_bios[ROM_TYPE_BIOS_NUM];
+
+static bool is_candidate(const char *name) {
+    size_t len = strlen(name);
+    if (len < 4 || name[len - 4] != '.') {
+        return false;
+    }
+    return strncmp(name, ROM_INDEX_FILE_PREFIX, strlen(ROM_INDEX_FILE_PREFIX)) != 0;
+}
+
+static int detect_type(const char *name, uint32_t crc32, const uint32_t *bios_crc32) {
+    for (int i = 0; i < ROM_TYPE_BIOS_NUM; i++) {
+        if (crc32 == bios_crc32[i]) {
+            return i;
+        }
+    }
+
+    const char *p = name + strlen(name) - 4;
+    if (((strcasecmp(p, ".bin")) &&
+         (strcasecmp(p, ".rom")) &&
+         (strcasecmp(p, ".int")) &&
+         (strcasecmp(p, ".cc3")) &&
+         (strcasecmp(p, ".luigi")) &&
+         (strcasecmp(p, ".itv"))) || (
+                (!strcasecmp(name, "exec.bin")) ||
+                (!strcasecmp(name, "grom.bin")) ||
+                (!strcasecmp(name, "wbexec.bin")) ||
+                (!strcasecmp(name, "gromintv.bin")) ||
+                (!strcasecmp(name, "ecs.bin"))) || crc32 == 0) {
+        return ROM_TYPE_OTHER;
+    }
+    return ROM_TYPE_GAME;
+}
+
+static void load_index(const char *index_file) {
+    index_map.clear();
+    index_map_file = index_file;
+    memset(index_map_bios, 0, sizeof(index_map_bios));
+
+    std::ifstream in(index_file, std::ios::binary);
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t count = 0;
+    in.read(magic, 4);
+    in.read((char *) &version, sizeof(version));
+    in.read((char *) index_map_bios, sizeof(index_map_bios));
+    in.read((char *) &count, sizeof(count));
+    if (!in.good() || memcmp(magic, ROM_INDEX_MAGIC, 4) || version != ROM_INDEX_VERSION) {
+        memset(index_map_bios, 0, sizeof(index_map_bios));
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        rom_index_entry_t entry;
+        uint32_t name_len = 0;
+        uint8_t type = 0;
+        in.read((char *) &name_len, sizeof(name_len));
+        if (!in.good() || name_len == 0 || name_len > FILENAME_MAX) {
+            break;
+        }
+        entry.file_name.resize(name_len);
+        in.read(&entry.file_name[0], name_len);
+        in.read((char *) &entry.size, sizeof(entry.size));
+        in.read((char *) &entry.mtime, sizeof(entry.mtime));
+        in.read((char *) &entry.crc32, sizeof(entry.crc32));
+        in.read((char *) &type, sizeof(type));
+        if (!in.good()) {
+            break;
+        }
+        entry.type = type;
+        index_map[entry.file_name] = entry;
+    }
+    Log(LOG_INFO) << "Rom index: " << index_map.size() << " entries loaded from " << index_file;
+}
+
+static void save_index() {
+    std::ofstream out(index_map_file.c_str(), std::ios::binary | std::ios::trunc);
+    uint32_t version = ROM_INDEX_VERSION;
+    uint32_t count = index_map.size();
+    out.write(ROM_INDEX_MAGIC, 4);
+    out.write((const char *) &version, sizeof(version));
+    out.write((const char *) index_map_bios, sizeof(index_map_bios));
+    out.write((const char *) &count, sizeof(count));
+    for (auto &it : index_map) {
+        const rom_index_entry_t &entry = it.second;
+        uint32_t name_len = entry.file_name.size();
+        uint8_t type = entry.type;
+        out.write((const char *) &name_len, sizeof(name_len));
+        out.write(entry.file_name.data(), name_len);
+        out.write((const char *) &entry.size, sizeof(entry.size));
+        out.write((const char *) &entry.mtime, sizeof(entry.mtime));
+        out.write((const char *) &entry.crc32, sizeof(entry.crc32));
+        out.write((const char *) &type, sizeof(type));
+    }
+    if (!out.good()) {
+        Log(LOG_ERROR) << "Rom index: unable to write " << index_map_file;
+    }
+}
+
+// Plain stdio rather than file_crc32(): that goes through lzoe, whose table
+// of open files is only per thread where the compiler has thread-locals.
+static uint32_t hash_file(const char *file_name) {
+    static const size_t buf_len = 64 * 1024;
+    uint32_t crc = 0xFFFFFFFFU;
+    FILE *f = fopen(file_name, "rb");
+    if (f == NULL) {
+        return crc;
+    }
+    vector<unsigned char> buf(buf_len);
+    size_t len;
+    while ((len = fread(buf.data(), 1, buf_len, f)) > 0) {
+        crc = crc32_block(crc, buf.data(), (int) len);
+    }
+    fclose(f);
+    return crc ^ 0xFFFFFFFFU;
+}
+
+struct hash_job_t {
+    const char *folder;
+    vector<rom_index_entry_t *> pending;
+    SDL_atomic_t next;
+    SDL_atomic_t done;
+};
+
+static int hash_worker(void *data) {
+    hash_job_t *job = (hash_job_t *) data;
+    int i;
+    while ((i = SDL_AtomicAdd(&job->next, 1)) < (int) job->pending.size()) {
+        rom_index_entry_t *entry = job->pending[i];
+        string complete_filename = string(job->folder) + "/" + entry->file_name;
+        entry->crc32 = hash_file(complete_filename.c_str());
+        SDL_AtomicIncRef(&job->done);
+    }
+    return 0;
+}
+
+bool rom_index_scan(const char *folder, const char *index_file, const uint32_t *bios_crc32,
+                    vector<rom_index_entry_t> *entries, void (*progress)()) {
+    entries->clear();
+    DIR *dir = opendir(folder);
+    if (dir == nullptr) {
+        return false;
+    }
+
+    long start_millis = get_act_millis();
+    if (index_map_file != index_file) {
+        load_index(index_file);
+    }
+
+    // Bios crc32s changed in configuration: types change, crc32s don't
+    bool dirty = memcmp(index_map_bios, bios_crc32, sizeof(index_map_bios)) != 0;
+    if (dirty) {
+        memcpy(index_map_bios, bios_crc32, sizeof(index_map_bios));
+        for (auto &it : index_map) {
+            it.second.type = detect_type(it.first.c_str(), it.second.crc32, bios_crc32);
+        }
+    }
+
+    struct dirent *Dirent;
+    hash_job_t job;
+    job.folder = folder;
+    while ((Dirent = readdir(dir)) != nullptr) {
+        if (Dirent->d_type == DT_DIR || !is_candidate(Dirent->d_name)) {
+            continue;
+        }
+        string complete_filename = string(folder) + "/" + Dirent->d_name;
+        struct stat info;
+        if (stat(complete_filename.c_str(), &info) != 0 || (info.st_mode & S_IFMT) != S_IFREG) {
+            continue;
+        }
+
+        rom_index_entry_t entry;
+        entry.file_name = Dirent->d_name;
+        entry.size = info.st_size;
+        entry.mtime = info.st_mtime;
+        entry.crc32 = 0;
+        entry.type = ROM_TYPE_OTHER;
+
+        auto cached = index_map.find(entry.file_name);
+        if (cached != index_map.end() && cached->second.size == entry.size && cached->second.mtime == entry.mtime) {
+            entry = cached->second;
+        } else {
+            entry.type = -1;
+        }
+        entries->push_back(entry);
+    }
+    closedir(dir);
+
+    for (auto &entry : *entries) {
+        if (entry.type == -1) {
+            job.pending.push_back(&entry);
+        }
+    }
+
+    // Hash new and changed files in parallel
+    int threads_num = 0;
+    if (!job.pending.empty()) {
+        SDL_Thread *threads[ROM_INDEX_MAX_THREADS];
+        int max_threads = std::min(std::max(SDL_GetCPUCount(), 1), ROM_INDEX_MAX_THREADS);
+        SDL_AtomicSet(&job.next, 0);
+        SDL_AtomicSet(&job.done, 0);
+        for (int i = 0; i < max_threads && i < (int) job.pending.size(); i++) {
+            threads[threads_num] = SDL_CreateThread(hash_worker, "rom_index", &job);
+            if (threads[threads_num] != nullptr) {
+                threads_num++;
+            }
+        }
+        if (threads_num == 0) {
+            hash_worker(&job);
+        }
+        while (SDL_AtomicGet(&job.done) < (int) job.pending.size()) {
+            if (progress != nullptr) {
+                progress();
+            }
+            SDL_Delay(5);
+        }
+        for (int i = 0; i < threads_num; i++) {
+            SDL_WaitThread(threads[i], nullptr);
+        }
+        for (auto entry : job.pending) {
+            entry->type = detect_type(entry->file_name.c_str(), entry->crc32, bios_crc32);
+        }
+        dirty = true;
+    }
+
+    // Only files still present stay in the index
+    if (dirty || index_map.size() != entries->size()) {
+        index_map.clear();
+        for (auto &entry : *entries) {
+            index_map[entry.file_name] = entry;
+        }
+        save_index();
+    }
+
+    Log(LOG_INFO) << "Rom index: " << entries->size() << " files, " << job.pending.size() << " hashed on "
+                  << std::max(threads_num, 1) << " threads, " << (get_act_millis() - start_millis) << " ms";
+    return true;
+}
+
+#ifdef ROM_INDEX_INOTIFY
+static int inotify_fd = -1;
+static bool change_pending = false;
+static long last_change_millis = 0;
+
+void rom_index_unwatch() {
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+    change_pending = false;
+}
+
+void rom_index_watch(const char *folder) {
+    rom_index_unwatch();
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        return;
+    }
+    if (inotify_add_watch(inotify_fd, folder, IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB) < 0) {
+        Log(LOG_INFO) << "Rom index: can't watch " << folder << " for changes";
+        rom_index_unwatch();
+    }
+}
+
+bool rom_index_changed() {
+    if (inotify_fd < 0) {
+        return false;
+    }
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+    while ((len = read(inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *ptr = buf; ptr < buf + len; ptr += sizeof(struct inotify_event) + ((struct inotify_event *) ptr)->len) {
+            struct inotify_event *event = (struct inotify_event *) ptr;
+            if (event->len > 0 && is_candidate(event->name)) {
+                change_pending = true;
+                last_change_millis = get_act_millis();
+            }
+        }
+    }
+
+    // Wait for copies in progress to settle
+    if (change_pending && get_act_millis() - last_change_millis >= ROM_INDEX_SETTLE_MILLIS) {
+        change_pending = false;
+        return true;
+    }
+    return false;
+}
+#else
+
+void rom_index_watch(const char *folder) {
+}
+
+bool rom_index_changed() {
+    return false;
+}
+
+void rom_index_unwatch() {
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef JZINTVIMGUI_ROM_INDEX_H
+#define JZINTVIMGUI_ROM_INDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Order matches the bios CRC32s passed to rom_index_scan
+#define ROM_TYPE_EXEC 0
+#define ROM_TYPE_GROM 1
+#define ROM_TYPE_TUTORVISION_EXEC 2
+#define ROM_TYPE_TUTORVISION_GROM 3
+#define ROM_TYPE_ECS 4
+#define ROM_TYPE_BIOS_NUM 5
+#define ROM_TYPE_GAME 5
+#define ROM_TYPE_OTHER 6
+
+#define ROM_INDEX_FILE_PREFIX "rom_index_"
+
+struct rom_index_entry_t {
+    std::string file_name;
+    uint64_t size;
+    int64_t mtime;
+    uint32_t crc32;
+    int type;
+};
+
+// Lists the candidate files in 'folder' with their CRC32 and type. Files whose size and mtime match the
+// persistent index in 'index_file' are not read again; the others are hashed by a pool of worker threads,
+// while 'progress' is called on this thread. Returns false if the folder can't be read.
+extern bool rom_index_scan(const char *folder, const char *index_file, const uint32_t *bios_crc32,
+                           std::vector<rom_index_entry_t> *entries, void (*progress)());
+
+// Watches 'folder' for changes, where the platform can (inotify). rom_index_changed returns true once,
+// after changes to candidate files have settled.
+extern void rom_index_watch(const char *folder);
+extern bool rom_index_changed();
+extern void rom_index_unwatch();
+
+#endif //JZINTVIMGUI_ROM_INDEX_H